@@ -3,21 +3,26 @@
  * @author 万鹏 7415 (2789152534@qq.com)
  * @date 2024-11-28 21:56:15
  * @brief 应用库，无线自组网通讯模块，基于DL-LN32P
- * @version 0.1
- * @note
+ * @version 0.3
+ * @note 所有命令都经过发送队列异步发出，需要应答的命令通过 DL_LN_request 登记，
+ *       应答按（端口 + 命令字）匹配，回调和超时都在主循环的 DL_LN_poll 中处理，不再忙等待；
+ *       其他节点主动发来的数据包按目标端口交给 DL_LN_register_port_handler 登记的处理函数。
+ *       全部状态都在 DL_LN_t 实例里，多个模块接不同串口即可并行，HAL 中断回调按串口找到对应实例。
+ *       DL_LN_negotiate_baud 在 DL_LN_poll 中逐级提高模块与本地串口的波特率，失败回退
 */
 
 #include "usart.h"
 #include "string.h"
 #include "stdio.h"
 #include "stdint.h"
+#include "DL-LN.h"
 
 /***************************************DL-LN信息读取相关函数****************************************************/
 /**
  * @brief 看我！别忘了配置！！！
 */
 
-#define DL_LN_UART &huart1  // DL-LN32P 连接的串口
+#define PC_UART NULL    // 上位机串口，DL_LN_report 默认从这里输出；NULL 表示与模块共用串口
 // 端口定义 尽可能不要冲突
 /*外部端口*/
 #define READ_PORT 0X90
@@ -25,18 +30,11 @@
 #define SET_PORT 0X95
 /*内部端口*/
 #define LOCAL_PORT 0X21
-#define LINK_TEST_PORT 0X23
+#define LINK_LOCAL_PORT 0X23
 
 // 特殊信息定义
 #define LOCAL_ADDRESS 0X00
-#define msg_length_to_PC 20     // 向上位机发送的数据长度，不要太大浪费
-#define MAX_PACKET_SIZE 256     // 定义最大包长
-#define msg_length_to_send 256   // 向其他模块发送的数据长度，不要太大浪费
-
-#define TEMP 0xAA       // 占位符，存在的意义是填充占位，等待更替
-#define CMD_TEMP 0xAA   // 占位符，存在的意义是填充命令位
-#define ADR_TEMP 0XAA   // 占位符，存在的意义是填充地址位
-
+#define msg_length_to_PC 40     // 向上位机发送的数据长度，不要太大浪费
 
 // 设置-命令定义
 #define SET_ADDRESS_CMD 0x11
@@ -45,31 +43,328 @@
 #define SET_BAUD_RATE_CMD 0x14
 #define RESTART_CMD 0x10
 
-// 设置-模式定义
-#define SET_ADDRESS_MODE 0x01
-#define SET_NETWORK_ID_MODE 0x02
-#define SET_CHANNEL_MODE 0x03
-#define SET_BAUD_RATE_MODE 0x04
-
-// 数据接收缓冲区
-uint8_t DL_LN_rx_buffer[20];  // 接收缓冲区
-uint8_t PC_tx_buffer[100];    // 转发给上位机的数据缓冲区
-int read_state = 0;
-
-// 读取命令定义
-const uint8_t READ_ADDRESS_CMD[] = {0xFE, 0x05, READ_PORT, LOCAL_PORT, LOCAL_ADDRESS, LOCAL_ADDRESS, 0x01, 0xFF};
-const uint8_t READ_NETWORK_ID_CMD[] = {0xFE, 0x05, READ_PORT, LOCAL_PORT, LOCAL_ADDRESS, LOCAL_ADDRESS, 0x02, 0xFF};
-const uint8_t READ_CHANNEL_CMD[] = {0xFE, 0x05, READ_PORT, LOCAL_PORT, LOCAL_ADDRESS, LOCAL_ADDRESS, 0x03, 0xFF};
-const uint8_t READ_BAUD_RATE_CMD[] = {0xFE, 0x05, READ_PORT, LOCAL_PORT, LOCAL_ADDRESS, LOCAL_ADDRESS, 0x04, 0xFF};
-// 设置命令定义
-uint8_t SET_CMD_ADR_ID[] = {0xFE, 0x07, SET_PORT, LOCAL_PORT, LOCAL_ADDRESS, LOCAL_ADDRESS, CMD_TEMP, TEMP, TEMP, 0xFF};
-uint8_t SET_CMD_CH_BPS[] = {0xFE, 0x06, SET_PORT, LOCAL_PORT, LOCAL_ADDRESS, LOCAL_ADDRESS, CMD_TEMP, TEMP, 0xFF};
-// 链路测试命令定义
-uint8_t LINK_QUALITY_TEST[] = {0xFE, 0x06, LINK_TEST_PORT, LINK_TEST_PORT, ADR_TEMP, ADR_TEMP, ADR_TEMP, ADR_TEMP, 0xFF}
+// 应答命令字 = 请求命令字 + REPLY_CODE_OFFSET
+#define REPLY_CODE_OFFSET 0x20
+// 链路测试没有命令字，用固定值参与匹配
+#define LINK_TEST_KEY 0x00
+
+#define DL_LN_DEFAULT_TIMEOUT 50    // 默认应答超时，单位 ms
+
+// 波特率协商配置
+#define DL_LN_RESTART_MS 300            // 重启命令应答后等待模块重新上线的时间，单位 ms
+#define DL_LN_NEGOTIATE_TIMEOUT 200     // 协商过程中每个请求的应答超时，单位 ms
+#define DL_LN_NEGOTIATE_RETRIES 3       // 设置、重启、扫描每一步的重试次数
+#define DL_LN_NEGOTIATE_PROBES 8        // 每级波特率验证的往返次数，全部成功才算可靠
+#define DL_LN_NEGOTIATE_FALLBACKS 3     // 最多回退次数，超过视为失联
+
+// 读取命令定义，只读，所有实例共用
+static const uint8_t READ_ADDRESS_CMD[] = {0xFE, 0x05, READ_PORT, LOCAL_PORT, LOCAL_ADDRESS, LOCAL_ADDRESS, 0x01, 0xFF};
+static const uint8_t READ_NETWORK_ID_CMD[] = {0xFE, 0x05, READ_PORT, LOCAL_PORT, LOCAL_ADDRESS, LOCAL_ADDRESS, 0x02, 0xFF};
+static const uint8_t READ_CHANNEL_CMD[] = {0xFE, 0x05, READ_PORT, LOCAL_PORT, LOCAL_ADDRESS, LOCAL_ADDRESS, 0x03, 0xFF};
+static const uint8_t READ_BAUD_RATE_CMD[] = {0xFE, 0x05, READ_PORT, LOCAL_PORT, LOCAL_ADDRESS, LOCAL_ADDRESS, 0x04, 0xFF};
 // 重启命令定义
-uint8_t RESTART[] = {0xFE, 0x05, SET_PORT, LOCAL_PORT, LOCAL_ADDRESS, LOCAL_ADDRESS, RESTART_CMD, 0xFF}
-// 普通发送信息
-unint8_t SEND_MSG[msg_length_to_send];
+static const uint8_t RESTART[] = {0xFE, 0x05, SET_PORT, LOCAL_PORT, LOCAL_ADDRESS, LOCAL_ADDRESS, RESTART_CMD, 0xFF};
+
+// 已初始化的实例，HAL 中断回调按串口查找
+static DL_LN_t *DL_LN_instances[DL_LN_MAX_INSTANCES];
+static uint8_t DL_LN_instance_count = 0;
+
+static void DL_LN_negotiate_step(DL_LN_t *dl);
+
+/***************************************DL-LN异步请求引擎****************************************************/
+
+/**
+ * @brief 请求槽状态
+ */
+enum
+{
+    REQUEST_FREE = 0,   ///< 空闲
+    REQUEST_WAITING,    ///< 已发送，等待应答
+    REQUEST_REPLIED,    ///< 中断里收到应答，等待主循环回调
+};
+
+/**
+ * @brief 按串口查找实例
+ * @return 实例，该串口没有接模块返回 NULL
+ */
+static DL_LN_t *DL_LN_find_instance(UART_HandleTypeDef *huart)
+{
+    for (int i = 0; i < DL_LN_instance_count; i++)
+    {
+        if (DL_LN_instances[i]->huart == huart)
+        {
+            return DL_LN_instances[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 串口空闲时从队列取下一帧发送
+ * @note 主循环和发送完成中断都会调用，关中断保护 busy 标志
+ */
+static void DL_LN_tx_kick(DL_LN_t *dl)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (!dl->tx_busy && dl->tx_head != dl->tx_tail)
+    {
+        uint8_t slot = dl->tx_head;
+        dl->tx_busy = 1;
+        if (HAL_UART_Transmit_IT(dl->huart, dl->tx_queue[slot], dl->tx_length[slot]) != HAL_OK)
+        {
+            dl->tx_busy = 0;  // 串口被其他发送占用，下次 poll 再试
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 帧拷贝进发送队列
+ * @return 1 入队成功，0 队列已满
+ */
+static uint8_t DL_LN_tx_enqueue(DL_LN_t *dl, const uint8_t *frame, uint16_t length)
+{
+    uint8_t next = (dl->tx_tail + 1) % DL_LN_TX_QUEUE_LEN;
+    if (next == dl->tx_head || length > DL_LN_MAX_PACKET)
+    {
+        return 0;
+    }
+    memcpy(dl->tx_queue[dl->tx_tail], frame, length);
+    dl->tx_length[dl->tx_tail] = length;
+    dl->tx_tail = next;
+    DL_LN_tx_kick(dl);
+    return 1;
+}
+
+/**
+ * @brief 发送命令并登记应答，立即返回，不等待
+ *
+ * 应答到达或超时后，在 DL_LN_poll 中调用 callback。同一（端口，命令字）同时只能有一个请求在等待，
+ * 不同的键可以并发，应答先后顺序不影响匹配。
+ *
+ * @param dl 驱动实例
+ * @param command 完整命令帧
+ * @param length 命令帧长度
+ * @param timeout_ms 应答超时，0 表示使用默认值
+ * @param callback 应答回调，为 NULL 时只发送不登记
+ * @param context 回调的用户指针
+ * @return 1 已发送，0 请求槽或发送队列已满、或同键请求尚未完成
+ */
+uint8_t DL_LN_request(DL_LN_t *dl, const uint8_t *command, uint8_t length, uint16_t timeout_ms,
+                      DL_LN_reply_callback_t callback, void *context)
+{
+    if (callback == NULL)
+    {
+        return DL_LN_tx_enqueue(dl, command, length);
+    }
+
+    uint8_t port = command[2];
+    uint8_t cmd = (port == LINK_TEST_PORT) ? LINK_TEST_KEY : command[6];
+    DL_LN_request_t *slot = NULL;
+    for (int i = 0; i < DL_LN_MAX_PENDING; i++)
+    {
+        DL_LN_request_t *req = &dl->pending[i];
+        if (req->state != REQUEST_FREE && req->port == port && req->cmd == cmd)
+        {
+            return 0;   // 同键请求还没结束，应答无法区分
+        }
+        if (req->state == REQUEST_FREE && slot == NULL)
+        {
+            slot = req;
+        }
+    }
+    if (slot == NULL)
+    {
+        return 0;
+    }
+
+    slot->port = port;
+    slot->cmd = cmd;
+    slot->deadline = HAL_GetTick() + (timeout_ms ? timeout_ms : DL_LN_DEFAULT_TIMEOUT);
+    slot->callback = callback;
+    slot->context = context;
+    slot->reply_length = 0;
+    slot->state = REQUEST_WAITING;  // 最后置状态，中断里才会开始匹配
+
+    if (!DL_LN_tx_enqueue(dl, command, length))
+    {
+        slot->state = REQUEST_FREE;
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief 登记数据端口处理函数
+ *
+ * 其他节点发到本机 port 端口的数据包会在 DL_LN_poll 中交给 handler。
+ * 端口不要和 READ_PORT、SET_PORT、LINK_TEST_PORT 冲突。重复登记同一端口会替换原处理函数。
+ *
+ * @param dl 驱动实例
+ * @param port 本机接收端口
+ * @param handler 处理函数
+ * @return 1 登记成功，0 处理函数表已满
+ * @note 在 DL_LN_init 之后、主循环中调用
+ */
+uint8_t DL_LN_register_port_handler(DL_LN_t *dl, uint8_t port, DL_LN_port_handler_t handler)
+{
+    for (int i = 0; i < dl->handler_count; i++)
+    {
+        if (dl->handlers[i].port == port)
+        {
+            dl->handlers[i].handler = handler;
+            return 1;
+        }
+    }
+    if (dl->handler_count >= DL_LN_MAX_HANDLERS)
+    {
+        return 0;
+    }
+    dl->handlers[dl->handler_count].port = port;
+    dl->handlers[dl->handler_count].handler = handler;
+    dl->handler_count++;     // 最后加计数，中断里才会开始匹配
+    return 1;
+}
+
+/**
+ * @brief 查找数据端口处理函数
+ * @return 处理函数，没有登记返回 NULL
+ */
+static DL_LN_port_handler_t DL_LN_find_handler(DL_LN_t *dl, uint8_t port)
+{
+    for (int i = 0; i < dl->handler_count; i++)
+    {
+        if (dl->handlers[i].port == port)
+        {
+            return dl->handlers[i].handler;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 主循环调用：分发已到达的应答，处理超时，处理收到的数据包
+ *
+ * 回调都在这里执行，不在中断里，可以放心做格式化输出或发起下一个请求。
+ *
+ * @param dl 驱动实例，每个实例都要调用
+ */
+void DL_LN_poll(DL_LN_t *dl)
+{
+    uint32_t now = HAL_GetTick();
+    for (int i = 0; i < DL_LN_MAX_PENDING; i++)
+    {
+        DL_LN_request_t *req = &dl->pending[i];
+        uint8_t reply[DL_LN_REPLY_MAX];
+        uint8_t reply_length = 0;
+        uint8_t status;
+
+        // 关中断判断并释放请求槽，避免超时判断和接收中断同时改状态
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        if (req->state == REQUEST_REPLIED)
+        {
+            status = DL_LN_REPLY_OK;
+            reply_length = req->reply_length;
+            memcpy(reply, req->reply, reply_length);
+        }
+        else if (req->state == REQUEST_WAITING && (int32_t)(now - req->deadline) >= 0)
+        {
+            status = DL_LN_REPLY_TIMEOUT;
+        }
+        else
+        {
+            __set_PRIMASK(primask);
+            continue;
+        }
+        DL_LN_reply_callback_t callback = req->callback;
+        void *context = req->context;
+        req->state = REQUEST_FREE;  // 先释放，回调里可以发起同键的新请求
+        __set_PRIMASK(primask);
+
+        callback(dl, status, status == DL_LN_REPLY_OK ? reply : NULL, reply_length, context);
+    }
+
+    // 数据包：FE 长度 源端口 目标端口 源地址(2) 数据 FF
+    while (dl->rx_head != dl->rx_tail)
+    {
+        const uint8_t *frame = dl->rx_queue[dl->rx_head];
+        DL_LN_port_handler_t handler = DL_LN_find_handler(dl, frame[3]);
+        if (handler != NULL)
+        {
+            handler(dl, frame[2], frame[4] | (frame[5] << 8), &frame[6], frame[1] - 4);
+        }
+        dl->rx_head = (dl->rx_head + 1) % DL_LN_RX_QUEUE_LEN;  // 处理完再出队，中断不会覆盖
+    }
+
+    DL_LN_negotiate_step(dl);   // 波特率协商进行中时推进一步
+    DL_LN_tx_kick(dl);    // 发送曾因串口忙失败时在这里补发
+}
+
+/**
+ * @brief 收到完整帧后按（端口，命令字）查找等待中的请求
+ * @note 在接收中断中调用，只拷贝数据，不执行回调
+ */
+static void DL_LN_dispatch_frame(DL_LN_t *dl, const uint8_t *frame, uint16_t length)
+{
+    uint8_t port = frame[3];    // 应答发回请求帧的源端口
+    uint8_t cmd;
+    if (port == LINK_TEST_PORT)
+    {
+        cmd = LINK_TEST_KEY;
+    }
+    else if (port == READ_PORT || port == SET_PORT)
+    {
+        cmd = frame[6] - REPLY_CODE_OFFSET;
+    }
+    else
+    {
+        // 普通数据包，登记了处理函数的端口入队，交给主循环处理；队列满则丢弃
+        uint8_t next = (dl->rx_tail + 1) % DL_LN_RX_QUEUE_LEN;
+        if (DL_LN_find_handler(dl, port) != NULL && next != dl->rx_head)
+        {
+            memcpy(dl->rx_queue[dl->rx_tail], frame, length);
+            dl->rx_tail = next;
+        }
+        return;
+    }
+
+    for (int i = 0; i < DL_LN_MAX_PENDING; i++)
+    {
+        DL_LN_request_t *req = &dl->pending[i];
+        if (req->state == REQUEST_WAITING && req->port == port && req->cmd == cmd)
+        {
+            uint16_t copy = length < DL_LN_REPLY_MAX ? length : DL_LN_REPLY_MAX;
+            memcpy(req->reply, frame, copy);
+            req->reply_length = copy;
+            req->state = REQUEST_REPLIED;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief 向上位机输出一行信息
+ * @note 弱定义，可在别处重写为 printf、USB 等。默认从 PC_UART 异步发送，
+ *       与模块共用串口时走该实例的发送队列，避免和模块命令抢占串口
+ */
+__weak void DL_LN_report(DL_LN_t *dl, const char *message)
+{
+    static uint8_t PC_tx_buffer[100];    // 转发给上位机的数据缓冲区
+
+    if (PC_UART == NULL || PC_UART == dl->huart)
+    {
+        DL_LN_tx_enqueue(dl, (const uint8_t *)message, strlen(message));
+    }
+    else
+    {
+        strncpy((char *)PC_tx_buffer, message, sizeof(PC_tx_buffer) - 1);
+        PC_tx_buffer[sizeof(PC_tx_buffer) - 1] = '\0';
+        HAL_UART_Transmit_IT(PC_UART, PC_tx_buffer, strlen((char *)PC_tx_buffer));
+    }
+}
+
 /**
  * @brief 将波特率代码转换为实际波特率，就是波特率解码，参见手册
  * @param baud_code 波特率代码
@@ -122,111 +417,115 @@ uint8_t DL_LN_encode_baud_rate(uint32_t baud_rate) {
 
 
 /**
- * @brief 解析模块信息并根据当前状态依次读取和发送相关数据。
- * 
- * 该函数根据`read_state`的值逐步解析模块的波特率、模块地址、网络ID和频道信息。
- * 每读取一个数据后，更新`read_state`并发送相应的读取命令来获取下一个信息。
+ * @brief 解析模块信息应答并发送到上位机
+ *
+ * 作为 DL_LN_read 各读取请求的回调，应答帧第 6 字节为应答命令字，之后是参数（小端）。
+ * 由命令字区分是哪一项，应答乱序到达也不会解析错。
  */
-void DL_LN_parse_module_info() {
-    if (read_state == 4)
-    {read_state = 0;}   // 这代表上一次读取完了，再读取就要重置为0，重新开始了捏
+void DL_LN_parse_module_info(DL_LN_t *dl, uint8_t status, const uint8_t *frame, uint8_t length, void *context) {
+    char message[msg_length_to_PC];
+    uint8_t cmd = (uint8_t)(uintptr_t)context;
 
-    switch (read_state) {
-        case 0: {
-            // 解析波特率
-            uint8_t baud_code = DL_LN_rx_buffer[6];
-            uint32_t baud_rate = DL_LN_decode_baud_rate(baud_code);
-            char baud_rate_message[msg_length_to_PC];
-            if (baud_rate != 0) {
-                sprintf(baud_rate_message, "Baud Rate: %lu bps\r\n", baud_rate);
-            } else {
-                sprintf(baud_rate_message, "Baud Rate: Unknown Code 0x%02X\r\n", baud_code);
-            }
-            HAL_UART_Transmit_IT(DL_LN_UART, (uint8_t*)baud_rate_message, strlen(baud_rate_message));
+    if (status != DL_LN_REPLY_OK || length < 9) {
+        sprintf(message, "Read 0x%02X: no reply\r\n", cmd);
+        DL_LN_report(dl, message);
+        return;
+    }
 
-            // 更新状态为1，准备读取模块地址
-            read_state = 1;
-            DL_LN_send_command(READ_ADDRESS_CMD, 8);  // 继续发送下一个读取命令
-            break;
-        }
-        case 1: {
+    switch (cmd) {
+        case 0x01: {
             // 解析模块地址
-            uint16_t module_address = DL_LN_rx_buffer[7] | (DL_LN_rx_buffer[8] << 8);
-            char address_message[msg_length_to_PC];
-            sprintf(address_message, "Module Address: 0x%04X\r\n", module_address);
-            HAL_UART_Transmit_IT(DL_LN_UART, (uint8_t*)address_message, strlen(address_message));
-
-            // 更新状态为2，准备读取网络ID
-            read_state = 2;
-            DL_LN_send_command(READ_NETWORK_ID_CMD, 8);  // 继续发送下一个读取命令
+            uint16_t module_address = frame[7] | (frame[8] << 8);
+            sprintf(message, "Module Address: 0x%04X\r\n", module_address);
             break;
         }
-        case 2: {
+        case 0x02: {
             // 解析网络ID
-            uint16_t network_id = DL_LN_rx_buffer[7] | (DL_LN_rx_buffer[8] << 8);
-            char network_id_message[msg_length_to_PC];
-            sprintf(network_id_message, "Network ID: 0x%04X\r\n", network_id);
-            HAL_UART_Transmit_IT(DL_LN_UART, (uint8_t*)network_id_message, strlen(network_id_message));
-
-            // 更新状态为3，准备读取频道
-            read_state = 3;
-            DL_LN_send_command(READ_CHANNEL_CMD, 8);  // 继续发送下一个读取命令
+            uint16_t network_id = frame[7] | (frame[8] << 8);
+            sprintf(message, "Network ID: 0x%04X\r\n", network_id);
             break;
         }
-        case 3: {
+        case 0x03: {
             // 解析频道
-            uint8_t channel = DL_LN_rx_buffer[7];
-            char channel_message[msg_length_to_PC];
-            sprintf(channel_message, "Channel: 0x%02X\r\n", channel);
-            HAL_UART_Transmit_IT(DL_LN_UART, (uint8_t*)channel_message, strlen(channel_message));
-
-            // 更新状态为4，表示完成所有读取
-            read_state = 4;
+            sprintf(message, "Channel: 0x%02X\r\n", frame[7]);
             break;
         }
-        default:
+        case 0x04: {
+            // 解析波特率
+            uint8_t baud_code = frame[7];
+            uint32_t baud_rate = DL_LN_decode_baud_rate(baud_code);
+            if (baud_rate != 0) {
+                sprintf(message, "Baud Rate: %lu bps\r\n", (unsigned long)baud_rate);
+            } else {
+                sprintf(message, "Baud Rate: Unknown Code 0x%02X\r\n", baud_code);
+            }
             break;
+        }
+        default:
+            return;
     }
+    DL_LN_report(dl, message);
 }
 
 
 /**
  * @brief 发送命令到UART接口，使用异步传输。
- * 
- * 该函数通过UART接口异步发送给定的命令。它使用`HAL_UART_Transmit_IT`函数来传输命令数据，确保命令在后台被发送。
- * 
+ *
+ * 命令拷贝进发送队列，串口空闲时由中断依次发出，调用方的缓冲区可以立即复用。
+ *
+ * @param dl 驱动实例
  * @param command 发送的命令数据
  * @param length 命令数据的长度
  */
-void DL_LN_send_command(const uint8_t *command, uint8_t length) 
+void DL_LN_send_command(DL_LN_t *dl, const uint8_t *command, uint8_t length)
 {
-    HAL_UART_Transmit_IT(DL_LN_UART, (uint8_t *)command, length);  // 使用异步传输
+    DL_LN_tx_enqueue(dl, command, length);
 }
 
 /**
- * @brief 发送读取模块信息的命令并启动数据接收。
- * 
- * 该函数依次发送读取模块地址、网络ID、频道和波特率的命令，并启动UART的接收中断来接收返回的数据。
- * 每发送一个命令后，都会通过`HAL_UART_Receive_IT`启动接收，确保能够及时接收数据。
- * 
- * @note 该函数中的`HAL_Delay`用来在发送每个命令后等待一段时间，以确保模块能够处理命令。
+ * @brief 绑定串口并启动接收，使用模块前调用一次
+ *
+ * @param dl 驱动实例，由使用者静态分配，例如遥测、遥控各一个
+ * @param huart 模块连接的串口，每个实例一个
+ * @return 1 成功，0 实例数超过 DL_LN_MAX_INSTANCES 或该串口已被其他实例占用
  */
-void DL_LN_read() {
-    // 发送读取模块信息命令
-    DL_LN_send_command(READ_ADDRESS_CMD, 8);
-    HAL_UART_Receive_IT(DL_LN_UART, DL_LN_rx_buffer, sizeof(DL_LN_rx_buffer));  // 启动接收
-
-    HAL_Delay(5);
-    DL_LN_send_command(READ_NETWORK_ID_CMD, 8);
-    HAL_UART_Receive_IT(DL_LN_UART, DL_LN_rx_buffer, sizeof(DL_LN_rx_buffer));  // 启动接收
+uint8_t DL_LN_init(DL_LN_t *dl, UART_HandleTypeDef *huart)
+{
+    DL_LN_t *owner = DL_LN_find_instance(huart);
+    if (owner == NULL)
+    {
+        if (DL_LN_instance_count >= DL_LN_MAX_INSTANCES)
+        {
+            return 0;
+        }
+    }
+    else if (owner != dl)
+    {
+        return 0;
+    }
 
-    HAL_Delay(5);
-    DL_LN_send_command(READ_CHANNEL_CMD, 8);
-    HAL_UART_Receive_IT(DL_LN_UART, DL_LN_rx_buffer, sizeof(DL_LN_rx_buffer));  // 启动接收
+    memset(dl, 0, sizeof(*dl));
+    dl->huart = huart;
+    if (owner == NULL)
+    {
+        DL_LN_instances[DL_LN_instance_count++] = dl;   // 登记后中断回调才会找到它
+    }
+    HAL_UART_Receive_IT(dl->huart, &dl->rx_byte, 1);
+    return 1;
+}
 
-    HAL_Delay(5);
-    DL_LN_send_command(READ_BAUD_RATE_CMD, 8);
-    HAL_UART_Receive_IT(DL_LN_UART, DL_LN_rx_buffer, sizeof(DL_LN_rx_buffer));  // 启动接收
+/**
+ * @brief 发送读取模块信息的命令。
+ *
+ * 四条读取命令同时登记、依次入队，立即返回；应答到达后由 `DL_LN_parse_module_info` 输出到上位机。
+ *
+ * @note 原先每条命令之间 `HAL_Delay(5)`，上电配置会阻塞几十毫秒，现在不再阻塞。
+ */
+void DL_LN_read(DL_LN_t *dl) {
+    DL_LN_request(dl, READ_ADDRESS_CMD, sizeof(READ_ADDRESS_CMD), 0, DL_LN_parse_module_info, (void *)0x01);
+    DL_LN_request(dl, READ_NETWORK_ID_CMD, sizeof(READ_NETWORK_ID_CMD), 0, DL_LN_parse_module_info, (void *)0x02);
+    DL_LN_request(dl, READ_CHANNEL_CMD, sizeof(READ_CHANNEL_CMD), 0, DL_LN_parse_module_info, (void *)0x03);
+    DL_LN_request(dl, READ_BAUD_RATE_CMD, sizeof(READ_BAUD_RATE_CMD), 0, DL_LN_parse_module_info, (void *)0x04);
 }
 
 
@@ -234,87 +533,111 @@ void DL_LN_read() {
 
 /**
  * @brief 解析链路质量信息（RSSI），并将其发送到上位机。
- * 
- * 该函数从接收到的字节流中提取RSSI数据并将其转换为链路质量值。如果接收到的数据为`0x80`，则认为没有数据,存储为0
- * 然后将链路质量信息格式化为字符串，并通过UART异步发送给上位机。
+ *
+ * 作为链路质量测试请求的回调。该函数从应答帧中提取RSSI数据并将其转换为链路质量值。如果接收到的数据为`0x80`，则认为没有数据,存储为0
+ * 然后将链路质量信息格式化为字符串，发送给上位机。
  */
-void DL_LN_parse_link_quality()
+void DL_LN_parse_link_quality(DL_LN_t *dl, uint8_t status, const uint8_t *frame, uint8_t length, void *context)
 {
-    uint8_t rssi_data = DL_LN_rx_buffer[7];  // 接收到的信号强度指示（RSSI）数据
+    (void)context;
+    char message[msg_length_to_PC];
+    if (status != DL_LN_REPLY_OK || length < 9)
+    {
+        DL_LN_report(dl, "Link Quality: no reply\n");
+        return;
+    }
+
+    uint8_t rssi_data = frame[7];  // 接收到的信号强度指示（RSSI）数据
     int8_t link_quality = (rssi_data != 0x80) ? (int8_t)rssi_data : 0; // 0x80 表示无数据
 
     // 格式化链路质量信息并发送到上位机
-    char message[msg_length_to_PC];
-    int len = sprintf(message, "Link Quality: %d\n", link_quality);
-    HAL_UART_Transmit_IT(DL_LN_UART, (uint8_t*)message, len);  // 异步发送链路质量信息
+    sprintf(message, "Link Quality: %d\n", link_quality);
+    DL_LN_report(dl, message);
 }
 
 /**
- * @brief UART接收完成中断回调函数，根据接收到的数据类型进行相应处理。
- * 
- * 该函数会在每次UART接收完成时触发。它首先检查接收到的数据包头，然后根据不同的命令类型解析数据。
- * 如果是链路质量测试数据包，则调用`DL_LN_parse_link_quality`进行解析；如果是模块信息读取数据包，则调用`DL_LN_parse_module_info`进行解析。
+ * @brief UART接收完成中断回调函数，逐字节组帧。
+ *
+ * 该函数会在每收到一个字节时触发。先按串口找到对应的实例，按 包头0xFE、长度、内容、包尾0xFF 组帧，
+ * 收齐后交给 `DL_LN_dispatch_frame` 按（端口，命令字）匹配等待中的请求；包尾不对则丢弃重新找包头。
  * 在处理完成后，函数继续启动UART接收。
- * 
+ *
  * @param huart 指向UART处理结构体的指针
  */
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) {
-    // 判断是哪一个 UART 收到数据（如果有多个 UART，需要区分）
-    if (huart->Instance == DL_LN_UART) {
-        // 先检查包头来识别不同的命令类型
-        if (DL_LN_rx_buffer[0] == 0xFE) {
-            if (DL_LN_rx_buffer[3] == LINK_TEST_PORT) {
-                // 链路质量测试数据包
-                DL_LN_parse_link_quality();
-            } 
-            else if (DL_LN_rx_buffer[3] == READ_PORT) {
-                // 解析模块信息
-                DL_LN_parse_module_info();  // 根据当前状态解析信息
+    // 判断是哪一个模块收到数据，没有接模块的串口直接忽略
+    DL_LN_t *dl = DL_LN_find_instance(huart);
+    if (dl != NULL) {
+        uint8_t byte = dl->rx_byte;
+        if (dl->rx_length == 0) {
+            if (byte == 0xFE) {
+                dl->rx_buffer[dl->rx_length++] = byte;  // 包头
+            }
+        } else {
+            dl->rx_buffer[dl->rx_length++] = byte;
+            if (dl->rx_length == 2) {
+                dl->rx_expected = byte + 3;   // 包头 + 长度 + 内容 + 包尾
+                if (byte < 4 || dl->rx_expected > sizeof(dl->rx_buffer)) {
+                    dl->rx_length = 0;        // 长度不够端口和地址，或超出缓冲区，丢弃
+                }
+            } else if (dl->rx_length == dl->rx_expected) {
+                if (byte == 0xFF) {
+                    DL_LN_dispatch_frame(dl, dl->rx_buffer, dl->rx_length);
+                }
+                dl->rx_length = 0;
             }
         }
 
         // 继续接收数据
-        HAL_UART_Receive_IT(DL_LN_UART, DL_LN_rx_buffer, sizeof(DL_LN_rx_buffer));  // 继续接收
+        HAL_UART_Receive_IT(dl->huart, &dl->rx_byte, 1);  // 继续接收
+    }
+}
+
+/**
+ * @brief UART发送完成中断回调函数，释放队首并发送下一帧。
+ *
+ * @param huart 指向UART处理结构体的指针
+ */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+    DL_LN_t *dl = DL_LN_find_instance(huart);
+    if (dl != NULL) {
+        dl->tx_head = (dl->tx_head + 1) % DL_LN_TX_QUEUE_LEN;
+        dl->tx_busy = 0;
+        DL_LN_tx_kick(dl);
     }
 }
 
 /**
  * @brief 发送链路质量测试命令，测试模块之间的链路质量。
- * 
- * 该函数将两个模块的地址（以小端格式）写入链路质量测试命令数据包，并通过UART接口发送该数据包。
- * 数据包的发送使用`HAL_UART_Transmit_IT`异步传输方式，确保链路质量测试命令被成功传输。
- * 
+ *
+ * 该函数将两个模块的地址（以小端格式）写入链路质量测试命令数据包，并登记应答。
+ * 应答到达后由 `DL_LN_parse_link_quality` 输出到上位机。
+ *
+ * @param dl 驱动实例
  * @param module_1_address 第一个模块的地址
  * @param module_2_address 第二个模块的地址
  */
-void DL_LN_link_quality_test(uint16_t module_1_address, uint16_t module_2_address) {
+void DL_LN_link_quality_test(DL_LN_t *dl, uint16_t module_1_address, uint16_t module_2_address) {
+    uint8_t command[] = {0xFE, 0x06, LINK_TEST_PORT, LINK_LOCAL_PORT, 0x00, 0x00, 0x00, 0x00, 0xFF};
+
     // 发送模块B的地址（小端格式）
-    LINK_QUALITY_TEST[4] = module_1_address & 0xFF;        // 小端格式：低字节
-    LINK_QUALITY_TEST[5] = (module_1_address >> 8) & 0xFF; // 小端格式：高字节
-    
+    command[4] = module_1_address & 0xFF;        // 小端格式：低字节
+    command[5] = (module_1_address >> 8) & 0xFF; // 小端格式：高字节
+
     // 发送模块C的地址（小端格式）
-    LINK_QUALITY_TEST[6] = module_2_address & 0xFF;        // 小端格式：低字节
-    LINK_QUALITY_TEST[7] = (module_2_address >> 8) & 0xFF; // 小端格式：高字节
+    command[6] = module_2_address & 0xFF;        // 小端格式：低字节
+    command[7] = (module_2_address >> 8) & 0xFF; // 小端格式：高字节
 
     // 发送数据包
-    HAL_UART_Transmit_IT(DL_LN_UART, tx_buffer, sizeof(tx_buffer));
+    DL_LN_request(dl, command, sizeof(command), 0, DL_LN_parse_link_quality, NULL);
 }
 
 /***************************************DL-LN信息设置相关函数****************************************************/
 
-/**
- * @brief 异步发送命令数据到 DL-LN 模块。
- * 
- * @param command 指向待发送数据的指针。
- * @param length 数据长度（字节数）。
- */
-void DL_LN_send_command(const uint8_t *command, uint8_t length) {
-    HAL_UART_Transmit_IT(DL_LN_UART, (uint8_t *)command, length);  // 异步发送
-}
-
 /**
  * @brief 设置 DL-LN 模块的各种参数。
- * 
+ *
+ * @param dl 驱动实例
  * @param mode 配置模式，指定要设置的参数类型。
  *             - SET_ADDRESS_MODE: 设置模块地址
  *             - SET_NETWORK_ID_MODE: 设置网络 ID
@@ -323,39 +646,44 @@ void DL_LN_send_command(const uint8_t *command, uint8_t length) {
  * @param param1 参数 1，根据不同 mode 有不同意义：
  *               - 地址或网络 ID 时为 16 位值（低字节为 param1 & 0xFF，高字节为 param1 >> 8）
  *               - 信道时为信道号（单字节）
- * @param param2 参数 2，仅用于设置波特率时传入波特率值（如 9600）。
+ * @param param2 参数 2，仅用于设置波特率时传入波特率值（如 115200），不支持的值不发送。
+ * @note 设置在重启后生效，改波特率后本地串口也要跟着改，建议直接用 DL_LN_negotiate_baud
  */
-void DL_LN_set(uint8_t mode, uint16_t param1, uint8_t param2) {
-    memset(SET_CMD_ADR_ID, 0, sizeof(SET_CMD_ADR_ID));  // 清空缓冲区
-    memset(SET_CMD_CH_BPS, 0, sizeof(SET_CMD_CH_BPS));  // 清空缓冲区
+void DL_LN_set(DL_LN_t *dl, uint8_t mode, uint16_t param1, uint32_t param2) {
+    uint8_t adr_id[] = {0xFE, 0x07, SET_PORT, LOCAL_PORT, LOCAL_ADDRESS, LOCAL_ADDRESS, 0x00, 0x00, 0x00, 0xFF};
+    uint8_t ch_bps[] = {0xFE, 0x06, SET_PORT, LOCAL_PORT, LOCAL_ADDRESS, LOCAL_ADDRESS, 0x00, 0x00, 0xFF};
 
     switch (mode) {
         case SET_ADDRESS_MODE:  // 设置地址
-            SET_CMD_ADR_ID[6] = SET_ADDRESS_CMD;  // 命令字
-            SET_CMD_ADR_ID[7] = param1 & 0xFF;  // 地址低字节
-            SET_CMD_ADR_ID[8] = (param1 >> 8) & 0xFF;  // 地址高字节
-            DL_LN_send_command(SET_CMD_ADR_ID, sizeof(SET_CMD_ADR_ID));
+            adr_id[6] = SET_ADDRESS_CMD;  // 命令字
+            adr_id[7] = param1 & 0xFF;  // 地址低字节
+            adr_id[8] = (param1 >> 8) & 0xFF;  // 地址高字节
+            DL_LN_send_command(dl, adr_id, sizeof(adr_id));
             break;
 
         case SET_NETWORK_ID_MODE:  // 设置网络ID
-            SET_CMD_ADR_ID[6] = SET_NETWORK_ID_CMD;  // 命令字
-            SET_CMD_ADR_ID[7] = param1 & 0xFF;  // 网络ID低字节
-            SET_CMD_ADR_ID[8] = (param1 >> 8) & 0xFF;  // 网络ID高字节
-            DL_LN_send_command(SET_CMD_ADR_ID, sizeof(SET_CMD_ADR_ID));
+            adr_id[6] = SET_NETWORK_ID_CMD;  // 命令字
+            adr_id[7] = param1 & 0xFF;  // 网络ID低字节
+            adr_id[8] = (param1 >> 8) & 0xFF;  // 网络ID高字节
+            DL_LN_send_command(dl, adr_id, sizeof(adr_id));
             break;
 
         case SET_CHANNEL_MODE:  // 设置信道
-            SET_CMD_CH_BPS[6] = SET_CHANNEL_CMD;  // 命令字
-            SET_CMD_CH_BPS[7] = param1;  // 新信道值
-            DL_LN_send_command(SET_CMD_CH_BPS, sizeof(SET_CMD_CH_BPS));
+            ch_bps[6] = SET_CHANNEL_CMD;  // 命令字
+            ch_bps[7] = param1;  // 新信道值
+            DL_LN_send_command(dl, ch_bps, sizeof(ch_bps));
             break;
 
-        case SET_BAUD_RATE_MODE:  // 设置波特率
+        case SET_BAUD_RATE_MODE: {  // 设置波特率
             uint8_t bps_encoded = DL_LN_encode_baud_rate(param2);
-            SET_CMD_CH_BPS[6] = SET_BAUD_RATE_CMD;  // 命令字
-            SET_CMD_CH_BPS[7] = bps_encoded;  // 新波特率值
-            DL_LN_send_command(SET_CMD_CH_BPS, sizeof(SET_CMD_CH_BPS));
+            if (bps_encoded == 0xFF) {
+                break;  // 模块不支持该波特率
+            }
+            ch_bps[6] = SET_BAUD_RATE_CMD;  // 命令字
+            ch_bps[7] = bps_encoded;  // 新波特率值
+            DL_LN_send_command(dl, ch_bps, sizeof(ch_bps));
             break;
+        }
 
         default:
             // 如果传入了无效的 mode，什么也不做
@@ -366,55 +694,469 @@ void DL_LN_set(uint8_t mode, uint16_t param1, uint8_t param2) {
 /**
  * @brief 发送重启命令以使模块生效最新设置。
  */
-void DL_LN_restart() {
-    DL_LN_send_command(RESTART, sizeof(RESTART));
+void DL_LN_restart(DL_LN_t *dl) {
+    DL_LN_send_command(dl, RESTART, sizeof(RESTART));
 }
 
 /***************************************DL-LN信息设置相关函数****************************************************/
 
 /**
  * @brief 封装数据包并发送
- * 
+ *
+ * @param dl 驱动实例
  * @param send_port 发送端口
  * @param recv_port 接收端口
  * @param target_address 目标地址（大端模式输入）例如0x1234
- * @param data 包内容指针
+ * @param data 包内容指针，字符串，长度按 strlen 计算
  */
-void DL_LN_send_packet(uint8_t send_port, uint8_t recv_port, uint16_t target_address, const uint8_t *data) {
-    
-    // 数据内容长度
-    uint8_t data_length = strlen((const char *)data); // 计算数据长度
-    if (data_length > (MAX_PACKET_SIZE - 7)) {
+void DL_LN_send_packet(DL_LN_t *dl, uint8_t send_port, uint8_t recv_port, uint16_t target_address, const uint8_t *data) {
+    uint16_t data_length = strlen((const char *)data); // 计算数据长度
+    if (data_length > 0xFF) {
         return; // 数据长度超出限制
     }
+    DL_LN_send_data(dl, send_port, recv_port, target_address, data, data_length);
+}
+
+/**
+ * @brief 封装二进制数据包并发送，数据里可以有 0x00
+ *
+ * @param dl 驱动实例
+ * @param send_port 发送端口
+ * @param recv_port 接收端口
+ * @param target_address 目标地址（大端模式输入）例如0x1234
+ * @param data 包内容指针
+ * @param length 包内容长度
+ * @return 1 已入队，0 长度超限或发送队列已满
+ */
+uint8_t DL_LN_send_data(DL_LN_t *dl, uint8_t send_port, uint8_t recv_port, uint16_t target_address,
+                        const uint8_t *data, uint8_t length) {
+    uint8_t packet[DL_LN_MAX_PACKET];
 
-    // 初始化数据包缓冲区
-    uint8_t SEND_MSG[MAX_PACKET_SIZE];
-    memset(SEND_MSG, 0, MAX_PACKET_SIZE);
+    // 数据内容长度
+    uint16_t data_length = length;
+    if (data_length > (DL_LN_MAX_PACKET - 7) || data_length > 0xFF - 4) {
+        return 0; // 数据长度超出限制
+    }
 
     // 包头
-    SEND_MSG[0] = 0xFE;
+    packet[0] = 0xFE;
 
     // 数据长度（自动计算从第3位到包尾前一位的字节数）
     uint8_t packet_length = 1 + 1+ 2 + data_length; // 发送端口(1) + 接收端口(1) + 目标地址(2) + 数据长度
-    SEND_MSG[1] = packet_length;
+    packet[1] = packet_length;
 
     // 发送端口
-    SEND_MSG[2] = send_port;
+    packet[2] = send_port;
 
     // 接收端口
-    SEND_MSG[3] = recv_port;
+    packet[3] = recv_port;
 
     // 目标地址（小端模式存储）
-    SEND_MSG[4] = target_address & 0xFF;        // 低字节
-    SEND_MSG[5] = (target_address >> 8) & 0xFF; // 高字节
+    packet[4] = target_address & 0xFF;        // 低字节
+    packet[5] = (target_address >> 8) & 0xFF; // 高字节
 
     // 数据内容
-    memcpy(&SEND_MSG[6], data, data_length);
+    memcpy(&packet[6], data, data_length);
 
     // 包尾
-    SEND_MSG[6 + data_length] = 0xFF;
+    packet[6 + data_length] = 0xFF;
+
+    // 拷贝进发送队列，packet 在栈上，出函数即可释放
+    return DL_LN_tx_enqueue(dl, packet, 7 + data_length);
+}
+
+/***************************************DL-LN波特率协商相关函数****************************************************/
+
+/**
+ * @brief 协商步骤
+ *
+ * 升级：SET 在当前波特率下发设置 -> RESTART 重启 -> WAIT 等模块上线后切本地串口 -> VERIFY 往返验证，
+ *       成功则记为可用并尝试下一级，失败进入回退。
+ * 回退：FALLBACK_SET / FALLBACK_RESTART 在当前（不可靠的）波特率下把模块设回最近一次可用的波特率，
+ *       FALLBACK_WAIT 后切回本地串口，CONFIRM 验证；仍不通则 SCAN 逐个波特率读模块，找到后再回退。
+ */
+enum
+{
+    NEG_IDLE = 0,
+    NEG_SET,
+    NEG_RESTART,
+    NEG_WAIT,
+    NEG_VERIFY,
+    NEG_FALLBACK_SET,
+    NEG_FALLBACK_RESTART,
+    NEG_FALLBACK_WAIT,
+    NEG_CONFIRM,
+    NEG_SCAN,
+};
+
+// 模块支持的波特率，按速度升序，与 DL_LN_encode_baud_rate 的代码表对应
+static const uint32_t DL_LN_baud_ladder[] = {2400, 4800, 9600, 14400, 19200, 28800, 38400,
+                                             57600, 115200, 125000, 230400, 250000, 500000};
+#define DL_LN_BAUD_LEVELS (sizeof(DL_LN_baud_ladder) / sizeof(DL_LN_baud_ladder[0]))
+
+/**
+ * @brief 保存协商出的波特率
+ * @note 弱定义，默认只向上位机输出。可重写为写 Flash，下次上电按保存的波特率初始化串口，
+ *       模块自身会在重启时保存设置
+ */
+__weak void DL_LN_baud_save(DL_LN_t *dl, uint32_t baud_rate)
+{
+    char message[msg_length_to_PC];
+    sprintf(message, "Baud Rate: %lu bps\r\n", (unsigned long)baud_rate);
+    DL_LN_report(dl, message);
+}
+
+/**
+ * @brief 切换本地串口波特率，重新启动接收
+ * @note HAL_UART_Init 对已初始化的串口只重新配置，不会重复调用 MspInit
+ */
+static void DL_LN_apply_baud(DL_LN_t *dl, uint32_t baud_rate)
+{
+    if (dl->huart->Init.BaudRate == baud_rate)
+    {
+        return;
+    }
+    HAL_UART_AbortReceive(dl->huart);
+    dl->huart->Init.BaudRate = baud_rate;
+    HAL_UART_Init(dl->huart);
+    dl->rx_length = 0;  // 旧波特率下收了一半的帧作废
+    HAL_UART_Receive_IT(dl->huart, &dl->rx_byte, 1);
+}
+
+/**
+ * @brief 协商请求的应答回调，只检查应答是否完整有效，结果留给 DL_LN_negotiate_step 处理
+ */
+static void DL_LN_negotiate_reply(DL_LN_t *dl, uint8_t status, const uint8_t *frame, uint8_t length, void *context)
+{
+    DL_LN_negotiation_t *neg = &dl->negotiation;
+    uint8_t expected_code = (uint8_t)(uintptr_t)context;   // 读波特率时期望的代码，0xFF 表示不限
+
+    uint8_t ok = (status == DL_LN_REPLY_OK);
+    if (ok && neg->expect == 0)
+    {
+        // 链路测试应答：FE 06 23 85 地址 RSSI RSSI FF，任一方向 RSSI 为 0x80（无数据）说明往返丢了，探测失败
+        ok = (length == 9 && frame[2] == LINK_LOCAL_PORT && frame[6] != 0x80 && frame[7] != 0x80);
+    }
+    else if (ok)
+    {
+        ok = (length >= 8 && frame[2] == LOCAL_PORT && frame[6] == neg->expect);
+        if (ok && neg->expect == READ_BAUD_RATE_CMD[6] + REPLY_CODE_OFFSET)
+        {
+            ok = (length == 9 && DL_LN_decode_baud_rate(frame[7]) != 0
+                  && (expected_code == 0xFF || frame[7] == expected_code));
+        }
+    }
+    neg->ok = ok;
+    neg->waiting = 0;
+}
+
+/**
+ * @brief 发出本步骤的请求
+ * @param expect 期望的应答命令字，链路测试为 0
+ * @param expected_code 读波特率时期望的代码，0xFF 表示不限
+ */
+static void DL_LN_negotiate_issue(DL_LN_t *dl, const uint8_t *command, uint8_t length, uint8_t expect, uint8_t expected_code)
+{
+    DL_LN_negotiation_t *neg = &dl->negotiation;
+    neg->expect = expect;
+    neg->waiting = 1;
+    if (DL_LN_request(dl, command, length, DL_LN_NEGOTIATE_TIMEOUT, DL_LN_negotiate_reply,
+                      (void *)(uintptr_t)expected_code))
+    {
+        neg->issued = 1;
+    }
+    else
+    {
+        neg->waiting = 0;   // 队列满，下次 poll 再发
+    }
+}
+
+/**
+ * @brief 设置模块波特率
+ */
+static void DL_LN_negotiate_set(DL_LN_t *dl, uint8_t level)
+{
+    uint8_t command[] = {0xFE, 0x06, SET_PORT, LOCAL_PORT, LOCAL_ADDRESS, LOCAL_ADDRESS, SET_BAUD_RATE_CMD, 0x00, 0xFF};
+    command[7] = DL_LN_encode_baud_rate(DL_LN_baud_ladder[level]);
+    DL_LN_negotiate_issue(dl, command, sizeof(command), SET_BAUD_RATE_CMD + REPLY_CODE_OFFSET, 0xFF);
+}
+
+/**
+ * @brief 验证一次往返：有对端时做链路测试，否则读本地模块的波特率并核对
+ */
+static void DL_LN_negotiate_probe(DL_LN_t *dl, uint8_t level)
+{
+    DL_LN_negotiation_t *neg = &dl->negotiation;
+    if (neg->peer != 0)
+    {
+        uint8_t command[] = {0xFE, 0x06, LINK_TEST_PORT, LINK_LOCAL_PORT, LOCAL_ADDRESS, LOCAL_ADDRESS,
+                             neg->peer & 0xFF, (neg->peer >> 8) & 0xFF, 0xFF};
+        DL_LN_negotiate_issue(dl, command, sizeof(command), 0, 0xFF);
+    }
+    else
+    {
+        DL_LN_negotiate_issue(dl, READ_BAUD_RATE_CMD, sizeof(READ_BAUD_RATE_CMD),
+                              READ_BAUD_RATE_CMD[6] + REPLY_CODE_OFFSET,
+                              DL_LN_encode_baud_rate(DL_LN_baud_ladder[level]));
+    }
+}
+
+/**
+ * @brief 协商结束：保存结果并回调
+ */
+static void DL_LN_negotiate_finish(DL_LN_t *dl, uint8_t status)
+{
+    DL_LN_negotiation_t *neg = &dl->negotiation;
+    uint32_t baud_rate = dl->huart->Init.BaudRate;
+    neg->state = NEG_IDLE;
+    if (status == DL_LN_REPLY_OK)
+    {
+        DL_LN_baud_save(dl, baud_rate);
+    }
+    if (neg->done != NULL)
+    {
+        neg->done(dl, status, baud_rate, neg->context);
+    }
+}
+
+/**
+ * @brief 进入回退：在当前波特率下把模块设回最近一次可用的波特率
+ */
+static void DL_LN_negotiate_fall_back(DL_LN_t *dl)
+{
+    DL_LN_negotiation_t *neg = &dl->negotiation;
+    if (++neg->fallbacks > DL_LN_NEGOTIATE_FALLBACKS)
+    {
+        DL_LN_negotiate_finish(dl, DL_LN_REPLY_TIMEOUT);
+        return;
+    }
+    neg->state = NEG_FALLBACK_SET;
+    neg->retries = 0;
+}
 
-    // 通过 UART 发送数据包
-    HAL_UART_Transmit_IT(DL_LN_UART, SEND_MSG, 7 + data_length);
-}
\ No newline at end of file
+/**
+ * @brief 进入扫描：按从快到慢逐个波特率读模块，找出模块实际所在的波特率
+ */
+static void DL_LN_negotiate_start_scan(DL_LN_t *dl)
+{
+    DL_LN_negotiation_t *neg = &dl->negotiation;
+    neg->state = NEG_SCAN;
+    neg->scan = DL_LN_BAUD_LEVELS - 1;
+    neg->retries = 0;
+}
+
+/**
+ * @brief 推进协商，每次 DL_LN_poll 调用一次，有请求在等应答时直接返回
+ */
+static void DL_LN_negotiate_step(DL_LN_t *dl)
+{
+    DL_LN_negotiation_t *neg = &dl->negotiation;
+    if (neg->state == NEG_IDLE || neg->waiting)
+    {
+        return;
+    }
+
+    uint8_t ok = neg->ok;
+    uint8_t issued = neg->issued;
+    neg->issued = 0;
+
+    switch (neg->state)
+    {
+    case NEG_SET:
+    case NEG_FALLBACK_SET:
+    {
+        uint8_t level = (neg->state == NEG_SET) ? neg->index : neg->best;
+        if (!issued)
+        {
+            DL_LN_negotiate_set(dl, level);
+        }
+        else if (ok)
+        {
+            neg->state = (neg->state == NEG_SET) ? NEG_RESTART : NEG_FALLBACK_RESTART;
+            neg->retries = 0;
+        }
+        else if (++neg->retries < DL_LN_NEGOTIATE_RETRIES)
+        {
+            DL_LN_negotiate_set(dl, level);
+        }
+        else if (neg->state == NEG_SET)
+        {
+            DL_LN_negotiate_finish(dl, DL_LN_REPLY_OK);     // 模块不接受新设置，停在当前已验证的波特率
+        }
+        else
+        {
+            DL_LN_negotiate_start_scan(dl);     // 当前波特率下说不上话，找模块在哪
+        }
+        break;
+    }
+
+    case NEG_RESTART:
+    case NEG_FALLBACK_RESTART:
+        if (!issued)
+        {
+            DL_LN_negotiate_issue(dl, RESTART, sizeof(RESTART), RESTART_CMD + REPLY_CODE_OFFSET, 0xFF);
+        }
+        else if (!ok && ++neg->retries < DL_LN_NEGOTIATE_RETRIES)
+        {
+            DL_LN_negotiate_issue(dl, RESTART, sizeof(RESTART), RESTART_CMD + REPLY_CODE_OFFSET, 0xFF);
+        }
+        else
+        {
+            // 应答丢了也可能已经重启，统一等待后由验证决定
+            neg->wait_until = HAL_GetTick() + DL_LN_RESTART_MS;
+            neg->state = (neg->state == NEG_RESTART) ? NEG_WAIT : NEG_FALLBACK_WAIT;
+        }
+        break;
+
+    case NEG_WAIT:
+    case NEG_FALLBACK_WAIT:
+        if ((int32_t)(HAL_GetTick() - neg->wait_until) < 0 || dl->tx_busy || dl->tx_head != dl->tx_tail)
+        {
+            break;  // 等模块上线，且本地发送队列清空后再切换
+        }
+        DL_LN_apply_baud(dl, DL_LN_baud_ladder[neg->state == NEG_WAIT ? neg->index : neg->best]);
+        neg->state = (neg->state == NEG_WAIT) ? NEG_VERIFY : NEG_CONFIRM;
+        neg->probes = 0;
+        neg->probes_ok = 0;
+        break;
+
+    case NEG_VERIFY:
+    case NEG_CONFIRM:
+    {
+        uint8_t level = (neg->state == NEG_VERIFY) ? neg->index : neg->best;
+        if (issued)
+        {
+            neg->probes++;
+            neg->probes_ok += ok;
+        }
+        if (neg->probes < DL_LN_NEGOTIATE_PROBES && neg->probes == neg->probes_ok)
+        {
+            DL_LN_negotiate_probe(dl, level);   // 有一次失败就不用再测了
+            break;
+        }
+
+        uint8_t reliable = (neg->probes_ok == DL_LN_NEGOTIATE_PROBES);
+        if (neg->state == NEG_CONFIRM)
+        {
+            if (reliable)
+            {
+                DL_LN_negotiate_finish(dl, DL_LN_REPLY_OK);
+            }
+            else
+            {
+                DL_LN_negotiate_start_scan(dl);
+            }
+        }
+        else if (!reliable)
+        {
+            DL_LN_negotiate_fall_back(dl);
+        }
+        else
+        {
+            neg->best = neg->index;
+            if (neg->index < neg->top)
+            {
+                neg->index++;
+                neg->state = NEG_SET;
+                neg->retries = 0;
+            }
+            else
+            {
+                DL_LN_negotiate_finish(dl, DL_LN_REPLY_OK);
+            }
+        }
+        break;
+    }
+
+    case NEG_SCAN:
+        if (issued && ok)
+        {
+            // 找到模块了
+            if (neg->scan == neg->best)
+            {
+                DL_LN_negotiate_finish(dl, DL_LN_REPLY_OK);
+            }
+            else
+            {
+                DL_LN_negotiate_fall_back(dl);
+            }
+            break;
+        }
+        if (issued && ++neg->retries >= DL_LN_NEGOTIATE_RETRIES)
+        {
+            neg->retries = 0;
+            if (neg->scan == 0)
+            {
+                DL_LN_negotiate_finish(dl, DL_LN_REPLY_TIMEOUT);    // 所有波特率都不应答
+                break;
+            }
+            neg->scan--;
+        }
+        if (dl->tx_busy || dl->tx_head != dl->tx_tail)
+        {
+            break;
+        }
+        DL_LN_apply_baud(dl, DL_LN_baud_ladder[neg->scan]);
+        DL_LN_negotiate_issue(dl, READ_BAUD_RATE_CMD, sizeof(READ_BAUD_RATE_CMD),
+                              READ_BAUD_RATE_CMD[6] + REPLY_CODE_OFFSET,
+                              DL_LN_encode_baud_rate(DL_LN_baud_ladder[neg->scan]));
+        break;
+
+    default:
+        neg->state = NEG_IDLE;
+        break;
+    }
+}
+
+/**
+ * @brief 把模块和本地串口协商到最快的可靠波特率，立即返回
+ *
+ * 从本地串口当前的波特率开始逐级提高：每级先用 SET_BAUD_RATE_CMD + 重启让模块换波特率，再切换本地串口，
+ * 连续 DL_LN_NEGOTIATE_PROBES 次往返全部成功才算可靠，然后尝试下一级。某级不可靠就把模块设回上一级；
+ * 设回也失败时逐个波特率扫描找到模块再设回。结束后调用 DL_LN_baud_save 保存并回调 done。
+ *
+ * @param dl 驱动实例，本地串口当前必须能和模块正常通信
+ * @param peer_address 验证用链路测试的对端地址，同时检验空中链路；0 表示只读本地模块
+ * @param max_baud 允许的最高波特率，受单片机串口时钟限制
+ * @param done 结束回调，可为 NULL
+ * @param context 回调的用户指针
+ * @return 1 已开始，0 已在协商中或当前波特率不在模块支持的列表里
+ * @note 协商期间不要通过该实例发送其他数据，主循环要持续调用 DL_LN_poll
+ */
+uint8_t DL_LN_negotiate_baud(DL_LN_t *dl, uint16_t peer_address, uint32_t max_baud,
+                             DL_LN_baud_callback_t done, void *context)
+{
+    DL_LN_negotiation_t *neg = &dl->negotiation;
+    if (neg->state != NEG_IDLE)
+    {
+        return 0;
+    }
+
+    uint8_t current = DL_LN_BAUD_LEVELS;
+    uint8_t top = 0;
+    for (uint8_t level = 0; level < DL_LN_BAUD_LEVELS; level++)
+    {
+        if (DL_LN_baud_ladder[level] == dl->huart->Init.BaudRate)
+        {
+            current = level;
+        }
+        if (DL_LN_baud_ladder[level] <= max_baud)
+        {
+            top = level;
+        }
+    }
+    if (current == DL_LN_BAUD_LEVELS)
+    {
+        return 0;
+    }
+
+    memset(neg, 0, sizeof(*neg));
+    neg->peer = peer_address;
+    neg->done = done;
+    neg->context = context;
+    neg->best = current;
+    neg->index = current;
+    neg->top = top;
+    neg->state = NEG_VERIFY;    // 先验证当前波特率，确认起点可靠
+    return 1;
+}
@@ -11,8 +11,8 @@
  * @author 万鹏 7415 (2789152534@qq.com)
  * @date 2024-11-28 21:56:15
  * @brief 应用库，无线自组网通讯模块，基于DL-LN32P
- * @version 0.1
- * @note
+ * @version 0.3
+ * @note 每个模块对应一个 DL_LN_t 实例，多个模块接在不同串口上可同时使用
 */
 
 
@@ -20,22 +20,164 @@
 #define DL_LN_H
 
 #include <stdint.h>  // 为了声明 uint8_t
+#include "usart.h"   // 为了声明 UART_HandleTypeDef
 
 #define SET_ADDRESS_MODE        0x01  // 设置地址模式
 #define SET_NETWORK_ID_MODE     0x02  // 设置网络 ID 模式
 #define SET_CHANNEL_MODE        0x03  // 设置信道模式
 #define SET_BAUD_RATE_MODE      0x04  // 设置波特率模式
 
+// 请求应答状态
+#define DL_LN_REPLY_OK          0x00  // 收到对应应答
+#define DL_LN_REPLY_TIMEOUT     0x01  // 超时未收到应答
+
+// 驱动实例配置，决定 DL_LN_t 的大小（每个实例约 3.6 KB）
+#define DL_LN_MAX_INSTANCES     4     // 同时使用的模块数
+#define DL_LN_MAX_PACKET        256   // 最大包长
+#define DL_LN_MAX_PENDING       8     // 同时等待应答的请求数
+#define DL_LN_TX_QUEUE_LEN      8     // 发送队列深度
+#define DL_LN_RX_QUEUE_LEN      4     // 数据包接收队列深度
+#define DL_LN_REPLY_MAX         32    // 应答帧保存长度，配置类应答不超过 10 字节
+#define DL_LN_MAX_HANDLERS      4     // 可登记的数据端口数
+
+typedef struct DL_LN_t DL_LN_t;
+
+/**
+ * @brief 请求应答回调，在 DL_LN_poll 中（主循环上下文）调用
+ * @param dl 发起请求的驱动实例
+ * @param status DL_LN_REPLY_OK 或 DL_LN_REPLY_TIMEOUT
+ * @param frame 完整应答帧（从包头 0xFE 开始），超时时为 NULL
+ * @param length 应答帧长度
+ * @param context 发起请求时传入的用户指针
+ */
+typedef void (*DL_LN_reply_callback_t)(DL_LN_t *dl, uint8_t status, const uint8_t *frame, uint8_t length, void *context);
+
+/**
+ * @brief 数据端口处理函数，其他节点发到本机某端口的数据包在 DL_LN_poll 中（主循环上下文）交给它
+ * @param dl 收到数据包的驱动实例，回复时用同一个实例
+ * @param src_port 对方的发送端口，回复时作为接收端口
+ * @param src_address 对方模块地址
+ * @param data 数据内容（不含包头、端口、地址、包尾）
+ * @param length 数据长度
+ */
+typedef void (*DL_LN_port_handler_t)(DL_LN_t *dl, uint8_t src_port, uint16_t src_address, const uint8_t *data, uint8_t length);
+
+/**
+ * @brief 波特率协商结束回调，在 DL_LN_poll 中（主循环上下文）调用
+ * @param dl 协商的驱动实例
+ * @param status DL_LN_REPLY_OK 停在已验证的波特率；DL_LN_REPLY_TIMEOUT 与模块失去联系
+ * @param baud_rate 结束时本地串口的波特率
+ * @param context 发起协商时传入的用户指针
+ */
+typedef void (*DL_LN_baud_callback_t)(DL_LN_t *dl, uint8_t status, uint32_t baud_rate, void *context);
+
+/**
+ * @brief 等待应答的请求
+ *
+ * 匹配键为（端口，命令字）：端口是请求帧的源端口，模块会把应答发回这个端口；
+ * 命令字是请求帧数据区第一个字节，应答的命令字为其加 0x20。
+ */
+typedef struct
+{
+    volatile uint8_t state;
+    uint8_t port;
+    uint8_t cmd;
+    uint32_t deadline;                      // HAL_GetTick() 超过该值视为超时
+    DL_LN_reply_callback_t callback;
+    void *context;
+    uint8_t reply[DL_LN_REPLY_MAX];
+    uint8_t reply_length;
+} DL_LN_request_t;
+
+/**
+ * @brief 数据端口处理函数表项
+ */
+typedef struct
+{
+    uint8_t port;
+    DL_LN_port_handler_t handler;
+} DL_LN_port_entry_t;
+
+/**
+ * @brief 波特率协商状态，由 DL_LN_poll 推进
+ */
+typedef struct
+{
+    uint8_t state;                          // 当前步骤，0 表示空闲
+    uint8_t index;                          // 正在尝试的波特率（升序表下标）
+    uint8_t best;                           // 已验证可用的最快波特率
+    uint8_t top;                            // 允许尝试的最高波特率
+    uint8_t scan;                           // 失联后逐个扫描的波特率
+    uint8_t issued;                         // 本步骤的请求已发出
+    volatile uint8_t waiting;               // 请求在等应答
+    uint8_t ok;                             // 最近一次请求的应答是否有效
+    uint8_t expect;                         // 期望的应答命令字，链路测试为 0
+    uint8_t retries;                        // 本步骤已重试次数
+    uint8_t probes;                         // 已发出的验证次数
+    uint8_t probes_ok;                      // 验证成功次数
+    uint8_t fallbacks;                      // 已回退次数
+    uint16_t peer;                          // 链路测试对端地址，0 表示只读本地模块
+    uint32_t wait_until;                    // 等待模块重启完成的时刻
+    DL_LN_baud_callback_t done;
+    void *context;
+} DL_LN_negotiation_t;
+
+/**
+ * @brief 驱动实例，每个模块一个，各自的串口、组帧状态、请求表、收发队列互不相干
+ * @note 成员只由驱动内部使用，定义在这里是为了让使用者静态分配
+ */
+struct DL_LN_t
+{
+    UART_HandleTypeDef *huart;              // 模块连接的串口
+
+    // 接收组帧
+    uint8_t rx_byte;                        // 单字节接收
+    uint8_t rx_buffer[DL_LN_MAX_PACKET];    // 组帧缓冲区
+    uint16_t rx_length;                     // 已收到的字节数
+    uint16_t rx_expected;                   // 本帧总长度
+
+    // 等待应答的请求
+    DL_LN_request_t pending[DL_LN_MAX_PENDING];
+
+    // 发送队列，帧内容拷贝进队列，发送完成中断里发下一帧
+    uint8_t tx_queue[DL_LN_TX_QUEUE_LEN][DL_LN_MAX_PACKET];
+    uint16_t tx_length[DL_LN_TX_QUEUE_LEN];
+    volatile uint8_t tx_head;               // 下一个待发送
+    volatile uint8_t tx_tail;               // 下一个空位
+    volatile uint8_t tx_busy;               // 串口正在发送
+
+    // 数据端口处理函数表
+    DL_LN_port_entry_t handlers[DL_LN_MAX_HANDLERS];
+    uint8_t handler_count;
+
+    // 数据包接收队列，接收中断入队，DL_LN_poll 出队交给处理函数
+    uint8_t rx_queue[DL_LN_RX_QUEUE_LEN][DL_LN_MAX_PACKET];
+    volatile uint8_t rx_head;               // 下一个待处理
+    volatile uint8_t rx_tail;               // 下一个空位
+
+    // 波特率协商
+    DL_LN_negotiation_t negotiation;
+};
 
 // 函数声明
-void DL_LN_parse_link_quality(void);  // 解析链路质量信息并发送到上位机
-void DL_LN_parse_module_info(void);   // 解析模块信息并发送到上位机
+uint8_t DL_LN_init(DL_LN_t *dl, UART_HandleTypeDef *huart);  // 绑定串口并启动接收，使用前调用一次
+void DL_LN_poll(DL_LN_t *dl);  // 主循环中调用，分发应答、处理超时和收到的数据包
+uint8_t DL_LN_request(DL_LN_t *dl, const uint8_t *command, uint8_t length, uint16_t timeout_ms,
+                      DL_LN_reply_callback_t callback, void *context);  // 发送命令并登记应答
+uint8_t DL_LN_register_port_handler(DL_LN_t *dl, uint8_t port, DL_LN_port_handler_t handler);  // 登记数据端口处理函数
+void DL_LN_report(DL_LN_t *dl, const char *message);  // 向上位机输出信息，弱定义，可按需重写
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);  // UART接收完成回调函数
-void DL_LN_send_command(const uint8_t *command, uint8_t length);  // 发送命令到UART接口
-void DL_LN_read(void);  // 读取模块信息
-void DL_LN_link_quality_test(uint16_t module_1_address, uint16_t module_2_address);  // 执行链路质量测试
-void DL_LN_set_module_param(uint8_t mode, uint16_t param1, uint8_t param2);
-void DL_LN_restart();
-void DL_LN_send_packet(uint8_t send_port, uint8_t recv_port, uint16_t target_address, const uint8_t *data)
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);  // UART发送完成回调函数
+void DL_LN_send_command(DL_LN_t *dl, const uint8_t *command, uint8_t length);  // 发送命令到UART接口
+void DL_LN_read(DL_LN_t *dl);  // 读取模块信息
+void DL_LN_link_quality_test(DL_LN_t *dl, uint16_t module_1_address, uint16_t module_2_address);  // 执行链路质量测试
+void DL_LN_set(DL_LN_t *dl, uint8_t mode, uint16_t param1, uint32_t param2);
+void DL_LN_restart(DL_LN_t *dl);
+void DL_LN_send_packet(DL_LN_t *dl, uint8_t send_port, uint8_t recv_port, uint16_t target_address, const uint8_t *data);
+uint8_t DL_LN_send_data(DL_LN_t *dl, uint8_t send_port, uint8_t recv_port, uint16_t target_address,
+                        const uint8_t *data, uint8_t length);
+uint8_t DL_LN_negotiate_baud(DL_LN_t *dl, uint16_t peer_address, uint32_t max_baud,
+                             DL_LN_baud_callback_t done, void *context);  // 协商到最快的可靠波特率
+void DL_LN_baud_save(DL_LN_t *dl, uint32_t baud_rate);  // 保存协商结果，弱定义，可重写为写 Flash
 
 #endif /* DL_LN_H */
@@ -0,0 +1,278 @@
+/**
+ * @file param.c
+ * @author 万鹏 7415 (2789152534@qq.com)
+ * @date 2026-10-19 10:12:40
+ * @brief 应用库，在线调参服务，通过DL-LN批量读写已登记的PID增益和浮点参数
+ * @version 0.1
+ * @note 写端（主循环）维护一份最新参数表，每批设置整表拷进三槽快照的空闲槽后发布；
+ *       读端（控制中断）在 param_tick 中取走最新一槽写回各个 pid_t 和 float。
+ *       一批设置要么整批生效，要么整批丢弃，同一节拍内的各个 PID 用的是同一批参数
+*/
+
+#include "string.h"
+#include "stdint.h"
+#include "param.h"
+#include "DL-LN.h"
+
+#define PARAM_REPLY_MAX 251     // 应答数据最大长度，DL-LN 一帧数据区上限
+
+/**
+ * @brief 已登记的参数
+ */
+typedef struct
+{
+    uint8_t id;
+    uint8_t type;       // PARAM_TYPE_PID 或 PARAM_TYPE_FLOAT
+    void *target;       // pid_t* 或 float*
+} param_entry_t;
+
+param_entry_t param_table[PARAM_MAX];
+uint8_t param_count = 0;
+
+float param_shadow[PARAM_MAX][3];                   // 写端的最新参数表，只在主循环访问
+float param_slot[SNAPSHOT_SLOTS][PARAM_MAX][3];     // 三槽快照，读端只读取走的槽
+snapshot_index_t param_index;
+
+/**
+ * @brief 参数类型对应的值个数
+ */
+static uint8_t param_value_count(uint8_t type)
+{
+    switch (type) {
+        case PARAM_TYPE_PID: return 3;
+        case PARAM_TYPE_FLOAT: return 1;
+        default: return 0;
+    }
+}
+
+/**
+ * @brief 按 ID 查找参数
+ * @return 参数在表中的下标，没有登记返回 -1
+ */
+static int param_find(uint8_t id)
+{
+    for (int k = 0; k < param_count; k++)
+    {
+        if (param_table[k].id == id)
+            return k;
+    }
+    return -1;
+}
+
+/**
+ * @brief 登记参数，最新值从目标处读取
+ * @return 1 登记成功，0 表满或 ID 重复
+ */
+static uint8_t param_register(uint8_t id, uint8_t type, void *target)
+{
+    if (param_count >= PARAM_MAX || param_find(id) >= 0)
+        return 0;
+
+    param_entry_t *entry = &param_table[param_count];
+    entry->id = id;
+    entry->type = type;
+    entry->target = target;
+
+    if (type == PARAM_TYPE_PID) {
+        pid_t *pid = (pid_t *)target;
+        param_shadow[param_count][0] = pid->p;
+        param_shadow[param_count][1] = pid->i;
+        param_shadow[param_count][2] = pid->d;
+    } else {
+        param_shadow[param_count][0] = *(float *)target;
+    }
+    param_count++;
+    return 1;
+}
+
+/**
+ * @brief 登记 PID，之后可以按 ID 读写它的 p/i/d
+ *
+ * @param id 参数 ID，上位机按它寻址
+ * @param pid 已经 PID_struct_init 过的控制器
+ * @return 1 登记成功，0 表满或 ID 重复
+ * @note 在控制中断启动前调用。登记后请通过本服务改增益，不要再直接调用 pid_dynamic_set，
+ *       否则下一批设置会用本服务记录的值覆盖
+ */
+uint8_t param_register_pid(uint8_t id, pid_t *pid)
+{
+    return param_register(id, PARAM_TYPE_PID, pid);
+}
+
+/**
+ * @brief 登记浮点参数，例如限幅、前馈系数
+ *
+ * @param id 参数 ID
+ * @param value 参数地址，控制中断读取它
+ * @return 1 登记成功，0 表满或 ID 重复
+ * @note 在控制中断启动前调用
+ */
+uint8_t param_register_float(uint8_t id, float *value)
+{
+    return param_register(id, PARAM_TYPE_FLOAT, value);
+}
+
+/**
+ * @brief 把写端的最新参数表整表发布给控制中断
+ */
+static void param_publish(void)
+{
+    uint8_t slot = snapshot_write_slot(&param_index);
+    memcpy(param_slot[slot], param_shadow, sizeof(param_shadow[0]) * param_count);
+    snapshot_publish(&param_index, slot);
+}
+
+/**
+ * @brief 主循环中本地设置单个参数
+ *
+ * @param id 参数 ID
+ * @param values 参数值，PID 为 {p, i, d}，浮点参数为 {x}
+ * @return PARAM_OK 或 PARAM_ERR_ID
+ */
+uint8_t param_set(uint8_t id, const float *values)
+{
+    int k = param_find(id);
+    if (k < 0)
+        return PARAM_ERR_ID;
+
+    memcpy(param_shadow[k], values, sizeof(float) * param_value_count(param_table[k].type));
+    param_publish();
+    return PARAM_OK;
+}
+
+/**
+ * @brief 处理批量设置：先整批校验，全部合法才写入并发布
+ * @return PARAM_OK、PARAM_ERR_ID 或 PARAM_ERR_FORMAT
+ */
+static uint8_t param_handle_set(const uint8_t *entries, uint8_t length, uint8_t n)
+{
+    // 第一遍只校验，每项的值都要完整落在消息内。pos 用 16 位，一批 PID 超过 255 字节时 8 位会回绕
+    uint16_t pos = 0;
+    for (uint8_t e = 0; e < n; e++)
+    {
+        if (pos >= length)
+            return PARAM_ERR_FORMAT;
+        int k = param_find(entries[pos]);
+        if (k < 0)
+            return PARAM_ERR_ID;
+        pos += 1 + 4 * param_value_count(param_table[k].type);
+        if (pos > length)
+            return PARAM_ERR_FORMAT;
+    }
+    if (pos != length)
+        return PARAM_ERR_FORMAT;
+
+    // 第二遍写入最新参数表，再整表发布
+    pos = 0;
+    for (uint8_t e = 0; e < n; e++)
+    {
+        int k = param_find(entries[pos]);
+        uint8_t values = param_value_count(param_table[k].type);
+        memcpy(param_shadow[k], &entries[pos + 1], 4 * values);    // 小端浮点，与 Cortex-M 一致
+        pos += 1 + 4 * values;
+    }
+    param_publish();
+    return PARAM_OK;
+}
+
+/**
+ * @brief 处理一条批量读写消息，生成应答
+ *
+ * 读取返回的是最近一次设置的值（写端参数表），控制中断最迟下一个节拍用上。
+ *
+ * @param request 消息数据区
+ * @param length 消息长度
+ * @param reply 应答缓冲区，至少 PARAM_REPLY_MAX 字节
+ * @return 应答长度，0 表示消息太短不应答
+ * @note 在主循环中调用
+ */
+uint8_t param_handle(const uint8_t *request, uint8_t length, uint8_t *reply)
+{
+    if (length < 3)
+        return 0;
+
+    uint8_t op = request[0];
+    uint8_t n = request[2];
+    reply[0] = op | PARAM_OP_REPLY;
+    reply[1] = request[1];  // 序号原样带回，上位机据此匹配应答
+
+    if (op == PARAM_OP_SET) {
+        reply[2] = param_handle_set(&request[3], length - 3, n);
+        reply[3] = reply[2] == PARAM_OK ? n : 0;
+        return 4;
+    }
+
+    if (op != PARAM_OP_GET || length - 3 < n) {
+        reply[2] = PARAM_ERR_FORMAT;
+        reply[3] = 0;
+        return 4;
+    }
+
+    uint8_t pos = 3;
+    uint8_t done = 0;
+    for (; done < n; done++)
+    {
+        int k = param_find(request[3 + done]);
+        uint8_t type = k < 0 ? PARAM_TYPE_NONE : param_table[k].type;
+        uint8_t values = param_value_count(type);
+        if (pos + 2 + 4 * values > PARAM_REPLY_MAX)
+            break;  // 应答放不下，只回前面的，上位机按个数补读
+
+        reply[pos++] = request[3 + done];
+        reply[pos++] = type;
+        if (values) {
+            memcpy(&reply[pos], param_shadow[k], 4 * values);
+            pos += 4 * values;
+        }
+    }
+    reply[2] = done;
+    return pos;
+}
+
+/**
+ * @brief DL-LN 数据端口处理函数，处理完原路应答
+ */
+static void param_on_message(DL_LN_t *dl, uint8_t src_port, uint16_t src_address, const uint8_t *data, uint8_t length)
+{
+    uint8_t reply[PARAM_REPLY_MAX];
+    uint8_t reply_length = param_handle(data, length, reply);
+    if (reply_length)
+        DL_LN_send_data(dl, PARAM_PORT, src_port, src_address, reply, reply_length);
+}
+
+/**
+ * @brief 启动调参服务，在指定模块上登记 PARAM_PORT 数据端口
+ * @param dl 已 DL_LN_init 的驱动实例，多个模块时可以分别登记，应答从收到请求的模块发回
+ * @note 在参数登记完成后、主循环开始前调用，主循环里要持续调用 DL_LN_poll
+ */
+void param_init(DL_LN_t *dl)
+{
+    DL_LN_register_port_handler(dl, PARAM_PORT, param_on_message);
+}
+
+/**
+ * @brief 换入最新一批参数
+ *
+ * 在控制中断的节拍开始处、所有 PID 计算之前调用。没有新参数时只读一个字节就返回。
+ *
+ * @note 只在控制中断中调用
+ */
+void param_tick(void)
+{
+    uint8_t slot = snapshot_take(&param_index);
+    if (slot == SNAPSHOT_NONE)
+        return;
+
+    for (int k = 0; k < param_count; k++)
+    {
+        const float *values = param_slot[slot][k];
+        if (param_table[k].type == PARAM_TYPE_PID) {
+            pid_t *pid = (pid_t *)param_table[k].target;
+            pid->p = values[0];
+            pid->i = values[1];
+            pid->d = values[2];
+        } else {
+            *(float *)param_table[k].target = values[0];
+        }
+    }
+}
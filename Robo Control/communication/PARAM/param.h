@@ -0,0 +1,53 @@
+/**
+ * @file param.h
+ * @author 万鹏 7415 (2789152534@qq.com)
+ * @date 2026-10-19 10:12:40
+ * @brief 应用库，在线调参服务，通过DL-LN批量读写已登记的PID增益和浮点参数
+ * @version 0.1
+ * @note 主循环收到的设置先整批写进三槽快照，控制中断在节拍开始调用 param_tick 整批换入，
+ *       控制环不加锁，也不会看到写了一半的参数
+*/
+
+#ifndef PARAM_H
+#define PARAM_H
+
+#include <stdint.h>  // 为了声明 uint8_t
+#include "pid.h"     // 为了声明 pid_t
+#include "DL-LN.h"   // 为了声明 DL_LN_t
+
+#define PARAM_PORT          0x31  // 调参服务端口，不要和 DL-LN 的配置端口冲突
+#define PARAM_MAX           32    // 最多可登记的参数个数
+
+// 参数类型
+#define PARAM_TYPE_NONE     0x00  // 未登记
+#define PARAM_TYPE_PID      0x01  // pid_t，值为 {p, i, d}
+#define PARAM_TYPE_FLOAT    0x02  // float，值为 {x}
+
+// 消息操作码，应答操作码 = 请求操作码 | PARAM_OP_REPLY
+#define PARAM_OP_GET        0x01  // 批量读取
+#define PARAM_OP_SET        0x02  // 批量设置
+#define PARAM_OP_REPLY      0x80
+
+// 设置结果
+#define PARAM_OK            0x00  // 整批已发布，下一个控制节拍生效
+#define PARAM_ERR_ID        0x01  // 有未登记的 ID，整批丢弃
+#define PARAM_ERR_FORMAT    0x02  // 长度不对或操作码未知，整批丢弃
+
+/*
+ * 消息格式（DL-LN 数据区，浮点数为小端 IEEE754）：
+ *   读取请求  01 seq n id*n
+ *   读取应答  81 seq n {id type 值*k}*n      k 由 type 决定，未登记的 ID 类型为 00、没有值
+ *   设置请求  02 seq n {id 值*k}*n            k 由本机登记的类型决定
+ *   设置应答  82 seq status n
+ * 一帧数据最多 251 字节，一次最多设置 19 个 PID。
+ */
+
+// 函数声明
+uint8_t param_register_pid(uint8_t id, pid_t *pid);        // 登记 PID，初始化阶段调用
+uint8_t param_register_float(uint8_t id, float *value);    // 登记浮点参数，初始化阶段调用
+void param_init(DL_LN_t *dl);                              // 在指定模块上登记数据端口
+uint8_t param_set(uint8_t id, const float *values);        // 主循环中本地设置单个参数
+uint8_t param_handle(const uint8_t *request, uint8_t length, uint8_t *reply);  // 处理一条批量消息
+void param_tick(void);                                     // 控制中断节拍开始时调用，换入最新参数
+
+#endif /* PARAM_H */
@@ -0,0 +1,918 @@
+/**
+ * @file dl_ln_emulator.c
+ * @date 2026-10-19 10:12:40
+ * @brief 上位机工具，DL-LN32P 无线自组网模块仿真器（Linux）
+ * @version 0.2
+ * @note
+ * 每个虚拟节点对应一个伪终端（pty），驱动或串口助手直接打开对应的 /dev/pts/N 即可，
+ * 不需要真实模块。仿真内容与 DL-LN.c 使用到的命令集保持一致：
+ * - 0x21 配置端口：读取（0x01~0x04）与设置（0x11~0x14）地址、网络 ID、信道、波特率，0x10 重启
+ * - 0x23 链路测试端口：由指定模块向另一模块发起往返测试，返回双向 RSSI
+ * - 其他端口：按目标地址在同网络、同信道的节点之间转发（0xFFFF 为广播）
+ *
+ * 设置命令只修改待生效配置，收到重启命令后模块离线 restart_ms，再统一生效，和真实模块一致。
+ * 空中链路可注入时延/抖动、带宽限制、丢包与乱序，串口输出按模块当前波特率限速。
+ * 串口可按波特率注入误码（-e），并可检查上位机波特率与模块是否一致（-m），不一致时收发都是乱码。
+ * 空中丢包也可以按模块波特率另加（-L），模拟高波特率下空中链路不可靠的模块。
+ *
+ * 编译：gcc -O2 -Wall -o dl_ln_emulator dl_ln_emulator.c
+ * 用法：./dl_ln_emulator -n 3 -l 5 -j 2 -p 0.01 -r 0.05 -d /tmp/dlln
+ *       之后 /tmp/dlln0、/tmp/dlln1、/tmp/dlln2 分别指向三个节点的串口
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <asm/termbits.h>   // termios2，可读取任意波特率；不要与 <termios.h> 同时包含
+
+/***************************************协议定义（与 DL-LN.c 保持一致）****************************************************/
+
+#define FRAME_HEAD              0xFE
+#define FRAME_TAIL              0xFF
+#define MAX_FRAME_BODY          255     // 长度字节能表示的最大内容长度
+#define MAX_FRAME_SIZE          (MAX_FRAME_BODY + 3)
+
+#define CONFIG_SERVICE_PORT     0x21    // 模块内部配置端口
+#define LINK_SERVICE_PORT       0x23    // 模块内部链路测试端口
+
+#define LOCAL_ADDRESS           0x0000  // 目标地址为 0 表示本地模块
+#define BROADCAST_ADDRESS       0xFFFF
+
+#define RESTART_CMD             0x10
+#define READ_CMD_FIRST          0x01    // 0x01 地址，0x02 网络ID，0x03 信道，0x04 波特率
+#define READ_CMD_LAST           0x04
+#define SET_CMD_FIRST           0x11    // 0x11 地址，0x12 网络ID，0x13 信道，0x14 波特率
+#define SET_CMD_LAST            0x14
+#define REPLY_CODE_OFFSET       0x20    // 应答命令字 = 请求命令字 + 0x20
+#define RSSI_NO_DATA            0x80    // RSSI 无数据
+
+#define BAUD_CODE_COUNT         13      // 波特率代码 0x00~0x0C
+#define MAX_NODES               64
+#define MAX_EVENTS              4096
+
+/***************************************仿真参数****************************************************/
+
+typedef struct
+{
+    int node_count;
+    uint16_t base_address;      // 第 k 个节点地址为 base_address + k
+    uint16_t network_id;
+    uint8_t channel;
+    uint8_t baud_code;          // 模块初始波特率代码
+    double latency_ms;          // 空中单程时延
+    double jitter_ms;           // 时延抖动（均匀分布 ±jitter）
+    double air_bandwidth;       // 每个信道的空中带宽，字节/秒，0 表示不限
+    double loss;                // 丢包概率
+    double reorder;             // 乱序概率：被选中的包额外延迟 reorder_delay_ms
+    double reorder_delay_ms;
+    int rssi_dbm;               // 链路测试基准 RSSI
+    double restart_ms;          // 重启离线时间
+    double baud_error[BAUD_CODE_COUNT]; // 各波特率下串口每字节误码概率，按波特率代码索引
+    double baud_loss[BAUD_CODE_COUNT];  // 模块工作在各波特率时另加的空中丢包概率，按波特率代码索引
+    int baud_check;             // 非 0 时检查上位机串口波特率，与模块不一致则收发乱码
+    unsigned int seed;
+    const char *link_prefix;    // 非空时创建 <prefix><k> 软链接指向各节点的 pty
+    int verbose;
+} emu_config_t;
+
+typedef struct
+{
+    int master_fd;
+    int slave_fd;               // 保持打开，避免无客户端时 master 读到 EIO
+    char slave_name[64];
+
+    /* 当前生效配置 */
+    uint16_t address;
+    uint16_t network_id;
+    uint8_t channel;
+    uint8_t baud_code;
+
+    /* 待生效配置，重启后复制到当前配置 */
+    uint16_t pending_address;
+    uint16_t pending_network_id;
+    uint8_t pending_channel;
+    uint8_t pending_baud_code;
+
+    uint64_t offline_until_us;  // 重启期间不收不发
+    uint64_t uart_free_us;      // 串口输出按波特率排队
+
+    /* 串口接收解析 */
+    uint8_t rx_frame[MAX_FRAME_SIZE];
+    int rx_len;
+    int rx_expected;
+
+    /* 统计 */
+    unsigned long uart_in_frames;
+    unsigned long uart_out_frames;
+    unsigned long uart_overruns;
+    unsigned long radio_lost;
+    unsigned long bad_frames;
+    unsigned long bit_errors;
+    unsigned long baud_mismatch_bytes;
+} emu_node_t;
+
+/**
+ * @brief 事件类型：串口输出一帧，或一帧空中数据到达某节点
+ */
+typedef enum
+{
+    EVENT_UART_OUT = 0,
+    EVENT_RADIO_ARRIVE,
+    EVENT_RESTART_DONE,
+} emu_event_type_t;
+
+typedef struct
+{
+    uint64_t time_us;
+    uint64_t order;             // 同一时刻按入队顺序处理
+    emu_event_type_t type;
+    int node;                   // 目标节点
+    int from;                   // 空中帧的发送节点
+    int len;
+    uint8_t data[MAX_FRAME_SIZE];
+} emu_event_t;
+
+static emu_config_t cfg = {
+    .node_count = 2,
+    .base_address = 0x0001,
+    .network_id = 0x0001,
+    .channel = 0x0B,
+    .baud_code = 0x08,          // 115200
+    .latency_ms = 2.0,
+    .jitter_ms = 0.0,
+    .air_bandwidth = 0.0,
+    .loss = 0.0,
+    .reorder = 0.0,
+    .reorder_delay_ms = 10.0,
+    .rssi_dbm = -45,
+    .restart_ms = 200.0,
+    .seed = 1,
+    .link_prefix = NULL,
+    .verbose = 0,
+};
+
+static emu_node_t nodes[MAX_NODES];
+static emu_event_t *events[MAX_EVENTS];     // 最小堆，按 (time_us, order) 排序
+static int event_count = 0;
+static uint64_t event_order = 0;
+static uint64_t air_free_us[256];           // 每个信道空中占用到的时间
+static volatile sig_atomic_t running = 1;
+
+/***************************************工具函数****************************************************/
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ull + (uint64_t)ts.tv_nsec / 1000ull;
+}
+
+static double rand_unit(void)
+{
+    return (double)rand() / ((double)RAND_MAX + 1.0);
+}
+
+/**
+ * @brief 波特率代码解码，与 DL_LN_decode_baud_rate 相同
+ */
+static uint32_t decode_baud_rate(uint8_t baud_code)
+{
+    static const uint32_t table[] = {2400, 4800, 9600, 14400, 19200, 28800, 38400,
+                                     57600, 115200, 230400, 125000, 250000, 500000};
+    return baud_code < sizeof(table) / sizeof(table[0]) ? table[baud_code] : 0;
+}
+
+/**
+ * @brief 波特率编码，不支持的波特率返回 0xFF
+ */
+static uint8_t encode_baud_rate(uint32_t baud)
+{
+    for (uint8_t code = 0; code < BAUD_CODE_COUNT; code++)
+        if (decode_baud_rate(code) == baud)
+            return code;
+    return 0xFF;
+}
+
+/**
+ * @brief 上位机当前设置的波特率，从 pty 从端读取
+ */
+static uint32_t host_baud_rate(int node)
+{
+    struct termios2 tio;
+    if (ioctl(nodes[node].slave_fd, TCGETS2, &tio) != 0)
+        return 0;
+    return tio.c_ospeed;
+}
+
+/**
+ * @brief 模拟串口线路：波特率不一致时每个字节都是乱码，否则按当前波特率的误码概率翻转一位
+ * @return 0 波特率不一致，1 一致（可能有误码）
+ */
+static int uart_line(int node, uint8_t *bytes, int count)
+{
+    emu_node_t *n = &nodes[node];
+    if (cfg.baud_check && host_baud_rate(node) != decode_baud_rate(n->baud_code))
+    {
+        for (int i = 0; i < count; i++)
+            bytes[i] = (uint8_t)(rand() & 0xFF);
+        n->baud_mismatch_bytes += count;
+        return 0;
+    }
+    double error = cfg.baud_error[n->baud_code];
+    for (int i = 0; i < count && error > 0; i++)
+    {
+        if (rand_unit() < error)
+        {
+            bytes[i] ^= (uint8_t)(1u << (rand() % 8));
+            n->bit_errors++;
+        }
+    }
+    return 1;
+}
+
+static void dump_frame(const char *tag, int node, const uint8_t *data, int len)
+{
+    if (!cfg.verbose)
+        return;
+    fprintf(stderr, "[%d] %s:", node, tag);
+    for (int i = 0; i < len; i++)
+        fprintf(stderr, " %02X", data[i]);
+    fprintf(stderr, "\n");
+}
+
+/***************************************事件队列****************************************************/
+
+static int event_before(const emu_event_t *a, const emu_event_t *b)
+{
+    return a->time_us < b->time_us || (a->time_us == b->time_us && a->order < b->order);
+}
+
+static emu_event_t *event_alloc(emu_event_type_t type, uint64_t time_us, int node)
+{
+    if (event_count >= MAX_EVENTS)
+        return NULL;    // 队列满视为拥塞丢弃
+    emu_event_t *ev = malloc(sizeof(emu_event_t));
+    if (ev == NULL)
+        return NULL;
+    ev->type = type;
+    ev->time_us = time_us;
+    ev->order = event_order++;
+    ev->node = node;
+    ev->from = -1;
+    ev->len = 0;
+    return ev;
+}
+
+static void event_push(emu_event_t *ev)
+{
+    int i = event_count++;
+    events[i] = ev;
+    while (i > 0)
+    {
+        int parent = (i - 1) / 2;
+        if (!event_before(events[i], events[parent]))
+            break;
+        emu_event_t *tmp = events[i];
+        events[i] = events[parent];
+        events[parent] = tmp;
+        i = parent;
+    }
+}
+
+static emu_event_t *event_pop(void)
+{
+    emu_event_t *top = events[0];
+    events[0] = events[--event_count];
+    int i = 0;
+    for (;;)
+    {
+        int l = 2 * i + 1, r = l + 1, m = i;
+        if (l < event_count && event_before(events[l], events[m]))
+            m = l;
+        if (r < event_count && event_before(events[r], events[m]))
+            m = r;
+        if (m == i)
+            break;
+        emu_event_t *tmp = events[i];
+        events[i] = events[m];
+        events[m] = tmp;
+        i = m;
+    }
+    return top;
+}
+
+/***************************************帧收发****************************************************/
+
+/**
+ * @brief 组帧：FE 长度 源端口 目的端口 地址(小端) 数据 FF
+ * @return 帧总长度
+ */
+static int build_frame(uint8_t *out, uint8_t src_port, uint8_t dst_port, uint16_t address,
+                       const uint8_t *data, int data_len)
+{
+    out[0] = FRAME_HEAD;
+    out[1] = (uint8_t)(4 + data_len);
+    out[2] = src_port;
+    out[3] = dst_port;
+    out[4] = address & 0xFF;
+    out[5] = (address >> 8) & 0xFF;
+    memcpy(&out[6], data, data_len);
+    out[6 + data_len] = FRAME_TAIL;
+    return 7 + data_len;
+}
+
+/**
+ * @brief 模块通过串口向上位机输出一帧，按模块当前波特率排队限速
+ */
+static void uart_send_after(int node, const uint8_t *frame, int len, uint64_t delay_us)
+{
+    emu_node_t *n = &nodes[node];
+    uint64_t now = now_us() + delay_us;
+    uint32_t baud = decode_baud_rate(n->baud_code);
+    uint64_t start = n->uart_free_us > now ? n->uart_free_us : now;
+    uint64_t duration = baud ? (uint64_t)len * 10ull * 1000000ull / baud : 0;    // 8N1，每字节 10 位
+    n->uart_free_us = start + duration;
+
+    emu_event_t *ev = event_alloc(EVENT_UART_OUT, n->uart_free_us, node);
+    if (ev == NULL)
+    {
+        n->uart_overruns++;
+        return;
+    }
+    memcpy(ev->data, frame, len);
+    ev->len = len;
+    event_push(ev);
+}
+
+static void uart_send(int node, const uint8_t *frame, int len)
+{
+    uart_send_after(node, frame, len, 0);
+}
+
+static int same_network(int a, int b)
+{
+    return nodes[a].network_id == nodes[b].network_id && nodes[a].channel == nodes[b].channel;
+}
+
+/**
+ * @brief 节点发出或收到一次空中传输的丢包概率：基础丢包叠加该节点当前波特率的丢包
+ */
+static double air_loss(int node)
+{
+    return 1.0 - (1.0 - cfg.loss) * (1.0 - cfg.baud_loss[nodes[node].baud_code]);
+}
+
+/**
+ * @brief 空中发送一帧，按信道带宽占用、时延、抖动、丢包、乱序排入到达事件
+ * @param frame 空中帧，地址字段为发送方地址，到达后可以直接输出或交给服务端口
+ */
+static void radio_send_after(int from, int to, const uint8_t *frame, int len, uint64_t delay_us)
+{
+    if (rand_unit() < air_loss(from))
+    {
+        nodes[from].radio_lost++;
+        return;
+    }
+
+    uint64_t now = now_us() + delay_us;
+    uint64_t depart = now;
+    if (cfg.air_bandwidth > 0)
+    {
+        uint64_t *air = &air_free_us[nodes[from].channel];
+        depart = *air > now ? *air : now;
+        *air = depart + (uint64_t)(len * 1e6 / cfg.air_bandwidth);
+        depart = *air;
+    }
+
+    double delay_ms = cfg.latency_ms;
+    if (cfg.jitter_ms > 0)
+        delay_ms += (rand_unit() * 2.0 - 1.0) * cfg.jitter_ms;
+    if (cfg.reorder > 0 && rand_unit() < cfg.reorder)
+        delay_ms += cfg.reorder_delay_ms;
+    if (delay_ms < 0)
+        delay_ms = 0;
+
+    emu_event_t *ev = event_alloc(EVENT_RADIO_ARRIVE, depart + (uint64_t)(delay_ms * 1000.0), to);
+    if (ev == NULL)
+    {
+        nodes[from].radio_lost++;
+        return;
+    }
+    ev->from = from;
+    memcpy(ev->data, frame, len);
+    ev->len = len;
+    event_push(ev);
+}
+
+static void radio_send(int from, int to, const uint8_t *frame, int len)
+{
+    radio_send_after(from, to, frame, len, 0);
+}
+
+static int find_node(uint16_t address, int near)
+{
+    for (int k = 0; k < cfg.node_count; k++)
+        if (nodes[k].address == address && same_network(k, near))
+            return k;
+    return -1;
+}
+
+/***************************************模块内部服务****************************************************/
+
+/**
+ * @brief 模拟链路 RSSI，基准值加 ±3dB 随机扰动
+ */
+static uint8_t link_rssi(void)
+{
+    int rssi = cfg.rssi_dbm + (int)(rand_unit() * 7.0) - 3;
+    if (rssi < -127)
+        rssi = -127;
+    return (uint8_t)(int8_t)rssi;
+}
+
+/**
+ * @brief 配置服务：读取、设置、重启
+ * @param node 执行命令的模块
+ * @param reply 应答数据（命令字 + 参数）
+ * @return 应答数据长度，0 表示不应答
+ */
+static int config_service(int node, const uint8_t *data, int data_len, uint8_t *reply)
+{
+    emu_node_t *n = &nodes[node];
+    if (data_len < 1)
+        return 0;
+    uint8_t cmd = data[0];
+    reply[0] = cmd + REPLY_CODE_OFFSET;
+
+    switch (cmd)
+    {
+    case 0x01:
+        reply[1] = n->address & 0xFF;
+        reply[2] = (n->address >> 8) & 0xFF;
+        return 3;
+    case 0x02:
+        reply[1] = n->network_id & 0xFF;
+        reply[2] = (n->network_id >> 8) & 0xFF;
+        return 3;
+    case 0x03:
+        reply[1] = n->channel;
+        return 2;
+    case 0x04:
+        reply[1] = n->baud_code;
+        return 2;
+    case 0x11:
+    case 0x12:
+        if (data_len < 3)
+            return 0;
+        if (cmd == 0x11)
+            n->pending_address = data[1] | (data[2] << 8);
+        else
+            n->pending_network_id = data[1] | (data[2] << 8);
+        return 1;
+    case 0x13:
+    case 0x14:
+        if (data_len < 2)
+            return 0;
+        if (cmd == 0x13)
+            n->pending_channel = data[1];
+        else if (decode_baud_rate(data[1]) != 0)
+            n->pending_baud_code = data[1];
+        return 1;
+    case RESTART_CMD:
+        return 1;   // 先应答，再离线
+    default:
+        return 0;
+    }
+}
+
+static void start_restart(int node)
+{
+    /* 应答先从串口发完，离线时间从应答发送完毕开始算 */
+    uint64_t start = nodes[node].uart_free_us > now_us() ? nodes[node].uart_free_us : now_us();
+    uint64_t done = start + (uint64_t)(cfg.restart_ms * 1000.0);
+    nodes[node].offline_until_us = done;
+    emu_event_t *ev = event_alloc(EVENT_RESTART_DONE, done, node);
+    if (ev != NULL)
+        event_push(ev);
+}
+
+/**
+ * @brief 把应答送回请求方：本地请求直接走串口，远程请求走空中
+ * @param delay_us 模块处理耗时，例如链路测试的空中往返
+ */
+static void reply_to(int node, int requester, uint8_t service_port, uint8_t requester_port,
+                     const uint8_t *reply, int reply_len, uint64_t delay_us)
+{
+    uint8_t frame[MAX_FRAME_SIZE];
+    if (requester == node)
+    {
+        int len = build_frame(frame, service_port, requester_port, LOCAL_ADDRESS, reply, reply_len);
+        uart_send_after(node, frame, len, delay_us);
+    }
+    else
+    {
+        int len = build_frame(frame, service_port, requester_port, nodes[node].address, reply, reply_len);
+        radio_send_after(node, requester, frame, len, delay_us);
+    }
+}
+
+/**
+ * @brief 链路测试：node 与目标模块做一次空中往返，回复双向 RSSI
+ *
+ * 往返按两次空中传输计丢包，任一方向丢失则对应 RSSI 为 0x80。
+ */
+static void link_service(int node, int requester, uint8_t requester_port, const uint8_t *data, int data_len)
+{
+    if (data_len < 2)
+        return;
+    uint16_t peer_address = data[0] | (data[1] << 8);
+    int peer = find_node(peer_address, node);
+
+    uint8_t reply[2] = {RSSI_NO_DATA, RSSI_NO_DATA};
+    if (peer >= 0 && peer != node && nodes[peer].offline_until_us <= now_us())
+    {
+        if (rand_unit() >= air_loss(node))
+        {
+            reply[0] = link_rssi();     // 对端收到本模块的 RSSI
+            if (rand_unit() >= air_loss(node))
+                reply[1] = link_rssi(); // 本模块收到对端应答的 RSSI
+        }
+    }
+    uint64_t round_trip_us = (uint64_t)(2.0 * cfg.latency_ms * 1000.0);
+    reply_to(node, requester, LINK_SERVICE_PORT, requester_port, reply, sizeof(reply), round_trip_us);
+}
+
+/**
+ * @brief 交给模块内部服务处理；非服务端口返回 0
+ */
+static int dispatch_service(int node, int requester, const uint8_t *frame, int len)
+{
+    uint8_t src_port = frame[2];
+    uint8_t dst_port = frame[3];
+    const uint8_t *data = &frame[6];
+    int data_len = len - 7;
+
+    if (dst_port == CONFIG_SERVICE_PORT)
+    {
+        uint8_t reply[8];
+        int reply_len = config_service(node, data, data_len, reply);
+        if (reply_len > 0)
+        {
+            reply_to(node, requester, CONFIG_SERVICE_PORT, src_port, reply, reply_len, 0);
+            if (data[0] == RESTART_CMD)
+                start_restart(node);
+        }
+        return 1;
+    }
+    if (dst_port == LINK_SERVICE_PORT)
+    {
+        link_service(node, requester, src_port, data, data_len);
+        return 1;
+    }
+    return 0;
+}
+
+/***************************************帧处理****************************************************/
+
+/**
+ * @brief 处理上位机从串口写入的一帧完整数据
+ */
+static void handle_uart_frame(int node, const uint8_t *frame, int len)
+{
+    emu_node_t *n = &nodes[node];
+    n->uart_in_frames++;
+    dump_frame("uart in ", node, frame, len);
+
+    uint16_t target = frame[4] | (frame[5] << 8);
+    if (target == LOCAL_ADDRESS || target == n->address)
+    {
+        dispatch_service(node, node, frame, len);
+        return;
+    }
+
+    /* 空中帧的地址字段换成发送方地址，接收方可以直接输出 */
+    uint8_t air[MAX_FRAME_SIZE];
+    memcpy(air, frame, len);
+    air[4] = n->address & 0xFF;
+    air[5] = (n->address >> 8) & 0xFF;
+
+    for (int k = 0; k < cfg.node_count; k++)
+    {
+        if (k == node || !same_network(k, node))
+            continue;
+        if (target == BROADCAST_ADDRESS || nodes[k].address == target)
+            radio_send(node, k, air, len);
+    }
+}
+
+/**
+ * @brief 空中帧到达：服务端口交给模块处理，其余输出到串口
+ */
+static void handle_radio_arrive(int node, int from, const uint8_t *frame, int len)
+{
+    if (nodes[node].offline_until_us > now_us() || !same_network(node, from))
+    {
+        nodes[from].radio_lost++;
+        return;
+    }
+    if (dispatch_service(node, from, frame, len))
+        return;
+    uart_send(node, frame, len);
+}
+
+/**
+ * @brief 串口字节流解析：FE 长度 内容 FF，尾字节不对则丢弃重新同步
+ */
+static void uart_feed(int node, const uint8_t *bytes, int count)
+{
+    emu_node_t *n = &nodes[node];
+    for (int i = 0; i < count; i++)
+    {
+        uint8_t b = bytes[i];
+        if (n->rx_len == 0)
+        {
+            if (b == FRAME_HEAD)
+                n->rx_frame[n->rx_len++] = b;
+            continue;
+        }
+        n->rx_frame[n->rx_len++] = b;
+        if (n->rx_len == 2)
+        {
+            n->rx_expected = b + 3;
+            if (b < 4)
+            {
+                n->bad_frames++;
+                n->rx_len = 0;
+            }
+            continue;
+        }
+        if (n->rx_len == n->rx_expected)
+        {
+            if (b == FRAME_TAIL)
+                handle_uart_frame(node, n->rx_frame, n->rx_len);
+            else
+                n->bad_frames++;
+            n->rx_len = 0;
+        }
+    }
+}
+
+static void handle_event(emu_event_t *ev)
+{
+    emu_node_t *n = &nodes[ev->node];
+    switch (ev->type)
+    {
+    case EVENT_UART_OUT:
+        uart_line(ev->node, ev->data, ev->len);
+        dump_frame("uart out", ev->node, ev->data, ev->len);
+        if (write(n->master_fd, ev->data, ev->len) != ev->len)
+            n->uart_overruns++;     // 上位机没读走，pty 缓冲已满
+        else
+            n->uart_out_frames++;
+        break;
+    case EVENT_RADIO_ARRIVE:
+        handle_radio_arrive(ev->node, ev->from, ev->data, ev->len);
+        break;
+    case EVENT_RESTART_DONE:
+        n->address = n->pending_address;
+        n->network_id = n->pending_network_id;
+        n->channel = n->pending_channel;
+        n->baud_code = n->pending_baud_code;
+        n->rx_len = 0;
+        if (cfg.verbose)
+            fprintf(stderr, "[%d] restarted: addr 0x%04X net 0x%04X ch 0x%02X baud %u\n", ev->node,
+                    n->address, n->network_id, n->channel, decode_baud_rate(n->baud_code));
+        break;
+    }
+}
+
+/***************************************初始化与主循环****************************************************/
+
+/**
+ * @brief 打开一个 pty，并把从端设为原始模式，避免行规程改写 0x0D 等字节
+ */
+static int open_node_pty(emu_node_t *n)
+{
+    n->master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (n->master_fd < 0 || grantpt(n->master_fd) != 0 || unlockpt(n->master_fd) != 0)
+        return -1;
+    if (ptsname_r(n->master_fd, n->slave_name, sizeof(n->slave_name)) != 0)
+        return -1;
+    n->slave_fd = open(n->slave_name, O_RDWR | O_NOCTTY);
+    if (n->slave_fd < 0)
+        return -1;
+
+    struct termios2 tio;
+    if (ioctl(n->slave_fd, TCGETS2, &tio) != 0)
+        return -1;
+    tio.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON);
+    tio.c_oflag &= ~OPOST;
+    tio.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    tio.c_cflag &= ~(CSIZE | PARENB | CBAUD | (CBAUD << IBSHIFT));
+    tio.c_cflag |= CS8 | BOTHER | (BOTHER << IBSHIFT);
+    tio.c_ispeed = tio.c_ospeed = decode_baud_rate(cfg.baud_code);   // 上位机未设置前与模块一致
+    if (ioctl(n->slave_fd, TCSETS2, &tio) != 0)
+        return -1;
+
+    fcntl(n->master_fd, F_SETFL, fcntl(n->master_fd, F_GETFL) | O_NONBLOCK);
+    return 0;
+}
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    running = 0;
+}
+
+static void print_usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -n <count>     节点数量（默认 2，最多 %d）\n"
+            "  -a <address>   第一个节点地址，其余依次加 1（默认 0x0001）\n"
+            "  -N <id>        网络 ID（默认 0x0001）\n"
+            "  -c <channel>   信道（默认 0x0B）\n"
+            "  -B <baud>      模块初始波特率（默认 115200）\n"
+            "  -l <ms>        空中单程时延（默认 2）\n"
+            "  -j <ms>        时延抖动（默认 0）\n"
+            "  -b <bytes/s>   每信道空中带宽，0 不限（默认 0）\n"
+            "  -p <prob>      丢包概率（默认 0）\n"
+            "  -r <prob>      乱序概率（默认 0）\n"
+            "  -D <ms>        乱序包额外延迟（默认 10）\n"
+            "  -R <dBm>       链路测试基准 RSSI（默认 -45）\n"
+            "  -t <ms>        重启离线时间（默认 200）\n"
+            "  -e <baud=prob> 该波特率下串口每字节误码概率，可重复（如 -e 500000=0.05）\n"
+            "  -L <baud=prob> 模块工作在该波特率时另加的空中丢包概率，可重复（如 -L 500000=0.5）\n"
+            "  -m             检查上位机串口波特率，与模块不一致时收发乱码\n"
+            "  -s <seed>      随机种子（默认 1）\n"
+            "  -d <prefix>    创建 <prefix>0..N-1 软链接指向各节点串口\n"
+            "  -v             打印收发帧\n",
+            prog, MAX_NODES);
+}
+
+static int parse_args(int argc, char **argv)
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "n:a:N:c:B:l:j:b:p:r:D:R:t:e:L:ms:d:vh")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n': cfg.node_count = atoi(optarg); break;
+        case 'a': cfg.base_address = (uint16_t)strtoul(optarg, NULL, 0); break;
+        case 'N': cfg.network_id = (uint16_t)strtoul(optarg, NULL, 0); break;
+        case 'c': cfg.channel = (uint8_t)strtoul(optarg, NULL, 0); break;
+        case 'B':
+        {
+            uint32_t baud = strtoul(optarg, NULL, 0);
+            uint8_t code = encode_baud_rate(baud);
+            if (code == 0xFF)
+            {
+                fprintf(stderr, "unsupported baud rate %u\n", baud);
+                return -1;
+            }
+            cfg.baud_code = code;
+            break;
+        }
+        case 'l': cfg.latency_ms = atof(optarg); break;
+        case 'j': cfg.jitter_ms = atof(optarg); break;
+        case 'b': cfg.air_bandwidth = atof(optarg); break;
+        case 'p': cfg.loss = atof(optarg); break;
+        case 'r': cfg.reorder = atof(optarg); break;
+        case 'D': cfg.reorder_delay_ms = atof(optarg); break;
+        case 'R': cfg.rssi_dbm = atoi(optarg); break;
+        case 't': cfg.restart_ms = atof(optarg); break;
+        case 'e':
+        case 'L':
+        {
+            char *end;
+            uint32_t baud = strtoul(optarg, &end, 0);
+            uint8_t code = encode_baud_rate(baud);
+            if (*end != '=' || code == 0xFF)
+            {
+                fprintf(stderr, "bad -%c %s, expect <baud>=<prob>\n", opt, optarg);
+                return -1;
+            }
+            if (opt == 'e')
+                cfg.baud_error[code] = atof(end + 1);
+            else
+                cfg.baud_loss[code] = atof(end + 1);
+            break;
+        }
+        case 'm': cfg.baud_check = 1; break;
+        case 's': cfg.seed = (unsigned int)strtoul(optarg, NULL, 0); break;
+        case 'd': cfg.link_prefix = optarg; break;
+        case 'v': cfg.verbose = 1; break;
+        default:
+            print_usage(argv[0]);
+            return -1;
+        }
+    }
+    if (cfg.node_count < 1 || cfg.node_count > MAX_NODES)
+    {
+        print_usage(argv[0]);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (parse_args(argc, argv) != 0)
+        return 1;
+    srand(cfg.seed);
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    struct pollfd fds[MAX_NODES];
+    for (int k = 0; k < cfg.node_count; k++)
+    {
+        emu_node_t *n = &nodes[k];
+        if (open_node_pty(n) != 0)
+        {
+            perror("open pty");
+            return 1;
+        }
+        n->address = n->pending_address = cfg.base_address + k;
+        n->network_id = n->pending_network_id = cfg.network_id;
+        n->channel = n->pending_channel = cfg.channel;
+        n->baud_code = n->pending_baud_code = cfg.baud_code;
+        fds[k].fd = n->master_fd;
+        fds[k].events = POLLIN;
+
+        if (cfg.link_prefix != NULL)
+        {
+            char link[256];
+            snprintf(link, sizeof(link), "%s%d", cfg.link_prefix, k);
+            unlink(link);
+            if (symlink(n->slave_name, link) != 0)
+                perror(link);
+        }
+        printf("node %d: %s address 0x%04X\n", k, n->slave_name, n->address);
+    }
+    fflush(stdout);
+
+    while (running)
+    {
+        uint64_t now = now_us();
+        while (event_count > 0 && events[0]->time_us <= now)
+        {
+            emu_event_t *ev = event_pop();
+            handle_event(ev);
+            free(ev);
+        }
+
+        int timeout_ms = 100;
+        if (event_count > 0)
+        {
+            uint64_t wait_us = events[0]->time_us - now;
+            timeout_ms = (int)((wait_us + 999) / 1000);
+        }
+        if (poll(fds, cfg.node_count, timeout_ms) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            perror("poll");
+            break;
+        }
+
+        for (int k = 0; k < cfg.node_count; k++)
+        {
+            if (!(fds[k].revents & POLLIN))
+                continue;
+            uint8_t buf[1024];
+            ssize_t got = read(fds[k].fd, buf, sizeof(buf));
+            if (got <= 0)
+                continue;
+            if (nodes[k].offline_until_us > now_us())
+                continue;   // 重启中，串口数据丢弃
+            if (!uart_line(k, buf, (int)got))
+                continue;   // 波特率不一致，模块只收到帧错误，丢弃
+            uart_feed(k, buf, (int)got);
+        }
+    }
+
+    for (int k = 0; k < cfg.node_count; k++)
+    {
+        emu_node_t *n = &nodes[k];
+        fprintf(stderr, "node %d: uart in %lu, uart out %lu, overruns %lu, radio lost %lu, bad frames %lu, "
+                "bit errors %lu, baud mismatch bytes %lu\n", k,
+                n->uart_in_frames, n->uart_out_frames, n->uart_overruns, n->radio_lost, n->bad_frames,
+                n->bit_errors, n->baud_mismatch_bytes);
+        if (cfg.link_prefix != NULL)
+        {
+            char link[256];
+            snprintf(link, sizeof(link), "%s%d", cfg.link_prefix, k);
+            unlink(link);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,299 @@
+/**
+ * @file hal_host.c
+ * @author 万鹏 7415 (2789152534@qq.com)
+ * @date 2026-10-19 14:05:18
+ * @brief 上位机测试用的 HAL 串口替身，把 huartN 映射到伪终端（或真实串口）
+ * @version 0.1
+ * @note 发送、接收都在 hal_host_process 中推进，完成时在同一线程调用 HAL 的完成回调；
+ *       发送完成回调按波特率（8N1，每字节 10 位）延后，吞吐和真实串口一致；
+ *       波特率用 termios2 设置，支持 DL-LN32P 的 125000、250000 等非标准值。
+ *       配合 dl_ln_emulator 使用，见 README
+*/
+
+#define _GNU_SOURCE
+#include "usart.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <asm/termbits.h>   // termios2；不要与 <termios.h> 同时包含
+
+#define HAL_HOST_MAX_UARTS 8
+
+UART_HandleTypeDef huart1;
+UART_HandleTypeDef huart2;
+UART_HandleTypeDef huart3;
+
+static UART_HandleTypeDef *opened[HAL_HOST_MAX_UARTS];
+static int opened_count = 0;
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ull + (uint64_t)ts.tv_nsec / 1000ull;
+}
+
+/**
+ * @brief 设置原始模式和波特率
+ */
+static int apply_termios(int fd, uint32_t baud)
+{
+    struct termios2 tio;
+    if (ioctl(fd, TCGETS2, &tio) != 0)
+        return -1;
+    tio.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON);
+    tio.c_oflag &= ~OPOST;
+    tio.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    tio.c_cflag &= ~(CSIZE | PARENB | CBAUD | (CBAUD << IBSHIFT));
+    tio.c_cflag |= CS8 | BOTHER | (BOTHER << IBSHIFT);
+    tio.c_ispeed = baud;
+    tio.c_ospeed = baud;
+    return ioctl(fd, TCSETS2, &tio);
+}
+
+/**
+ * @brief 打开串口或伪终端并绑定到 huart
+ * @param huart 要绑定的串口句柄，例如 &huart1
+ * @param path 设备路径，例如仿真器 -d 参数生成的软链接
+ * @param baud 初始波特率，同时写入 huart->Init.BaudRate
+ * @return 0 成功，-1 失败（errno 有效）
+ */
+int hal_host_open(UART_HandleTypeDef *huart, const char *path, uint32_t baud)
+{
+    int slot = 0;
+    while (slot < opened_count && opened[slot] != huart)
+        slot++;     // 关闭后重新打开同一个句柄沿用原来的位置
+    if (slot >= HAL_HOST_MAX_UARTS)
+    {
+        errno = EMFILE;
+        return -1;
+    }
+    int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0)
+        return -1;
+
+    huart->fd = fd;
+    huart->Init.BaudRate = baud;
+    huart->tx_data = NULL;
+    huart->rx_data = NULL;
+    huart->rx_overruns = 0;
+    if (HAL_UART_Init(huart) != HAL_OK)
+    {
+        close(fd);
+        return -1;
+    }
+    opened[slot] = huart;
+    if (slot == opened_count)
+        opened_count++;
+    return 0;
+}
+
+/**
+ * @brief 按 huart->Init.BaudRate 重新设置串口
+ */
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart)
+{
+    if (huart->fd <= 0)
+        return HAL_ERROR;
+    return apply_termios(huart->fd, huart->Init.BaudRate) == 0 ? HAL_OK : HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size)
+{
+    if (huart->fd <= 0)
+        return HAL_ERROR;
+    if (huart->tx_data != NULL)
+        return HAL_BUSY;
+    huart->tx_data = data;
+    huart->tx_size = size;
+    huart->tx_count = 0;
+    huart->tx_done_us = now_us() + (huart->Init.BaudRate ? (uint64_t)size * 10000000ull / huart->Init.BaudRate : 0);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size)
+{
+    if (huart->fd <= 0)
+        return HAL_ERROR;
+    if (huart->rx_data != NULL)
+        return HAL_BUSY;
+    huart->rx_size = size;
+    huart->rx_count = 0;
+    huart->rx_data = data;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart)
+{
+    huart->rx_data = NULL;
+    return HAL_OK;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000u + ts.tv_nsec / 1000000u);
+}
+
+void HAL_Delay(uint32_t delay_ms)
+{
+    uint32_t start = HAL_GetTick();
+    while (HAL_GetTick() - start < delay_ms)
+        hal_host_process(1);
+}
+
+/* 弱定义，链接了驱动时由驱动提供 */
+__weak void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) { (void)huart; }
+__weak void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) { (void)huart; }
+
+/**
+ * @brief 推进一个串口的发送，写完且到了按波特率算的完成时刻才调用发送完成回调
+ */
+static void process_tx(UART_HandleTypeDef *huart)
+{
+    while (huart->tx_data != NULL)
+    {
+        if (huart->tx_count < huart->tx_size)
+        {
+            ssize_t n = write(huart->fd, huart->tx_data + huart->tx_count, huart->tx_size - huart->tx_count);
+            if (n <= 0)
+                return;     // 对端缓冲区满，下次再写
+            huart->tx_count += n;
+            continue;
+        }
+        if (now_us() < huart->tx_done_us)
+            return;         // 线上还没发完
+        huart->tx_data = NULL;
+        HAL_UART_TxCpltCallback(huart);     // 回调里可能立刻发下一帧
+    }
+}
+
+/**
+ * @brief 读出一个串口已到达的数据，逐字节交给接收缓冲区，收满调用接收完成回调
+ */
+static void process_rx(UART_HandleTypeDef *huart)
+{
+    uint8_t buffer[512];
+    ssize_t n;
+    while ((n = read(huart->fd, buffer, sizeof(buffer))) > 0)
+    {
+        for (ssize_t k = 0; k < n; k++)
+        {
+            if (huart->rx_data == NULL)
+            {
+                huart->rx_overruns++;
+                continue;
+            }
+            huart->rx_data[huart->rx_count++] = buffer[k];
+            if (huart->rx_count == huart->rx_size)
+            {
+                huart->rx_data = NULL;
+                HAL_UART_RxCpltCallback(huart);     // 回调里重新启动接收
+            }
+        }
+    }
+}
+
+/**
+ * @brief 收发一轮：等到任一串口可读、可写或发送到时，最多 timeout_ms
+ */
+void hal_host_process(int timeout_ms)
+{
+    struct pollfd fds[HAL_HOST_MAX_UARTS];
+    uint64_t now = now_us();
+    uint64_t timeout_us = timeout_ms < 0 ? UINT64_MAX : (uint64_t)timeout_ms * 1000ull;
+    for (int k = 0; k < opened_count; k++)
+    {
+        UART_HandleTypeDef *huart = opened[k];
+        fds[k].fd = huart->fd;
+        fds[k].events = POLLIN;
+        fds[k].revents = 0;
+        if (huart->tx_data == NULL)
+            continue;
+        if (huart->tx_count < huart->tx_size)
+        {
+            fds[k].events |= POLLOUT;
+        }
+        else
+        {
+            uint64_t wait_us = huart->tx_done_us > now ? huart->tx_done_us - now : 0;
+            if (wait_us < timeout_us)
+                timeout_us = wait_us;
+        }
+    }
+    struct timespec timeout = {(time_t)(timeout_us / 1000000ull), (long)(timeout_us % 1000000ull) * 1000};
+    ppoll(fds, opened_count, timeout_us == UINT64_MAX ? NULL : &timeout, NULL);   // 微秒精度，高波特率下不拖慢发送
+    for (int k = 0; k < opened_count; k++)
+    {
+        if (fds[k].revents & POLLIN)
+            process_rx(opened[k]);
+        if (opened[k]->tx_data != NULL)
+            process_tx(opened[k]);
+    }
+}
+
+/**
+ * @brief 启动仿真器子进程，等到各节点串口的软链接出现
+ * @param emulator 仿真器可执行文件路径
+ * @param prefix 软链接前缀，传给仿真器 -d
+ * @param nodes 节点数，传给仿真器 -n
+ * @param extra_args 其他仿真器参数，NULL 结尾，可为 NULL
+ * @return 进程号，失败返回 -1
+ */
+int hal_host_start_emulator(const char *emulator, const char *prefix, int nodes, const char *const extra_args[])
+{
+    char node_count[16];
+    const char *argv[64];
+    int argc = 0;
+    snprintf(node_count, sizeof(node_count), "%d", nodes);
+    argv[argc++] = emulator;
+    argv[argc++] = "-n";
+    argv[argc++] = node_count;
+    argv[argc++] = "-d";
+    argv[argc++] = prefix;
+    for (int k = 0; extra_args != NULL && extra_args[k] != NULL && argc < 63; k++)
+        argv[argc++] = extra_args[k];
+    argv[argc] = NULL;
+
+    pid_t child = fork();
+    if (child < 0)
+        return -1;
+    if (child == 0)
+    {
+        execv(emulator, (char *const *)argv);
+        perror(emulator);
+        _exit(127);
+    }
+
+    char last[256];
+    snprintf(last, sizeof(last), "%s%d", prefix, nodes - 1);
+    for (int waited = 0; waited < 2000; waited += 10)
+    {
+        if (access(last, F_OK) == 0)
+            return (int)child;
+        if (waitpid(child, NULL, WNOHANG) == child)
+            return -1;  // 仿真器启动失败
+        usleep(10000);
+    }
+    kill(child, SIGKILL);
+    waitpid(child, NULL, 0);
+    return -1;
+}
+
+/**
+ * @brief 结束仿真器子进程并等待退出
+ */
+void hal_host_stop_emulator(int process)
+{
+    if (process <= 0)
+        return;
+    kill((pid_t)process, SIGINT);
+    waitpid((pid_t)process, NULL, 0);
+}
@@ -0,0 +1,172 @@
+/**
+ * @file test_dl_ln_baud.c
+ * @author 万鹏 7415 (2789152534@qq.com)
+ * @date 2026-10-19 16:20:44
+ * @brief 上位机测试：DL_LN_negotiate_baud 波特率协商
+ * @version 0.1
+ * @note 仿真器开 -m 检查波特率是否一致（不一致收发都是乱码），并用 -e 给某些波特率注入误码。
+ *       每个场景从 9600 开始协商，检查：
+ *       - 协商停在期望的最快可靠波特率，回调状态为成功
+ *       - DL_LN_baud_save 收到同一个波特率，本地串口也切到了这个波特率
+ *       - 协商结束后读模块波特率，应答正常且代码与本地一致
+ *       空中丢包场景用 -L 让模块在高波特率下丢包，串口完好，应答帧齐全但 RSSI 为 0x80，也要判为不可靠
+ *
+ *       用法：./test_dl_ln_baud [仿真器路径，默认 ./dl_ln_emulator]
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "usart.h"
+#include "DL-LN.h"
+
+#define START_BAUD      9600
+#define NEGOTIATE_MS    30000   // 单个场景协商的最长时间
+#define PEER_ADDRESS    0x0002  // 链路测试对端，仿真器第二个节点
+
+typedef struct
+{
+    const char *name;
+    uint16_t peer;              // 0 表示只读本地模块
+    uint32_t max_baud;
+    const char *const *errors;  // 仿真器 -e 参数，NULL 结尾
+    uint32_t expected;          // 期望协商到的波特率
+    uint8_t expected_code;      // 该波特率在模块里的代码
+} scenario_t;
+
+static const char *const ERRORS_500K[] = {"-e", "500000=0.05", NULL};
+static const char *const ERRORS_250K_UP[] = {"-e", "250000=0.05", "-e", "500000=0.05", NULL};
+static const char *const AIR_LOSS_250K_UP[] = {"-L", "250000=0.5", "-L", "500000=0.5", NULL};    // 串口无误码
+
+static const scenario_t SCENARIOS[] = {
+    {"500000 noisy, link test", PEER_ADDRESS, 500000, ERRORS_500K, 250000, 0x0B},
+    {"capped at 115200", PEER_ADDRESS, 115200, ERRORS_500K, 115200, 0x08},
+    {"250000 noisy, local read", 0, 500000, ERRORS_250K_UP, 230400, 0x09},
+    {"250000 air loss, link test", PEER_ADDRESS, 500000, AIR_LOSS_250K_UP, 230400, 0x09},
+};
+
+static DL_LN_t dl;
+static int finished;
+static uint8_t finish_status;
+static uint32_t finish_baud;
+static uint32_t saved_baud;
+static int read_done;
+static uint8_t read_status;
+static uint8_t read_code;
+
+static const uint8_t READ_BAUD[] = {0xFE, 0x05, 0x90, 0x21, 0x00, 0x00, 0x04, 0xFF};
+
+void DL_LN_baud_save(DL_LN_t *instance, uint32_t baud_rate)
+{
+    (void)instance;
+    saved_baud = baud_rate;
+}
+
+static void on_negotiated(DL_LN_t *instance, uint8_t status, uint32_t baud_rate, void *context)
+{
+    (void)instance;
+    (void)context;
+    finished = 1;
+    finish_status = status;
+    finish_baud = baud_rate;
+}
+
+static void on_read_baud(DL_LN_t *instance, uint8_t status, const uint8_t *frame, uint8_t length, void *context)
+{
+    (void)instance;
+    (void)context;
+    read_done = 1;
+    read_status = status;
+    if (status == DL_LN_REPLY_OK && length == 9)
+        read_code = frame[7];
+}
+
+static int run_scenario(const char *emulator, const scenario_t *scenario)
+{
+    char prefix[64];
+    char path[80];
+    const char *args[16] = {"-m", "-t", "100", "-B", "9600"};
+    int argc = 5;
+    for (int k = 0; scenario->errors[k] != NULL; k++)
+        args[argc++] = scenario->errors[k];
+    args[argc] = NULL;
+
+    snprintf(prefix, sizeof(prefix), "/tmp/dlln_baud_%d_", (int)getpid());
+    int emu = hal_host_start_emulator(emulator, prefix, 2, args);
+    if (emu < 0)
+    {
+        printf("FAIL cannot start %s\n", emulator);
+        return 1;
+    }
+    snprintf(path, sizeof(path), "%s0", prefix);
+    if (hal_host_open(&huart1, path, START_BAUD) != 0 || !DL_LN_init(&dl, &huart1))
+    {
+        printf("FAIL cannot open module port\n");
+        hal_host_stop_emulator(emu);
+        return 1;
+    }
+
+    finished = 0;
+    saved_baud = 0;
+    read_done = 0;
+    read_code = 0xFF;
+    int failures = 0;
+    uint32_t start = HAL_GetTick();
+    if (!DL_LN_negotiate_baud(&dl, scenario->peer, scenario->max_baud, on_negotiated, NULL))
+    {
+        printf("FAIL %s: negotiation did not start\n", scenario->name);
+        failures++;
+        finished = 1;
+    }
+    while (!finished && HAL_GetTick() - start < NEGOTIATE_MS)
+    {
+        hal_host_process(1);
+        DL_LN_poll(&dl);
+    }
+    uint32_t elapsed = HAL_GetTick() - start;
+
+    // 协商结束后按最终波特率读一次模块
+    if (finished && DL_LN_request(&dl, READ_BAUD, sizeof(READ_BAUD), 200, on_read_baud, NULL))
+    {
+        while (!read_done)
+        {
+            hal_host_process(1);
+            DL_LN_poll(&dl);
+        }
+    }
+    hal_host_stop_emulator(emu);
+    close(huart1.fd);
+    huart1.fd = 0;
+
+    printf("%-26s %6lu bps in %5lu ms  saved %6lu  local %6lu  module code 0x%02X\n", scenario->name,
+           (unsigned long)finish_baud, (unsigned long)elapsed, (unsigned long)saved_baud,
+           (unsigned long)huart1.Init.BaudRate, read_code);
+
+    if (!finished || finish_status != DL_LN_REPLY_OK)
+    {
+        printf("FAIL %s: negotiation %s\n", scenario->name, finished ? "lost the module" : "did not finish");
+        return failures + 1;
+    }
+    if (finish_baud != scenario->expected || saved_baud != scenario->expected
+        || huart1.Init.BaudRate != scenario->expected)
+    {
+        printf("FAIL %s: expected %lu bps\n", scenario->name, (unsigned long)scenario->expected);
+        failures++;
+    }
+    if (read_status != DL_LN_REPLY_OK || read_code != scenario->expected_code)
+    {
+        printf("FAIL %s: module does not answer at the negotiated rate\n", scenario->name);
+        failures++;
+    }
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    const char *emulator = argc > 1 ? argv[1] : "./dl_ln_emulator";
+    int failures = 0;
+    for (size_t k = 0; k < sizeof(SCENARIOS) / sizeof(SCENARIOS[0]); k++)
+        failures += run_scenario(emulator, &SCENARIOS[k]);
+    printf(failures ? "FAILED (%d)\n" : "OK\n", failures);
+    return failures ? 1 : 0;
+}
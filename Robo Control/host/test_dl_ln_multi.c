@@ -0,0 +1,204 @@
+/**
+ * @file test_dl_ln_multi.c
+ * @author 万鹏 7415 (2789152534@qq.com)
+ * @date 2026-10-19 14:05:18
+ * @brief 上位机测试：两个 DL-LN 驱动实例接在两个串口上同时满速收发
+ * @version 0.1
+ * @note 仿真器提供两个节点（地址 0x0001、0x0002），遥测实例接 huart1、遥控实例接 huart2，
+ *       两边互相满队列发送带序号的数据包，期间不停读取各自模块地址。检查：
+ *       - 每个实例只收到对端的包，序号连续、内容正确、一个不丢
+ *       - 读地址的应答回到发起请求的实例，telemetry 读到 0x0001，teleop 读到 0x0002
+ *       - 两个实例各自的吞吐都接近串口线速，互不拖累
+ *
+ *       用法：./test_dl_ln_multi [仿真器路径，默认 ./dl_ln_emulator]
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "usart.h"
+#include "DL-LN.h"
+
+#define BAUD            115200
+#define DATA_PORT       0x40    // 测试数据端口
+#define PAYLOAD_LEN     60      // 数据包内容长度
+#define RUN_MS          2000    // 满速发送时间
+#define DRAIN_MS        500     // 停发后等待在途数据
+#define READ_PERIOD_MS  100     // 读地址间隔
+#define MIN_LINE_RATIO  0.7     // 吞吐至少达到线速的比例
+
+typedef struct
+{
+    DL_LN_t dl;                 // 放在第一个，回调里由 DL_LN_t* 转回
+    const char *name;
+    uint16_t address;           // 本模块地址
+    uint16_t peer;              // 对端地址
+    uint8_t tag;                // 数据内容标记，区分两个实例发出的包
+
+    uint16_t tx_seq;            // 已发送包数
+    uint16_t rx_seq;            // 已收到包数（也是下一个期望的序号）
+    unsigned long rx_bad;       // 来源、序号或内容不对的包
+
+    int read_pending;
+    unsigned long reads_ok;
+    unsigned long reads_wrong;
+    unsigned long reads_timeout;
+} link_t;
+
+static link_t telemetry = {.name = "telemetry", .address = 0x0001, .peer = 0x0002, .tag = 0x5A};
+static link_t teleop = {.name = "teleop", .address = 0x0002, .peer = 0x0001, .tag = 0xA5};
+
+static const uint8_t READ_ADDRESS[] = {0xFE, 0x05, 0x90, 0x21, 0x00, 0x00, 0x01, 0xFF};
+
+static void fill_payload(uint8_t *payload, uint16_t seq, uint8_t tag)
+{
+    payload[0] = seq & 0xFF;
+    payload[1] = seq >> 8;
+    for (int k = 2; k < PAYLOAD_LEN; k++)
+        payload[k] = (uint8_t)(seq * 7 + k) ^ tag;
+}
+
+static void on_data(DL_LN_t *dl, uint8_t src_port, uint16_t src_address, const uint8_t *data, uint8_t length)
+{
+    link_t *link = (link_t *)dl;
+    link_t *peer = link == &telemetry ? &teleop : &telemetry;
+    uint8_t expected[PAYLOAD_LEN];
+    fill_payload(expected, link->rx_seq, peer->tag);
+
+    if (src_port != DATA_PORT || src_address != link->peer || length != PAYLOAD_LEN
+        || memcmp(data, expected, PAYLOAD_LEN) != 0)
+    {
+        if (link->rx_bad++ == 0)
+            printf("%s: unexpected packet from 0x%04X, seq %u (expected %u)\n",
+                   link->name, src_address, data[0] | (data[1] << 8), link->rx_seq);
+        link->rx_seq = (data[0] | (data[1] << 8)) + 1;
+        return;
+    }
+    link->rx_seq++;
+}
+
+static void on_read_address(DL_LN_t *dl, uint8_t status, const uint8_t *frame, uint8_t length, void *context)
+{
+    link_t *link = context;
+    link->read_pending = 0;
+    if ((link_t *)dl != link)
+    {
+        link->reads_wrong++;
+        return;
+    }
+    if (status != DL_LN_REPLY_OK || length < 10)
+    {
+        link->reads_timeout++;
+        return;
+    }
+    if ((frame[7] | (frame[8] << 8)) == link->address)
+        link->reads_ok++;
+    else
+        link->reads_wrong++;
+}
+
+/* 两个实例都要重写上位机输出，测试里打印到终端 */
+void DL_LN_report(DL_LN_t *dl, const char *message)
+{
+    printf("%s: %s", ((link_t *)dl)->name, message);
+}
+
+static void fill_tx_queue(link_t *link)
+{
+    uint8_t payload[PAYLOAD_LEN];
+    for (;;)
+    {
+        fill_payload(payload, link->tx_seq, link->tag);
+        if (!DL_LN_send_data(&link->dl, DATA_PORT, DATA_PORT, link->peer, payload, PAYLOAD_LEN))
+            return;     // 发送队列满
+        link->tx_seq++;
+    }
+}
+
+static int check_link(link_t *link, const link_t *peer, double seconds)
+{
+    int failures = 0;
+    double line_rate = BAUD / 10.0 / (PAYLOAD_LEN + 7);    // 每秒能过串口的包数
+    double rate = peer->tx_seq / seconds;
+
+    printf("%-9s sent %5u  received %5u  bad %lu  %.0f pkt/s (line %.0f)  reads ok %lu wrong %lu timeout %lu\n",
+           link->name, link->tx_seq, link->rx_seq, link->rx_bad, rate, line_rate,
+           link->reads_ok, link->reads_wrong, link->reads_timeout);
+
+    if (link->rx_seq != peer->tx_seq || link->rx_bad != 0)
+    {
+        printf("FAIL %s: received %u of %u packets, %lu bad\n", link->name, link->rx_seq, peer->tx_seq, link->rx_bad);
+        failures++;
+    }
+    if (link->reads_ok == 0 || link->reads_wrong != 0 || link->reads_timeout != 0)
+    {
+        printf("FAIL %s: address reads ok %lu wrong %lu timeout %lu\n",
+               link->name, link->reads_ok, link->reads_wrong, link->reads_timeout);
+        failures++;
+    }
+    if (rate < MIN_LINE_RATIO * line_rate)
+    {
+        printf("FAIL %s: %.0f pkt/s is below %.0f%% of line rate\n", peer->name, rate, MIN_LINE_RATIO * 100);
+        failures++;
+    }
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    const char *emulator = argc > 1 ? argv[1] : "./dl_ln_emulator";
+    char prefix[64];
+    char path[80];
+    snprintf(prefix, sizeof(prefix), "/tmp/dlln_multi_%d_", (int)getpid());
+
+    int emu = hal_host_start_emulator(emulator, prefix, 2, NULL);
+    if (emu < 0)
+    {
+        printf("FAIL cannot start %s\n", emulator);
+        return 1;
+    }
+    snprintf(path, sizeof(path), "%s0", prefix);
+    int opened = hal_host_open(&huart1, path, BAUD) == 0;
+    snprintf(path, sizeof(path), "%s1", prefix);
+    opened = opened && hal_host_open(&huart2, path, BAUD) == 0;
+    if (!opened || !DL_LN_init(&telemetry.dl, &huart1) || !DL_LN_init(&teleop.dl, &huart2))
+    {
+        printf("FAIL cannot open module ports\n");
+        hal_host_stop_emulator(emu);
+        return 1;
+    }
+    DL_LN_register_port_handler(&telemetry.dl, DATA_PORT, on_data);
+    DL_LN_register_port_handler(&teleop.dl, DATA_PORT, on_data);
+
+    link_t *links[] = {&telemetry, &teleop};
+    uint32_t start = HAL_GetTick();
+    uint32_t last_read = 0;
+    while (HAL_GetTick() - start < RUN_MS + DRAIN_MS)
+    {
+        uint32_t elapsed = HAL_GetTick() - start;
+        for (int k = 0; k < 2; k++)
+        {
+            link_t *link = links[k];
+            // 先登记读地址再灌数据，否则发送队列总是满的
+            if (elapsed - last_read >= READ_PERIOD_MS && !link->read_pending)
+                link->read_pending = DL_LN_request(&link->dl, READ_ADDRESS, sizeof(READ_ADDRESS), 500,
+                                                   on_read_address, link);
+            if (elapsed < RUN_MS)
+                fill_tx_queue(link);
+        }
+        if (elapsed - last_read >= READ_PERIOD_MS)
+            last_read = elapsed;
+
+        hal_host_process(1);
+        DL_LN_poll(&telemetry.dl);
+        DL_LN_poll(&teleop.dl);
+    }
+
+    hal_host_stop_emulator(emu);
+
+    int failures = 0;
+    failures += check_link(&telemetry, &teleop, RUN_MS / 1000.0);
+    failures += check_link(&teleop, &telemetry, RUN_MS / 1000.0);
+    printf(failures ? "FAILED (%d)\n" : "OK\n", failures);
+    return failures ? 1 : 0;
+}
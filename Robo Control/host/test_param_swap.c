@@ -0,0 +1,290 @@
+/**
+ * @file test_param_swap.c
+ * @author 万鹏 7415 (2789152534@qq.com)
+ * @date 2026-10-19 10:40:05
+ * @brief 上位机测试：调参服务的批量读写，以及三槽快照在并发读写下不会出现写了一半的参数
+ * @version 0.1
+ * @note 写端模拟主循环不停下发参数，读端模拟控制中断换入并检查，每批参数取 {k, 2k, 3k}，
+ *       读端看到的值不成比例或者 k 倒退都算失败。读端分别以线程（多核真并发）和
+ *       定时信号（随机打断写端，等同单核 MCU 上的中断）两种方式运行
+*/
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#define pid_t pid_ctrl_t    // 避开 sys/types.h 中的 pid_t
+#include "param.h"
+
+#define RUN_SECONDS 1   // 每种模式运行时间
+#define TICK_US 50      // 模拟控制中断周期
+
+/* DL-LN 替身，测试直接调用 param_handle，不走无线 */
+uint8_t DL_LN_register_port_handler(DL_LN_t *dl, uint8_t port, DL_LN_port_handler_t handler)
+{
+    (void)dl;
+    (void)port;
+    (void)handler;
+    return 1;
+}
+
+uint8_t DL_LN_send_data(DL_LN_t *dl, uint8_t send_port, uint8_t recv_port, uint16_t target_address,
+                        const uint8_t *data, uint8_t length)
+{
+    (void)dl;
+    (void)send_port;
+    (void)recv_port;
+    (void)target_address;
+    (void)data;
+    (void)length;
+    return 1;
+}
+
+static pid_t pid_a;
+static pid_t pid_b;
+static float feed_forward;
+static volatile int stop;
+static int failures;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("FAIL %s:%d ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+static uint8_t put_float(uint8_t *buffer, float value)
+{
+    memcpy(buffer, &value, 4);
+    return 4;
+}
+
+static float get_float(const uint8_t *buffer)
+{
+    float value;
+    memcpy(&value, buffer, 4);
+    return value;
+}
+
+/* 组一条设置消息：PID 1、PID 2 为 {k, 2k, 3k}，浮点参数 3 为 k */
+static uint8_t build_set(uint8_t *msg, uint8_t seq, float k)
+{
+    uint8_t pos = 0;
+    msg[pos++] = PARAM_OP_SET;
+    msg[pos++] = seq;
+    msg[pos++] = 3;
+    for (uint8_t id = 1; id <= 2; id++) {
+        msg[pos++] = id;
+        pos += put_float(&msg[pos], k);
+        pos += put_float(&msg[pos], 2 * k);
+        pos += put_float(&msg[pos], 3 * k);
+    }
+    msg[pos++] = 3;
+    pos += put_float(&msg[pos], k);
+    return pos;
+}
+
+static void test_messages(void)
+{
+    uint8_t msg[64];
+    uint8_t reply[251];
+
+    // 读取：两个 PID、一个浮点、一个未登记的 ID
+    uint8_t get[] = {PARAM_OP_GET, 7, 4, 1, 2, 3, 9};
+    uint8_t n = param_handle(get, sizeof(get), reply);
+    CHECK(n == 3 + 14 + 14 + 6 + 2, "get reply length %u", n);
+    CHECK(reply[0] == (PARAM_OP_GET | PARAM_OP_REPLY) && reply[1] == 7 && reply[2] == 4, "get reply header");
+    CHECK(reply[3] == 1 && reply[4] == PARAM_TYPE_PID && get_float(&reply[5]) == 1.0f, "get pid 1");
+    CHECK(reply[31] == 3 && reply[32] == PARAM_TYPE_FLOAT && get_float(&reply[33]) == 0.5f, "get float 3");
+    CHECK(reply[37] == 9 && reply[38] == PARAM_TYPE_NONE, "get unknown id");
+
+    // 设置里有未登记的 ID，整批丢弃
+    uint8_t len = build_set(msg, 8, 5.0f);
+    msg[len - 5] = 9;
+    n = param_handle(msg, len, reply);
+    CHECK(n == 4 && reply[2] == PARAM_ERR_ID && reply[3] == 0, "set with unknown id");
+    param_tick();
+    CHECK(pid_a.p == 1.0f && feed_forward == 0.5f, "rejected batch must not apply");
+
+    // 长度不对，整批丢弃
+    len = build_set(msg, 9, 5.0f);
+    n = param_handle(msg, len - 1, reply);
+    CHECK(reply[2] == PARAM_ERR_FORMAT, "truncated set");
+
+    // 一批 39 个 PID，数据区 251 字节：第 20 项从 247 开始，读到 259 越过消息末尾，8 位下标会回绕到 4。
+    // 从 4 起再摆 19 个 PID 正好落在 251，回绕后仍能通过长度检查，必须整批拒绝
+    uint8_t wrap[3 + 251 + 16];
+    memset(wrap, 0x7F, sizeof(wrap));   // 消息后面的字节当增益读进来是 3.4e38
+    wrap[0] = PARAM_OP_SET;
+    wrap[1] = 11;
+    wrap[2] = 39;
+    for (int k = 0; k < 20; k++)
+        wrap[3 + 13 * k] = 1;
+    for (int k = 0; k < 19; k++)
+        wrap[3 + 4 + 13 * k] = 1;
+    n = param_handle(wrap, 3 + 251, reply);
+    CHECK(n == 4 && reply[2] == PARAM_ERR_FORMAT && reply[3] == 0, "set whose position wraps past 255");
+    param_tick();
+    CHECK(pid_a.p == 1.0f && pid_a.d == 3.0f, "wrapping batch must not apply");
+
+    // 合法设置，节拍开始才生效
+    len = build_set(msg, 10, 5.0f);
+    n = param_handle(msg, len, reply);
+    CHECK(n == 4 && reply[1] == 10 && reply[2] == PARAM_OK && reply[3] == 3, "set reply");
+    CHECK(pid_a.p == 1.0f, "set must wait for the tick");
+    param_tick();
+    CHECK(pid_a.p == 5.0f && pid_a.i == 10.0f && pid_b.d == 15.0f && feed_forward == 5.0f, "set applied");
+}
+
+/* 读端检查：每次换入后 p/i/d 必须成比例，批量参数必须属于同一批且不倒退 */
+
+static volatile long swaps;
+static volatile int torn;
+static float last_k;
+
+static void pid_tick(void)
+{
+    general_pid_calc(&pid_a, 0, 1, "");
+    float p = pid_a.p;
+    if (pid_a.i != 2 * p || pid_a.d != 3 * p)
+        torn = 1;
+    if (p != last_k)
+        swaps++;
+    last_k = p;
+}
+
+static void batch_tick(void)
+{
+    param_tick();
+    float k = pid_a.p;
+    if (pid_a.i != 2 * k || pid_a.d != 3 * k || pid_b.p != k || pid_b.i != 2 * k || pid_b.d != 3 * k
+        || feed_forward != k || k < last_k)
+        torn = 1;
+    if (k != last_k)
+        swaps++;
+    last_k = k;
+}
+
+/* 写端：k 从 1 递增，整数值的 float 乘 2、乘 3 都是精确的 */
+
+static void pid_write(float k)
+{
+    pid_dynamic_set(&pid_a, k, 2 * k, 3 * k);
+}
+
+static void batch_write(float k)
+{
+    uint8_t msg[64];
+    uint8_t reply[251];
+    param_handle(msg, build_set(msg, (uint8_t)k, k), reply);
+}
+
+static void (*tick_fn)(void);
+static void (*write_fn)(float k);
+
+static void *reader_thread(void *arg)
+{
+    (void)arg;
+    while (!stop && !torn)
+        tick_fn();
+    return NULL;
+}
+
+static void *writer_thread(void *arg)
+{
+    (void)arg;
+    for (float k = 1; !stop; k++)
+        write_fn(k);
+    return NULL;
+}
+
+static void on_alarm(int sig)
+{
+    (void)sig;
+    tick_fn();
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* 模式一：两个线程真并发，多核机器上读写同时进行 */
+static void run_threads(const char *name)
+{
+    pthread_t w, r;
+    swaps = 0;
+    torn = 0;
+    last_k = 0;
+    stop = 0;
+    pthread_create(&r, NULL, reader_thread, NULL);
+    pthread_create(&w, NULL, writer_thread, NULL);
+    struct timespec duration = {RUN_SECONDS, 0};
+    nanosleep(&duration, NULL);
+    stop = 1;
+    pthread_join(w, NULL);
+    pthread_join(r, NULL);
+    printf("%s, threads: %ld swaps observed\n", name, swaps);
+    CHECK(!torn, "%s: torn read in threaded mode", name);
+    CHECK(swaps > 0, "%s: reader never saw an update", name);
+}
+
+/* 模式二：定时信号当控制中断，在写端任意位置打断它，和单核 MCU 的情况一致 */
+static void run_interrupts(const char *name)
+{
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_alarm;
+    sigaction(SIGALRM, &action, NULL);
+
+    swaps = 0;
+    torn = 0;
+    last_k = 0;
+    struct itimerval timer = {{0, TICK_US}, {0, TICK_US}};
+    setitimer(ITIMER_REAL, &timer, NULL);
+
+    double end = now_seconds() + RUN_SECONDS;
+    for (float k = 1; now_seconds() < end && !torn; k++)
+        write_fn(k);
+
+    struct itimerval off = {{0, 0}, {0, 0}};
+    setitimer(ITIMER_REAL, &off, NULL);
+    printf("%s, interrupts: %ld swaps observed\n", name, swaps);
+    CHECK(!torn, "%s: torn read in interrupt mode", name);
+    CHECK(swaps > 0, "%s: tick never saw an update", name);
+}
+
+/* 并发一改过 pid_a，先发一批全零让所有参数一致 */
+static void reset_batch(void)
+{
+    batch_write(0.0f);
+    param_tick();
+}
+
+int main(void)
+{
+    PID_struct_init(&pid_a, 0, 1000, 1000, 1.0f, 2.0f, 3.0f);
+    PID_struct_init(&pid_b, 0, 1000, 1000, 1.0f, 2.0f, 3.0f);
+    feed_forward = 0.5f;
+    param_register_pid(1, &pid_a);
+    param_register_pid(2, &pid_b);
+    param_register_float(3, &feed_forward);
+    CHECK(!param_register_float(3, &feed_forward), "duplicate id must be rejected");
+
+    test_messages();
+
+    tick_fn = pid_tick;
+    write_fn = pid_write;
+    run_threads("pid_dynamic_set");
+    run_interrupts("pid_dynamic_set");
+
+    tick_fn = batch_tick;
+    write_fn = batch_write;
+    reset_batch();
+    run_threads("param batches");
+    reset_batch();
+    run_interrupts("param batches");
+
+    printf(failures ? "FAILED (%d)\n" : "OK\n", failures);
+    return failures ? 1 : 0;
+}
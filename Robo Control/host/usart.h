@@ -0,0 +1,75 @@
+/**
+ * @file usart.h
+ * @author 万鹏 7415 (2789152534@qq.com)
+ * @date 2026-10-19 10:40:05
+ * @brief 上位机测试用的 HAL 串口头文件替身，串口由 hal_host.c 映射到伪终端
+ * @version 0.2
+ * @note 只用于 host 目录下的测试程序，单片机工程使用 CubeMX 生成的 usart.h。
+ *       上位机没有中断：hal_host_process 在主循环里收发数据，并在同一线程里调用
+ *       HAL_UART_RxCpltCallback / HAL_UART_TxCpltCallback，时序上相当于中断在 poll 之间发生
+*/
+
+#ifndef HOST_USART_H
+#define HOST_USART_H
+
+#include <stdint.h>
+
+#ifndef __weak
+#define __weak __attribute__((weak))
+#endif
+
+typedef enum
+{
+    HAL_OK = 0x00,
+    HAL_ERROR = 0x01,
+    HAL_BUSY = 0x02,
+    HAL_TIMEOUT = 0x03
+} HAL_StatusTypeDef;
+
+typedef struct
+{
+    uint32_t BaudRate;
+} UART_InitTypeDef;
+
+typedef struct
+{
+    UART_InitTypeDef Init;      // 与 HAL 一致，改 BaudRate 后调用 HAL_UART_Init 生效
+
+    /* 以下为上位机替身内部状态 */
+    int fd;                     // 对应的串口或伪终端，0 表示未打开
+    const uint8_t *tx_data;     // 正在发送的数据，NULL 表示空闲
+    uint16_t tx_size;
+    uint16_t tx_count;
+    uint64_t tx_done_us;        // 按波特率算出的发送完成时刻，到点才调用发送完成回调
+    uint8_t *rx_data;           // 接收目标，NULL 表示没有启动接收
+    uint16_t rx_size;
+    uint16_t rx_count;
+    unsigned long rx_overruns;  // 没有启动接收时到达而丢掉的字节
+} UART_HandleTypeDef;
+
+extern UART_HandleTypeDef huart1;
+extern UART_HandleTypeDef huart2;
+extern UART_HandleTypeDef huart3;
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size);
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size);
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart);
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t delay_ms);
+
+int hal_host_open(UART_HandleTypeDef *huart, const char *path, uint32_t baud);  // 打开串口或伪终端，0 成功
+void hal_host_process(int timeout_ms);  // 收发一轮数据并调用中断回调，最多等待 timeout_ms
+
+// 测试辅助：启动 dl_ln_emulator，节点串口为 <prefix>0..<prefix>N-1，返回进程号，失败返回 -1
+int hal_host_start_emulator(const char *emulator, const char *prefix, int nodes, const char *const extra_args[]);
+void hal_host_stop_emulator(int process);  // 结束仿真器，仿真器退出时打印各节点统计
+
+// 上位机没有中断，临界区为空
+static inline uint32_t __get_PRIMASK(void) { return 0; }
+static inline void __disable_irq(void) {}
+static inline void __set_PRIMASK(uint32_t primask) { (void)primask; }
+
+#endif /* HOST_USART_H */
@@ -6,12 +6,21 @@
  * @version 0.1
  * @note
 */
-#include "stm32f427xx.h"
 #include "pid.h"
 #include <math.h>
 #include "stdint.h"
 #include "string.h"
 
+// 快照索引的读写要求不被编译器重排；GCC/Clang 下用原子内建函数，上位机多核测试时同样成立。
+// 单核 MCU 上字节读写本身是原子的，其他编译器退化为 volatile 访问
+#if defined(__GNUC__) && !defined(__CC_ARM)
+#define SNAPSHOT_LOAD(x)     __atomic_load_n(&(x), __ATOMIC_SEQ_CST)
+#define SNAPSHOT_STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_SEQ_CST)
+#else
+#define SNAPSHOT_LOAD(x)     (x)
+#define SNAPSHOT_STORE(x, v) ((x) = (v))
+#endif
+
 /*********************基本数学与基础运算相关*********************/
 /**
  * @brief 绝对值运算函数
@@ -81,6 +90,59 @@ float calculate_2D_distance(float x1, float y1, float x2, float y2) {
 // }
 
 
+/*********************三槽快照*********************/
+
+/**
+ * @brief 写端取一个可写的空闲槽
+ *
+ * 返回的槽既不是读端正在用的，也不是已发布待取的，写端可以慢慢写，不影响读端。
+ * 先读 pending 再读 front：读端换槽时先改 front 再清 pending，这个顺序保证写端
+ * 不会选中读端刚取走的槽。
+ *
+ * @param index 快照索引
+ * @return 槽号
+ * @note 只允许一个写端
+ */
+uint8_t snapshot_write_slot(snapshot_index_t *index)
+{
+    uint8_t pending = SNAPSHOT_LOAD(index->pending);
+    uint8_t front = SNAPSHOT_LOAD(index->front);
+    for (uint8_t slot = 0; slot < SNAPSHOT_SLOTS; slot++)
+    {
+        if (slot != front && slot + 1 != pending)
+            return slot;
+    }
+    return 0;   // 三个槽不可能都被占用
+}
+
+/**
+ * @brief 写端发布写好的槽，之前发布但读端还没取走的槽作废
+ * @param index 快照索引
+ * @param slot snapshot_write_slot 返回的槽号
+ */
+void snapshot_publish(snapshot_index_t *index, uint8_t slot)
+{
+    SNAPSHOT_STORE(index->pending, (uint8_t)(slot + 1));
+}
+
+/**
+ * @brief 读端取走最新发布的槽
+ * @param index 快照索引
+ * @return 新槽号，读端此后只读这个槽；没有新数据返回 SNAPSHOT_NONE
+ * @note 只允许一个读端，一般在控制中断的节拍开始处调用
+ */
+uint8_t snapshot_take(snapshot_index_t *index)
+{
+    uint8_t pending = SNAPSHOT_LOAD(index->pending);
+    if (pending == 0)
+        return SNAPSHOT_NONE;
+
+    uint8_t slot = pending - 1;
+    SNAPSHOT_STORE(index->front, slot);  // 先占住，再清待取标记
+    SNAPSHOT_STORE(index->pending, 0);
+    return slot;
+}
+
 /*********************PID库*********************/
 
 /**
@@ -156,6 +218,10 @@ void PID_struct_init(
     // pid->f_cal_pid = pid_calc;        // 可选：设置 PID 计算函数
     // pid->f_cal_sp_pid = pid_sp_calc;  // 可选：设置设定点 PID 计算函数
 
+    /* 清空待生效增益 */
+    pid->gain_index.front = 0;
+    pid->gain_index.pending = 0;
+
     /* 初始化 PID 参数 */
     pid->f_param_init(pid, mode, maxout, intergral_limit, kp, ki, kd);  // 调用 f_param_init 初始化 PID 参数
 }
@@ -166,6 +232,9 @@ void PID_struct_init(
  * 该函数用于在运行时修改 PID 控制器的比例、积分、微分增益值
  * 用于调试阶段
  * 
+ * 新增益写进三槽快照的空闲槽，下一次 PID 计算开始时由 pid_gain_sync 整体换入，
+ * 控制中断不会读到只改了一半的 p/i/d。
+ * 
  * @param pid 指向 PID 控制器结构体的指针
  */
 
@@ -176,10 +245,33 @@ void pid_dynamic_set(
     float kd    
 )
 {
+    uint8_t slot = snapshot_write_slot(&pid->gain_index);
+
     // 更新比例、积分、微分增益
-    pid->p = kp;  
-    pid->i = ki;
-    pid->d = kd;  
+    pid->gain_slot[slot][0] = kp;
+    pid->gain_slot[slot][1] = ki;
+    pid->gain_slot[slot][2] = kd;
+
+    snapshot_publish(&pid->gain_index, slot);
+}
+
+/**
+ * @brief 换入 pid_dynamic_set 发布的增益
+ * 
+ * PID 计算函数开头自动调用，也可以在控制节拍开始处手动调用，让同一节拍内的所有计算用同一组增益。
+ * 
+ * @param pid 指向 PID 控制器结构体的指针
+ * @note 只在控制中断（PID 计算所在的上下文）中调用
+ */
+void pid_gain_sync(pid_t *pid)
+{
+    uint8_t slot = snapshot_take(&pid->gain_index);
+    if (slot == SNAPSHOT_NONE)
+        return;
+
+    pid->p = pid->gain_slot[slot][0];
+    pid->i = pid->gain_slot[slot][1];
+    pid->d = pid->gain_slot[slot][2];
 }
 
 /**
@@ -197,6 +289,8 @@ void pid_dynamic_set(
  */
 float pid_calc(pid_t *pid, float get, float set)
 {
+    pid_gain_sync(pid); // 节拍开始换入新增益
+
     // 更新当前测量值和设定值
     pid->get[NOW] = get;
     pid->set[NOW] = set;
@@ -318,6 +412,8 @@ float general_pid_calc(pid_t *pid, float get, float set, char* mode)
  */
 float pid_sp_calc(pid_t *pid, float get, float set, float gyro)
 {
+    pid_gain_sync(pid); // 节拍开始换入新增益
+
     // 更新当前测量值、目标值和误差
     pid->get[NOW] = get;
     pid->set[NOW] = set;
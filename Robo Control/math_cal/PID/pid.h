@@ -10,6 +10,7 @@
 #ifndef __pid_H
 #define __pid_H
 
+#include <stdint.h>  // 为了声明 uint32_t
 
 
 /*数学与基础计算函数相关声明*/
@@ -20,6 +21,27 @@ float calculate_2D_distance(float x1, float y1, float x2, float y2);
 float abs_value(float x);
 void abs_limit(float *a, float ABS_MAX);
 
+/*三槽快照相关声明*/
+/**
+ * @brief 三槽快照索引，一个写端、一个读端之间无锁交换整块数据
+ *
+ * 写端（主循环、调参）把新数据写进读端不会碰的空闲槽，再发布；读端（控制中断）在节拍开始时
+ * 取走最新发布的槽。任何时刻读端只读自己取走的槽，写端只写第三个槽，读端永远看不到写了一半的数据，
+ * 两边都不关中断、不加锁。全零初始化即为有效的初始状态（读端用槽 0，无待取数据）。
+ */
+typedef struct
+{
+    volatile uint8_t front;    // 读端正在使用的槽
+    volatile uint8_t pending;  // 已发布、读端尚未取走的槽号 + 1，0 表示没有
+} snapshot_index_t;
+
+#define SNAPSHOT_SLOTS 3       // 快照槽数
+#define SNAPSHOT_NONE  0xFF    // snapshot_take 没有新数据时的返回值
+
+uint8_t snapshot_write_slot(snapshot_index_t *index);           // 写端：取一个可写的空闲槽
+void snapshot_publish(snapshot_index_t *index, uint8_t slot);   // 写端：发布写好的槽
+uint8_t snapshot_take(snapshot_index_t *index);                 // 读端：取走最新发布的槽
+
 /*PID相关声明*/
 /**
  * @brief PID 控制器结构体
@@ -31,6 +53,7 @@ void abs_limit(float *a, float ABS_MAX);
  * - **控制量变化**：包括控制量变化（delta_u）和基于变化量的输出（delta_out），用于改进控制响应。
  * - **限制条件**：包括最大误差（max_err）、死区误差（deadband）、最大输出限制（MaxOutput）、积分限制（IntegralLimit）等，防止控制器输出异常。
  * - **函数指针**：包含初始化和重置 PID 参数的函数指针，允许动态修改 PID 控制器的行为。
+ * - **待生效增益**：pid_dynamic_set 写入的增益先放在三槽快照里，下一次 PID 计算开始时整体换入 p/i/d。
  * 
  * @struct __pid_t
  */
@@ -71,6 +94,9 @@ typedef struct __pid_t
 
     // 函数指针：用于重置PID参数
     void (*f_pid_reset)(struct __pid_t *pid, float p, float i, float d); // 重置PID的三个参数
+
+    float gain_slot[SNAPSHOT_SLOTS][3];  // 待生效增益 {p, i, d}，由 gain_index 管理
+    snapshot_index_t gain_index;         // 增益快照索引
 } pid_t;
 
 
@@ -83,7 +109,7 @@ void PID_struct_init(
     float ki,
     float kd);
 /**
- * @brief 用于动态调整PID三个参数
+ * @brief 用于动态调整PID三个参数，可在控制中断运行时从主循环调用，下一次PID计算开始时生效
 */
 void pid_dynamic_set(
     pid_t *pid, 
@@ -92,6 +118,8 @@ void pid_dynamic_set(
     float kd    
 );
 
+void pid_gain_sync(pid_t *pid);  // 换入待生效增益，PID计算函数开头会自动调用
+
 float general_pid_calc(pid_t *pid, float get, float set, char* mode);
 
 
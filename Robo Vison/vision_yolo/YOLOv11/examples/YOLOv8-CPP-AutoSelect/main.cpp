@@ -0,0 +1,148 @@
+// Runs a YOLOv8 model on whichever backend built in is fastest on this machine. On the first start every backend
+// is loaded in turn and timed on the image (../YOLOv8-CPP-Common/backend_probe.h); the winner is cached per model
+// and image size in backend_probe.txt, and later starts load only that backend.
+//
+// Usage: ./yolov8_autoselect <model.onnx> <image> [model.torchscript [cache_file]]
+
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "backend_probe.h"
+
+#ifdef WITH_ONNXRUNTIME
+#include "../YOLOv8-ONNXRuntime-CPP/ort_detector.h"
+#endif
+#ifdef WITH_OPENCV_DNN
+#include "../YOLOv8-CPP-Inference/dnn_detector.h"
+#endif
+#ifdef WITH_OPENVINO
+#include "../YOLOv8-OpenVINO-CPP-Inference/openvino_detector.h"
+#endif
+#ifdef WITH_LIBTORCH
+#include "../YOLOv8-LibTorch-CPP-Inference/libtorch_detector.h"
+#endif
+
+
+// What the decision depends on besides the candidates: the model files as they are now and the frame size
+static std::string CacheKey(const std::vector<std::string>& modelPaths, const cv::Mat& image)
+{
+    std::string key;
+    for (const std::string& path : modelPaths)
+    {
+        std::error_code error;
+        const auto size = std::filesystem::file_size(path, error);
+        const auto mtime = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+        key += std::filesystem::absolute(path).string() + ":" + std::to_string(size) + ":" + std::to_string(mtime) + "|";
+    }
+    return key + std::to_string(image.cols) + "x" + std::to_string(image.rows);
+}
+
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "usage: " << argv[0] << " <model.onnx> <image> [model.torchscript [cache_file]]" << std::endl;
+        return 1;
+    }
+    const std::string onnxPath = argv[1];
+    const std::string torchScriptPath = argc > 3 ? argv[3] : "";
+    cv::Mat image = cv::imread(argv[2]);
+    if (image.empty())
+    {
+        std::cerr << "cannot read " << argv[2] << std::endl;
+        return 1;
+    }
+
+    // Candidates in order of preference on a tie; each returns nullptr when it can't run here
+    std::vector<yolo::BackendCandidate> candidates;
+#ifdef WITH_ONNXRUNTIME
+    for (bool cuda : { true, false })
+    {
+        candidates.push_back({ cuda ? "onnxruntime-cuda" : "onnxruntime-cpu", [onnxPath, cuda]() {
+            DL_INIT_PARAM params;
+            params.modelPath = onnxPath;
+            params.rectConfidenceThreshold = 0.25;
+            params.cudaEnable = cuda;
+            return std::unique_ptr<yolo::IDetector>(ORT_DETECTOR::Create(params));
+        } });
+    }
+#endif
+#ifdef WITH_OPENVINO
+    candidates.push_back({ "openvino-auto", [onnxPath]() {
+        return std::unique_ptr<yolo::IDetector>(yolo::OpenVinoDetector::Create(onnxPath, cv::Size(640, 640), 0.25f));
+    } });
+#endif
+#ifdef WITH_LIBTORCH
+    if (!torchScriptPath.empty())
+    {
+        for (bool cuda : { true, false })
+        {
+            candidates.push_back({ cuda ? "libtorch-cuda" : "libtorch-cpu", [torchScriptPath, cuda]() {
+                return std::unique_ptr<yolo::IDetector>(
+                    LibTorchDetector::create(torchScriptPath, cuda ? torch::Device(torch::kCUDA) : torch::Device(torch::kCPU)));
+            } });
+        }
+    }
+#endif
+#ifdef WITH_OPENCV_DNN
+    for (bool cuda : { true, false })
+    {
+        candidates.push_back({ cuda ? "opencv-dnn-cuda" : "opencv-dnn-cpu", [onnxPath, cuda]() {
+            return std::unique_ptr<yolo::IDetector>(DnnDetector::create(onnxPath, cv::Size(640, 640), cuda));
+        } });
+    }
+#endif
+
+    yolo::ImageView frame;
+    frame.data = image.data;
+    frame.width = image.cols;
+    frame.height = image.rows;
+    frame.stride = image.step;
+
+    yolo::ProbeOptions options;
+    options.cache_path = argc > 4 ? argv[4] : "backend_probe.txt";
+    std::vector<std::string> modelPaths = { onnxPath };
+    if (!torchScriptPath.empty())
+    {
+        modelPaths.push_back(torchScriptPath);
+    }
+    options.cache_key = CacheKey(modelPaths, image);
+
+    std::vector<yolo::BackendTiming> timings;
+    std::unique_ptr<yolo::IDetector> detector = yolo::SelectFastestBackend(candidates, frame, options, &timings);
+    std::cout << std::fixed << std::setprecision(2);
+    for (const yolo::BackendTiming& timing : timings)
+    {
+        std::cout << "  " << std::left << std::setw(18) << timing.name << std::right;
+        if (timing.available)
+        {
+            std::cout << std::setw(9) << timing.median_ms << " ms\n";
+        }
+        else
+        {
+            std::cout << "  unavailable\n";
+        }
+    }
+    if (!detector)
+    {
+        std::cerr << "no backend could run " << onnxPath << std::endl;
+        return 1;
+    }
+    std::cout << "Backend: " << detector->Name() << (timings.empty() ? " (cached in " + options.cache_path + ")" : "")
+              << std::endl;
+
+    yolo::DetectionResults results;
+    detector->Detect(frame, results);
+    for (const yolo::DetectedObject& object : results)
+    {
+        std::cout << "Rect: [" << object.x << "," << object.y << "," << object.width << "," << object.height
+                  << "]  Conf: " << object.score << "  Class: " << object.class_id << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,172 @@
+#ifndef YOLO_BACKEND_PROBE_H_
+#define YOLO_BACKEND_PROBE_H_
+
+// Startup selection of the fastest detector backend on this machine, for the model at hand.
+//
+// The application lists the backends it was built with as candidates (IDetector factories, detector.h), each
+// returning nullptr when its engine or device isn't usable here. SelectFastestBackend creates them one at a
+// time, times Detect on a representative frame (median after warm-up) and keeps the lowest-latency one. Only the
+// best so far and the one being timed are alive, so candidates don't compete for memory or cores.
+//
+// The decision is cached in a small text file, one line per key: the caller's key (model file, input size, ...)
+// plus the candidate names. A later start with the same key creates the cached winner directly and skips the
+// probe; if that backend no longer loads (driver gone, library missing) it probes again. The file is rewritten
+// through a pending file of the writer's own and a rename (model_cache.h), so neither a reboot during the write nor
+// two processes probing at once leave a torn file; of two concurrent writers the later rename wins.
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "detector.h"
+#include "model_cache.h"
+
+namespace yolo {
+
+struct BackendCandidate {
+	std::string name;                                    // Unique among the candidates, stored in the cache
+	std::function<std::unique_ptr<IDetector>()> create;  // nullptr when the backend can't run here
+};
+
+struct BackendTiming {
+	std::string name;
+	bool available = false;  // Created and detected without failing
+	double median_ms = 0.0;
+};
+
+struct ProbeOptions {
+	int warmup = 3;          // Untimed Detect calls first (lazy allocation, kernel selection, caches)
+	int iterations = 20;
+	std::string cache_path;  // Decision file, empty to probe on every start
+	std::string cache_key;   // What the decision depends on besides the candidates, e.g. model path, size, mtime
+};
+
+namespace detail {
+
+inline std::string ProbeKey(const std::vector<BackendCandidate> &candidates, const ProbeOptions &options) {
+	std::string key = options.cache_key + '|';
+	for (const BackendCandidate &candidate : candidates) {
+		key += candidate.name + ',';
+	}
+	return key;
+}
+
+// The backend name cached for key, empty if none
+inline std::string ReadDecision(const std::string &path, const std::string &key) {
+	std::ifstream file(path);
+	std::string line;
+	while (std::getline(file, line)) {
+		const size_t name_end = line.find('\t', key.size() + 1);
+		if (name_end != std::string::npos && line.compare(0, key.size() + 1, key + '\t') == 0) {
+			return line.substr(key.size() + 1, name_end - key.size() - 1);
+		}
+	}
+	return std::string();
+}
+
+inline bool WriteDecision(const std::string &path, const std::string &key, const std::string &name, double median_ms) {
+	std::vector<std::string> lines;
+	{
+		std::ifstream file(path);
+		std::string line;
+		while (std::getline(file, line)) {
+			if (line.compare(0, key.size() + 1, key + '\t') != 0) {
+				lines.push_back(line);
+			}
+		}
+	}
+	std::ostringstream decision;
+	decision << key << '\t' << name << '\t' << median_ms;
+	lines.push_back(decision.str());
+
+	const std::filesystem::path pending = PendingCachePath(path);
+	{
+		std::ofstream file(pending, std::ios::trunc);
+		for (const std::string &line : lines) {
+			file << line << '\n';
+		}
+		if (!file.flush()) {
+			file.close();
+			std::error_code error;
+			std::filesystem::remove(pending, error);
+			return false;
+		}
+	}
+	return CommitCacheFile(pending, path);
+}
+
+} // namespace detail
+
+// Median Detect latency in ms over iterations calls after warmup, negative when a call fails
+inline double MedianDetectMs(IDetector &detector, const ImageView &frame, int warmup, int iterations) {
+	DetectionResults results;
+	for (int i = 0; i < warmup; ++i) {
+		if (!detector.Detect(frame, results)) {
+			return -1.0;
+		}
+	}
+	std::vector<double> samples;
+	for (int i = 0; i < std::max(1, iterations); ++i) {
+		const auto start = std::chrono::steady_clock::now();
+		if (!detector.Detect(frame, results)) {
+			return -1.0;
+		}
+		samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+	return samples[samples.size() / 2];
+}
+
+// The fastest available candidate on frame, nullptr when none runs. timings, if given, gets one entry per
+// candidate probed (empty when the cached decision was used).
+inline std::unique_ptr<IDetector> SelectFastestBackend(const std::vector<BackendCandidate> &candidates,
+		const ImageView &frame, const ProbeOptions &options, std::vector<BackendTiming> *timings = nullptr) {
+	if (timings) {
+		timings->clear();
+	}
+	const std::string key = detail::ProbeKey(candidates, options);
+	if (!options.cache_path.empty()) {
+		const std::string cached = detail::ReadDecision(options.cache_path, key);
+		for (const BackendCandidate &candidate : candidates) {
+			if (!cached.empty() && candidate.name == cached) {
+				std::unique_ptr<IDetector> detector = candidate.create();
+				if (detector) {
+					return detector;
+				}
+			}
+		}
+	}
+
+	std::unique_ptr<IDetector> best;
+	std::string best_name;
+	double best_ms = 0.0;
+	for (const BackendCandidate &candidate : candidates) {
+		BackendTiming timing;
+		timing.name = candidate.name;
+		std::unique_ptr<IDetector> detector = candidate.create();
+		if (detector) {
+			timing.median_ms = MedianDetectMs(*detector, frame, options.warmup, options.iterations);
+			timing.available = timing.median_ms >= 0.0;
+		}
+		if (timing.available && (!best || timing.median_ms < best_ms)) {
+			best = std::move(detector);
+			best_name = candidate.name;
+			best_ms = timing.median_ms;
+		}
+		if (timings) {
+			timings->push_back(timing);
+		}
+	}
+	if (best && !options.cache_path.empty()) {
+		detail::WriteDecision(options.cache_path, key, best_name, best_ms);
+	}
+	return best;
+}
+
+} // namespace yolo
+
+#endif // YOLO_BACKEND_PROBE_H_
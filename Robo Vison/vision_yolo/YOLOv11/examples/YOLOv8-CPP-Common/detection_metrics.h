@@ -0,0 +1,185 @@
+#ifndef YOLO_DETECTION_METRICS_H_
+#define YOLO_DETECTION_METRICS_H_
+
+// Box mAP as ultralytics val reports it, for comparing models (precisions, exports) from the C++ examples.
+//
+// Per image and per IoU threshold (0.50:0.05:0.95), predictions are matched to ground truth of the same class as
+// in DetectionValidator.match_predictions: pairs with IoU >= threshold, highest IoU first, each prediction and
+// each ground-truth box used once. Per class (classes with ground truth only), the matches are sorted by
+// confidence into a precision/recall curve, and AP is the 101-point interpolated area under its envelope
+// (metrics.compute_ap, np.interp semantics included, so a perfect class scores 0.995 there as here).
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <vector>
+
+namespace yolo {
+
+struct EvalBox {
+	float x1 = 0.0f;
+	float y1 = 0.0f;
+	float x2 = 0.0f;
+	float y2 = 0.0f;
+	int class_id = 0;
+	float score = 1.0f;   // Confidence of predictions, unused for ground truth
+};
+
+struct DetectionSummary {
+	double map50 = 0.0;
+	double map50_95 = 0.0;
+	size_t images = 0;
+	size_t ground_truth = 0;
+	size_t predictions = 0;
+	size_t classes = 0;   // Classes with ground truth, the ones averaged
+};
+
+class DetectionMetrics {
+ public:
+	static constexpr int kThresholds = 10;
+
+	void AddImage(const std::vector<EvalBox> &predictions, const std::vector<EvalBox> &ground_truth);
+
+	DetectionSummary Compute() const;
+
+	// metrics.compute_ap on one class: recall and precision in confidence order
+	static double AveragePrecision(const std::vector<double> &recall, const std::vector<double> &precision);
+
+	static float Iou(const EvalBox &a, const EvalBox &b) {
+		const float w = std::max(0.0f, std::min(a.x2, b.x2) - std::max(a.x1, b.x1));
+		const float h = std::max(0.0f, std::min(a.y2, b.y2) - std::max(a.y1, b.y1));
+		const float inter = w * h;
+		const float uni = (a.x2 - a.x1) * (a.y2 - a.y1) + (b.x2 - b.x1) * (b.y2 - b.y1) - inter;
+		return uni > 0.0f ? inter / uni : 0.0f;
+	}
+
+ private:
+	struct Match {
+		float score;
+		bool tp[kThresholds];
+	};
+
+	std::map<int, std::vector<Match>> predictions_;   // Per predicted class
+	std::map<int, size_t> ground_truth_;              // Boxes per class
+	size_t images_ = 0;
+};
+
+inline void DetectionMetrics::AddImage(const std::vector<EvalBox> &predictions,
+                                       const std::vector<EvalBox> &ground_truth) {
+	images_++;
+	for (const EvalBox &g : ground_truth) {
+		ground_truth_[g.class_id]++;
+	}
+	std::vector<Match> matches(predictions.size());
+	for (size_t p = 0; p < predictions.size(); p++) {
+		matches[p].score = predictions[p].score;
+		std::fill(matches[p].tp, matches[p].tp + kThresholds, false);
+	}
+	// Same-class pairs by IoU, best first; stable so ties keep the (ground truth, prediction) order numpy gives
+	struct Pair {
+		float iou;
+		size_t g;
+		size_t p;
+	};
+	std::vector<Pair> pairs;
+	for (size_t g = 0; g < ground_truth.size(); g++) {
+		for (size_t p = 0; p < predictions.size(); p++) {
+			if (predictions[p].class_id == ground_truth[g].class_id) {
+				const float iou = Iou(ground_truth[g], predictions[p]);
+				if (iou > 0.0f) {
+					pairs.push_back({iou, g, p});
+				}
+			}
+		}
+	}
+	std::stable_sort(pairs.begin(), pairs.end(), [](const Pair &a, const Pair &b) { return a.iou > b.iou; });
+	std::vector<char> used_g, used_p;
+	for (int t = 0; t < kThresholds; t++) {
+		const float threshold = 0.5f + 0.05f * t;
+		used_g.assign(ground_truth.size(), 0);
+		used_p.assign(predictions.size(), 0);
+		for (const Pair &pair : pairs) {
+			if (pair.iou < threshold) {
+				break;
+			}
+			if (!used_g[pair.g] && !used_p[pair.p]) {
+				used_g[pair.g] = used_p[pair.p] = 1;
+				matches[pair.p].tp[t] = true;
+			}
+		}
+	}
+	for (size_t p = 0; p < predictions.size(); p++) {
+		predictions_[predictions[p].class_id].push_back(matches[p]);
+	}
+}
+
+inline double DetectionMetrics::AveragePrecision(const std::vector<double> &recall,
+                                                 const std::vector<double> &precision) {
+	// Sentinels, then the precision envelope from the right
+	std::vector<double> mrec(1, 0.0), mpre(1, 1.0);
+	mrec.insert(mrec.end(), recall.begin(), recall.end());
+	mpre.insert(mpre.end(), precision.begin(), precision.end());
+	mrec.push_back(1.0);
+	mpre.push_back(0.0);
+	for (size_t i = mpre.size() - 1; i > 0; i--) {
+		mpre[i - 1] = std::max(mpre[i - 1], mpre[i]);
+	}
+	// np.interp on 101 points (x in [0, 1], the last point on the sentinel gives 0), then np.trapz
+	auto interp = [&](double x) {
+		if (x >= mrec.back()) {
+			return mpre.back();
+		}
+		const size_t j = static_cast<size_t>(std::upper_bound(mrec.begin(), mrec.end(), x) - mrec.begin()) - 1;
+		return mpre[j] + (x - mrec[j]) * (mpre[j + 1] - mpre[j]) / (mrec[j + 1] - mrec[j]);
+	};
+	double ap = 0.0;
+	double previous = interp(0.0);
+	for (int i = 1; i <= 100; i++) {
+		const double value = interp(i / 100.0);
+		ap += (previous + value) / 2.0 * 0.01;
+		previous = value;
+	}
+	return ap;
+}
+
+inline DetectionSummary DetectionMetrics::Compute() const {
+	DetectionSummary summary;
+	summary.images = images_;
+	double ap50 = 0.0, ap50_95 = 0.0;
+	for (const auto &gt : ground_truth_) {
+		summary.ground_truth += gt.second;
+		summary.classes++;
+		auto found = predictions_.find(gt.first);
+		if (found == predictions_.end() || found->second.empty()) {
+			continue;
+		}
+		std::vector<Match> sorted = found->second;
+		std::stable_sort(sorted.begin(), sorted.end(), [](const Match &a, const Match &b) { return a.score > b.score; });
+		for (int t = 0; t < kThresholds; t++) {
+			std::vector<double> recall, precision;
+			double tp = 0.0, fp = 0.0;
+			for (const Match &m : sorted) {
+				m.tp[t] ? tp++ : fp++;
+				recall.push_back(tp / (static_cast<double>(gt.second) + 1e-16));
+				precision.push_back(tp / (tp + fp));
+			}
+			const double ap = AveragePrecision(recall, precision);
+			ap50_95 += ap / kThresholds;
+			if (t == 0) {
+				ap50 += ap;
+			}
+		}
+	}
+	for (const auto &p : predictions_) {
+		summary.predictions += p.second.size();
+	}
+	if (summary.classes > 0) {
+		summary.map50 = ap50 / summary.classes;
+		summary.map50_95 = ap50_95 / summary.classes;
+	}
+	return summary;
+}
+
+}  // namespace yolo
+
+#endif  // YOLO_DETECTION_METRICS_H_
@@ -0,0 +1,80 @@
+#ifndef YOLO_DETECTOR_H_
+#define YOLO_DETECTOR_H_
+
+// One detector interface over the C++ backends: ONNX Runtime (YOLO_V8), OpenCV DNN (Inference), OpenVINO
+// (yolo::Inference) and LibTorch. Each example folder has an adapter implementing it, so an application or the
+// backend probe (backend_probe.h) can swap engines without touching the code around them.
+//
+// Frames come in as a view of BGR u8 pixels, which every backend wraps without a copy. Results go to a
+// caller-owned DetectionResults whose storage is allocated once at construction: Detect overwrites it and never
+// grows it, so a steady detection loop allocates nothing for its results.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "stage_times.h"
+
+namespace yolo {
+
+// Interleaved BGR u8 pixels, not owned
+struct ImageView {
+	const uint8_t *data = nullptr;
+	int width = 0;
+	int height = 0;
+	size_t stride = 0;  // Bytes from one row to the next, at least 3 * width
+};
+
+// Axis-aligned box in frame pixels
+struct DetectedObject {
+	float x = 0.0f;       // Left
+	float y = 0.0f;       // Top
+	float width = 0.0f;
+	float height = 0.0f;
+	float score = 0.0f;
+	int class_id = 0;
+};
+
+// Fixed-capacity result buffer, reused from frame to frame
+class DetectionResults {
+ public:
+	explicit DetectionResults(size_t capacity = 300) : objects_(capacity) {}
+
+	void clear() { size_ = 0; }
+	// False when the buffer is full, the object is dropped
+	bool push_back(const DetectedObject &object) {
+		if (size_ == objects_.size()) {
+			return false;
+		}
+		objects_[size_++] = object;
+		return true;
+	}
+
+	size_t size() const { return size_; }
+	size_t capacity() const { return objects_.size(); }
+	bool empty() const { return size_ == 0; }
+	const DetectedObject &operator[](size_t i) const { return objects_[i]; }
+	const DetectedObject *begin() const { return objects_.data(); }
+	const DetectedObject *end() const { return objects_.data() + size_; }
+
+ private:
+	std::vector<DetectedObject> objects_;
+	size_t size_ = 0;
+};
+
+class IDetector {
+ public:
+	virtual ~IDetector() = default;
+
+	// Backend and device, e.g. "onnxruntime-cpu"
+	virtual const char *Name() const = 0;
+
+	// Replaces results with the detections in frame after NMS, best first, at most results.capacity().
+	// Returns false when the backend failed, results are then empty. times, if given, gets the wall-clock time of
+	// the backend's stages (stage_times.h).
+	virtual bool Detect(const ImageView &frame, DetectionResults &results, StageTimes *times = nullptr) = 0;
+};
+
+} // namespace yolo
+
+#endif // YOLO_DETECTOR_H_
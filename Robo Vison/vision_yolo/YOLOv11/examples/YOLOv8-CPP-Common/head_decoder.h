@@ -0,0 +1,239 @@
+#ifndef YOLO_HEAD_DECODER_H_
+#define YOLO_HEAD_DECODER_H_
+
+// YOLOv8 detection head decoder shared by the C++ examples.
+//
+// Works directly on the channel-major output the models produce ([4 + classes (+ extra)] x anchors, one row
+// per channel), so there is no transpose and no per-anchor cv::Mat / cv::minMaxLoc. Each SIMD lane is one
+// anchor: the best class score and its index are tracked across the class rows (8 anchors per vector with
+// AVX2, 16 with AVX-512, 4 with NEON, several vectors in flight). Anchors whose best score does not pass the
+// threshold are rejected with one compare per vector; only survivors have their box read, and they are
+// written into arrays that are sized once and reused.
+//
+// Results are bit-identical to the per-anchor cv::minMaxLoc loop: the same scan from -FLT_MAX with strict '>'
+// in class order (first class wins ties, NaN never wins), scores copied unchanged, candidates in anchor order.
+
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "trace.h"
+
+#if defined(__AVX512F__)
+#define YOLO_HEAD_DECODER_AVX512 1
+#include <immintrin.h>
+#elif defined(__AVX2__)
+#define YOLO_HEAD_DECODER_AVX2 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define YOLO_HEAD_DECODER_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace yolo {
+
+// Anchors that passed the threshold, structure of arrays. Only the first count entries are valid.
+struct HeadCandidates {
+	std::vector<float> score;     // Best class score
+	std::vector<int> class_id;    // Class index of that score
+	std::vector<int> anchor;      // Column in the head output (for keypoint / mask rows of the same anchor)
+	std::vector<float> box;       // cx, cy, w, h per candidate, model input coordinates
+	size_t count = 0;
+
+	void Reserve(size_t anchors) {
+		if (score.size() < anchors) {
+			score.resize(anchors);
+			class_id.resize(anchors);
+			anchor.resize(anchors);
+			box.resize(4 * anchors);
+		}
+	}
+};
+
+namespace detail {
+
+inline int LowestBit(uint32_t mask) {
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+inline void EmitCandidate(const float *output, int anchors, int anchor, float score, int class_id,
+                          HeadCandidates &out) {
+	const size_t n = out.count++;
+	out.score[n] = score;
+	out.class_id[n] = class_id;
+	out.anchor[n] = anchor;
+	out.box[4 * n + 0] = output[anchor];
+	out.box[4 * n + 1] = output[anchors + anchor];
+	out.box[4 * n + 2] = output[2 * static_cast<size_t>(anchors) + anchor];
+	out.box[4 * n + 3] = output[3 * static_cast<size_t>(anchors) + anchor];
+}
+
+// Lanes of one vector block: emit the set bits of mask in lane order
+inline void EmitLanes(const float *output, int anchors, int first, uint32_t mask, const float *scores,
+                      const int *ids, HeadCandidates &out) {
+	while (mask != 0) {
+		const int lane = LowestBit(mask);
+		EmitCandidate(output, anchors, first + lane, scores[lane], ids[lane], out);
+		mask &= mask - 1;
+	}
+}
+
+}  // namespace detail
+
+// output: head of one image, row r starts at output + r * anchors. Rows 0-3 are the box (cx, cy, w, h), class
+// scores are rows class_row .. class_row + num_classes - 1. Keeps anchors whose best class score is
+// > threshold. Returns out.count.
+inline size_t DecodeHead(const float *output, int anchors, int class_row, int num_classes, float threshold,
+                         HeadCandidates &out) {
+	YOLO_TRACE_ZONE("DecodeHead");
+	out.Reserve(static_cast<size_t>(anchors));
+	out.count = 0;
+	if (num_classes <= 0) {
+		return 0;
+	}
+	const float *scores = output + static_cast<size_t>(class_row) * anchors;
+	int a = 0;
+
+#if defined(YOLO_HEAD_DECODER_AVX512)
+	constexpr int kLanes = 16;
+	constexpr int kVectors = 4;
+	const __m512 threshold_v = _mm512_set1_ps(threshold);
+	alignas(64) float lane_scores[kLanes];
+	alignas(64) int lane_ids[kLanes];
+	for (; a + kLanes <= anchors; a += kLanes * kVectors) {
+		const int vectors = (anchors - a) / kLanes < kVectors ? (anchors - a) / kLanes : kVectors;
+		__m512 best[kVectors];
+		__m512i ids[kVectors];
+		for (int v = 0; v < vectors; v++) {
+			best[v] = _mm512_set1_ps(-FLT_MAX);
+			ids[v] = _mm512_setzero_si512();
+		}
+		for (int c = 0; c < num_classes; c++) {
+			const float *row = scores + static_cast<size_t>(c) * anchors + a;
+			const __m512i class_v = _mm512_set1_epi32(c);
+			for (int v = 0; v < vectors; v++) {
+				const __m512 value = _mm512_loadu_ps(row + v * kLanes);
+				const __mmask16 greater = _mm512_cmp_ps_mask(value, best[v], _CMP_GT_OQ);
+				best[v] = _mm512_mask_blend_ps(greater, best[v], value);
+				ids[v] = _mm512_mask_blend_epi32(greater, ids[v], class_v);
+			}
+		}
+		for (int v = 0; v < vectors; v++) {
+			const uint32_t mask = _mm512_cmp_ps_mask(best[v], threshold_v, _CMP_GT_OQ);
+			if (mask != 0) {
+				_mm512_store_ps(lane_scores, best[v]);
+				_mm512_store_si512(lane_ids, ids[v]);
+				detail::EmitLanes(output, anchors, a + v * kLanes, mask, lane_scores, lane_ids, out);
+			}
+		}
+		if (vectors < kVectors) {
+			a += vectors * kLanes - kLanes * kVectors;  // Leave a at the first anchor not covered
+		}
+	}
+#elif defined(YOLO_HEAD_DECODER_AVX2)
+	constexpr int kLanes = 8;
+	constexpr int kVectors = 4;
+	const __m256 threshold_v = _mm256_set1_ps(threshold);
+	alignas(32) float lane_scores[kLanes];
+	alignas(32) int lane_ids[kLanes];
+	for (; a + kLanes <= anchors; a += kLanes * kVectors) {
+		const int vectors = (anchors - a) / kLanes < kVectors ? (anchors - a) / kLanes : kVectors;
+		__m256 best[kVectors];
+		__m256 ids[kVectors];  // Class indices as int32 bits, blended as floats
+		for (int v = 0; v < vectors; v++) {
+			best[v] = _mm256_set1_ps(-FLT_MAX);
+			ids[v] = _mm256_setzero_ps();
+		}
+		for (int c = 0; c < num_classes; c++) {
+			const float *row = scores + static_cast<size_t>(c) * anchors + a;
+			const __m256 class_v = _mm256_castsi256_ps(_mm256_set1_epi32(c));
+			for (int v = 0; v < vectors; v++) {
+				const __m256 value = _mm256_loadu_ps(row + v * kLanes);
+				const __m256 greater = _mm256_cmp_ps(value, best[v], _CMP_GT_OQ);
+				best[v] = _mm256_blendv_ps(best[v], value, greater);
+				ids[v] = _mm256_blendv_ps(ids[v], class_v, greater);
+			}
+		}
+		for (int v = 0; v < vectors; v++) {
+			const uint32_t mask = static_cast<uint32_t>(
+			    _mm256_movemask_ps(_mm256_cmp_ps(best[v], threshold_v, _CMP_GT_OQ)));
+			if (mask != 0) {
+				_mm256_store_ps(lane_scores, best[v]);
+				_mm256_store_si256(reinterpret_cast<__m256i *>(lane_ids), _mm256_castps_si256(ids[v]));
+				detail::EmitLanes(output, anchors, a + v * kLanes, mask, lane_scores, lane_ids, out);
+			}
+		}
+		if (vectors < kVectors) {
+			a += vectors * kLanes - kLanes * kVectors;
+		}
+	}
+#elif defined(YOLO_HEAD_DECODER_NEON)
+	constexpr int kLanes = 4;
+	constexpr int kVectors = 4;
+	const float32x4_t threshold_v = vdupq_n_f32(threshold);
+	float lane_scores[kLanes];
+	int lane_ids[kLanes];
+	for (; a + kLanes <= anchors; a += kLanes * kVectors) {
+		const int vectors = (anchors - a) / kLanes < kVectors ? (anchors - a) / kLanes : kVectors;
+		float32x4_t best[kVectors];
+		int32x4_t ids[kVectors];
+		for (int v = 0; v < vectors; v++) {
+			best[v] = vdupq_n_f32(-FLT_MAX);
+			ids[v] = vdupq_n_s32(0);
+		}
+		for (int c = 0; c < num_classes; c++) {
+			const float *row = scores + static_cast<size_t>(c) * anchors + a;
+			const int32x4_t class_v = vdupq_n_s32(c);
+			for (int v = 0; v < vectors; v++) {
+				const float32x4_t value = vld1q_f32(row + v * kLanes);
+				const uint32x4_t greater = vcgtq_f32(value, best[v]);
+				best[v] = vbslq_f32(greater, value, best[v]);
+				ids[v] = vbslq_s32(greater, class_v, ids[v]);
+			}
+		}
+		for (int v = 0; v < vectors; v++) {
+			const uint32x4_t passed = vcgtq_f32(best[v], threshold_v);
+			if (vmaxvq_u32(passed) != 0) {
+				const uint32_t mask = (vgetq_lane_u32(passed, 0) & 1u) | (vgetq_lane_u32(passed, 1) & 2u) |
+				                      (vgetq_lane_u32(passed, 2) & 4u) | (vgetq_lane_u32(passed, 3) & 8u);
+				vst1q_f32(lane_scores, best[v]);
+				vst1q_s32(lane_ids, ids[v]);
+				detail::EmitLanes(output, anchors, a + v * kLanes, mask, lane_scores, lane_ids, out);
+			}
+		}
+		if (vectors < kVectors) {
+			a += vectors * kLanes - kLanes * kVectors;
+		}
+	}
+#endif
+
+	for (; a < anchors; a++) {
+		float best = -FLT_MAX;
+		int id = 0;
+		for (int c = 0; c < num_classes; c++) {
+			const float value = scores[static_cast<size_t>(c) * anchors + a];
+			if (value > best) {
+				best = value;
+				id = c;
+			}
+		}
+		if (best > threshold) {
+			detail::EmitCandidate(output, anchors, a, best, id, out);
+		}
+	}
+	return out.count;
+}
+
+}  // namespace yolo
+
+#endif  // YOLO_HEAD_DECODER_H_
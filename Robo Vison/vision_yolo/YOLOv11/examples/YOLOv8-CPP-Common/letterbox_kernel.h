@@ -0,0 +1,478 @@
+#ifndef YOLO_LETTERBOX_KERNEL_H_
+#define YOLO_LETTERBOX_KERNEL_H_
+
+// Fused letterbox preprocessing shared by the C++ examples.
+//
+// One pass over the BGR/BGRA/gray u8 frame produces the normalized RGB planar (NCHW) input tensor:
+// resize (bilinear or area) + channel swap + scale/mean/std + HWC->CHW + padding, written straight
+// into a caller-owned buffer (float or FP16 bits). Sampling tables and per-thread row caches live in
+// the kernel object and are rebuilt only when the geometry changes, so steady-state frames do no
+// heap allocation. Rows split across threads run on workers the kernel starts once (worker_pool.h).
+//
+// SIMD: AVX2+FMA (+F16C for FP16 stores) on x86, NEON on aarch64, scalar elsewhere. Compile with
+// -mavx2 -mfma -mf16c (or /arch:AVX2) to enable the x86 path.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "worker_pool.h"
+
+// MSVC /arch:AVX2 implies FMA and F16C but only defines __AVX2__
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#define YOLO_LETTERBOX_AVX2 1
+#if defined(__F16C__) || defined(_MSC_VER)
+#define YOLO_LETTERBOX_F16C 1
+#endif
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define YOLO_LETTERBOX_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace yolo {
+
+enum class ResizeFilter {
+	kBilinear,  // Same sampling as cv::INTER_LINEAR
+	kArea,      // Box filter when shrinking (cv::INTER_AREA), bilinear when enlarging
+};
+
+enum class PadAlign {
+	kTopLeft,  // Image at (0, 0), padding right/bottom (what YOLO_V8::PreProcess did)
+	kCenter,   // Image centred, padding split on both sides (Ultralytics LetterBox)
+};
+
+struct LetterboxParams {
+	int dst_width = 640;
+	int dst_height = 640;
+	ResizeFilter filter = ResizeFilter::kBilinear;
+	PadAlign align = PadAlign::kTopLeft;
+	bool keep_ratio = true;     // false stretches the frame to the full input size
+	bool swap_rb = true;        // BGR in, RGB planes out
+	float pad_value = 0.0f;     // Pad colour in u8 units, normalized like the pixels
+	float scale = 1.0f / 255.0f;
+	float mean[3] = {0.0f, 0.0f, 0.0f};  // Per output plane, applied after scale
+	float std[3] = {1.0f, 1.0f, 1.0f};
+	int threads = 1;            // Output rows split across this many threads
+};
+
+// Maps model coordinates back to the frame: x_frame = (x_model - pad_x) * scale_x.
+struct LetterboxInfo {
+	float scale_x = 1.0f;
+	float scale_y = 1.0f;
+	int pad_x = 0;
+	int pad_y = 0;
+	int width = 0;   // Size of the resized image inside the input tensor
+	int height = 0;
+};
+
+namespace detail {
+
+// IEEE 754 binary32 -> binary16, round to nearest even.
+inline uint16_t FloatToHalf(float value) {
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	const uint32_t sign = (bits >> 16) & 0x8000u;
+	uint32_t mantissa = bits & 0x7FFFFFu;
+	const int exponent = static_cast<int>((bits >> 23) & 0xFFu);
+	if (exponent == 0xFF) {
+		return static_cast<uint16_t>(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+	}
+	const int half_exponent = exponent - 127 + 15;
+	if (half_exponent >= 0x1F) {
+		return static_cast<uint16_t>(sign | 0x7C00u);
+	}
+	if (half_exponent <= 0) {
+		if (half_exponent < -10) {
+			return static_cast<uint16_t>(sign);
+		}
+		mantissa |= 0x800000u;
+		const int shift = 14 - half_exponent;
+		uint32_t half = mantissa >> shift;
+		const uint32_t rest = mantissa & ((1u << shift) - 1u);
+		const uint32_t middle = 1u << (shift - 1);
+		if (rest > middle || (rest == middle && (half & 1u))) {
+			half++;
+		}
+		return static_cast<uint16_t>(sign | half);
+	}
+	uint32_t half = sign | (static_cast<uint32_t>(half_exponent) << 10) | (mantissa >> 13);
+	const uint32_t rest = mantissa & 0x1FFFu;
+	if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) {
+		half++;
+	}
+	return static_cast<uint16_t>(half);
+}
+
+inline void StoreValue(float value, float *out) { *out = value; }
+inline void StoreValue(float value, uint16_t *out) { *out = FloatToHalf(value); }
+
+// out[x] = (sum_t weights[t] * rows[t][x]) * a + b
+inline void BlendRow(const float *const *rows, const float *weights, int taps, int count, float a, float b,
+                     float *out) {
+	int x = 0;
+#if defined(YOLO_LETTERBOX_AVX2)
+	const __m256 va = _mm256_set1_ps(a);
+	const __m256 vb = _mm256_set1_ps(b);
+	for (; x + 8 <= count; x += 8) {
+		__m256 acc = _mm256_mul_ps(_mm256_set1_ps(weights[0]), _mm256_loadu_ps(rows[0] + x));
+		for (int t = 1; t < taps; t++) {
+			acc = _mm256_fmadd_ps(_mm256_set1_ps(weights[t]), _mm256_loadu_ps(rows[t] + x), acc);
+		}
+		_mm256_storeu_ps(out + x, _mm256_fmadd_ps(acc, va, vb));
+	}
+#elif defined(YOLO_LETTERBOX_NEON)
+	const float32x4_t va = vdupq_n_f32(a);
+	const float32x4_t vb = vdupq_n_f32(b);
+	for (; x + 4 <= count; x += 4) {
+		float32x4_t acc = vmulq_n_f32(vld1q_f32(rows[0] + x), weights[0]);
+		for (int t = 1; t < taps; t++) {
+			acc = vfmaq_n_f32(acc, vld1q_f32(rows[t] + x), weights[t]);
+		}
+		vst1q_f32(out + x, vfmaq_f32(vb, acc, va));
+	}
+#endif
+	for (; x < count; x++) {
+		float acc = weights[0] * rows[0][x];
+		for (int t = 1; t < taps; t++) {
+			acc += weights[t] * rows[t][x];
+		}
+		out[x] = acc * a + b;
+	}
+}
+
+inline void BlendRow(const float *const *rows, const float *weights, int taps, int count, float a, float b,
+                     uint16_t *out) {
+	int x = 0;
+#if defined(YOLO_LETTERBOX_F16C)
+	const __m256 va = _mm256_set1_ps(a);
+	const __m256 vb = _mm256_set1_ps(b);
+	for (; x + 8 <= count; x += 8) {
+		__m256 acc = _mm256_mul_ps(_mm256_set1_ps(weights[0]), _mm256_loadu_ps(rows[0] + x));
+		for (int t = 1; t < taps; t++) {
+			acc = _mm256_fmadd_ps(_mm256_set1_ps(weights[t]), _mm256_loadu_ps(rows[t] + x), acc);
+		}
+		const __m128i half = _mm256_cvtps_ph(_mm256_fmadd_ps(acc, va, vb), _MM_FROUND_TO_NEAREST_INT);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), half);
+	}
+#elif defined(YOLO_LETTERBOX_NEON)
+	const float32x4_t va = vdupq_n_f32(a);
+	const float32x4_t vb = vdupq_n_f32(b);
+	for (; x + 4 <= count; x += 4) {
+		float32x4_t acc = vmulq_n_f32(vld1q_f32(rows[0] + x), weights[0]);
+		for (int t = 1; t < taps; t++) {
+			acc = vfmaq_n_f32(acc, vld1q_f32(rows[t] + x), weights[t]);
+		}
+		vst1_u16(out + x, vreinterpret_u16_f16(vcvt_f16_f32(vfmaq_f32(vb, acc, va))));
+	}
+#endif
+	for (; x < count; x++) {
+		float acc = weights[0] * rows[0][x];
+		for (int t = 1; t < taps; t++) {
+			acc += weights[t] * rows[t][x];
+		}
+		out[x] = FloatToHalf(acc * a + b);
+	}
+}
+
+}  // namespace detail
+
+class LetterboxKernel {
+ public:
+	// src: 8-bit frame with 1 (gray), 3 (BGR) or 4 (BGRA) interleaved channels, step in bytes.
+	// dst: 3 * dst_height * dst_width values, planes in RGB order (BGR if swap_rb is false).
+	LetterboxInfo Run(const uint8_t *src, int width, int height, size_t step, int channels, float *dst,
+	                  const LetterboxParams &params) {
+		return RunImpl(src, width, height, step, channels, dst, params);
+	}
+
+	// Same as above, FP16 output as raw IEEE half bits (layout compatible with half / Ort::Float16_t).
+	LetterboxInfo Run(const uint8_t *src, int width, int height, size_t step, int channels, uint16_t *dst,
+	                  const LetterboxParams &params) {
+		return RunImpl(src, width, height, step, channels, dst, params);
+	}
+
+ private:
+	struct Taps {
+		std::vector<int> begin;     // dst index -> first tap, size dst + 1
+		std::vector<int> index;     // Source pixel (column or row)
+		std::vector<float> weight;
+		int max_taps = 0;
+	};
+
+	struct Scratch {
+		std::vector<float> rows;    // cache_rows_ horizontally resampled rows, planes_ * width each
+		std::vector<int> keys;      // Source row held by each cache slot, -1 if none
+		std::vector<const float *> row_ptrs;
+		std::vector<const float *> plane_ptrs;
+	};
+
+	struct Geometry {
+		int width, height, channels, dst_width, dst_height;
+		ResizeFilter filter;
+		PadAlign align;
+		bool keep_ratio;
+		int threads;
+		bool operator==(const Geometry &o) const {
+			return width == o.width && height == o.height && channels == o.channels && dst_width == o.dst_width &&
+			       dst_height == o.dst_height && filter == o.filter && align == o.align &&
+			       keep_ratio == o.keep_ratio && threads == o.threads;
+		}
+	};
+
+	static void BuildTaps(int src, int dst, ResizeFilter filter, Taps &taps) {
+		const double ratio = static_cast<double>(src) / dst;
+		taps.begin.assign(1, 0);
+		taps.index.clear();
+		taps.weight.clear();
+		taps.max_taps = 0;
+		for (int d = 0; d < dst; d++) {
+			if (filter == ResizeFilter::kArea && ratio > 1.0) {
+				// Overlap of [d * ratio, (d + 1) * ratio) with each source cell
+				const double from = d * ratio;
+				const double to = std::min(from + ratio, static_cast<double>(src));
+				for (int s = static_cast<int>(from); s < to; s++) {
+					const double overlap = std::min<double>(s + 1, to) - std::max<double>(s, from);
+					if (overlap > 1e-6) {
+						taps.index.push_back(s);
+						taps.weight.push_back(static_cast<float>(overlap / (to - from)));
+					}
+				}
+			} else {
+				double f = (d + 0.5) * ratio - 0.5;
+				int s = static_cast<int>(std::floor(f));
+				f -= s;
+				if (s < 0) {
+					s = 0;
+					f = 0.0;
+				}
+				if (s >= src - 1) {
+					s = src - 1;
+					f = 0.0;
+				}
+				taps.index.push_back(s);
+				taps.weight.push_back(static_cast<float>(1.0 - f));
+				taps.index.push_back(std::min(s + 1, src - 1));
+				taps.weight.push_back(static_cast<float>(f));
+			}
+			taps.begin.push_back(static_cast<int>(taps.index.size()));
+			taps.max_taps = std::max(taps.max_taps, taps.begin[d + 1] - taps.begin[d]);
+		}
+	}
+
+	void Prepare(int width, int height, int channels, const LetterboxParams &params) {
+		const Geometry geometry{width,           height,       channels,          params.dst_width, params.dst_height,
+		                        params.filter,   params.align, params.keep_ratio, std::max(1, params.threads)};
+		if (prepared_ && geometry == geometry_) {
+			return;
+		}
+		geometry_ = geometry;
+		prepared_ = true;
+
+		if (params.keep_ratio) {
+			const float ratio = std::max(static_cast<float>(width) / params.dst_width,
+			                             static_cast<float>(height) / params.dst_height);
+			info_.width = std::clamp(static_cast<int>(width / ratio), 1, params.dst_width);
+			info_.height = std::clamp(static_cast<int>(height / ratio), 1, params.dst_height);
+			info_.scale_x = info_.scale_y = ratio;
+		} else {
+			info_.width = params.dst_width;
+			info_.height = params.dst_height;
+			info_.scale_x = static_cast<float>(width) / params.dst_width;
+			info_.scale_y = static_cast<float>(height) / params.dst_height;
+		}
+		info_.pad_x = params.align == PadAlign::kCenter ? (params.dst_width - info_.width) / 2 : 0;
+		info_.pad_y = params.align == PadAlign::kCenter ? (params.dst_height - info_.height) / 2 : 0;
+
+		channels_ = channels;
+		planes_ = channels == 1 ? 1 : 3;
+		BuildTaps(width, info_.width, params.filter, x_taps_);
+		BuildTaps(height, info_.height, params.filter, y_taps_);
+
+		// Bilinear columns: byte offsets of the two neighbours, for the gather path
+		bilinear_x_ = x_taps_.max_taps == 2 && static_cast<int>(x_taps_.index.size()) == 2 * info_.width;
+		x_offset0_.resize(info_.width);
+		x_offset1_.resize(info_.width);
+		x_alpha_.resize(info_.width);
+		gather_end_ = 0;
+		for (int x = 0; x < info_.width && bilinear_x_; x++) {
+			x_offset0_[x] = x_taps_.index[2 * x] * channels;
+			x_offset1_[x] = x_taps_.index[2 * x + 1] * channels;
+			x_alpha_[x] = x_taps_.weight[2 * x + 1];
+			// A 4-byte gather at the last channel must stay inside the row
+			if (x_offset1_[x] + planes_ - 1 + 4 <= width * channels) {
+				gather_end_ = x + 1;
+			}
+		}
+		for (int &offset : x_taps_.index) {
+			offset *= channels;
+		}
+
+		cache_rows_ = y_taps_.max_taps;
+		scratch_.resize(geometry.threads);
+		for (Scratch &scratch : scratch_) {
+			scratch.rows.assign(static_cast<size_t>(cache_rows_) * planes_ * info_.width, 0.0f);
+			scratch.keys.assign(cache_rows_, -1);
+			scratch.row_ptrs.assign(cache_rows_, nullptr);
+			scratch.plane_ptrs.assign(cache_rows_, nullptr);
+		}
+		if (geometry.threads == 1) {
+			pool_.reset();
+		} else if (!pool_ || pool_->workers() != geometry.threads - 1) {
+			pool_.reset(new WorkerPool(geometry.threads - 1));
+		}
+	}
+
+	// Resample one source row horizontally into planes_ float planes of info_.width values.
+	void HorizontalRow(const uint8_t *row, float *out) const {
+		const int count = info_.width;
+		if (!bilinear_x_) {
+			for (int x = 0; x < count; x++) {
+				const int begin = x_taps_.begin[x];
+				const int end = x_taps_.begin[x + 1];
+				for (int c = 0; c < planes_; c++) {
+					float acc = 0.0f;
+					for (int t = begin; t < end; t++) {
+						acc += x_taps_.weight[t] * row[x_taps_.index[t] + c];
+					}
+					out[c * count + x] = acc;
+				}
+			}
+			return;
+		}
+		int x = 0;
+#if defined(YOLO_LETTERBOX_AVX2)
+		const __m256i byte_mask = _mm256_set1_epi32(0xFF);
+		for (; x + 8 <= gather_end_; x += 8) {
+			const __m256i offset0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&x_offset0_[x]));
+			const __m256i offset1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&x_offset1_[x]));
+			const __m256 alpha = _mm256_loadu_ps(&x_alpha_[x]);
+			for (int c = 0; c < planes_; c++) {
+				const int *base = reinterpret_cast<const int *>(row + c);
+				const __m256 left = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_i32gather_epi32(base, offset0, 1), byte_mask));
+				const __m256 right = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_i32gather_epi32(base, offset1, 1), byte_mask));
+				_mm256_storeu_ps(out + c * count + x, _mm256_fmadd_ps(alpha, _mm256_sub_ps(right, left), left));
+			}
+		}
+#endif
+		for (; x < count; x++) {
+			const float alpha = x_alpha_[x];
+			for (int c = 0; c < planes_; c++) {
+				const float left = row[x_offset0_[x] + c];
+				const float right = row[x_offset1_[x] + c];
+				out[c * count + x] = alpha * (right - left) + left;
+			}
+		}
+	}
+
+	const float *CachedRow(Scratch &scratch, const uint8_t *src, size_t step, int source_row) const {
+		const int slot = source_row % cache_rows_;
+		float *row = scratch.rows.data() + static_cast<size_t>(slot) * planes_ * info_.width;
+		if (scratch.keys[slot] != source_row) {
+			HorizontalRow(src + source_row * step, row);
+			scratch.keys[slot] = source_row;
+		}
+		return row;
+	}
+
+	template <typename T>
+	void RunRows(int worker, int row_begin, int row_end, const uint8_t *src, size_t step, T *dst,
+	             const LetterboxParams &params) {
+		Scratch &scratch = scratch_[worker];
+		std::fill(scratch.keys.begin(), scratch.keys.end(), -1);  // New frame, cached rows are stale
+		const size_t plane_size = static_cast<size_t>(params.dst_width) * params.dst_height;
+		for (int y = row_begin; y < row_end; y++) {
+			const int begin = y_taps_.begin[y];
+			const int taps = y_taps_.begin[y + 1] - begin;
+			for (int t = 0; t < taps; t++) {
+				scratch.row_ptrs[t] = CachedRow(scratch, src, step, y_taps_.index[begin + t]);
+			}
+			const size_t offset = static_cast<size_t>(info_.pad_y + y) * params.dst_width + info_.pad_x;
+			for (int k = 0; k < 3; k++) {
+				const int plane = planes_ == 1 ? 0 : (params.swap_rb ? 2 - k : k);
+				for (int t = 0; t < taps; t++) {
+					scratch.plane_ptrs[t] = scratch.row_ptrs[t] + static_cast<size_t>(plane) * info_.width;
+				}
+				detail::BlendRow(scratch.plane_ptrs.data(), &y_taps_.weight[begin], taps, info_.width, gain_[k],
+				                 bias_[k], dst + k * plane_size + offset);
+			}
+		}
+	}
+
+	template <typename T>
+	void FillPadding(T *dst, const LetterboxParams &params) const {
+		const int W = params.dst_width;
+		const int H = params.dst_height;
+		const size_t plane_size = static_cast<size_t>(W) * H;
+		for (int k = 0; k < 3; k++) {
+			T pad;
+			detail::StoreValue(params.pad_value * gain_[k] + bias_[k], &pad);
+			T *plane = dst + k * plane_size;
+			std::fill(plane, plane + static_cast<size_t>(info_.pad_y) * W, pad);
+			std::fill(plane + static_cast<size_t>(info_.pad_y + info_.height) * W, plane + plane_size, pad);
+			for (int y = info_.pad_y; y < info_.pad_y + info_.height; y++) {
+				T *row = plane + static_cast<size_t>(y) * W;
+				std::fill(row, row + info_.pad_x, pad);
+				std::fill(row + info_.pad_x + info_.width, row + W, pad);
+			}
+		}
+	}
+
+	template <typename T>
+	LetterboxInfo RunImpl(const uint8_t *src, int width, int height, size_t step, int channels, T *dst,
+	                      const LetterboxParams &params) {
+		Prepare(width, height, channels, params);
+		for (int k = 0; k < 3; k++) {
+			gain_[k] = params.scale / params.std[k];
+			bias_[k] = -params.mean[k] / params.std[k];
+		}
+		FillPadding(dst, params);
+
+		const int workers = std::min<int>(geometry_.threads, std::max(1, info_.height / 16));
+		if (workers == 1) {
+			RunRows(0, 0, info_.height, src, step, dst, params);
+			return info_;
+		}
+		// Band w is rows [w * rows, (w + 1) * rows). The item captures two pointers, small enough for std::function
+		// to hold without allocating.
+		struct Bands {
+			const uint8_t *src;
+			size_t step;
+			T *dst;
+			const LetterboxParams *params;
+			int rows;
+		};
+		const Bands bands{src, step, dst, &params, (info_.height + workers - 1) / workers};
+		pool_->Run(workers, [this, &bands](size_t w) {
+			const int begin = std::min(info_.height, static_cast<int>(w) * bands.rows);
+			const int end = std::min(info_.height, begin + bands.rows);
+			RunRows(static_cast<int>(w), begin, end, bands.src, bands.step, bands.dst, *bands.params);
+		});
+		return info_;
+	}
+
+	bool prepared_ = false;
+	Geometry geometry_{};
+	LetterboxInfo info_{};
+	int channels_ = 3;
+	int planes_ = 3;
+	Taps x_taps_;
+	Taps y_taps_;
+	bool bilinear_x_ = false;
+	std::vector<int> x_offset0_;
+	std::vector<int> x_offset1_;
+	std::vector<float> x_alpha_;
+	int gather_end_ = 0;
+	int cache_rows_ = 1;
+	std::vector<Scratch> scratch_;
+	std::unique_ptr<WorkerPool> pool_;  // threads - 1 workers besides the caller, none for a single thread
+	float gain_[3] = {1.0f, 1.0f, 1.0f};
+	float bias_[3] = {0.0f, 0.0f, 0.0f};
+};
+
+}  // namespace yolo
+
+#endif  // YOLO_LETTERBOX_KERNEL_H_
@@ -0,0 +1,272 @@
+#ifndef YOLO_MASK_DECODER_H_
+#define YOLO_MASK_DECODER_H_
+
+// Instance mask decoder for YOLOv8 segmentation heads, shared by the C++ examples.
+//
+// A -seg model returns, next to the detection head, prototype masks ([channels x proto_h x proto_w], 32 x 160
+// x 160 at 640) and one row of mask coefficients per anchor. The Python reference (ultralytics ops.process_mask*)
+// multiplies every detection's coefficients with the whole prototype tensor, applies the sigmoid to every pixel,
+// upsamples full masks and crops to the box at the end. Here each detection, after NMS, only touches its box:
+//   - the box is clipped to the image first (pixels with x1 <= x < x2, y1 <= y < y2, as crop_mask keeps);
+//   - the coefficient x prototype product is evaluated only on the prototype pixels the box samples from
+//     (its footprint plus the bilinear neighbours), 8 (AVX2) or 4 (NEON) pixels per instruction;
+//   - the bilinear upsample (align_corners=False, as F.interpolate) runs only over the box pixels, straight
+//     from prototype to image coordinates;
+//   - no sigmoid: sigmoid(v) > t is v > log(t / (1 - t)), so the threshold is applied to the logits.
+// The result is run-length encoded inside the box (MaskRle), a few hundred counts for a typical object instead
+// of a full image bitmap. Scratch lives in the MaskDecoder object and is reused, keep one per thread.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#define YOLO_MASK_DECODER_AVX2 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define YOLO_MASK_DECODER_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace yolo {
+
+// Binary mask of one detection. counts alternate background / foreground run lengths over the box, row-major,
+// the first run is background (0 when the first box pixel is set); runs continue from one row to the next.
+// An empty box (width or height 0) has no counts.
+struct MaskRle {
+	int x = 0;       // Box the runs cover, image pixels, inside the image
+	int y = 0;
+	int width = 0;
+	int height = 0;
+	std::vector<uint32_t> counts;
+
+	size_t Area() const {
+		size_t area = 0;
+		for (size_t i = 1; i < counts.size(); i += 2) {
+			area += counts[i];
+		}
+		return area;
+	}
+};
+
+// Calls fn(y, x_begin, x_end) for every horizontal span of set pixels, image coordinates, x_end exclusive
+template <typename F>
+void ForEachMaskSpan(const MaskRle &mask, F fn) {
+	if (mask.width <= 0) {
+		return;
+	}
+	size_t position = 0;
+	for (size_t i = 0; i < mask.counts.size(); i++) {
+		size_t end = position + mask.counts[i];
+		if (i % 2 == 1) {
+			while (position < end) {
+				const int row = static_cast<int>(position / mask.width);
+				const int column = static_cast<int>(position % mask.width);
+				const int span_end = column + static_cast<int>(end - position) < mask.width
+				                         ? column + static_cast<int>(end - position)
+				                         : mask.width;
+				fn(mask.y + row, mask.x + column, mask.x + span_end);
+				position += span_end - column;
+			}
+		}
+		position = end;
+	}
+}
+
+// Sets the mask's pixels to value in an 8-bit image (e.g. a cv::Mat of the frame size: data, step)
+inline void PaintMask(const MaskRle &mask, uint8_t *image, size_t step, uint8_t value) {
+	ForEachMaskSpan(mask, [&](int y, int x_begin, int x_end) {
+		uint8_t *row = image + static_cast<size_t>(y) * step;
+		for (int x = x_begin; x < x_end; x++) {
+			row[x] = value;
+		}
+	});
+}
+
+// Where the prototypes sit in the image: model input size and the letterbox, image at the top-left of the input
+struct MaskGeometry {
+	int proto_width = 160;
+	int proto_height = 160;
+	int input_width = 640;
+	int input_height = 640;
+	float scale = 1.0f;       // Image pixels per input pixel (the letterbox scale the boxes are multiplied by)
+	int image_width = 0;      // Frame size, masks are clipped to it
+	int image_height = 0;
+};
+
+class MaskDecoder {
+ public:
+	// coefficients: channels values, coefficient_stride apart (the anchor's column of the head: stride = anchors).
+	// protos: channels planes of proto_height x proto_width. x1, y1, x2, y2: box in image pixels. Pixels whose
+	// probability is > threshold are set. Returns mask.Area().
+	size_t Decode(const float *coefficients, size_t coefficient_stride, const float *protos, int channels,
+	              const MaskGeometry &geometry, float x1, float y1, float x2, float y2, float threshold,
+	              MaskRle &mask);
+
+ private:
+	// Bilinear source taps for F.interpolate(mode="bilinear", align_corners=False), relative to first
+	struct Tap {
+		int i0;
+		int i1;
+		float w1;
+	};
+
+	static Tap SourceTap(int destination, float ratio, int size, int first);
+
+	std::vector<float> coefficients_;
+	std::vector<float> logits_;   // Product over the footprint, one row per prototype row
+	std::vector<float> line_;     // Vertically interpolated footprint row
+	std::vector<Tap> columns_;    // Horizontal taps per box column
+};
+
+namespace detail {
+
+// acc[i] += c0 * r0[i] + c1 * r1[i] + c2 * r2[i] + c3 * r3[i]
+inline void MaskAxpy4(float *acc, const float *r0, const float *r1, const float *r2, const float *r3, float c0,
+                      float c1, float c2, float c3, int n) {
+	int i = 0;
+#if defined(YOLO_MASK_DECODER_AVX2)
+	const __m256 v0 = _mm256_set1_ps(c0);
+	const __m256 v1 = _mm256_set1_ps(c1);
+	const __m256 v2 = _mm256_set1_ps(c2);
+	const __m256 v3 = _mm256_set1_ps(c3);
+	for (; i + 8 <= n; i += 8) {
+		__m256 a = _mm256_loadu_ps(acc + i);
+		a = _mm256_fmadd_ps(v0, _mm256_loadu_ps(r0 + i), a);
+		a = _mm256_fmadd_ps(v1, _mm256_loadu_ps(r1 + i), a);
+		a = _mm256_fmadd_ps(v2, _mm256_loadu_ps(r2 + i), a);
+		a = _mm256_fmadd_ps(v3, _mm256_loadu_ps(r3 + i), a);
+		_mm256_storeu_ps(acc + i, a);
+	}
+#elif defined(YOLO_MASK_DECODER_NEON)
+	for (; i + 4 <= n; i += 4) {
+		float32x4_t a = vld1q_f32(acc + i);
+		a = vfmaq_n_f32(a, vld1q_f32(r0 + i), c0);
+		a = vfmaq_n_f32(a, vld1q_f32(r1 + i), c1);
+		a = vfmaq_n_f32(a, vld1q_f32(r2 + i), c2);
+		a = vfmaq_n_f32(a, vld1q_f32(r3 + i), c3);
+		vst1q_f32(acc + i, a);
+	}
+#endif
+	for (; i < n; i++) {
+		acc[i] += c0 * r0[i] + c1 * r1[i] + c2 * r2[i] + c3 * r3[i];
+	}
+}
+
+inline void MaskAxpy(float *acc, const float *r0, float c0, int n) {
+	for (int i = 0; i < n; i++) {
+		acc[i] += c0 * r0[i];
+	}
+}
+
+}  // namespace detail
+
+inline MaskDecoder::Tap MaskDecoder::SourceTap(int destination, float ratio, int size, int first) {
+	float source = (static_cast<float>(destination) + 0.5f) * ratio - 0.5f;
+	if (source < 0.0f) {
+		source = 0.0f;
+	}
+	int i0 = static_cast<int>(source);
+	if (i0 > size - 1) {
+		i0 = size - 1;
+	}
+	const int i1 = i0 < size - 1 ? i0 + 1 : i0;
+	return Tap{i0 - first, i1 - first, source - static_cast<float>(i0)};
+}
+
+inline size_t MaskDecoder::Decode(const float *coefficients, size_t coefficient_stride, const float *protos,
+                                  int channels, const MaskGeometry &geometry, float x1, float y1, float x2,
+                                  float y2, float threshold, MaskRle &mask) {
+	mask.counts.clear();
+	// Pixels x1 <= x < x2 of the image
+	const int bx0 = x1 > 0.0f ? static_cast<int>(std::ceil(x1)) : 0;
+	const int by0 = y1 > 0.0f ? static_cast<int>(std::ceil(y1)) : 0;
+	const float width = static_cast<float>(geometry.image_width);
+	const float height = static_cast<float>(geometry.image_height);
+	const int bx1 = x2 < width ? static_cast<int>(std::ceil(x2)) : geometry.image_width;
+	const int by1 = y2 < height ? static_cast<int>(std::ceil(y2)) : geometry.image_height;
+	mask.x = bx0;
+	mask.y = by0;
+	mask.width = bx1 > bx0 ? bx1 - bx0 : 0;
+	mask.height = by1 > by0 ? by1 - by0 : 0;
+	if (mask.width == 0 || mask.height == 0) {
+		mask.width = mask.height = 0;
+		return 0;
+	}
+
+	// Image pixel -> prototype pixel, through the input letterbox
+	const int pw = geometry.proto_width;
+	const int ph = geometry.proto_height;
+	const float ratio_x = static_cast<float>(pw) / (static_cast<float>(geometry.input_width) * geometry.scale);
+	const float ratio_y = static_cast<float>(ph) / (static_cast<float>(geometry.input_height) * geometry.scale);
+	const int fx0 = SourceTap(bx0, ratio_x, pw, 0).i0;
+	const int fx1 = SourceTap(bx1 - 1, ratio_x, pw, 0).i1;
+	const int fy0 = SourceTap(by0, ratio_y, ph, 0).i0;
+	const int fy1 = SourceTap(by1 - 1, ratio_y, ph, 0).i1;
+	const int fw = fx1 - fx0 + 1;
+	const int fh = fy1 - fy0 + 1;
+
+	// Coefficients x prototypes over the footprint only
+	coefficients_.resize(channels);
+	for (int c = 0; c < channels; c++) {
+		coefficients_[c] = coefficients[c * coefficient_stride];
+	}
+	logits_.assign(static_cast<size_t>(fw) * fh, 0.0f);
+	const size_t plane = static_cast<size_t>(pw) * ph;
+	for (int r = 0; r < fh; r++) {
+		float *acc = logits_.data() + static_cast<size_t>(r) * fw;
+		const float *row = protos + static_cast<size_t>(fy0 + r) * pw + fx0;
+		int c = 0;
+		for (; c + 4 <= channels; c += 4) {
+			detail::MaskAxpy4(acc, row + c * plane, row + (c + 1) * plane, row + (c + 2) * plane,
+			                  row + (c + 3) * plane, coefficients_[c], coefficients_[c + 1], coefficients_[c + 2],
+			                  coefficients_[c + 3], fw);
+		}
+		for (; c < channels; c++) {
+			detail::MaskAxpy(acc, row + c * plane, coefficients_[c], fw);
+		}
+	}
+
+	// sigmoid(v) > threshold  <=>  v > logit(threshold)
+	const float cut = threshold <= 0.0f ? -INFINITY
+	                  : threshold >= 1.0f ? INFINITY
+	                                      : std::log(threshold / (1.0f - threshold));
+
+	// Upsample the box region and run-length encode it
+	columns_.resize(mask.width);
+	for (int x = 0; x < mask.width; x++) {
+		columns_[x] = SourceTap(bx0 + x, ratio_x, pw, fx0);
+	}
+	line_.resize(fw);
+	uint32_t run = 0;
+	bool on = false;
+	size_t area = 0;
+	for (int y = 0; y < mask.height; y++) {
+		const Tap row_tap = SourceTap(by0 + y, ratio_y, ph, fy0);
+		const float *top = logits_.data() + static_cast<size_t>(row_tap.i0) * fw;
+		const float *bottom = logits_.data() + static_cast<size_t>(row_tap.i1) * fw;
+		const float wy1 = row_tap.w1;
+		const float wy0 = 1.0f - wy1;
+		for (int i = 0; i < fw; i++) {
+			line_[i] = wy0 * top[i] + wy1 * bottom[i];
+		}
+		for (int x = 0; x < mask.width; x++) {
+			const Tap &t = columns_[x];
+			const bool value = (1.0f - t.w1) * line_[t.i0] + t.w1 * line_[t.i1] > cut;
+			if (value != on) {
+				mask.counts.push_back(run);
+				run = 0;
+				on = value;
+			}
+			run++;
+			area += value;
+		}
+	}
+	mask.counts.push_back(run);
+	return area;
+}
+
+}  // namespace yolo
+
+#endif  // YOLO_MASK_DECODER_H_
@@ -0,0 +1,212 @@
+#ifndef YOLO_MODEL_CACHE_H_
+#define YOLO_MODEL_CACHE_H_
+
+// Persistent cache of optimized models for the C++ examples (C++17), so a restart loads what the previous boot
+// optimized instead of optimizing again.
+//
+// CachedModelPath names the cache entry of a model: the source file's name, size and modification time plus a
+// backend tag (runtime version, device, settings) are hashed into the file name, so editing or replacing the model,
+// or upgrading the runtime, misses the cache instead of loading a stale entry. CpuTag identifies the instruction set
+// for backends whose optimized models are CPU specific. Entries are written under a temporary name unique to the
+// writer and renamed once complete (CommitCacheFile), so a power cut while writing leaves no truncated entry behind,
+// and two processes filling the same cache at once each rename a complete file of their own.
+// MappedFile maps an entry read-only, for runtimes that can use the bytes in place.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <system_error>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#elif defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#endif
+
+namespace yolo {
+
+// cache_dir/<model stem>-<hash of the model file and tag><extension>, empty when the model can't be read
+inline std::filesystem::path CachedModelPath(const std::filesystem::path &model_path,
+		const std::filesystem::path &cache_dir, const std::string &tag, const std::string &extension) {
+	std::error_code error;
+	const std::filesystem::path model = std::filesystem::absolute(model_path, error);
+	const std::uintmax_t size = std::filesystem::file_size(model, error);
+	if (error) {
+		return {};
+	}
+	const auto modified = std::filesystem::last_write_time(model, error).time_since_epoch().count();
+	if (error) {
+		return {};
+	}
+	const std::string key = model.string() + '|' + std::to_string(size) + '|' + std::to_string(modified) + '|' + tag;
+	char hash[17];
+	std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(std::hash<std::string>()(key)));
+	return cache_dir / (model.stem().string() + '-' + hash + extension);
+}
+
+// Instruction set extensions of this CPU, for the tag of CPU-specific entries: an entry written on a machine with
+// other extensions (AVX-512 against AVX2, another ARM core) misses instead of loading kernels or layouts chosen for
+// that machine. Only ISA feature bits go in, so identical machines share entries.
+inline std::string CpuTag() {
+	char tag[80];
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	unsigned int leaf1[4] = {};
+	unsigned int leaf7[4] = {};
+#if defined(_M_X64) || defined(_M_IX86)
+	int regs[4];
+	__cpuid(regs, 0);
+	const unsigned int max_leaf = static_cast<unsigned int>(regs[0]);
+	__cpuidex(regs, 1, 0);
+	for (int k = 0; k < 4; k++) {
+		leaf1[k] = static_cast<unsigned int>(regs[k]);
+	}
+	if (max_leaf >= 7) {
+		__cpuidex(regs, 7, 0);
+		for (int k = 0; k < 4; k++) {
+			leaf7[k] = static_cast<unsigned int>(regs[k]);
+		}
+	}
+#else
+	const unsigned int max_leaf = __get_cpuid_max(0, nullptr);
+	__get_cpuid_count(1, 0, &leaf1[0], &leaf1[1], &leaf1[2], &leaf1[3]);
+	if (max_leaf >= 7) {
+		__get_cpuid_count(7, 0, &leaf7[0], &leaf7[1], &leaf7[2], &leaf7[3]);
+	}
+#endif
+	// Feature registers only: ecx bit 31 (running under a hypervisor) does not change the instruction set
+	std::snprintf(tag, sizeof(tag), "x86|%08x%08x|%08x%08x%08x", leaf1[2] & 0x7fffffffu, leaf1[3], leaf7[1],
+		leaf7[2], leaf7[3]);
+#elif defined(__aarch64__) && defined(__linux__)
+	std::snprintf(tag, sizeof(tag), "aarch64|%lx|%lx", getauxval(AT_HWCAP), getauxval(AT_HWCAP2));
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	std::snprintf(tag, sizeof(tag), "aarch64");
+#else
+	std::snprintf(tag, sizeof(tag), "cpu");
+#endif
+	return tag;
+}
+
+// Temporary name to write an entry under before CommitCacheFile. Each call gives a new name (process id and a
+// counter), so writers starting together never share a pending file.
+inline std::filesystem::path PendingCachePath(const std::filesystem::path &entry) {
+	static std::atomic<unsigned long> counter{0};
+#ifdef _WIN32
+	const unsigned long process = GetCurrentProcessId();
+#else
+	const unsigned long process = static_cast<unsigned long>(getpid());
+#endif
+	std::filesystem::path pending = entry;
+	pending += '.' + std::to_string(process) + '.' + std::to_string(counter++) + ".tmp";
+	return pending;
+}
+
+// Moves a completely written pending file into place as entry, false (and the pending file removed) on failure.
+// When two writers commit the same entry, the later rename replaces an equally complete file.
+inline bool CommitCacheFile(const std::filesystem::path &pending, const std::filesystem::path &entry) {
+	std::error_code error;
+	std::filesystem::rename(pending, entry, error);
+	if (error) {
+		std::filesystem::remove(pending, error);
+		return false;
+	}
+	return true;
+}
+
+// Read-only memory mapping of a whole file. The pages are loaded on first touch and shared with the page cache,
+// so opening a large model costs no read and no copy.
+class MappedFile {
+ public:
+	MappedFile() = default;
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+	~MappedFile() { Close(); }
+
+	bool Open(const std::filesystem::path &path) {
+		Close();
+#ifdef _WIN32
+		file_ = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL, nullptr);
+		LARGE_INTEGER size;
+		if (file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_, &size) || size.QuadPart == 0) {
+			Close();
+			return false;
+		}
+		mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		data_ = mapping_ ? MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		size_ = static_cast<size_t>(size.QuadPart);
+#else
+		const int fd = ::open(path.c_str(), O_RDONLY);
+		struct stat status;
+		if (fd < 0 || fstat(fd, &status) != 0 || status.st_size == 0) {
+			if (fd >= 0) {
+				::close(fd);
+			}
+			return false;
+		}
+		void *data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);  // The mapping keeps the file
+		data_ = data == MAP_FAILED ? nullptr : data;
+		size_ = static_cast<size_t>(status.st_size);
+#endif
+		if (!data_) {
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void Close() {
+#ifdef _WIN32
+		if (data_) {
+			UnmapViewOfFile(data_);
+		}
+		if (mapping_) {
+			CloseHandle(mapping_);
+		}
+		if (file_ != INVALID_HANDLE_VALUE) {
+			CloseHandle(file_);
+		}
+		mapping_ = nullptr;
+		file_ = INVALID_HANDLE_VALUE;
+#else
+		if (data_) {
+			munmap(data_, size_);
+		}
+#endif
+		data_ = nullptr;
+		size_ = 0;
+	}
+
+	const void *data() const { return data_; }
+	size_t size() const { return size_; }
+
+ private:
+	void *data_ = nullptr;
+	size_t size_ = 0;
+#ifdef _WIN32
+	HANDLE file_ = INVALID_HANDLE_VALUE;
+	HANDLE mapping_ = nullptr;
+#endif
+};
+
+} // namespace yolo
+
+#endif // YOLO_MODEL_CACHE_H_
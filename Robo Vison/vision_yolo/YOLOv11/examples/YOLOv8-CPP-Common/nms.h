@@ -0,0 +1,310 @@
+#ifndef YOLO_NMS_H_
+#define YOLO_NMS_H_
+
+// Greedy non-maximum suppression shared by the C++ examples.
+//
+// Candidates are visited in score order (ties by index, as a stable sort would) and each one is kept unless
+// its IoU with an already kept box of the same class (any class when agnostic) is > iou_threshold. That is
+// the same result as suppressing from every kept box in turn (cv::dnn::NMSBoxes, torchvision nms), but a
+// candidate is only compared with the kept set, 8 (AVX2) or 4 (NEON) kept boxes per instruction.
+//
+// Cost is bounded in three ways:
+//   - the score order is built with partial sorts, a chunk at a time, so only the prefix that is actually
+//     visited gets sorted; visiting stops once max_det boxes are kept;
+//   - class-aware suppression keeps one set per class, a candidate never looks at other classes;
+//   - from grid_min_candidates per set on, kept boxes are bucketed into a uniform grid sized from the mean
+//     box instead, and a candidate only checks the cells its box covers (disjoint boxes have IoU 0).
+// Scratch lives in the NonMaxSuppression object and is reused, keep one per thread.
+
+#include <algorithm>
+#include <cfloat>
+#include <cstddef>
+#include <vector>
+#include "trace.h"
+
+#if defined(__AVX2__)
+#define YOLO_NMS_AVX2 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define YOLO_NMS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace yolo {
+
+struct NmsOptions {
+	float iou_threshold = 0.45f;        // Suppress when IoU with a kept box is > this
+	float score_threshold = -FLT_MAX;   // Candidates with score <= this are dropped first
+	int max_det = 300;                  // Keep at most this many boxes, <= 0 for no limit
+	bool agnostic = false;              // Suppress across classes (class_ids may then be nullptr)
+	size_t grid_min_candidates = 4096;  // Use the spatial grid from this many candidates per class on
+};
+
+// One image for NonMaxSuppression::RunBatch
+struct NmsInput {
+	const float *boxes = nullptr;       // x1, y1, x2, y2 per candidate
+	const float *scores = nullptr;
+	const int *class_ids = nullptr;     // >= 0, may be nullptr when agnostic
+	size_t count = 0;
+};
+
+class NonMaxSuppression {
+ public:
+	// boxes: x1, y1, x2, y2 per candidate. keep receives the indices of the kept candidates, best score first.
+	// Returns keep.size().
+	size_t Run(const float *boxes, const float *scores, const int *class_ids, size_t count,
+	           const NmsOptions &options, std::vector<int> &keep);
+
+	// Rectangles with x, y, width, height members (cv::Rect, cv::Rect2f, ...)
+	template <typename Rect>
+	size_t RunRects(const std::vector<Rect> &rects, const std::vector<float> &scores,
+	                const std::vector<int> &class_ids, const NmsOptions &options, std::vector<int> &keep) {
+		corners_.resize(4 * rects.size());
+		for (size_t i = 0; i < rects.size(); i++) {
+			corners_[4 * i + 0] = static_cast<float>(rects[i].x);
+			corners_[4 * i + 1] = static_cast<float>(rects[i].y);
+			corners_[4 * i + 2] = static_cast<float>(rects[i].x + rects[i].width);
+			corners_[4 * i + 3] = static_cast<float>(rects[i].y + rects[i].height);
+		}
+		return Run(corners_.data(), scores.data(), class_ids.empty() ? nullptr : class_ids.data(), rects.size(),
+		           options, keep);
+	}
+
+	// Several images with the same options, keep[i] belongs to inputs[i]
+	void RunBatch(const NmsInput *inputs, size_t images, const NmsOptions &options,
+	              std::vector<std::vector<int>> &keep) {
+		keep.resize(images);
+		for (size_t i = 0; i < images; i++) {
+			Run(inputs[i].boxes, inputs[i].scores, inputs[i].class_ids, inputs[i].count, options, keep[i]);
+		}
+	}
+
+ private:
+	// Kept boxes of one class or one grid cell, structure of arrays for the IoU kernel
+	struct KeptSet {
+		std::vector<float> x1, y1, x2, y2, area;
+		std::vector<int> class_id;
+
+		size_t size() const { return x1.size(); }
+		void clear() {
+			x1.clear();
+			y1.clear();
+			x2.clear();
+			y2.clear();
+			area.clear();
+			class_id.clear();
+		}
+		void push_back(const float *box, float box_area, int cls) {
+			x1.push_back(box[0]);
+			y1.push_back(box[1]);
+			x2.push_back(box[2]);
+			y2.push_back(box[3]);
+			area.push_back(box_area);
+			class_id.push_back(cls);
+		}
+	};
+
+	template <bool kMatchClass>
+	static bool Overlaps(const KeptSet &set, const float *box, float box_area, int cls, float iou_threshold);
+
+	void Insert(size_t set, const float *box, float box_area, int cls) {
+		if (sets_[set].size() == 0) {
+			touched_.push_back(set);
+		}
+		sets_[set].push_back(box, box_area, cls);
+	}
+
+	std::vector<int> order_;
+	std::vector<KeptSet> sets_;
+	std::vector<size_t> touched_;
+	std::vector<float> corners_;
+};
+
+template <bool kMatchClass>
+inline bool NonMaxSuppression::Overlaps(const KeptSet &set, const float *box, float box_area, int cls,
+                                        float iou_threshold) {
+	const size_t n = set.size();
+	size_t j = 0;
+#if defined(YOLO_NMS_AVX2)
+	const __m256 bx1 = _mm256_set1_ps(box[0]);
+	const __m256 by1 = _mm256_set1_ps(box[1]);
+	const __m256 bx2 = _mm256_set1_ps(box[2]);
+	const __m256 by2 = _mm256_set1_ps(box[3]);
+	const __m256 barea = _mm256_set1_ps(box_area);
+	const __m256 threshold = _mm256_set1_ps(iou_threshold);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256i bclass = _mm256_set1_epi32(cls);
+	for (; j + 8 <= n; j += 8) {
+		const __m256 xx1 = _mm256_max_ps(bx1, _mm256_loadu_ps(&set.x1[j]));
+		const __m256 yy1 = _mm256_max_ps(by1, _mm256_loadu_ps(&set.y1[j]));
+		const __m256 xx2 = _mm256_min_ps(bx2, _mm256_loadu_ps(&set.x2[j]));
+		const __m256 yy2 = _mm256_min_ps(by2, _mm256_loadu_ps(&set.y2[j]));
+		const __m256 w = _mm256_max_ps(zero, _mm256_sub_ps(xx2, xx1));
+		const __m256 h = _mm256_max_ps(zero, _mm256_sub_ps(yy2, yy1));
+		const __m256 inter = _mm256_mul_ps(w, h);
+		const __m256 uni = _mm256_sub_ps(_mm256_add_ps(barea, _mm256_loadu_ps(&set.area[j])), inter);
+		__m256 over = _mm256_cmp_ps(_mm256_div_ps(inter, uni), threshold, _CMP_GT_OQ);
+		if (kMatchClass) {
+			const __m256i same = _mm256_cmpeq_epi32(
+			    _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&set.class_id[j])), bclass);
+			over = _mm256_and_ps(over, _mm256_castsi256_ps(same));
+		}
+		if (_mm256_movemask_ps(over) != 0) {
+			return true;
+		}
+	}
+#elif defined(YOLO_NMS_NEON)
+	const float32x4_t bx1 = vdupq_n_f32(box[0]);
+	const float32x4_t by1 = vdupq_n_f32(box[1]);
+	const float32x4_t bx2 = vdupq_n_f32(box[2]);
+	const float32x4_t by2 = vdupq_n_f32(box[3]);
+	const float32x4_t barea = vdupq_n_f32(box_area);
+	const float32x4_t threshold = vdupq_n_f32(iou_threshold);
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+	const int32x4_t bclass = vdupq_n_s32(cls);
+	for (; j + 4 <= n; j += 4) {
+		const float32x4_t xx1 = vmaxq_f32(bx1, vld1q_f32(&set.x1[j]));
+		const float32x4_t yy1 = vmaxq_f32(by1, vld1q_f32(&set.y1[j]));
+		const float32x4_t xx2 = vminq_f32(bx2, vld1q_f32(&set.x2[j]));
+		const float32x4_t yy2 = vminq_f32(by2, vld1q_f32(&set.y2[j]));
+		const float32x4_t w = vmaxq_f32(zero, vsubq_f32(xx2, xx1));
+		const float32x4_t h = vmaxq_f32(zero, vsubq_f32(yy2, yy1));
+		const float32x4_t inter = vmulq_f32(w, h);
+		const float32x4_t uni = vsubq_f32(vaddq_f32(barea, vld1q_f32(&set.area[j])), inter);
+		uint32x4_t over = vcgtq_f32(vdivq_f32(inter, uni), threshold);
+		if (kMatchClass) {
+			over = vandq_u32(over, vceqq_s32(vld1q_s32(&set.class_id[j]), bclass));
+		}
+		if (vmaxvq_u32(over) != 0) {
+			return true;
+		}
+	}
+#endif
+	for (; j < n; j++) {
+		if (kMatchClass && set.class_id[j] != cls) {
+			continue;
+		}
+		const float w = std::max(0.0f, std::min(box[2], set.x2[j]) - std::max(box[0], set.x1[j]));
+		const float h = std::max(0.0f, std::min(box[3], set.y2[j]) - std::max(box[1], set.y1[j]));
+		const float inter = w * h;
+		if (inter / (box_area + set.area[j] - inter) > iou_threshold) {
+			return true;
+		}
+	}
+	return false;
+}
+
+inline size_t NonMaxSuppression::Run(const float *boxes, const float *scores, const int *class_ids, size_t count,
+                                     const NmsOptions &options, std::vector<int> &keep) {
+	YOLO_TRACE_ZONE("NMS");
+	keep.clear();
+	order_.clear();
+	for (size_t i = 0; i < count; i++) {
+		if (scores[i] > options.score_threshold) {
+			order_.push_back(static_cast<int>(i));
+		}
+	}
+	const size_t n = order_.size();
+	if (n == 0) {
+		return 0;
+	}
+	const bool agnostic = options.agnostic || class_ids == nullptr;
+	const size_t max_det = options.max_det > 0 ? static_cast<size_t>(options.max_det) : n;
+	auto by_score = [scores](int a, int b) { return scores[a] > scores[b] || (scores[a] == scores[b] && a < b); };
+
+	// One kept set per class, or a spatial grid over the candidates' extent (cells about the size of the mean
+	// box) once a single set would hold grid_min_candidates. A negative threshold suppresses disjoint boxes
+	// too, so it always takes the plain path.
+	int max_class = 0;
+	if (!agnostic) {
+		for (int i : order_) {
+			max_class = std::max(max_class, class_ids[i]);
+		}
+	}
+	const size_t per_set = n / (static_cast<size_t>(max_class) + 1);
+	const bool grid = per_set >= options.grid_min_candidates && options.iou_threshold >= 0.0f;
+	float min_x = FLT_MAX, min_y = FLT_MAX, cell = 1.0f;
+	int grid_w = 1, grid_h = 1;
+	size_t sets = static_cast<size_t>(max_class) + 1;
+	if (grid) {
+		constexpr int kMaxCells = 64;  // Per axis
+		float max_x = -FLT_MAX, max_y = -FLT_MAX;
+		double extent_sum = 0.0;
+		for (int i : order_) {
+			const float *box = boxes + 4 * static_cast<size_t>(i);
+			min_x = std::min(min_x, box[0]);
+			min_y = std::min(min_y, box[1]);
+			max_x = std::max(max_x, box[2]);
+			max_y = std::max(max_y, box[3]);
+			extent_sum += std::max(box[2] - box[0], box[3] - box[1]);
+		}
+		const float span = std::max(max_x - min_x, max_y - min_y);
+		cell = std::max({static_cast<float>(extent_sum / n), span / kMaxCells, 1.0f});
+		grid_w = std::min(kMaxCells, static_cast<int>((max_x - min_x) / cell) + 1);
+		grid_h = std::min(kMaxCells, static_cast<int>((max_y - min_y) / cell) + 1);
+		sets = static_cast<size_t>(grid_w) * grid_h;
+	}
+	if (sets_.size() < sets) {
+		sets_.resize(sets);
+	}
+	auto cell_of = [&](float v, float origin, int cells) {
+		const int c = static_cast<int>((v - origin) / cell);
+		return c < 0 ? 0 : (c >= cells ? cells - 1 : c);
+	};
+
+	// Sort lazily: the first chunk covers max_det with room for suppressed boxes, the next ones double
+	size_t sorted = 0;
+	size_t chunk = std::max<size_t>(4 * max_det, 256);
+	for (size_t k = 0; k < n && keep.size() < max_det; k++) {
+		if (k == sorted) {
+			const size_t end = std::min(n, sorted + chunk);
+			if (end < n) {
+				std::nth_element(order_.begin() + sorted, order_.begin() + end, order_.end(), by_score);
+			}
+			std::sort(order_.begin() + sorted, order_.begin() + end, by_score);
+			sorted = end;
+			chunk *= 2;
+		}
+		const int i = order_[k];
+		const float *box = boxes + 4 * static_cast<size_t>(i);
+		const float area = (box[2] - box[0]) * (box[3] - box[1]);
+		const int cls = agnostic ? 0 : class_ids[i];
+		bool suppressed = false;
+		if (grid) {
+			const int cx0 = cell_of(box[0], min_x, grid_w), cx1 = cell_of(box[2], min_x, grid_w);
+			const int cy0 = cell_of(box[1], min_y, grid_h), cy1 = cell_of(box[3], min_y, grid_h);
+			for (int cy = cy0; cy <= cy1 && !suppressed; cy++) {
+				for (int cx = cx0; cx <= cx1 && !suppressed; cx++) {
+					const KeptSet &set = sets_[static_cast<size_t>(cy) * grid_w + cx];
+					suppressed = agnostic ? Overlaps<false>(set, box, area, cls, options.iou_threshold)
+					                      : Overlaps<true>(set, box, area, cls, options.iou_threshold);
+				}
+			}
+			if (!suppressed) {
+				for (int cy = cy0; cy <= cy1; cy++) {
+					for (int cx = cx0; cx <= cx1; cx++) {
+						Insert(static_cast<size_t>(cy) * grid_w + cx, box, area, cls);
+					}
+				}
+			}
+		} else {
+			suppressed = Overlaps<false>(sets_[cls], box, area, cls, options.iou_threshold);
+			if (!suppressed) {
+				Insert(static_cast<size_t>(cls), box, area, cls);
+			}
+		}
+		if (!suppressed) {
+			keep.push_back(i);
+		}
+	}
+
+	for (size_t set : touched_) {
+		sets_[set].clear();
+	}
+	touched_.clear();
+	return keep.size();
+}
+
+}  // namespace yolo
+
+#endif  // YOLO_NMS_H_
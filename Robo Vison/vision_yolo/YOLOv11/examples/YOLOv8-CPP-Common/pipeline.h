@@ -0,0 +1,402 @@
+#ifndef YOLO_PIPELINE_H_
+#define YOLO_PIPELINE_H_
+
+// Multi-stage pipelined executor shared by the C++ examples.
+//
+// capture -> preprocess -> inference -> postprocess -> sink, each stage on its own thread(s), connected by
+// bounded lock-free MPMC queues (Vyukov). Frames are a caller-defined type, allocated once (frames_in_flight
+// of them) and recycled through a free list, so a cv::Mat read into frame.image keeps its buffer between
+// frames. While the inference stage runs frame N, frame N+1 is being preprocessed and frame N-1 postprocessed.
+//
+// Backpressure applies where frames enter: when capture_queue frames are already waiting for preprocessing,
+// kBlock stalls the source (files: no frame lost), kDropOldest discards the oldest waiting frame (live
+// cameras: latency stays bounded). Dropped frames are counted, never reach the sink, and keep their place
+// in the sequence so ordered delivery does not stall on them.
+//
+// Idle workers spin briefly, then sleep in 100 us steps; there are no locks on the frame path.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace yolo {
+
+// Bounded multi-producer multi-consumer queue (Dmitry Vyukov's algorithm): one CAS per operation, every
+// cell carries a sequence number telling producers and consumers whose turn it is. Capacity is rounded up
+// to a power of two.
+template <typename T>
+class BoundedQueue {
+ public:
+	explicit BoundedQueue(size_t capacity) {
+		size_t size = 2;
+		while (size < capacity) {
+			size *= 2;
+		}
+		mask_ = size - 1;
+		cells_.reset(new Cell[size]);
+		for (size_t i = 0; i < size; i++) {
+			cells_[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		enqueue_pos_.store(0, std::memory_order_relaxed);
+		dequeue_pos_.store(0, std::memory_order_relaxed);
+	}
+
+	BoundedQueue(const BoundedQueue &) = delete;
+	BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+	bool TryPush(const T &value) {
+		Cell *cell;
+		size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+		for (;;) {
+			cell = &cells_[pos & mask_];
+			const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+			if (diff == 0) {
+				if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					break;
+				}
+			} else if (diff < 0) {
+				return false;  // Full
+			} else {
+				pos = enqueue_pos_.load(std::memory_order_relaxed);
+			}
+		}
+		cell->data = value;
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool TryPop(T &value) {
+		Cell *cell;
+		size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+		for (;;) {
+			cell = &cells_[pos & mask_];
+			const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+			if (diff == 0) {
+				if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					break;
+				}
+			} else if (diff < 0) {
+				return false;  // Empty
+			} else {
+				pos = dequeue_pos_.load(std::memory_order_relaxed);
+			}
+		}
+		value = cell->data;
+		cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+		return true;
+	}
+
+	size_t capacity() const { return mask_ + 1; }
+
+ private:
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T data;
+	};
+
+	std::unique_ptr<Cell[]> cells_;
+	size_t mask_ = 0;
+	alignas(64) std::atomic<size_t> enqueue_pos_;
+	alignas(64) std::atomic<size_t> dequeue_pos_;
+};
+
+// Spin, then yield, then sleep: cheap when the next item is microseconds away, quiet when the stage idles.
+class Backoff {
+ public:
+	void Pause() {
+		if (++rounds_ < 16) {
+			return;
+		}
+		if (rounds_ < 64) {
+			std::this_thread::yield();
+		} else {
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+	}
+
+	void Reset() { rounds_ = 0; }
+
+ private:
+	int rounds_ = 0;
+};
+
+enum class Backpressure {
+	kBlock,       // Source waits until preprocessing catches up
+	kDropOldest,  // Oldest frame waiting for preprocessing is discarded
+};
+
+struct PipelineOptions {
+	size_t frames_in_flight = 8;  // Frame buffers allocated up front and recycled
+	size_t capture_queue = 2;     // Captured frames allowed to wait for preprocessing (power of two)
+	Backpressure backpressure = Backpressure::kBlock;
+	bool ordered = true;          // Sink sees frames in capture order; false delivers as they complete
+	int pre_workers = 1;
+	int infer_workers = 1;        // More than one only if the inference stage may run concurrently
+	int post_workers = 1;
+};
+
+struct PipelineStats {
+	size_t captured = 0;
+	size_t delivered = 0;
+	size_t dropped = 0;
+	double seconds = 0.0;
+	std::vector<double> latency_ms;  // Source return to sink call, per delivered frame
+
+	double Fps() const { return seconds > 0.0 ? delivered / seconds : 0.0; }
+
+	double LatencyPercentile(double q) const {
+		if (latency_ms.empty()) {
+			return 0.0;
+		}
+		std::vector<double> sorted(latency_ms);
+		std::sort(sorted.begin(), sorted.end());
+		const size_t index = static_cast<size_t>(q * sorted.size());
+		return sorted[std::min(index, sorted.size() - 1)];
+	}
+};
+
+// Frame: default-constructible per-frame state (image, tensors, results). The callbacks run on pipeline
+// threads; a stage callback of frame N may run concurrently with another stage's callback of frame N+1, and
+// with itself on other frames when that stage has several workers. An exception from any callback stops
+// capture, the frames in flight drain without further processing, and Run() rethrows it.
+template <typename Frame>
+class Pipeline {
+ public:
+	using Source = std::function<bool(Frame &)>;  // Fill the frame, false at end of stream
+	using Stage = std::function<void(Frame &)>;
+
+	Pipeline(const PipelineOptions &options, Source source, Stage pre, Stage infer, Stage post, Stage sink)
+	    : options_(options),
+	      source_(std::move(source)),
+	      stages_{std::move(pre), std::move(infer), std::move(post)},
+	      sink_(std::move(sink)),
+	      slots_(std::max<size_t>(options.frames_in_flight, 1)),
+	      free_(slots_.size()) {
+		queues_.emplace_back(new BoundedQueue<Slot *>(std::max<size_t>(options.capture_queue, 1)));
+		for (int k = 1; k < kQueues; k++) {
+			queues_.emplace_back(new BoundedQueue<Slot *>(slots_.size()));
+		}
+		for (Slot &slot : slots_) {
+			free_.TryPush(&slot);
+		}
+	}
+
+	// Runs until the source returns false (or Stop() is called) and every captured frame has left the
+	// pipeline. One pipeline runs once.
+	PipelineStats Run() {
+		const int workers[kStages] = {options_.pre_workers, options_.infer_workers, options_.post_workers};
+		remaining_[0].store(1);
+		for (int k = 0; k < kStages; k++) {
+			remaining_[k + 1].store(std::max(workers[k], 1));
+		}
+		stats_.latency_ms.reserve(1024);
+		start_ = Clock::now();
+
+		std::vector<std::thread> threads;
+		threads.emplace_back(&Pipeline::CaptureLoop, this);
+		for (int k = 0; k < kStages; k++) {
+			for (int w = 0; w < std::max(workers[k], 1); w++) {
+				threads.emplace_back(&Pipeline::StageLoop, this, k);
+			}
+		}
+		threads.emplace_back(&Pipeline::SinkLoop, this);
+		for (std::thread &thread : threads) {
+			thread.join();
+		}
+		stats_.seconds = std::chrono::duration<double>(Clock::now() - start_).count();
+		if (error_) {
+			std::rethrow_exception(error_);
+		}
+		return stats_;
+	}
+
+	// Ends capture from any thread (a sink that has seen enough, a signal handler flag); frames in flight
+	// still complete.
+	void Stop() { stop_.store(true, std::memory_order_relaxed); }
+
+ private:
+	using Clock = std::chrono::steady_clock;
+	static constexpr int kStages = 3;
+	static constexpr int kQueues = kStages + 1;  // queues_[k] feeds stage k, queues_[kStages] feeds the sink
+
+	struct Slot {
+		Frame frame;
+		uint64_t sequence = 0;
+		Clock::time_point captured;
+		bool dropped = false;
+	};
+
+	void Fail() {
+		std::lock_guard<std::mutex> lock(error_mutex_);
+		if (!error_) {
+			error_ = std::current_exception();
+		}
+		failed_.store(true, std::memory_order_relaxed);
+		stop_.store(true, std::memory_order_relaxed);
+	}
+
+	void Push(int queue, Slot *slot) {
+		Backoff backoff;
+		while (!queues_[queue]->TryPush(slot)) {
+			backoff.Pause();
+		}
+	}
+
+	// Producers of queues_[k] are done and it is drained
+	bool Finished(int k) { return remaining_[k].load(std::memory_order_acquire) == 0; }
+
+	void Done(int k) { remaining_[k].fetch_sub(1, std::memory_order_acq_rel); }
+
+	void CaptureLoop() {
+		uint64_t sequence = 0;
+		Backoff backoff;
+		while (!stop_.load(std::memory_order_relaxed)) {
+			Slot *slot = nullptr;
+			while (!free_.TryPop(slot)) {
+				if (stop_.load(std::memory_order_relaxed)) {
+					break;
+				}
+				backoff.Pause();  // Every frame is in a later stage: wait, whatever the policy
+			}
+			backoff.Reset();
+			if (slot == nullptr) {
+				break;
+			}
+			bool more = false;
+			try {
+				more = source_(slot->frame);
+			} catch (...) {
+				Fail();
+			}
+			if (!more) {
+				free_.TryPush(slot);
+				break;
+			}
+			slot->sequence = sequence++;
+			slot->captured = Clock::now();
+			slot->dropped = false;
+			stats_.captured++;
+			while (!queues_[0]->TryPush(slot)) {
+				Slot *oldest = nullptr;
+				if (options_.backpressure == Backpressure::kDropOldest && queues_[0]->TryPop(oldest)) {
+					oldest->dropped = true;
+					Push(kStages, oldest);
+				} else {
+					backoff.Pause();
+				}
+			}
+			backoff.Reset();
+		}
+		Done(0);
+	}
+
+	void StageLoop(int k) {
+		Backoff backoff;
+		for (;;) {
+			Slot *slot = nullptr;
+			if (!queues_[k]->TryPop(slot)) {
+				// Pop once more after seeing the producers finish: their last push happened before Done()
+				const bool finished = Finished(k);
+				if (!finished || !queues_[k]->TryPop(slot)) {
+					if (finished) {
+						break;
+					}
+					backoff.Pause();
+					continue;
+				}
+			}
+			backoff.Reset();
+			if (!slot->dropped && !failed_.load(std::memory_order_relaxed)) {
+				try {
+					stages_[k](slot->frame);
+				} catch (...) {
+					Fail();
+				}
+			}
+			if (failed_.load(std::memory_order_relaxed)) {
+				slot->dropped = true;  // Drain without handing half-processed frames to the sink
+			}
+			Push(k + 1, slot);
+		}
+		Done(k + 1);
+	}
+
+	void Deliver(Slot *slot) {
+		if (slot->dropped) {
+			stats_.dropped++;
+		} else {
+			try {
+				sink_(slot->frame);
+			} catch (...) {
+				Fail();
+			}
+			stats_.delivered++;
+			stats_.latency_ms.push_back(std::chrono::duration<double, std::milli>(Clock::now() - slot->captured).count());
+		}
+		free_.TryPush(slot);
+	}
+
+	void SinkLoop() {
+		// Ordered mode: completed frames wait here, sorted by descending sequence so the next one is at the back.
+		// Dropped frames come through too, so the sequence has no gaps.
+		std::vector<Slot *> pending;
+		pending.reserve(slots_.size());
+		uint64_t next = 0;
+		Backoff backoff;
+		for (;;) {
+			Slot *slot = nullptr;
+			if (!queues_[kStages]->TryPop(slot)) {
+				const bool finished = Finished(kStages);
+				if (!finished || !queues_[kStages]->TryPop(slot)) {
+					if (finished) {
+						break;
+					}
+					backoff.Pause();
+					continue;
+				}
+			}
+			backoff.Reset();
+			if (!options_.ordered) {
+				Deliver(slot);
+				continue;
+			}
+			pending.insert(std::upper_bound(pending.begin(), pending.end(), slot,
+			                                [](const Slot *a, const Slot *b) { return a->sequence > b->sequence; }),
+			               slot);
+			while (!pending.empty() && pending.back()->sequence == next) {
+				Deliver(pending.back());
+				pending.pop_back();
+				next++;
+			}
+		}
+	}
+
+	PipelineOptions options_;
+	Source source_;
+	Stage stages_[kStages];
+	Stage sink_;
+	std::vector<Slot> slots_;
+	BoundedQueue<Slot *> free_;
+	std::vector<std::unique_ptr<BoundedQueue<Slot *>>> queues_;
+	std::atomic<int> remaining_[kQueues];  // Producers still running, per queue
+	std::atomic<bool> stop_{false};
+	std::atomic<bool> failed_{false};
+	std::mutex error_mutex_;
+	std::exception_ptr error_;
+	PipelineStats stats_;
+	Clock::time_point start_;
+};
+
+}  // namespace yolo
+
+#endif  // YOLO_PIPELINE_H_
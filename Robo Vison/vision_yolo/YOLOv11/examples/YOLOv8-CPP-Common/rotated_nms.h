@@ -0,0 +1,301 @@
+#ifndef YOLO_ROTATED_NMS_H_
+#define YOLO_ROTATED_NMS_H_
+
+// Oriented bounding boxes (YOLOv8 -obb heads): angle regularization, corners and greedy rotated NMS, shared by
+// the C++ examples.
+//
+// Overlap is the probabilistic IoU the Python side uses (ultralytics ops.batch_probiou): each box is a 2D
+// Gaussian with covariance from its size and angle, and 1 - Hellinger distance is the IoU. Unlike a polygon
+// intersection it needs no clipping and no branches. The Bhattacharyya distance is bd = t1 + t2 + t3, where
+// t1 + t2 is the Mahalanobis term and t3 >= 0 depends on the shapes only. IoU > t is bd < -log(1 - (1 - t)^2),
+// so a kept box whose Mahalanobis term alone is past that limit cannot suppress. That test needs no log, exp or
+// sqrt and runs on 8 (AVX2) or 4 (NEON) kept boxes per instruction. Only boxes that pass it go through the exact
+// probiou, so the result is the same as comparing every pair.
+//
+// Candidates are visited in score order (ties by index) and kept unless their probiou with a kept box of the
+// same class (any class when agnostic) is > iou_threshold, the greedy order of NonMaxSuppression (nms.h). The
+// score order is sorted lazily in chunks and visiting stops at max_det. Scratch lives in the object and is
+// reused, keep one per thread.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "nms.h"
+
+#if defined(__AVX2__)
+#define YOLO_ROTATED_NMS_AVX2 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define YOLO_ROTATED_NMS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace yolo {
+
+// Center, size and rotation in radians (the xywhr layout of the -obb heads)
+struct RotatedBox {
+	float cx = 0.0f;
+	float cy = 0.0f;
+	float width = 0.0f;
+	float height = 0.0f;
+	float angle = 0.0f;
+};
+
+namespace detail {
+
+constexpr float kProbIouEps = 1e-7f;
+
+// Python's %: the result has the sign of the divisor
+inline float FloorMod(float value, float divisor) {
+	const float r = std::fmod(value, divisor);
+	return r < 0.0f ? r + divisor : r;
+}
+
+// Gaussian of a box: a, b, c of the covariance [[a, c], [c, b]]
+inline void RotatedCovariance(const RotatedBox &box, float &a, float &b, float &c) {
+	const float a0 = box.width * box.width / 12.0f;
+	const float b0 = box.height * box.height / 12.0f;
+	const float cos = std::cos(box.angle);
+	const float sin = std::sin(box.angle);
+	a = a0 * cos * cos + b0 * sin * sin;
+	b = a0 * sin * sin + b0 * cos * cos;
+	c = (a0 - b0) * cos * sin;
+}
+
+// ops.batch_probiou for one pair of Gaussians, same operations and eps
+inline float ProbIou(float x1, float y1, float a1, float b1, float c1, float x2, float y2, float a2, float b2,
+                     float c2) {
+	const float a = a1 + a2;
+	const float b = b1 + b2;
+	const float c = c1 + c2;
+	const float den = a * b - c * c;
+	const float t1 = (a * (y1 - y2) * (y1 - y2) + b * (x1 - x2) * (x1 - x2)) / (den + kProbIouEps) * 0.25f;
+	const float t2 = (c * (x2 - x1) * (y1 - y2)) / (den + kProbIouEps) * 0.5f;
+	const float det1 = std::max(a1 * b1 - c1 * c1, 0.0f);
+	const float det2 = std::max(a2 * b2 - c2 * c2, 0.0f);
+	const float t3 = std::log(den / (4.0f * std::sqrt(det1 * det2) + kProbIouEps) + kProbIouEps) * 0.5f;
+	const float bd = std::min(std::max(t1 + t2 + t3, kProbIouEps), 100.0f);
+	const float hd = std::sqrt(1.0f - std::exp(-bd) + kProbIouEps);
+	return 1.0f - hd;
+}
+
+}  // namespace detail
+
+// ops.regularize_rboxes: angle in [0, pi/2), width and height swapped when the angle was in [pi/2, pi) mod pi
+inline RotatedBox RegularizeRotatedBox(RotatedBox box) {
+	constexpr float kPi = 3.14159265358979323846f;
+	if (detail::FloorMod(box.angle, kPi) >= kPi / 2.0f) {
+		std::swap(box.width, box.height);
+	}
+	box.angle = detail::FloorMod(box.angle, kPi / 2.0f);
+	return box;
+}
+
+// ops.xywhr2xyxyxyxy: x, y of the four corners
+inline void RotatedBoxCorners(const RotatedBox &box, float *corners) {
+	const float cos = std::cos(box.angle);
+	const float sin = std::sin(box.angle);
+	const float v1x = box.width / 2.0f * cos, v1y = box.width / 2.0f * sin;
+	const float v2x = -box.height / 2.0f * sin, v2y = box.height / 2.0f * cos;
+	const float points[8] = {box.cx + v1x + v2x, box.cy + v1y + v2y, box.cx + v1x - v2x, box.cy + v1y - v2y,
+	                         box.cx - v1x - v2x, box.cy - v1y - v2y, box.cx - v1x + v2x, box.cy - v1y + v2y};
+	std::copy(points, points + 8, corners);
+}
+
+// Probabilistic IoU of two rotated boxes (ops.batch_probiou)
+inline float ProbIou(const RotatedBox &box1, const RotatedBox &box2) {
+	float a1, b1, c1, a2, b2, c2;
+	detail::RotatedCovariance(box1, a1, b1, c1);
+	detail::RotatedCovariance(box2, a2, b2, c2);
+	return detail::ProbIou(box1.cx, box1.cy, a1, b1, c1, box2.cx, box2.cy, a2, b2, c2);
+}
+
+class RotatedNonMaxSuppression {
+ public:
+	// keep receives the indices of the kept candidates, best score first. options.grid_min_candidates is not
+	// used. Returns keep.size().
+	size_t Run(const RotatedBox *boxes, const float *scores, const int *class_ids, size_t count,
+	           const NmsOptions &options, std::vector<int> &keep);
+
+ private:
+	// Kept boxes of one class, centers and covariances as structure of arrays
+	struct KeptSet {
+		std::vector<float> x, y, a, b, c;
+
+		size_t size() const { return x.size(); }
+		void clear() {
+			x.clear();
+			y.clear();
+			a.clear();
+			b.clear();
+			c.clear();
+		}
+	};
+
+	static bool Overlaps(const KeptSet &set, float x, float y, float a, float b, float c, float limit,
+	                     float iou_threshold);
+
+	std::vector<int> order_;
+	std::vector<KeptSet> sets_;
+	std::vector<size_t> touched_;
+};
+
+// limit: Mahalanobis term from which a pair cannot be over the threshold
+inline bool RotatedNonMaxSuppression::Overlaps(const KeptSet &set, float x, float y, float a, float b, float c,
+                                               float limit, float iou_threshold) {
+	const size_t n = set.size();
+	size_t j = 0;
+	auto exact = [&](size_t k) {
+		return detail::ProbIou(x, y, a, b, c, set.x[k], set.y[k], set.a[k], set.b[k], set.c[k]) > iou_threshold;
+	};
+#if defined(YOLO_ROTATED_NMS_AVX2)
+	const __m256 vx = _mm256_set1_ps(x);
+	const __m256 vy = _mm256_set1_ps(y);
+	const __m256 va = _mm256_set1_ps(a);
+	const __m256 vb = _mm256_set1_ps(b);
+	const __m256 vc = _mm256_set1_ps(c);
+	const __m256 vlimit = _mm256_set1_ps(limit);
+	const __m256 eps = _mm256_set1_ps(detail::kProbIouEps);
+	const __m256 quarter = _mm256_set1_ps(0.25f);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	for (; j + 8 <= n; j += 8) {
+		// t1 + t2 < limit, multiplied out by the positive denominator
+		const __m256 sa = _mm256_add_ps(va, _mm256_loadu_ps(&set.a[j]));
+		const __m256 sb = _mm256_add_ps(vb, _mm256_loadu_ps(&set.b[j]));
+		const __m256 sc = _mm256_add_ps(vc, _mm256_loadu_ps(&set.c[j]));
+		const __m256 dx = _mm256_sub_ps(vx, _mm256_loadu_ps(&set.x[j]));
+		const __m256 dy = _mm256_sub_ps(vy, _mm256_loadu_ps(&set.y[j]));
+		const __m256 den = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(sa, sb), _mm256_mul_ps(sc, sc)), eps);
+		const __m256 quadratic = _mm256_add_ps(_mm256_mul_ps(sa, _mm256_mul_ps(dy, dy)),
+		                                       _mm256_mul_ps(sb, _mm256_mul_ps(dx, dx)));
+		const __m256 mahalanobis = _mm256_sub_ps(_mm256_mul_ps(quarter, quadratic),
+		                                         _mm256_mul_ps(half, _mm256_mul_ps(sc, _mm256_mul_ps(dx, dy))));
+		const int near = _mm256_movemask_ps(_mm256_cmp_ps(mahalanobis, _mm256_mul_ps(vlimit, den), _CMP_LT_OQ));
+		for (int lane = 0; near != 0 && lane < 8; lane++) {
+			if (((near >> lane) & 1) != 0 && exact(j + lane)) {
+				return true;
+			}
+		}
+	}
+#elif defined(YOLO_ROTATED_NMS_NEON)
+	const float32x4_t vx = vdupq_n_f32(x);
+	const float32x4_t vy = vdupq_n_f32(y);
+	const float32x4_t va = vdupq_n_f32(a);
+	const float32x4_t vb = vdupq_n_f32(b);
+	const float32x4_t vc = vdupq_n_f32(c);
+	const float32x4_t vlimit = vdupq_n_f32(limit);
+	const float32x4_t eps = vdupq_n_f32(detail::kProbIouEps);
+	for (; j + 4 <= n; j += 4) {
+		const float32x4_t sa = vaddq_f32(va, vld1q_f32(&set.a[j]));
+		const float32x4_t sb = vaddq_f32(vb, vld1q_f32(&set.b[j]));
+		const float32x4_t sc = vaddq_f32(vc, vld1q_f32(&set.c[j]));
+		const float32x4_t dx = vsubq_f32(vx, vld1q_f32(&set.x[j]));
+		const float32x4_t dy = vsubq_f32(vy, vld1q_f32(&set.y[j]));
+		const float32x4_t den = vaddq_f32(vsubq_f32(vmulq_f32(sa, sb), vmulq_f32(sc, sc)), eps);
+		const float32x4_t quadratic = vaddq_f32(vmulq_f32(sa, vmulq_f32(dy, dy)), vmulq_f32(sb, vmulq_f32(dx, dx)));
+		const float32x4_t mahalanobis = vsubq_f32(vmulq_n_f32(quadratic, 0.25f),
+		                                          vmulq_n_f32(vmulq_f32(sc, vmulq_f32(dx, dy)), 0.5f));
+		const uint32x4_t near = vcltq_f32(mahalanobis, vmulq_f32(vlimit, den));
+		if (vmaxvq_u32(near) != 0) {
+			uint32_t lanes[4];
+			vst1q_u32(lanes, near);
+			for (int lane = 0; lane < 4; lane++) {
+				if (lanes[lane] != 0 && exact(j + lane)) {
+					return true;
+				}
+			}
+		}
+	}
+#endif
+	for (; j < n; j++) {
+		const float sa = a + set.a[j], sb = b + set.b[j], sc = c + set.c[j];
+		const float dx = x - set.x[j], dy = y - set.y[j];
+		const float den = sa * sb - sc * sc + detail::kProbIouEps;
+		const float mahalanobis = 0.25f * (sa * dy * dy + sb * dx * dx) - 0.5f * sc * dx * dy;
+		if (mahalanobis < limit * den && exact(j)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+inline size_t RotatedNonMaxSuppression::Run(const RotatedBox *boxes, const float *scores, const int *class_ids,
+                                            size_t count, const NmsOptions &options, std::vector<int> &keep) {
+	YOLO_TRACE_ZONE("RotatedNMS");
+	keep.clear();
+	order_.clear();
+	for (size_t i = 0; i < count; i++) {
+		if (scores[i] > options.score_threshold) {
+			order_.push_back(static_cast<int>(i));
+		}
+	}
+	const size_t n = order_.size();
+	if (n == 0) {
+		return 0;
+	}
+	const bool agnostic = options.agnostic || class_ids == nullptr;
+	const size_t max_det = options.max_det > 0 ? static_cast<size_t>(options.max_det) : n;
+	auto by_score = [scores](int a, int b) { return scores[a] > scores[b] || (scores[a] == scores[b] && a < b); };
+
+	// probiou > t  <=>  bd < -log(1 + eps - (1 - t)^2), with headroom for the rounding of the vector test (the
+	// shape term t3 only adds to bd). t < 0 suppresses everything, t >= 1 nothing, both left to the exact test.
+	const double t = options.iou_threshold;
+	float limit = INFINITY;
+	if (t >= 0.0 && t < 1.0) {
+		const double bd = -std::log(1.0 + detail::kProbIouEps - (1.0 - t) * (1.0 - t));
+		limit = static_cast<float>(bd * 1.001 + 1e-3);
+	}
+
+	int max_class = 0;
+	if (!agnostic) {
+		for (int i : order_) {
+			max_class = std::max(max_class, class_ids[i]);
+		}
+	}
+	if (sets_.size() < static_cast<size_t>(max_class) + 1) {
+		sets_.resize(static_cast<size_t>(max_class) + 1);
+	}
+
+	// Sort lazily: the first chunk covers max_det with room for suppressed boxes, the next ones double
+	size_t sorted = 0;
+	size_t chunk = std::max<size_t>(4 * max_det, 256);
+	for (size_t k = 0; k < n && keep.size() < max_det; k++) {
+		if (k == sorted) {
+			const size_t end = std::min(n, sorted + chunk);
+			if (end < n) {
+				std::nth_element(order_.begin() + sorted, order_.begin() + end, order_.end(), by_score);
+			}
+			std::sort(order_.begin() + sorted, order_.begin() + end, by_score);
+			sorted = end;
+			chunk *= 2;
+		}
+		const int i = order_[k];
+		const RotatedBox &box = boxes[i];
+		const size_t cls = agnostic ? 0 : static_cast<size_t>(class_ids[i]);
+		float a, b, c;
+		detail::RotatedCovariance(box, a, b, c);
+		KeptSet &set = sets_[cls];
+		if (!Overlaps(set, box.cx, box.cy, a, b, c, limit, options.iou_threshold)) {
+			if (set.size() == 0) {
+				touched_.push_back(cls);
+			}
+			set.x.push_back(box.cx);
+			set.y.push_back(box.cy);
+			set.a.push_back(a);
+			set.b.push_back(b);
+			set.c.push_back(c);
+			keep.push_back(i);
+		}
+	}
+
+	for (size_t set : touched_) {
+		sets_[set].clear();
+	}
+	touched_.clear();
+	return keep.size();
+}
+
+}  // namespace yolo
+
+#endif  // YOLO_ROTATED_NMS_H_
@@ -0,0 +1,192 @@
+#ifndef YOLO_SLICING_H_
+#define YOLO_SLICING_H_
+
+// Sliced inference (SAHI) for high-resolution frames, shared by the C++ examples.
+//
+// Squashing a 1920x1080 or 4K frame into a 640x640 input shrinks small objects by 3x to 6x, below what the model
+// detects. Sliced inference runs the model on overlapping tiles at (close to) native resolution instead, optionally
+// with the whole frame as well for objects larger than a tile. Detections are shifted back into frame coordinates,
+// and the duplicates where tiles overlap are merged. The backend does the batching; this header has the geometry
+// and the merge.
+//
+// The tiling follows sahi.slicing.get_slice_bboxes: tiles step by the slice size minus the overlap, and the last
+// row and column are moved back to end at the frame border, so every tile has the full slice size when the frame is
+// large enough. The merge follows sahi's postprocess: in score order, each box not yet matched removes every later
+// box (of its class, unless agnostic) whose IoU, or intersection over the smaller area (IoS), is > match_threshold.
+// kNms keeps the removed boxes out. kNmm (non-maximum merging, sahi's default) also grows the kept box to the union
+// of the boxes it matched, which rebuilds an object that tile borders cut into pieces. Matches are always tested
+// against the kept box as detected, not the grown one, as sahi does.
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+#include "nms.h"
+#include "trace.h"
+
+namespace yolo {
+
+enum class SliceMerge {
+	kNms,  // Drop matched boxes
+	kNmm,  // Merge matched boxes into the kept one
+};
+
+enum class SliceMatchMetric {
+	kIou,  // Intersection over union
+	kIos,  // Intersection over the smaller box: a piece of an object matches the whole
+};
+
+struct SliceOptions {
+	int slice_width = 640;
+	int slice_height = 640;
+	float overlap_width_ratio = 0.2f;   // Of the slice width shared by horizontal neighbours
+	float overlap_height_ratio = 0.2f;
+	bool full_frame = true;             // Also detect on the whole frame, for objects larger than a tile
+	SliceMerge merge = SliceMerge::kNmm;
+	SliceMatchMetric metric = SliceMatchMetric::kIos;
+	float match_threshold = 0.5f;       // Boxes match when the metric is > this
+	bool agnostic = false;              // Match across classes
+	int max_det = 300;                  // Keep at most this many merged boxes, <= 0 for no limit
+};
+
+// Tile of the frame, in pixels
+struct SliceRect {
+	int x = 0;
+	int y = 0;
+	int width = 0;
+	int height = 0;
+};
+
+// Detection in frame coordinates
+struct SliceBox {
+	float x1 = 0.0f;
+	float y1 = 0.0f;
+	float x2 = 0.0f;
+	float y2 = 0.0f;
+	float score = 0.0f;
+	int class_id = 0;
+};
+
+// Tiles covering a width x height frame, row by row. A frame no larger than a slice is one tile.
+inline std::vector<SliceRect> ComputeSlices(int width, int height, const SliceOptions &options) {
+	std::vector<SliceRect> slices;
+	if (width <= 0 || height <= 0 || options.slice_width <= 0 || options.slice_height <= 0) {
+		return slices;
+	}
+	const int overlap_x = static_cast<int>(options.overlap_width_ratio * options.slice_width);
+	const int overlap_y = static_cast<int>(options.overlap_height_ratio * options.slice_height);
+	// A step of at least one pixel, whatever the overlap
+	const int step_x = std::max(options.slice_width - overlap_x, 1);
+	const int step_y = std::max(options.slice_height - overlap_y, 1);
+	for (int y = 0;; y += step_y) {
+		const int y2 = std::min(y + options.slice_height, height);
+		const int y1 = std::max(y2 - options.slice_height, 0);
+		for (int x = 0;; x += step_x) {
+			const int x2 = std::min(x + options.slice_width, width);
+			const int x1 = std::max(x2 - options.slice_width, 0);
+			SliceRect slice;
+			slice.x = x1;
+			slice.y = y1;
+			slice.width = x2 - x1;
+			slice.height = y2 - y1;
+			slices.push_back(slice);
+			if (x + options.slice_width >= width) {
+				break;
+			}
+		}
+		if (y + options.slice_height >= height) {
+			break;
+		}
+	}
+	return slices;
+}
+
+// Merges the detections of all tiles (and the full frame). Scratch is reused, keep one per thread.
+class SliceMerger {
+ public:
+	// boxes in frame coordinates, any order. out receives the kept boxes, best score first.
+	void Merge(const std::vector<SliceBox> &boxes, const SliceOptions &options, std::vector<SliceBox> &out) {
+		YOLO_TRACE_ZONE("MergeSlices");
+		out.clear();
+		if (options.merge == SliceMerge::kNms && options.metric == SliceMatchMetric::kIou) {
+			MergeNms(boxes, options, out);
+			return;
+		}
+		order_.resize(boxes.size());
+		std::iota(order_.begin(), order_.end(), 0);
+		std::stable_sort(order_.begin(), order_.end(),
+		                 [&boxes](int a, int b) { return boxes[a].score > boxes[b].score; });
+		matched_.assign(boxes.size(), 0);
+		for (size_t i = 0; i < order_.size(); i++) {
+			if (matched_[order_[i]]) {
+				continue;
+			}
+			const SliceBox &kept = boxes[order_[i]];
+			SliceBox merged = kept;
+			for (size_t j = i + 1; j < order_.size(); j++) {
+				const SliceBox &other = boxes[order_[j]];
+				if (matched_[order_[j]] || (!options.agnostic && other.class_id != kept.class_id) ||
+				    Match(kept, other, options.metric) <= options.match_threshold) {
+					continue;
+				}
+				matched_[order_[j]] = 1;
+				if (options.merge == SliceMerge::kNmm) {
+					merged.x1 = std::min(merged.x1, other.x1);
+					merged.y1 = std::min(merged.y1, other.y1);
+					merged.x2 = std::max(merged.x2, other.x2);
+					merged.y2 = std::max(merged.y2, other.y2);
+				}
+			}
+			out.push_back(merged);
+			if (options.max_det > 0 && out.size() >= static_cast<size_t>(options.max_det)) {
+				break;
+			}
+		}
+	}
+
+	static float Match(const SliceBox &a, const SliceBox &b, SliceMatchMetric metric) {
+		const float w = std::max(0.0f, std::min(a.x2, b.x2) - std::max(a.x1, b.x1));
+		const float h = std::max(0.0f, std::min(a.y2, b.y2) - std::max(a.y1, b.y1));
+		const float inter = w * h;
+		const float area_a = (a.x2 - a.x1) * (a.y2 - a.y1);
+		const float area_b = (b.x2 - b.x1) * (b.y2 - b.y1);
+		const float denominator = metric == SliceMatchMetric::kIou ? area_a + area_b - inter : std::min(area_a, area_b);
+		return denominator > 0.0f ? inter / denominator : 0.0f;
+	}
+
+ private:
+	// Same greedy result, on the vectorized suppression of nms.h
+	void MergeNms(const std::vector<SliceBox> &boxes, const SliceOptions &options, std::vector<SliceBox> &out) {
+		corners_.resize(4 * boxes.size());
+		scores_.resize(boxes.size());
+		class_ids_.resize(boxes.size());
+		for (size_t i = 0; i < boxes.size(); i++) {
+			corners_[4 * i] = boxes[i].x1;
+			corners_[4 * i + 1] = boxes[i].y1;
+			corners_[4 * i + 2] = boxes[i].x2;
+			corners_[4 * i + 3] = boxes[i].y2;
+			scores_[i] = boxes[i].score;
+			class_ids_[i] = boxes[i].class_id;
+		}
+		NmsOptions nms_options;
+		nms_options.iou_threshold = options.match_threshold;
+		nms_options.max_det = options.max_det;
+		nms_options.agnostic = options.agnostic;
+		nms_.Run(corners_.data(), scores_.data(), class_ids_.data(), boxes.size(), nms_options, keep_);
+		for (int index : keep_) {
+			out.push_back(boxes[index]);
+		}
+	}
+
+	std::vector<int> order_;
+	std::vector<char> matched_;
+	std::vector<float> corners_;
+	std::vector<float> scores_;
+	std::vector<int> class_ids_;
+	std::vector<int> keep_;
+	NonMaxSuppression nms_;
+};
+
+} // namespace yolo
+
+#endif // YOLO_SLICING_H_
@@ -0,0 +1,268 @@
+#ifndef YOLO_STAGE_BENCHMARK_H_
+#define YOLO_STAGE_BENCHMARK_H_
+
+// Latency benchmark of a detector (detector.h) for the benchmark_stages tools of every C++ backend.
+//
+// After warm-up, Detect runs a fixed number of times on one frame. Every call yields the backend's stage times
+// (stage_times.h) and the wall time of the whole call, which also covers the adapter's conversion to
+// DetectionResults. Each is summarized as p50/p90/p99/max/mean (nearest-rank percentiles), and fps is the number of
+// calls over the wall time of the timed loop. Results go to a table for reading and to JSON or CSV (one row per
+// backend and thread count, same columns every run) for tracking regressions across builds.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "detector.h"
+
+namespace yolo {
+
+struct LatencyStats {
+	double p50 = 0.0;
+	double p90 = 0.0;
+	double p99 = 0.0;
+	double max = 0.0;
+	double mean = 0.0;
+};
+
+// Nearest-rank percentiles: p is the smallest sample with at least p% of the samples at or below it
+inline LatencyStats Summarize(std::vector<double> samples) {
+	LatencyStats stats;
+	if (samples.empty()) {
+		return stats;
+	}
+	std::sort(samples.begin(), samples.end());
+	const auto rank = [&samples](double p) {
+		const size_t k = static_cast<size_t>(std::ceil(p / 100.0 * samples.size()));
+		return samples[std::max<size_t>(k, 1) - 1];
+	};
+	stats.p50 = rank(50.0);
+	stats.p90 = rank(90.0);
+	stats.p99 = rank(99.0);
+	stats.max = samples.back();
+	double sum = 0.0;
+	for (double sample : samples) {
+		sum += sample;
+	}
+	stats.mean = sum / samples.size();
+	return stats;
+}
+
+struct BenchmarkOptions {
+	int warmup = 10;       // Untimed calls first (lazy allocation, kernel selection, caches, clocks ramping up)
+	int iterations = 200;
+};
+
+struct BenchmarkResult {
+	std::string backend;
+	int threads = 0;       // Inference threads the backend was created with, 0 for its default
+	int iterations = 0;    // Timed calls that succeeded
+	int failures = 0;      // Timed calls that returned false, not in the statistics
+	LatencyStats preprocess;
+	LatencyStats inference;
+	LatencyStats postprocess;
+	LatencyStats total;    // Whole Detect call
+	double fps = 0.0;
+};
+
+// Runs the warm-up and the timed calls of detector on frame. Returns false when no timed call succeeded.
+inline bool BenchmarkDetector(IDetector &detector, const ImageView &frame, const BenchmarkOptions &options, int threads,
+		BenchmarkResult &result) {
+	result = BenchmarkResult();
+	result.backend = detector.Name();
+	result.threads = threads;
+	DetectionResults detections;
+	for (int i = 0; i < options.warmup; ++i) {
+		detector.Detect(frame, detections);
+	}
+
+	std::vector<double> preprocess, inference, postprocess, total;
+	preprocess.reserve(options.iterations);
+	inference.reserve(options.iterations);
+	postprocess.reserve(options.iterations);
+	total.reserve(options.iterations);
+	const std::chrono::steady_clock::time_point loop_start = std::chrono::steady_clock::now();
+	for (int i = 0; i < options.iterations; ++i) {
+		StageTimes times;
+		StageClock call_clock;
+		const bool ok = detector.Detect(frame, detections, &times);
+		const double call_ms = call_clock.Lap();
+		if (!ok) {
+			++result.failures;
+			continue;
+		}
+		preprocess.push_back(times.preprocess_ms);
+		inference.push_back(times.inference_ms);
+		postprocess.push_back(times.postprocess_ms);
+		total.push_back(call_ms);
+	}
+	const double loop_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - loop_start).count();
+
+	result.iterations = static_cast<int>(total.size());
+	result.preprocess = Summarize(preprocess);
+	result.inference = Summarize(inference);
+	result.postprocess = Summarize(postprocess);
+	result.total = Summarize(total);
+	result.fps = loop_s > 0.0 ? result.iterations / loop_s : 0.0;
+	return result.iterations > 0;
+}
+
+// Comma-separated thread counts, e.g. "1,2,4,8"; 0 stands for the backend's default
+inline std::vector<int> ParseThreadList(const std::string &list) {
+	std::vector<int> threads;
+	std::stringstream stream(list);
+	std::string item;
+	while (std::getline(stream, item, ',')) {
+		if (!item.empty()) {
+			threads.push_back(std::max(0, std::atoi(item.c_str())));
+		}
+	}
+	if (threads.empty()) {
+		threads.push_back(0);
+	}
+	return threads;
+}
+
+// What the results were measured on, repeated in every JSON document and CSV row
+struct BenchmarkInfo {
+	std::string model;
+	int frame_width = 0;
+	int frame_height = 0;
+	int warmup = 0;
+};
+
+namespace detail {
+
+inline std::string UtcTimestamp() {
+	const std::time_t now = std::time(nullptr);
+	char text[32] = "";
+	const std::tm *utc = std::gmtime(&now);
+	if (utc) {
+		std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", utc);
+	}
+	return text;
+}
+
+inline std::string JsonString(const std::string &text) {
+	std::string quoted = "\"";
+	for (char c : text) {
+		if (c == '"' || c == '\\') {
+			quoted += '\\';
+			quoted += c;
+		} else if (static_cast<unsigned char>(c) < 0x20) {
+			char escaped[8];
+			std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+			quoted += escaped;
+		} else {
+			quoted += c;
+		}
+	}
+	return quoted + '"';
+}
+
+inline std::string CsvField(const std::string &text) {
+	if (text.find_first_of(",\"\n") == std::string::npos) {
+		return text;
+	}
+	std::string quoted = "\"";
+	for (char c : text) {
+		quoted += c;
+		if (c == '"') {
+			quoted += '"';
+		}
+	}
+	return quoted + '"';
+}
+
+inline void WriteJsonStats(std::ostream &out, const char *name, const LatencyStats &stats) {
+	out << '"' << name << "\": {\"p50_ms\": " << stats.p50 << ", \"p90_ms\": " << stats.p90 << ", \"p99_ms\": "
+	    << stats.p99 << ", \"max_ms\": " << stats.max << ", \"mean_ms\": " << stats.mean << '}';
+}
+
+} // namespace detail
+
+inline void WriteJson(std::ostream &out, const BenchmarkInfo &info, const std::vector<BenchmarkResult> &results) {
+	out << std::fixed << std::setprecision(4);
+	out << "{\n  \"timestamp\": " << detail::JsonString(detail::UtcTimestamp()) << ",\n  \"model\": "
+	    << detail::JsonString(info.model) << ",\n  \"frame\": [" << info.frame_width << ", " << info.frame_height
+	    << "],\n  \"warmup\": " << info.warmup << ",\n  \"results\": [";
+	for (size_t i = 0; i < results.size(); ++i) {
+		const BenchmarkResult &result = results[i];
+		out << (i ? ",\n" : "\n") << "    {\"backend\": " << detail::JsonString(result.backend) << ", \"threads\": "
+		    << result.threads << ", \"iterations\": " << result.iterations << ", \"failures\": " << result.failures
+		    << ", \"fps\": " << result.fps << ",\n     ";
+		detail::WriteJsonStats(out, "preprocess", result.preprocess);
+		out << ",\n     ";
+		detail::WriteJsonStats(out, "inference", result.inference);
+		out << ",\n     ";
+		detail::WriteJsonStats(out, "postprocess", result.postprocess);
+		out << ",\n     ";
+		detail::WriteJsonStats(out, "total", result.total);
+		out << '}';
+	}
+	out << "\n  ]\n}\n";
+}
+
+inline void WriteCsv(std::ostream &out, const BenchmarkInfo &info, const std::vector<BenchmarkResult> &results) {
+	static const char *const stages[] = {"preprocess", "inference", "postprocess", "total"};
+	out << "timestamp,model,frame_width,frame_height,warmup,backend,threads,iterations,failures,fps";
+	for (const char *stage : stages) {
+		out << ',' << stage << "_p50_ms," << stage << "_p90_ms," << stage << "_p99_ms," << stage << "_max_ms," << stage
+		    << "_mean_ms";
+	}
+	out << '\n' << std::fixed << std::setprecision(4);
+	const std::string timestamp = detail::UtcTimestamp();
+	for (const BenchmarkResult &result : results) {
+		out << timestamp << ',' << detail::CsvField(info.model) << ',' << info.frame_width << ',' << info.frame_height
+		    << ',' << info.warmup << ',' << detail::CsvField(result.backend) << ',' << result.threads << ','
+		    << result.iterations << ',' << result.failures << ',' << result.fps;
+		for (const LatencyStats *stats : {&result.preprocess, &result.inference, &result.postprocess, &result.total}) {
+			out << ',' << stats->p50 << ',' << stats->p90 << ',' << stats->p99 << ',' << stats->max << ',' << stats->mean;
+		}
+		out << '\n';
+	}
+}
+
+// JSON for a path ending in .json, CSV otherwise. False when the file can't be written.
+inline bool WriteResults(const std::string &path, const BenchmarkInfo &info, const std::vector<BenchmarkResult> &results) {
+	std::ofstream file(path);
+	const bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+	if (json) {
+		WriteJson(file, info, results);
+	} else {
+		WriteCsv(file, info, results);
+	}
+	return static_cast<bool>(file.flush());
+}
+
+// Table of the p50/p90/p99/max per stage and the fps of every result
+inline void PrintResults(std::ostream &out, const std::vector<BenchmarkResult> &results) {
+	out << std::fixed << std::setprecision(2);
+	for (const BenchmarkResult &result : results) {
+		out << result.backend << ", " << (result.threads > 0 ? std::to_string(result.threads) : std::string("default"))
+		    << " threads, " << result.iterations << " iterations";
+		if (result.failures > 0) {
+			out << " (" << result.failures << " failed)";
+		}
+		out << ", " << result.fps << " fps\n";
+		out << "  stage (ms)        p50      p90      p99      max\n";
+		const LatencyStats *stats[] = {&result.preprocess, &result.inference, &result.postprocess, &result.total};
+		const char *names[] = {"preprocess ", "inference  ", "postprocess", "total      "};
+		for (int s = 0; s < 4; ++s) {
+			out << "  " << names[s] << std::setw(11) << stats[s]->p50 << std::setw(9) << stats[s]->p90 << std::setw(9)
+			    << stats[s]->p99 << std::setw(9) << stats[s]->max << '\n';
+		}
+	}
+}
+
+} // namespace yolo
+
+#endif // YOLO_STAGE_BENCHMARK_H_
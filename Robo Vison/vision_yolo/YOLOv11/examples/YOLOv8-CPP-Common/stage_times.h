@@ -0,0 +1,39 @@
+#ifndef YOLO_STAGE_TIMES_H_
+#define YOLO_STAGE_TIMES_H_
+
+// Per-frame wall-clock time of the three stages every backend runs, measured with the monotonic steady_clock.
+// Process CPU time (clock()) adds up the time of every thread ORT, OpenVINO or LibTorch runs on, so it says little
+// about latency once inference is multi-threaded.
+
+#include <chrono>
+
+namespace yolo {
+
+// One frame, in ms
+struct StageTimes {
+	double preprocess_ms = 0.0;   // Frame to input tensor (letterbox, conversion, upload)
+	double inference_ms = 0.0;    // Engine run, output available on the host
+	double postprocess_ms = 0.0;  // Decode and NMS
+
+	double total_ms() const { return preprocess_ms + inference_ms + postprocess_ms; }
+};
+
+// Splits a frame into stages: each Lap returns the time since the previous one (or construction)
+class StageClock {
+ public:
+	StageClock() : last_(std::chrono::steady_clock::now()) {}
+
+	double Lap() {
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		const double ms = std::chrono::duration<double, std::milli>(now - last_).count();
+		last_ = now;
+		return ms;
+	}
+
+ private:
+	std::chrono::steady_clock::time_point last_;
+};
+
+} // namespace yolo
+
+#endif // YOLO_STAGE_TIMES_H_
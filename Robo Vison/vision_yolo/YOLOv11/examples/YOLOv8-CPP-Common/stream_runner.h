@@ -0,0 +1,244 @@
+#ifndef YOLO_STREAM_RUNNER_H_
+#define YOLO_STREAM_RUNNER_H_
+
+// Live-stream runner shared by the C++ examples: always process the newest frame and drop stale ones when inference
+// is slower than capture.
+//
+// A capture thread reads frames into a single-slot mailbox, and the calling thread takes them from there and
+// processes them. So at most one frame waits, and the latency from capture to result is bounded by about one capture
+// interval plus one processing time, whatever the two rates are. A queue would grow that by one processing time per
+// frame it holds. When a frame arrives while another waits, the drop policy decides:
+//   kDropOldest  the waiting frame is replaced, the consumer gets the newest one (live cameras)
+//   kDropNewest  the arriving frame is discarded, the waiting one stays (steadier spacing, up to one frame older)
+//   kBlock       capture waits for the consumer, nothing is dropped (files processed in full)
+// With max_age_ms, frames that waited longer than that are dropped when taken instead of processed.
+//
+// Frame buffers are swapped between the capture thread, the mailbox and the consumer, never copied: with a cv::Mat
+// frame, VideoCapture::read reuses the buffer of a frame that was dropped or already processed. The pipelined
+// executor (pipeline.h) is the choice when every frame matters and throughput is the goal.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "stage_benchmark.h"
+#include "trace.h"
+
+namespace yolo {
+
+enum class DropPolicy {
+	kDropOldest,  // Arriving frame replaces the waiting one
+	kDropNewest,  // Arriving frame is discarded while one waits
+	kBlock,       // Capture waits until the consumer takes the waiting frame
+};
+
+// One frame slot between a producer and a consumer thread. Put and Take swap with the slot, so the caller gets a
+// buffer back to reuse.
+template <typename T>
+class LatestMailbox {
+ public:
+	explicit LatestMailbox(DropPolicy policy) : policy_(policy) {}
+
+	LatestMailbox(const LatestMailbox &) = delete;
+	LatestMailbox &operator=(const LatestMailbox &) = delete;
+
+	// Offers item. Returns false when a frame was dropped: the waiting one (kDropOldest), the arriving one
+	// (kDropNewest) or the arriving one after Close. Afterwards item holds a buffer to refill.
+	bool Put(T &item) {
+		std::unique_lock<std::mutex> lock(mutex_);
+		if (policy_ == DropPolicy::kBlock) {
+			taken_.wait(lock, [this] { return !full_ || closed_; });
+		}
+		if (closed_ || (full_ && policy_ == DropPolicy::kDropNewest)) {
+			dropped_++;
+			return false;
+		}
+		const bool replaced = full_;
+		dropped_ += replaced;
+		std::swap(slot_, item);
+		full_ = true;
+		lock.unlock();
+		filled_.notify_one();
+		return !replaced;
+	}
+
+	// Waits for a frame and swaps it into item. Returns false once the mailbox is closed and empty.
+	bool Take(T &item) {
+		std::unique_lock<std::mutex> lock(mutex_);
+		filled_.wait(lock, [this] { return full_ || closed_; });
+		if (!full_) {
+			return false;
+		}
+		std::swap(slot_, item);
+		full_ = false;
+		lock.unlock();
+		taken_.notify_one();
+		return true;
+	}
+
+	// No more frames: Take returns what still waits, then false; Put drops
+	void Close() {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			closed_ = true;
+		}
+		filled_.notify_all();
+		taken_.notify_all();
+	}
+
+	size_t dropped() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		return dropped_;
+	}
+
+ private:
+	const DropPolicy policy_;
+	mutable std::mutex mutex_;
+	std::condition_variable filled_;
+	std::condition_variable taken_;
+	T slot_;
+	bool full_ = false;
+	bool closed_ = false;
+	size_t dropped_ = 0;
+};
+
+struct StreamOptions {
+	DropPolicy policy = DropPolicy::kDropOldest;
+	double max_age_ms = 0.0;  // Frames that waited longer are dropped when taken, 0 keeps them all
+	double source_fps = 0.0;  // Paces the source like a camera (a file standing in for one), 0 reads back to back
+	size_t max_frames = 0;    // Captured frames after which capture stops, 0 for the whole stream
+};
+
+struct StreamStats {
+	size_t captured = 0;
+	size_t processed = 0;      // Process returned true
+	size_t failed = 0;         // Process returned false
+	size_t dropped = 0;        // By the drop policy
+	size_t stale = 0;          // Older than max_age_ms when taken
+	double seconds = 0.0;
+	LatencyStats latency;      // Capture to result in ms, processed frames
+	std::vector<double> latency_ms;
+
+	double Fps() const { return seconds > 0.0 ? processed / seconds : 0.0; }
+
+	// Captured frames that were never processed
+	double DropRate() const { return captured > 0 ? double(dropped + stale) / captured : 0.0; }
+};
+
+// Frame: default-constructible, swappable per-frame state (image, results). The source runs on the capture thread,
+// process on the thread that calls Run. An exception from either stops the stream and Run rethrows it.
+template <typename Frame>
+class StreamRunner {
+ public:
+	using Source = std::function<bool(Frame &)>;   // Fill the frame (blocking, like a camera read), false at the end
+	using Process = std::function<bool(Frame &)>;  // Detect and use the result, false if the frame failed
+
+	StreamRunner(const StreamOptions &options, Source source, Process process)
+	    : options_(options), source_(std::move(source)), process_(std::move(process)), mailbox_(options.policy) {}
+
+	// Runs until the source ends, max_frames are captured or Stop() is called, then processes what still waits.
+	// One runner runs once.
+	StreamStats Run() {
+		stats_ = StreamStats();
+		const Clock::time_point start = Clock::now();
+		std::thread capture(&StreamRunner::CaptureLoop, this);
+		Stamped stamped;
+		try {
+			while (mailbox_.Take(stamped)) {
+				const Clock::time_point taken = Clock::now();
+				if (options_.max_age_ms > 0.0 && Milliseconds(taken - stamped.captured) > options_.max_age_ms) {
+					stats_.stale++;
+					continue;
+				}
+				if (process_(stamped.frame)) {
+					stats_.processed++;
+					stats_.latency_ms.push_back(Milliseconds(Clock::now() - stamped.captured));
+				} else {
+					stats_.failed++;
+				}
+			}
+		} catch (...) {
+			Stop();
+			mailbox_.Close();
+			capture.join();
+			throw;
+		}
+		capture.join();
+		if (error_) {
+			std::rethrow_exception(error_);
+		}
+		stats_.seconds = Milliseconds(Clock::now() - start) / 1000.0;
+		stats_.captured = captured_;
+		stats_.dropped = mailbox_.dropped();
+		stats_.latency = Summarize(stats_.latency_ms);
+		return stats_;
+	}
+
+	// Ends capture from any thread (a key press, a signal handler flag); the waiting frame is still processed
+	void Stop() { stop_.store(true, std::memory_order_relaxed); }
+
+ private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Stamped {
+		Frame frame;
+		Clock::time_point captured;
+	};
+
+	static double Milliseconds(Clock::duration duration) {
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+
+	void CaptureLoop() {
+		const Clock::duration period = options_.source_fps > 0.0
+		    ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / options_.source_fps))
+		    : Clock::duration::zero();
+		Clock::time_point due = Clock::now();
+		Stamped stamped;
+		try {
+			while (!stop_.load(std::memory_order_relaxed)) {
+				if (period > Clock::duration::zero()) {
+					std::this_thread::sleep_until(due);
+					// A camera that fell behind does not catch up in a burst
+					due = std::max(due + period, Clock::now());
+				}
+				{
+					YOLO_TRACE_ZONE("Capture");
+					if (!source_(stamped.frame)) {
+						break;
+					}
+				}
+				stamped.captured = Clock::now();
+				captured_++;
+				mailbox_.Put(stamped);
+				if (options_.max_frames > 0 && captured_ >= options_.max_frames) {
+					break;
+				}
+			}
+		} catch (...) {
+			error_ = std::current_exception();
+		}
+		mailbox_.Close();
+	}
+
+	StreamOptions options_;
+	Source source_;
+	Process process_;
+	LatestMailbox<Stamped> mailbox_;
+	std::atomic<bool> stop_{false};
+	size_t captured_ = 0;          // Written by the capture thread, read after it is joined
+	std::exception_ptr error_;     // Same
+	StreamStats stats_;
+};
+
+} // namespace yolo
+
+#endif // YOLO_STREAM_RUNNER_H_
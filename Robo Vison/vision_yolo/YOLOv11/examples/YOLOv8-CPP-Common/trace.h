@@ -0,0 +1,378 @@
+#ifndef YOLO_TRACE_H_
+#define YOLO_TRACE_H_
+
+// Hot-path tracing: scoped zones (preprocessing, blob, engine run, decode, NMS) recorded with steady_clock
+// nanosecond timestamps into one ring buffer per thread, dumped as Chrome trace event JSON that chrome://tracing and
+// ui.perfetto.dev open. A thread only ever writes its own ring, so recording takes no lock, only relaxed stores and
+// a release fence. Once a ring is full the oldest zones are overwritten. When a thread exits its ring goes back to a
+// free list and the next thread to record takes it over, so threads started per call or per connection don't add a
+// ring each: there are only as many rings as threads ever recorded at once. The zones of an exited thread are dumped
+// until its successor overwrites them, under the same thread id.
+//
+// Off by default: a zone then costs one relaxed atomic load. YOLO_TRACE_DISABLED compiles every zone away. To leave
+// tracing on in production, SetSampleEvery(n) records one frame in n per thread; a frame is a YOLO_TRACE_FRAME scope
+// and the zones nested in it. Zones outside any frame are recorded whenever tracing is on.
+//
+// Zone names are kept by pointer, they must be string literals (or otherwise outlive the dump).
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace yolo {
+namespace trace {
+
+// One completed zone
+struct Event {
+	const char *name = nullptr;
+	uint64_t start_ns = 0;     // steady_clock
+	uint64_t duration_ns = 0;
+	uint32_t thread = 0;       // Ring the zone was recorded in, from 1; one thread at a time owns a ring
+};
+
+namespace detail {
+
+inline uint64_t NowNs() {
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+	    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Single-writer ring. The owner thread records; any thread may take a snapshot concurrently. begun_ is raised before
+// a slot is overwritten and head_ after it is complete, so a reader drops every slot that may have changed under it
+// (a seqlock over the whole ring).
+class ThreadRing {
+ public:
+	ThreadRing(uint32_t thread, size_t capacity) : thread_(thread), slots_(std::max<size_t>(capacity, 1)) {}
+
+	void Record(const char *name, uint64_t start_ns, uint64_t duration_ns) {
+		const uint64_t index = head_.load(std::memory_order_relaxed);
+		begun_.store(index + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		Slot &slot = slots_[index % slots_.size()];
+		slot.name.store(name, std::memory_order_relaxed);
+		slot.start_ns.store(start_ns, std::memory_order_relaxed);
+		slot.duration_ns.store(duration_ns, std::memory_order_relaxed);
+		head_.store(index + 1, std::memory_order_release);
+	}
+
+	// Appends the zones still in the ring, oldest first
+	void Snapshot(std::vector<Event> &out) const {
+		const uint64_t capacity = slots_.size();
+		const uint64_t head = head_.load(std::memory_order_acquire);
+		const uint64_t first = head > capacity ? head - capacity : 0;
+		std::vector<Event> copied;
+		copied.reserve((size_t)(head - first));
+		for (uint64_t i = first; i < head; ++i) {
+			const Slot &slot = slots_[i % capacity];
+			Event event;
+			event.name = slot.name.load(std::memory_order_relaxed);
+			event.start_ns = slot.start_ns.load(std::memory_order_relaxed);
+			event.duration_ns = slot.duration_ns.load(std::memory_order_relaxed);
+			event.thread = thread_;
+			copied.push_back(event);
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		// Slot i is overwritten by record i + capacity, which raised begun_ to i + capacity + 1 first
+		const uint64_t begun = begun_.load(std::memory_order_relaxed);
+		const uint64_t valid_from = begun > capacity ? begun - capacity : 0;
+		for (uint64_t i = std::max(first, valid_from); i < head; ++i) {
+			out.push_back(copied[(size_t)(i - first)]);
+		}
+	}
+
+	uint32_t thread() const { return thread_; }
+	size_t capacity() const { return slots_.size(); }
+
+ private:
+	struct Slot {
+		std::atomic<const char *> name{nullptr};
+		std::atomic<uint64_t> start_ns{0};
+		std::atomic<uint64_t> duration_ns{0};
+	};
+
+	const uint32_t thread_;
+	std::vector<Slot> slots_;
+	std::atomic<uint64_t> begun_{0};
+	std::atomic<uint64_t> head_{0};
+};
+
+struct Registry {
+	std::atomic<bool> enabled{false};
+	std::atomic<uint32_t> sample_every{1};
+	std::atomic<uint64_t> since_ns{0};   // Clear: zones that started before are not dumped
+	std::atomic<size_t> capacity{8192};  // Zones per thread, 24 bytes each
+	std::mutex mutex;                    // Guards the rest
+	std::vector<std::shared_ptr<ThreadRing>> rings;       // Every ring, its zones are dumped
+	std::vector<std::shared_ptr<ThreadRing>> free_rings;  // Rings of exited threads, taken over by new ones
+	std::map<uint32_t, std::string> thread_names;
+};
+
+inline Registry &GetRegistry() {
+	static Registry registry;
+	return registry;
+}
+
+// Holds the calling thread's ring and hands it back to the free list when the thread exits. The registry is a
+// function static constructed before any owner, so it outlives the owners of every thread, the main one included.
+struct RingOwner {
+	~RingOwner() {
+		if (ring) {
+			Registry &registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			registry.free_rings.push_back(std::move(ring));
+		}
+	}
+
+	std::shared_ptr<ThreadRing> ring;
+};
+
+// The calling thread's ring, taken on its first zone: a free ring of the current capacity, else a new one. The
+// registry mutex orders the last record of the previous owner before the first of the next.
+inline ThreadRing &LocalRing() {
+	thread_local RingOwner owner;
+	if (!owner.ring) {
+		Registry &registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		const size_t capacity = std::max<size_t>(registry.capacity.load(std::memory_order_relaxed), 1);
+		for (size_t i = 0; i < registry.free_rings.size(); ++i) {
+			if (registry.free_rings[i]->capacity() == capacity) {
+				owner.ring = std::move(registry.free_rings[i]);
+				registry.free_rings.erase(registry.free_rings.begin() + (std::ptrdiff_t)i);
+				// The previous owner's name would label this thread's zones
+				registry.thread_names.erase(owner.ring->thread());
+				break;
+			}
+		}
+		if (!owner.ring) {
+			owner.ring = std::make_shared<ThreadRing>((uint32_t)registry.rings.size() + 1, capacity);
+			registry.rings.push_back(owner.ring);
+		}
+	}
+	return *owner.ring;
+}
+
+// Sampling state of the calling thread
+struct FrameState {
+	int depth = 0;         // Nested YOLO_TRACE_FRAME scopes
+	bool sampled = true;   // Whether the current frame (or no frame) is recorded
+	uint64_t frames = 0;   // Outermost frames begun on this thread
+};
+
+inline FrameState &LocalFrame() {
+	thread_local FrameState state;
+	return state;
+}
+
+inline void WriteString(std::ostream &out, const char *text) {
+	out << '"';
+	for (const char *c = text ? text : ""; *c; ++c) {
+		if (*c == '"' || *c == '\\') {
+			out << '\\' << *c;
+		} else if ((unsigned char)*c < 0x20) {
+			char escaped[8];
+			std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned)(unsigned char)*c);
+			out << escaped;
+		} else {
+			out << *c;
+		}
+	}
+	out << '"';
+}
+
+// ns as the trace format's microseconds, keeping the nanoseconds
+inline void WriteMicroseconds(std::ostream &out, uint64_t ns) {
+	char text[32];
+	std::snprintf(text, sizeof(text), "%llu.%03u", (unsigned long long)(ns / 1000), (unsigned)(ns % 1000));
+	out << text;
+}
+
+} // namespace detail
+
+inline void Enable(bool enabled) { detail::GetRegistry().enabled.store(enabled, std::memory_order_relaxed); }
+
+inline bool IsEnabled() { return detail::GetRegistry().enabled.load(std::memory_order_relaxed); }
+
+// Records one outermost frame in every n per thread, 1 (or 0) records all of them
+inline void SetSampleEvery(uint32_t n) {
+	detail::GetRegistry().sample_every.store(n > 0 ? n : 1, std::memory_order_relaxed);
+}
+
+// Ring size of the threads that record their first zone after the call
+inline void SetBufferCapacity(size_t zones) { detail::GetRegistry().capacity.store(zones, std::memory_order_relaxed); }
+
+// Rings allocated so far, at most the number of threads that recorded at once (per buffer capacity used)
+inline size_t RingCount() {
+	detail::Registry &registry = detail::GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	return registry.rings.size();
+}
+
+// Name of the calling thread in the trace viewer
+inline void SetThreadName(const std::string &name) {
+	const uint32_t thread = detail::LocalRing().thread();
+	detail::Registry &registry = detail::GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.thread_names[thread] = name;
+}
+
+// Drops every zone recorded so far; safe while other threads record
+inline void Clear() { detail::GetRegistry().since_ns.store(detail::NowNs(), std::memory_order_relaxed); }
+
+// Zones of every thread since the last Clear, by start time
+inline std::vector<Event> Collect() {
+	detail::Registry &registry = detail::GetRegistry();
+	std::vector<std::shared_ptr<detail::ThreadRing>> rings;
+	{
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		rings = registry.rings;
+	}
+	std::vector<Event> events;
+	for (const std::shared_ptr<detail::ThreadRing> &ring : rings) {
+		ring->Snapshot(events);
+	}
+	const uint64_t since = registry.since_ns.load(std::memory_order_relaxed);
+	events.erase(std::remove_if(events.begin(), events.end(), [since](const Event &e) { return e.start_ns < since; }),
+	             events.end());
+	std::stable_sort(events.begin(), events.end(),
+	                 [](const Event &a, const Event &b) { return a.start_ns < b.start_ns; });
+	return events;
+}
+
+// Chrome trace event JSON ("X" complete events, timestamps from the first zone), thread names as metadata
+inline void WriteChromeTrace(std::ostream &out) {
+	const std::vector<Event> events = Collect();
+	std::map<uint32_t, std::string> names;
+	{
+		detail::Registry &registry = detail::GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		names = registry.thread_names;
+	}
+	const uint64_t origin = events.empty() ? 0 : events.front().start_ns;
+	out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+	out << "  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, \"args\": {\"name\": \"yolo\"}}";
+	for (const auto &name : names) {
+		out << ",\n  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << name.first
+		    << ", \"args\": {\"name\": ";
+		detail::WriteString(out, name.second.c_str());
+		out << "}}";
+	}
+	for (const Event &event : events) {
+		out << ",\n  {\"name\": ";
+		detail::WriteString(out, event.name);
+		out << ", \"cat\": \"yolo\", \"ph\": \"X\", \"ts\": ";
+		detail::WriteMicroseconds(out, event.start_ns - origin);
+		out << ", \"dur\": ";
+		detail::WriteMicroseconds(out, event.duration_ns);
+		out << ", \"pid\": 1, \"tid\": " << event.thread << "}";
+	}
+	out << "\n]}\n";
+}
+
+inline bool WriteChromeTrace(const std::string &path) {
+	std::ofstream file(path.c_str());
+	if (!file) {
+		return false;
+	}
+	WriteChromeTrace(file);
+	return (bool)file;
+}
+
+// Turns tracing on when YOLO_TRACE names an output file, sampling one frame in YOLO_TRACE_SAMPLE (default 1).
+// Returns the file, empty when tracing stays off.
+inline std::string EnableFromEnvironment() {
+	const char *path = std::getenv("YOLO_TRACE");
+	if (path == nullptr || *path == '\0') {
+		return std::string();
+	}
+	const char *sample = std::getenv("YOLO_TRACE_SAMPLE");
+	SetSampleEvery(sample ? (uint32_t)std::strtoul(sample, nullptr, 10) : 1);
+	Enable(true);
+	return path;
+}
+
+// Records its lifetime as a zone when tracing is on and the current frame is sampled
+class Zone {
+ public:
+	explicit Zone(const char *name) : name_(Recording() ? name : nullptr), start_ns_(name_ ? detail::NowNs() : 0) {}
+
+	~Zone() {
+		if (name_) {
+			detail::LocalRing().Record(name_, start_ns_, detail::NowNs() - start_ns_);
+		}
+	}
+
+	Zone(const Zone &) = delete;
+	Zone &operator=(const Zone &) = delete;
+
+	static bool Recording() {
+		return detail::GetRegistry().enabled.load(std::memory_order_relaxed) && detail::LocalFrame().sampled;
+	}
+
+ private:
+	const char *name_;
+	const uint64_t start_ns_;
+};
+
+// A zone that is also a sampling unit: the outermost frame on a thread decides whether it and its zones are recorded
+class Frame {
+ public:
+	explicit Frame(const char *name) : scope_(), zone_(name) {}
+
+ private:
+	class Scope {
+	 public:
+		Scope() : active_(IsEnabled()) {
+			if (!active_) {
+				return;
+			}
+			detail::FrameState &state = detail::LocalFrame();
+			if (state.depth++ == 0) {
+				const uint32_t every = detail::GetRegistry().sample_every.load(std::memory_order_relaxed);
+				state.sampled = every <= 1 || state.frames % every == 0;
+				state.frames++;
+			}
+		}
+
+		~Scope() {
+			if (active_ && --detail::LocalFrame().depth == 0) {
+				detail::LocalFrame().sampled = true;
+			}
+		}
+
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+
+	 private:
+		const bool active_;
+	};
+
+	Scope scope_;  // Declared first: decides before the zone starts, resets after it ends
+	Zone zone_;
+};
+
+} // namespace trace
+} // namespace yolo
+
+#define YOLO_TRACE_CONCAT_(a, b) a##b
+#define YOLO_TRACE_CONCAT(a, b) YOLO_TRACE_CONCAT_(a, b)
+
+#ifndef YOLO_TRACE_DISABLED
+#define YOLO_TRACE_ZONE(name) ::yolo::trace::Zone YOLO_TRACE_CONCAT(yolo_trace_zone_, __LINE__)(name)
+#define YOLO_TRACE_FRAME(name) ::yolo::trace::Frame YOLO_TRACE_CONCAT(yolo_trace_frame_, __LINE__)(name)
+#else
+#define YOLO_TRACE_ZONE(name) ((void)0)
+#define YOLO_TRACE_FRAME(name) ((void)0)
+#endif
+
+#endif // YOLO_TRACE_H_
@@ -0,0 +1,138 @@
+#ifndef YOLO_WORKER_POOL_H_
+#define YOLO_WORKER_POOL_H_
+
+// Persistent worker threads for the per-image loops of batched inference, shared by the C++ examples.
+//
+// Starting a std::thread per image and per call costs tens of microseconds each, and every new thread starts with
+// empty thread_local scratch (decoder candidates, NMS buffers), so it allocates again on each frame. The pool starts
+// its threads once and parks them on a condition variable between calls. Run hands out the indices of a loop one at a
+// time through an atomic counter; the calling thread takes part, so a pool of N workers runs up to N + 1 items at once
+// and a pool of zero workers runs the loop inline.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace yolo {
+
+class WorkerPool {
+ public:
+	// workers threads besides the caller, started here and joined by the destructor
+	explicit WorkerPool(int workers) {
+		threads_.reserve(workers > 0 ? workers : 0);
+		for (int w = 0; w < workers; w++) {
+			threads_.emplace_back(&WorkerPool::WorkerLoop, this);
+		}
+	}
+
+	~WorkerPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stop_ = true;
+		}
+		wake_.notify_all();
+		for (std::thread &thread : threads_) {
+			thread.join();
+		}
+	}
+
+	WorkerPool(const WorkerPool &) = delete;
+	WorkerPool &operator=(const WorkerPool &) = delete;
+
+	int workers() const { return static_cast<int>(threads_.size()); }
+
+	// Calls item(i) for every i in [0, count) across the workers and the calling thread, and returns when all are
+	// done. The first exception thrown by an item is rethrown here once the others finished. Calls on one pool run
+	// one at a time.
+	void Run(size_t count, const std::function<void(size_t)> &item) {
+		std::lock_guard<std::mutex> run_lock(run_mutex_);
+		if (count == 0) {
+			return;
+		}
+		if (threads_.empty() || count == 1) {
+			for (size_t i = 0; i < count; i++) {
+				item(i);
+			}
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			item_ = &item;
+			count_ = count;
+			next_.store(0, std::memory_order_relaxed);
+			error_ = nullptr;
+			generation_++;
+		}
+		wake_.notify_all();
+		Work();
+
+		// Every index is taken once Work returns; wait for the workers still running theirs, then retire the job so a
+		// worker that wakes late finds nothing to do
+		std::unique_lock<std::mutex> lock(mutex_);
+		idle_.wait(lock, [this] { return active_ == 0; });
+		item_ = nullptr;
+		if (error_) {
+			std::exception_ptr error = error_;
+			error_ = nullptr;
+			std::rethrow_exception(error);
+		}
+	}
+
+ private:
+	void WorkerLoop() {
+		uint64_t seen = 0;
+		std::unique_lock<std::mutex> lock(mutex_);
+		while (true) {
+			wake_.wait(lock, [&] { return stop_ || (generation_ != seen && item_ != nullptr); });
+			if (stop_) {
+				return;
+			}
+			seen = generation_;
+			active_++;
+			lock.unlock();
+			Work();
+			lock.lock();
+			if (--active_ == 0) {
+				idle_.notify_one();
+			}
+		}
+	}
+
+	// Takes indices of the current job until none are left
+	void Work() {
+		for (size_t i = next_.fetch_add(1, std::memory_order_relaxed); i < count_;
+		     i = next_.fetch_add(1, std::memory_order_relaxed)) {
+			try {
+				(*item_)(i);
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(mutex_);
+				if (!error_) {
+					error_ = std::current_exception();
+				}
+			}
+		}
+	}
+
+	std::vector<std::thread> threads_;
+	std::mutex run_mutex_;                             // One Run at a time
+	std::mutex mutex_;                                 // Guards the job fields below and the counters
+	std::condition_variable wake_;                     // Workers wait here for a job or stop
+	std::condition_variable idle_;                     // Run waits here for the workers to finish
+	const std::function<void(size_t)> *item_ = nullptr;  // Current job, written under mutex_ while no worker is active
+	size_t count_ = 0;
+	std::atomic<size_t> next_{0};
+	uint64_t generation_ = 0;
+	int active_ = 0;                                   // Workers inside the current job
+	bool stop_ = false;
+	std::exception_ptr error_;
+};
+
+} // namespace yolo
+
+#endif // YOLO_WORKER_POOL_H_
@@ -0,0 +1,98 @@
+// Wall-clock latency of runInference per stage (blob, forward pass, decode + NMS) and in total, as p50/p90/p99/max
+// and fps over a number of frames after warm-up, for each OpenCV thread count (cv::setNumThreads). Same harness and
+// report as benchmark_stages of the other C++ examples (../YOLOv8-CPP-Common/stage_benchmark.h).
+//
+// Usage: ./benchmark_stages <model.onnx> [image|- [iterations [warmup [threads [report.json|report.csv [cuda]]]]]]
+//        (default a random 1280x720 frame, 200 iterations, 10 warm-up, threads 0 = OpenCV's default, no report
+//        file, CPU)
+// threads is a comma-separated list such as 1,2,4,8. The report is JSON for a .json path and CSV otherwise.
+// With YOLO_TRACE=trace.json in the environment the stage zones of every frame (one in YOLO_TRACE_SAMPLE) are also
+// written there as a Chrome trace (../YOLOv8-CPP-Common/trace.h).
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "dnn_detector.h"
+#include "stage_benchmark.h"
+#include "trace.h"
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <model.onnx> [image|- [iterations [warmup [threads [report.json|report.csv [cuda]]]]]]" << std::endl;
+        return 1;
+    }
+    std::string modelPath = argv[1];
+    std::string imagePath = argc > 2 ? argv[2] : "-";
+    yolo::BenchmarkOptions options;
+    options.iterations = argc > 3 ? std::atoi(argv[3]) : 200;
+    options.warmup = argc > 4 ? std::atoi(argv[4]) : 10;
+    std::vector<int> threads = yolo::ParseThreadList(argc > 5 ? argv[5] : "0");
+    std::string reportPath = argc > 6 ? argv[6] : "";
+    bool runOnGPU = argc > 7 && std::atoi(argv[7]) != 0;
+    std::string tracePath = yolo::trace::EnableFromEnvironment();
+
+    cv::Mat frame;
+    if (imagePath == "-")
+    {
+        frame.create(720, 1280, CV_8UC3);
+        cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(256));
+    }
+    else
+    {
+        frame = cv::imread(imagePath);
+        if (frame.empty())
+        {
+            std::cerr << "cannot read " << imagePath << std::endl;
+            return 1;
+        }
+    }
+    yolo::ImageView view;
+    view.data = frame.data;
+    view.width = frame.cols;
+    view.height = frame.rows;
+    view.stride = frame.step;
+
+    const int defaultThreads = cv::getNumThreads();
+    std::vector<yolo::BenchmarkResult> results;
+    for (int threadCount : threads)
+    {
+        // OpenCV's thread pool is process-wide, it runs both the blob and the CPU forward pass
+        cv::setNumThreads(threadCount > 0 ? threadCount : defaultThreads);
+        std::unique_ptr<DnnDetector> detector = DnnDetector::create(modelPath, cv::Size(640, 640), runOnGPU);
+        yolo::BenchmarkResult result;
+        if (!detector || !yolo::BenchmarkDetector(*detector, view, options, threadCount, result))
+        {
+            std::cerr << "cannot run " << modelPath << " with " << threadCount << " threads" << std::endl;
+            return 1;
+        }
+        results.push_back(result);
+    }
+
+    std::cout << modelPath << ", " << frame.cols << "x" << frame.rows << ", " << options.warmup << " warm-up\n";
+    yolo::PrintResults(std::cout, results);
+    if (!reportPath.empty())
+    {
+        yolo::BenchmarkInfo info;
+        info.model = modelPath;
+        info.frame_width = frame.cols;
+        info.frame_height = frame.rows;
+        info.warmup = options.warmup;
+        if (!yolo::WriteResults(reportPath, info, results))
+        {
+            std::cerr << "cannot write " << reportPath << std::endl;
+            return 1;
+        }
+    }
+    if (!tracePath.empty() && !yolo::trace::WriteChromeTrace(tracePath))
+    {
+        std::cerr << "cannot write " << tracePath << std::endl;
+        return 1;
+    }
+    return 0;
+}
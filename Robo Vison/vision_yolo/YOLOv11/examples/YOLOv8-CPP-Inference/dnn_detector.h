@@ -0,0 +1,78 @@
+#ifndef DNN_DETECTOR_H
+#define DNN_DETECTOR_H
+
+// yolo::IDetector (../YOLOv8-CPP-Common/detector.h) over Inference, for the backend probe and applications that
+// swap engines
+
+// Cpp native
+#include <memory>
+#include <string>
+#include <vector>
+
+// OpenCV
+#include <opencv2/core/cuda.hpp>
+
+#include "detector.h"
+#include "inference.h"
+
+class DnnDetector : public yolo::IDetector
+{
+public:
+    // nullptr when the model doesn't load, or for runWithCuda without a CUDA device (OpenCV would fall back to the
+    // CPU and the probe would time the wrong target)
+    static std::unique_ptr<DnnDetector> create(const std::string &onnxModelPath, const cv::Size &modelInputShape = {640, 640}, const bool &runWithCuda = true)
+    {
+        if (runWithCuda && cv::cuda::getCudaEnabledDeviceCount() == 0)
+            return nullptr;
+        try
+        {
+            return std::unique_ptr<DnnDetector>(new DnnDetector(onnxModelPath, modelInputShape, runWithCuda));
+        }
+        catch (const cv::Exception &)
+        {
+            return nullptr;
+        }
+    }
+
+    const char *Name() const override { return name.c_str(); }
+
+    bool Detect(const yolo::ImageView &frame, yolo::DetectionResults &results, yolo::StageTimes *times = nullptr) override
+    {
+        results.clear();
+        // The frame as a Mat header, runInference only reads it
+        const cv::Mat image(frame.height, frame.width, CV_8UC3, const_cast<uint8_t *>(frame.data), frame.stride);
+        std::vector<Detection> detections;
+        try
+        {
+            detections = inference.runInference(image, times);
+        }
+        catch (const cv::Exception &)
+        {
+            return false;
+        }
+        for (const Detection &detection : detections)
+        {
+            yolo::DetectedObject object;
+            object.x = (float)detection.box.x;
+            object.y = (float)detection.box.y;
+            object.width = (float)detection.box.width;
+            object.height = (float)detection.box.height;
+            object.score = detection.confidence;
+            object.class_id = detection.class_id;
+            if (!results.push_back(object))
+                break;
+        }
+        return true;
+    }
+
+private:
+    DnnDetector(const std::string &onnxModelPath, const cv::Size &modelInputShape, bool runWithCuda)
+        : inference(onnxModelPath, modelInputShape, "", runWithCuda), name(runWithCuda ? "opencv-dnn-cuda" : "opencv-dnn-cpu")
+    {
+    }
+
+    Inference inference;
+    std::string name;
+};
+
+#endif // DNN_DETECTOR_H
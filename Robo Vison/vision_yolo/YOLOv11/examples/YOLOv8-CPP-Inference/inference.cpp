@@ -11,18 +11,31 @@ Inference::Inference(const std::string &onnxModelPath, const cv::Size &modelInpu
     // loadClassesFromFile(); The classes are hard-coded for this example
 }
 
-std::vector<Detection> Inference::runInference(const cv::Mat &input)
+std::vector<Detection> Inference::runInference(const cv::Mat &input, yolo::StageTimes *times)
 {
+    YOLO_TRACE_FRAME("runInference");
+    yolo::StageClock stageClock;
+    yolo::StageTimes stageTimes;
     cv::Mat modelInput = input;
-    if (letterBoxForSquare && modelShape.width == modelShape.height)
-        modelInput = formatToSquare(modelInput);
-
     cv::Mat blob;
-    cv::dnn::blobFromImage(modelInput, blob, 1.0/255.0, modelShape, cv::Scalar(), true, false);
-    net.setInput(blob);
+    {
+        YOLO_TRACE_ZONE("PreProcess");
+        if (letterBoxForSquare && modelShape.width == modelShape.height)
+            modelInput = formatToSquare(modelInput);
+    }
+    {
+        YOLO_TRACE_ZONE("BlobFromImage");
+        cv::dnn::blobFromImage(modelInput, blob, 1.0/255.0, modelShape, cv::Scalar(), true, false);
+        net.setInput(blob);
+    }
+    stageTimes.preprocess_ms = stageClock.Lap();
 
     std::vector<cv::Mat> outputs;
-    net.forward(outputs, net.getUnconnectedOutLayersNames());
+    {
+        YOLO_TRACE_ZONE("net.forward");
+        net.forward(outputs, net.getUnconnectedOutLayersNames());
+    }
+    stageTimes.inference_ms = stageClock.Lap();
 
     int rows = outputs[0].size[1];
     int dimensions = outputs[0].size[2];
@@ -35,9 +48,6 @@ std::vector<Detection> Inference::runInference(const cv::Mat &input)
         yolov8 = true;
         rows = outputs[0].size[2];
         dimensions = outputs[0].size[1];
-
-        outputs[0] = outputs[0].reshape(1, dimensions);
-        cv::transpose(outputs[0], outputs[0]);
     }
     float *data = (float *)outputs[0].data;
 
@@ -48,38 +58,33 @@ std::vector<Detection> Inference::runInference(const cv::Mat &input)
     std::vector<float> confidences;
     std::vector<cv::Rect> boxes;
 
-    for (int i = 0; i < rows; ++i)
+    if (yolov8)
     {
-        if (yolov8)
+        // Decoded in the channel-major layout the model outputs, no transpose; only anchors above the threshold
+        // are read further
+        yolo::DecodeHead(data, rows, 4, (int)classes.size(), modelScoreThreshold, headCandidates);
+        for (size_t i = 0; i < headCandidates.count; ++i)
         {
-            float *classes_scores = data+4;
-
-            cv::Mat scores(1, classes.size(), CV_32FC1, classes_scores);
-            cv::Point class_id;
-            double maxClassScore;
+            confidences.push_back(headCandidates.score[i]);
+            class_ids.push_back(headCandidates.class_id[i]);
 
-            minMaxLoc(scores, 0, &maxClassScore, 0, &class_id);
+            float x = headCandidates.box[4 * i];
+            float y = headCandidates.box[4 * i + 1];
+            float w = headCandidates.box[4 * i + 2];
+            float h = headCandidates.box[4 * i + 3];
 
-            if (maxClassScore > modelScoreThreshold)
-            {
-                confidences.push_back(maxClassScore);
-                class_ids.push_back(class_id.x);
-
-                float x = data[0];
-                float y = data[1];
-                float w = data[2];
-                float h = data[3];
-
-                int left = int((x - 0.5 * w) * x_factor);
-                int top = int((y - 0.5 * h) * y_factor);
+            int left = int((x - 0.5 * w) * x_factor);
+            int top = int((y - 0.5 * h) * y_factor);
 
-                int width = int(w * x_factor);
-                int height = int(h * y_factor);
+            int width = int(w * x_factor);
+            int height = int(h * y_factor);
 
-                boxes.push_back(cv::Rect(left, top, width, height));
-            }
+            boxes.push_back(cv::Rect(left, top, width, height));
         }
-        else // yolov5
+    }
+    else // yolov5
+    {
+        for (int i = 0; i < rows; ++i)
         {
             float confidence = data[4];
 
@@ -112,13 +117,19 @@ std::vector<Detection> Inference::runInference(const cv::Mat &input)
                     boxes.push_back(cv::Rect(left, top, width, height));
                 }
             }
-        }
 
-        data += dimensions;
+            data += dimensions;
+        }
     }
 
+    yolo::NmsOptions nmsOptions;
+    nmsOptions.iou_threshold = modelNMSThreshold;
+    nmsOptions.score_threshold = modelScoreThreshold;
+    nmsOptions.agnostic = agnosticNMS;
+    nmsOptions.max_det = maxDetections;
+
     std::vector<int> nms_result;
-    cv::dnn::NMSBoxes(boxes, confidences, modelScoreThreshold, modelNMSThreshold, nms_result);
+    nms.RunRects(boxes, confidences, class_ids, nmsOptions, nms_result);
 
     std::vector<Detection> detections{};
     for (unsigned long i = 0; i < nms_result.size(); ++i)
@@ -142,6 +153,9 @@ std::vector<Detection> Inference::runInference(const cv::Mat &input)
         detections.push_back(result);
     }
 
+    stageTimes.postprocess_ms = stageClock.Lap();
+    if (times)
+        *times = stageTimes;
     return detections;
 }
 
@@ -12,6 +12,12 @@
 #include <opencv2/opencv.hpp>
 #include <opencv2/dnn.hpp>
 
+// Shared decoder, NMS, stage timing and tracing (../YOLOv8-CPP-Common)
+#include "head_decoder.h"
+#include "nms.h"
+#include "stage_times.h"
+#include "trace.h"
+
 struct Detection
 {
     int class_id{0};
@@ -25,7 +31,8 @@ class Inference
 {
 public:
     Inference(const std::string &onnxModelPath, const cv::Size &modelInputShape = {640, 640}, const std::string &classesTxtFile = "", const bool &runWithCuda = true);
-    std::vector<Detection> runInference(const cv::Mat &input);
+    // times, if given, gets the wall-clock time of the blob, the forward pass and the decode + NMS
+    std::vector<Detection> runInference(const cv::Mat &input, yolo::StageTimes *times = nullptr);
 
 private:
     void loadClassesFromFile();
@@ -43,10 +50,15 @@ private:
     float modelConfidenceThreshold {0.25};
     float modelScoreThreshold      {0.45};
     float modelNMSThreshold        {0.50};
+    bool  agnosticNMS              {true};  // suppress across classes
+    int   maxDetections            {300};
 
     bool letterBoxForSquare = true;
 
     cv::dnn::Net net;
+
+    yolo::HeadCandidates headCandidates; // reused between frames
+    yolo::NonMaxSuppression nms;
 };
 
 #endif // INFERENCE_H
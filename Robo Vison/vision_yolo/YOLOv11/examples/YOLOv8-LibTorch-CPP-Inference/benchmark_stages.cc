@@ -0,0 +1,93 @@
+// Wall-clock latency of run_detection per stage (letterbox and upload, forward pass back to the CPU, NMS) and in
+// total, as p50/p90/p99/max and fps over a number of frames after warm-up, for each intra-op thread count
+// (torch::set_num_threads). Same harness and report as benchmark_stages of the other C++ examples
+// (../YOLOv8-CPP-Common/stage_benchmark.h).
+//
+// Usage: ./yolov8_libtorch_benchmark <model.torchscript> [image|- [iterations [warmup [threads [report.json|report.csv [cuda]]]]]]
+//        (default a random 1280x720 frame, 200 iterations, 10 warm-up, threads 0 = LibTorch's default, no report
+//        file, CPU)
+// threads is a comma-separated list such as 1,2,4,8. The report is JSON for a .json path and CSV otherwise.
+// With YOLO_TRACE=trace.json in the environment the stage zones of every frame (one in YOLO_TRACE_SAMPLE) are also
+// written there as a Chrome trace (../YOLOv8-CPP-Common/trace.h).
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "libtorch_detector.h"
+#include "stage_benchmark.h"
+#include "trace.h"
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <model.torchscript> [image|- [iterations [warmup [threads [report.json|report.csv [cuda]]]]]]" << std::endl;
+        return 1;
+    }
+    std::string model_path = argv[1];
+    std::string image_path = argc > 2 ? argv[2] : "-";
+    yolo::BenchmarkOptions options;
+    options.iterations = argc > 3 ? std::atoi(argv[3]) : 200;
+    options.warmup = argc > 4 ? std::atoi(argv[4]) : 10;
+    std::vector<int> threads = yolo::ParseThreadList(argc > 5 ? argv[5] : "0");
+    std::string report_path = argc > 6 ? argv[6] : "";
+    torch::Device device(argc > 7 && std::atoi(argv[7]) != 0 ? torch::kCUDA : torch::kCPU);
+    std::string trace_path = yolo::trace::EnableFromEnvironment();
+
+    cv::Mat frame;
+    if (image_path == "-") {
+        frame.create(720, 1280, CV_8UC3);
+        cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(256));
+    } else {
+        frame = cv::imread(image_path);
+        if (frame.empty()) {
+            std::cerr << "cannot read " << image_path << std::endl;
+            return 1;
+        }
+    }
+    yolo::ImageView view;
+    view.data = frame.data;
+    view.width = frame.cols;
+    view.height = frame.rows;
+    view.stride = frame.step;
+
+    std::unique_ptr<LibTorchDetector> detector = LibTorchDetector::create(model_path, device);
+    if (!detector) {
+        std::cerr << "cannot load " << model_path << " on " << device << std::endl;
+        return 1;
+    }
+    const int default_threads = torch::get_num_threads();
+    std::vector<yolo::BenchmarkResult> results;
+    for (int thread_count : threads) {
+        // LibTorch's intra-op pool is process-wide, so one module serves every thread count
+        torch::set_num_threads(thread_count > 0 ? thread_count : default_threads);
+        yolo::BenchmarkResult result;
+        if (!yolo::BenchmarkDetector(*detector, view, options, thread_count, result)) {
+            std::cerr << "cannot run " << model_path << " with " << thread_count << " threads" << std::endl;
+            return 1;
+        }
+        results.push_back(result);
+    }
+
+    std::cout << model_path << ", " << frame.cols << "x" << frame.rows << ", " << options.warmup << " warm-up\n";
+    yolo::PrintResults(std::cout, results);
+    if (!report_path.empty()) {
+        yolo::BenchmarkInfo info;
+        info.model = model_path;
+        info.frame_width = frame.cols;
+        info.frame_height = frame.rows;
+        info.warmup = options.warmup;
+        if (!yolo::WriteResults(report_path, info, results)) {
+            std::cerr << "cannot write " << report_path << std::endl;
+            return 1;
+        }
+    }
+    if (!trace_path.empty() && !yolo::trace::WriteChromeTrace(trace_path)) {
+        std::cerr << "cannot write " << trace_path << std::endl;
+        return 1;
+    }
+    return 0;
+}
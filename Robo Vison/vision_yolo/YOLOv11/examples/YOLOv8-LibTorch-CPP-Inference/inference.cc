@@ -0,0 +1,239 @@
+#include "inference.h"
+
+#include <filesystem>
+#include <iostream>
+
+#include <opencv2/imgproc.hpp>
+#include <torch/version.h>
+
+#include "model_cache.h"
+#include "nms.h"
+
+using torch::indexing::Slice;
+using torch::indexing::None;
+
+
+float generate_scale(cv::Mat& image, const std::vector<int>& target_size) {
+    int origin_w = image.cols;
+    int origin_h = image.rows;
+
+    int target_h = target_size[0];
+    int target_w = target_size[1];
+
+    float ratio_h = static_cast<float>(target_h) / static_cast<float>(origin_h);
+    float ratio_w = static_cast<float>(target_w) / static_cast<float>(origin_w);
+    float resize_scale = std::min(ratio_h, ratio_w);
+    return resize_scale;
+}
+
+
+float letterbox(cv::Mat &input_image, cv::Mat &output_image, const std::vector<int> &target_size) {
+    if (input_image.cols == target_size[1] && input_image.rows == target_size[0]) {
+        if (input_image.data == output_image.data) {
+            return 1.;
+        } else {
+            output_image = input_image.clone();
+            return 1.;
+        }
+    }
+
+    float resize_scale = generate_scale(input_image, target_size);
+    int new_shape_w = std::round(input_image.cols * resize_scale);
+    int new_shape_h = std::round(input_image.rows * resize_scale);
+    float padw = (target_size[1] - new_shape_w) / 2.;
+    float padh = (target_size[0] - new_shape_h) / 2.;
+
+    int top = std::round(padh - 0.1);
+    int bottom = std::round(padh + 0.1);
+    int left = std::round(padw - 0.1);
+    int right = std::round(padw + 0.1);
+
+    cv::resize(input_image, output_image,
+               cv::Size(new_shape_w, new_shape_h),
+               0, 0, cv::INTER_AREA);
+
+    cv::copyMakeBorder(output_image, output_image, top, bottom, left, right,
+                       cv::BORDER_CONSTANT, cv::Scalar(114.));
+    return resize_scale;
+}
+
+
+torch::Tensor xyxy2xywh(const torch::Tensor& x) {
+    auto y = torch::empty_like(x);
+    y.index_put_({"...", 0}, (x.index({"...", 0}) + x.index({"...", 2})).div(2));
+    y.index_put_({"...", 1}, (x.index({"...", 1}) + x.index({"...", 3})).div(2));
+    y.index_put_({"...", 2}, x.index({"...", 2}) - x.index({"...", 0}));
+    y.index_put_({"...", 3}, x.index({"...", 3}) - x.index({"...", 1}));
+    return y;
+}
+
+
+torch::Tensor xywh2xyxy(const torch::Tensor& x) {
+    auto y = torch::empty_like(x);
+    auto dw = x.index({"...", 2}).div(2);
+    auto dh = x.index({"...", 3}).div(2);
+    y.index_put_({"...", 0}, x.index({"...", 0}) - dw);
+    y.index_put_({"...", 1}, x.index({"...", 1}) - dh);
+    y.index_put_({"...", 2}, x.index({"...", 0}) + dw);
+    y.index_put_({"...", 3}, x.index({"...", 1}) + dh);
+    return y;
+}
+
+
+torch::Tensor non_max_suppression(torch::Tensor& prediction, float conf_thres, float iou_thres, int max_det) {
+    auto bs = prediction.size(0);
+    auto nc = prediction.size(1) - 4;
+    auto nm = prediction.size(1) - nc - 4;
+    auto mi = 4 + nc;
+    auto xc = prediction.index({Slice(), Slice(4, mi)}).amax(1) > conf_thres;
+
+    prediction = prediction.transpose(-1, -2);
+    prediction.index_put_({"...", Slice({None, 4})}, xywh2xyxy(prediction.index({"...", Slice(None, 4)})));
+
+    std::vector<torch::Tensor> output;
+    for (int i = 0; i < bs; i++) {
+        output.push_back(torch::zeros({0, 6 + nm}, prediction.device()));
+    }
+
+    // Candidates of every image first, then one batched NMS (../YOLOv8-CPP-Common/nms.h). Classes are kept
+    // apart by id instead of offsetting the boxes, and suppression stops after max_det kept boxes.
+    std::vector<torch::Tensor> candidates(bs), boxes(bs), scores(bs), classes(bs);
+    std::vector<yolo::NmsInput> inputs(bs);
+    for (int xi = 0; xi < bs; xi++) {
+        auto x = prediction[xi];
+        x = x.index({xc[xi]});
+        auto x_split = x.split({4, nc, nm}, 1);
+        auto box = x_split[0], cls = x_split[1], mask = x_split[2];
+        auto [conf, j] = cls.max(1, true);
+        x = torch::cat({box, conf, j.toType(torch::kFloat), mask}, 1);
+        candidates[xi] = x.index({conf.view(-1) > conf_thres});
+        boxes[xi] = candidates[xi].index({Slice(), Slice(None, 4)}).contiguous();
+        scores[xi] = candidates[xi].index({Slice(), 4}).contiguous();
+        classes[xi] = candidates[xi].index({Slice(), 5}).toType(torch::kInt).contiguous();
+        inputs[xi].boxes = boxes[xi].data_ptr<float>();
+        inputs[xi].scores = scores[xi].data_ptr<float>();
+        inputs[xi].class_ids = classes[xi].data_ptr<int>();
+        inputs[xi].count = candidates[xi].size(0);
+    }
+
+    // NMS
+    thread_local yolo::NonMaxSuppression nms;
+    yolo::NmsOptions options;
+    options.iou_threshold = iou_thres;
+    options.max_det = max_det;
+    std::vector<std::vector<int>> keep;
+    nms.RunBatch(inputs.data(), inputs.size(), options, keep);
+
+    for (int xi = 0; xi < bs; xi++) {
+        auto i = torch::from_blob(keep[xi].data(), {static_cast<int64_t>(keep[xi].size())}, torch::kInt).toType(torch::kLong);
+        output[xi] = candidates[xi].index({i});
+    }
+
+    return torch::stack(output);
+}
+
+
+torch::Tensor clip_boxes(torch::Tensor& boxes, const std::vector<int>& shape) {
+    boxes.index_put_({"...", 0}, boxes.index({"...", 0}).clamp(0, shape[1]));
+    boxes.index_put_({"...", 1}, boxes.index({"...", 1}).clamp(0, shape[0]));
+    boxes.index_put_({"...", 2}, boxes.index({"...", 2}).clamp(0, shape[1]));
+    boxes.index_put_({"...", 3}, boxes.index({"...", 3}).clamp(0, shape[0]));
+    return boxes;
+}
+
+
+torch::Tensor scale_boxes(const std::vector<int>& img1_shape, torch::Tensor& boxes, const std::vector<int>& img0_shape) {
+    auto gain = (std::min)((float)img1_shape[0] / img0_shape[0], (float)img1_shape[1] / img0_shape[1]);
+    auto pad0 = std::round((float)(img1_shape[1] - img0_shape[1] * gain) / 2. - 0.1);
+    auto pad1 = std::round((float)(img1_shape[0] - img0_shape[0] * gain) / 2. - 0.1);
+
+    boxes.index_put_({"...", 0}, boxes.index({"...", 0}) - pad0);
+    boxes.index_put_({"...", 2}, boxes.index({"...", 2}) - pad0);
+    boxes.index_put_({"...", 1}, boxes.index({"...", 1}) - pad1);
+    boxes.index_put_({"...", 3}, boxes.index({"...", 3}) - pad1);
+    boxes.index_put_({"...", Slice(None, 4)}, boxes.index({"...", Slice(None, 4)}).div(gain));
+    return boxes;
+}
+
+
+torch::jit::script::Module load_model(const std::string& model_path, const torch::Device& device, const std::string& cache_dir) {
+    std::filesystem::path cache_path;
+    if (!cache_dir.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(cache_dir, error);
+        cache_path = yolo::CachedModelPath(model_path, cache_dir, std::string(TORCH_VERSION) + "|" + device.str(), ".torchscript");
+    }
+    if (!cache_path.empty() && std::filesystem::exists(cache_path)) {
+        try {
+            torch::jit::script::Module frozen = torch::jit::load(cache_path.string(), device);
+            frozen.eval();
+            return frozen;
+        } catch (const c10::Error& e) {
+            std::cout << "Model cache " << cache_path << " unusable, rebuilding: " << e.msg() << std::endl;
+            std::filesystem::remove(cache_path);
+        }
+    }
+
+    torch::jit::script::Module yolo_model = torch::jit::load(model_path, device);
+    yolo_model.eval();
+    yolo_model.to(device, torch::kFloat32);
+    torch::jit::script::Module frozen = torch::jit::freeze(yolo_model);
+    if (!cache_path.empty()) {
+        // Written under a pending name and renamed once complete, a reboot while saving leaves no partial entry.
+        // A failed save (disk full, read-only file system) only costs the cache, the model itself is fine.
+        const std::filesystem::path pending_path = yolo::PendingCachePath(cache_path);
+        try {
+            frozen.save(pending_path.string());
+            yolo::CommitCacheFile(pending_path, cache_path);
+        } catch (const std::exception& e) {
+            std::cout << "Could not write the model cache " << cache_path << ": " << e.what() << std::endl;
+            std::error_code error;
+            std::filesystem::remove(pending_path, error);
+        }
+    }
+    return frozen;
+}
+
+
+torch::Tensor run_detection(torch::jit::script::Module& model, cv::Mat& image, const torch::Device& device,
+                            const std::vector<int>& input_size, float conf_thres, float iou_thres, yolo::StageTimes* times) {
+    YOLO_TRACE_FRAME("run_detection");
+    torch::NoGradGuard no_grad;
+    yolo::StageClock stage_clock;
+    yolo::StageTimes stage_times;
+    cv::Mat input_image;
+    std::vector<torch::jit::IValue> inputs;
+    {
+        YOLO_TRACE_ZONE("PreProcess");
+        letterbox(image, input_image, input_size);
+    }
+    {
+        YOLO_TRACE_ZONE("BlobFromImage");
+        torch::Tensor image_tensor = torch::from_blob(input_image.data, {input_image.rows, input_image.cols, 3}, torch::kByte).to(device);
+        image_tensor = image_tensor.toType(torch::kFloat32).div(255);
+        image_tensor = image_tensor.permute({2, 0, 1});
+        image_tensor = image_tensor.unsqueeze(0);
+        inputs.push_back(image_tensor);
+    }
+    stage_times.preprocess_ms = stage_clock.Lap();
+
+    torch::Tensor output;
+    {
+        YOLO_TRACE_ZONE("forward");
+        output = model.forward(inputs).toTensor().cpu();
+    }
+    stage_times.inference_ms = stage_clock.Lap();
+
+    torch::Tensor keep;
+    {
+        YOLO_TRACE_ZONE("PostProcess");  // non_max_suppression records its own "NMS" zone inside
+        keep = non_max_suppression(output, conf_thres, iou_thres)[0];
+        auto boxes = keep.index({Slice(), Slice(None, 4)});
+        keep.index_put_({Slice(), Slice(None, 4)}, scale_boxes({input_image.rows, input_image.cols}, boxes, {image.rows, image.cols}));
+    }
+    stage_times.postprocess_ms = stage_clock.Lap();
+    if (times) {
+        *times = stage_times;
+    }
+    return keep;
+}
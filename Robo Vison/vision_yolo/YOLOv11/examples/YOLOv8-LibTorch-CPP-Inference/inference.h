@@ -0,0 +1,43 @@
+#ifndef YOLOV8_LIBTORCH_INFERENCE_H
+#define YOLOV8_LIBTORCH_INFERENCE_H
+
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <torch/torch.h>
+#include <torch/script.h>
+
+#include "stage_times.h"
+#include "trace.h"
+
+
+float generate_scale(cv::Mat& image, const std::vector<int>& target_size);
+
+// Resizes keeping the aspect ratio and pads with 114 to target_size (height, width), returns the resize scale
+float letterbox(cv::Mat &input_image, cv::Mat &output_image, const std::vector<int> &target_size);
+
+torch::Tensor xyxy2xywh(const torch::Tensor& x);
+
+torch::Tensor xywh2xyxy(const torch::Tensor& x);
+
+// Per image the kept boxes as rows of x1, y1, x2, y2, conf, class (then mask coefficients), best first
+torch::Tensor non_max_suppression(torch::Tensor& prediction, float conf_thres = 0.25, float iou_thres = 0.45, int max_det = 300);
+
+torch::Tensor clip_boxes(torch::Tensor& boxes, const std::vector<int>& shape);
+
+torch::Tensor scale_boxes(const std::vector<int>& img1_shape, torch::Tensor& boxes, const std::vector<int>& img0_shape);
+
+// Loads the TorchScript model in eval mode and frozen: parameters become constants and conv + batch norm are folded.
+// With a cache_dir the frozen module is saved there on the first start and loaded as it is on later ones, so
+// restarts skip freezing. Entries are keyed by the model file, the LibTorch version and the device.
+torch::jit::script::Module load_model(const std::string& model_path, const torch::Device& device, const std::string& cache_dir);
+
+// Letterbox, inference without autograd and NMS of one BGR image: rows of x1, y1, x2, y2, conf, class in image
+// pixels, on the CPU. times, if given, gets the wall-clock time of the three; inference ends once the output is
+// copied back to the CPU, which waits for the CUDA kernels.
+torch::Tensor run_detection(torch::jit::script::Module& model, cv::Mat& image, const torch::Device& device,
+                            const std::vector<int>& input_size = {640, 640}, float conf_thres = 0.25, float iou_thres = 0.45,
+                            yolo::StageTimes* times = nullptr);
+
+#endif // YOLOV8_LIBTORCH_INFERENCE_H
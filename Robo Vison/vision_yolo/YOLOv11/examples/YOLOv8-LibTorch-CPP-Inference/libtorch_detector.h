@@ -0,0 +1,68 @@
+#ifndef YOLOV8_LIBTORCH_DETECTOR_H
+#define YOLOV8_LIBTORCH_DETECTOR_H
+
+// yolo::IDetector (../YOLOv8-CPP-Common/detector.h) over load_model and run_detection, for the backend probe and
+// applications that swap engines
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "detector.h"
+#include "inference.h"
+
+
+class LibTorchDetector : public yolo::IDetector {
+public:
+    // nullptr when the model doesn't load, or for CUDA without a CUDA device
+    static std::unique_ptr<LibTorchDetector> create(const std::string& model_path, const torch::Device& device,
+                                                    const std::string& cache_dir = std::string()) {
+        if (device.is_cuda() && !torch::cuda::is_available()) {
+            return nullptr;
+        }
+        try {
+            return std::unique_ptr<LibTorchDetector>(new LibTorchDetector(load_model(model_path, device, cache_dir), device));
+        } catch (const c10::Error&) {
+            return nullptr;
+        }
+    }
+
+    const char* Name() const override { return name_.c_str(); }
+
+    bool Detect(const yolo::ImageView& frame, yolo::DetectionResults& results, yolo::StageTimes* times = nullptr) override {
+        results.clear();
+        // The frame as a Mat header, run_detection only reads it
+        cv::Mat image(frame.height, frame.width, CV_8UC3, const_cast<uint8_t*>(frame.data), frame.stride);
+        torch::Tensor keep;
+        try {
+            keep = run_detection(model_, image, device_, {640, 640}, 0.25, 0.45, times).contiguous();
+        } catch (const c10::Error&) {
+            return false;
+        }
+        const float* rows = keep.data_ptr<float>();
+        for (int64_t i = 0; i < keep.size(0); i++) {
+            const float* row = rows + i * keep.size(1);
+            yolo::DetectedObject object;
+            object.x = row[0];
+            object.y = row[1];
+            object.width = row[2] - row[0];
+            object.height = row[3] - row[1];
+            object.score = row[4];
+            object.class_id = static_cast<int>(row[5]);
+            if (!results.push_back(object)) {
+                break;
+            }
+        }
+        return true;
+    }
+
+private:
+    LibTorchDetector(torch::jit::script::Module model, const torch::Device& device)
+        : model_(std::move(model)), device_(device), name_(device.is_cuda() ? "libtorch-cuda" : "libtorch-cpu") {}
+
+    torch::jit::script::Module model_;
+    torch::Device device_;
+    std::string name_;
+};
+
+#endif // YOLOV8_LIBTORCH_DETECTOR_H
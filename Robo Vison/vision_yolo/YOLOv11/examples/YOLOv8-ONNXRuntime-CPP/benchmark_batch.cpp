@@ -0,0 +1,78 @@
+// Batch throughput benchmark for YOLO_V8::RunSessionBatch on CPU.
+//
+// Usage: ./BatchBenchmark [model.onnx [iterations [intra_op_threads]]]   (default yolov8n.onnx 20 1)
+// The model must be exported with a dynamic batch axis, otherwise batches run in chunks of the fixed batch size:
+//   yolo export model=yolov8n.pt format=onnx opset=12 simplify=True dynamic=True imgsz=640
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "inference.h"
+
+
+int main(int argc, char** argv)
+{
+    std::string modelPath = argc > 1 ? argv[1] : "yolov8n.onnx";
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 20;
+    int intraOpThreads = argc > 3 ? std::atoi(argv[3]) : 1;
+
+    YOLO_V8 detector;
+    DL_INIT_PARAM params;
+    params.modelPath = modelPath;
+    params.modelType = YOLO_DETECT_V8;
+    params.imgSize = { 640, 640 };
+    params.rectConfidenceThreshold = 0.25;
+    params.iouThreshold = 0.5;
+    params.cudaEnable = false;
+    params.intraOpNumThreads = intraOpThreads;
+    if (detector.CreateSession(params) != RET_OK)
+    {
+        return 1;
+    }
+
+    // Frames from different cameras: different sizes, so every batch slot has its own letterbox scale
+    const cv::Size cameraSizes[] = { { 1920, 1080 }, { 1280, 720 }, { 1280, 1024 }, { 640, 480 } };
+    std::vector<cv::Mat> cameras;
+    for (const cv::Size& size : cameraSizes)
+    {
+        cv::Mat frame(size, CV_8UC3);
+        cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(256));
+        cameras.push_back(frame);
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << modelPath << ", " << iterations << " iterations, " << intraOpThreads << " intra-op thread(s)\n";
+    double baseline = 0;
+    for (int batch : { 1, 2, 4, 8 })
+    {
+        std::vector<cv::Mat> frames;
+        for (int i = 0; i < batch; i++)
+        {
+            frames.push_back(cameras[i % cameras.size()]);
+        }
+        std::vector<std::vector<DL_RESULT>> results;
+        detector.RunSessionBatch(frames, results);//warm-up for this batch shape
+
+        std::vector<double> samples;
+        for (int i = 0; i < iterations; i++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            detector.RunSessionBatch(frames, results);
+            samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        std::sort(samples.begin(), samples.end());
+        double median = samples[samples.size() / 2];
+        double imagesPerSecond = batch * 1000.0 / median;
+        if (batch == 1)
+        {
+            baseline = imagesPerSecond;
+        }
+        std::cout << "batch " << batch << ": " << std::setw(9) << median << " ms/batch  " << std::setw(7)
+                  << imagesPerSecond << " img/s  " << imagesPerSecond / baseline << "x\n";
+    }
+    return 0;
+}
@@ -0,0 +1,145 @@
+// Memory and throughput of multi-camera deployments, one thread per camera:
+//   independent   one YOLO_V8 per camera, each with its own session, weights and intra-op thread
+//   pool/session  YOLO_SESSION_POOL, one session per camera (exclusive leases) on the global thread pool, prepacked
+//                 weights shared between the sessions
+//   pool/shared   YOLO_SESSION_POOL, every camera leasing the same re-entrant YOLO_V8
+//
+// Usage: ./CameraPoolBenchmark [model.onnx [seconds [cameras...]]]   (default yolov8n.onnx 3, cameras 1 4 8)
+// Each camera loops over a random 1280x720 frame for the given time. Independent sessions get one intra-op thread
+// each and the pool a global pool of one thread per camera, so every setup has the same thread budget. Prints total
+// frames/s and the resident memory the detectors added (Linux, from /proc/self/status), after one frame per camera
+// so the run contexts and the arena are included.
+// Every setup is torn down before the next, so the pool creates the process's only Env, the global thread pools
+// come with it. Freed memory the allocator keeps can make a later setup look smaller, compare runs of one setup.
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "inference.h"
+
+
+static double ResidentMiB()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmRSS:") == 0)
+        {
+            return std::atof(line.c_str() + 6) / 1024.0;
+        }
+    }
+    return 0.0;
+}
+
+
+// Frames per second of one thread per camera, camera c running on detectors[c]
+static double Throughput(std::vector<std::shared_ptr<YOLO_V8>>& detectors, const cv::Mat& frame, double seconds)
+{
+    std::atomic<bool> stop{ false };
+    std::atomic<long> frames{ 0 };
+    std::vector<std::thread> threads;
+    for (std::shared_ptr<YOLO_V8>& detector : detectors)
+    {
+        threads.emplace_back([&, detector] {
+            std::vector<DL_RESULT> results;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                results.clear();
+                detector->RunSession(frame, results);
+                frames++;
+            }
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    return frames / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+int main(int argc, char** argv)
+{
+    std::string modelPath = argc > 1 ? argv[1] : "yolov8n.onnx";
+    double seconds = argc > 2 ? std::atof(argv[2]) : 3.0;
+    std::vector<int> cameraCounts;
+    for (int i = 3; i < argc; i++)
+    {
+        cameraCounts.push_back(std::atoi(argv[i]));
+    }
+    if (cameraCounts.empty())
+    {
+        cameraCounts = { 1, 4, 8 };
+    }
+
+    DL_INIT_PARAM params;
+    params.modelPath = modelPath;
+    params.modelType = YOLO_DETECT_V8;
+    params.imgSize = { 640, 640 };
+    params.rectConfidenceThreshold = 0.25;
+    params.iouThreshold = 0.5;
+    params.cudaEnable = false;
+    params.intraOpNumThreads = 1;
+    cv::Mat frame(720, 1280, CV_8UC3);
+    cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(256));
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << modelPath << ", " << seconds << " s per run, one thread per camera\n";
+    std::cout << "  cameras   independent fps    MiB   pool/session fps    MiB   pool/shared fps    MiB\n";
+    for (int cameras : cameraCounts)
+    {
+        double fps[3], mib[3];
+        for (int mode = 0; mode < 3; mode++)
+        {
+            double before = ResidentMiB();
+            {
+                std::unique_ptr<YOLO_SESSION_POOL> pool;
+                if (mode > 0)
+                {
+                    pool.reset(new YOLO_SESSION_POOL(cameras));
+                }
+                std::vector<std::shared_ptr<YOLO_V8>> detectors(cameras);
+                for (std::shared_ptr<YOLO_V8>& detector : detectors)
+                {
+                    char* Ret = RET_OK;
+                    if (mode == 0)
+                    {
+                        detector = std::make_shared<YOLO_V8>();
+                        Ret = detector->CreateSession(params);
+                    }
+                    else
+                    {
+                        Ret = pool->Lease(params, detector, mode == 1);
+                    }
+                    if (Ret != RET_OK)
+                    {
+                        std::cerr << Ret << std::endl;
+                        return 1;
+                    }
+                }
+                std::vector<DL_RESULT> results;
+                for (std::shared_ptr<YOLO_V8>& detector : detectors)
+                {
+                    detector->RunSession(frame, results);
+                }
+                mib[mode] = ResidentMiB() - before;
+                fps[mode] = Throughput(detectors, frame, seconds);
+            }
+        }
+        std::cout << "  " << std::setw(7) << cameras << std::setw(18) << fps[0] << std::setw(7) << mib[0]
+                  << std::setw(19) << fps[1] << std::setw(7) << mib[1] << std::setw(18) << fps[2] << std::setw(7)
+                  << mib[2] << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,108 @@
+// Head decode only: the transpose + per-anchor cv::minMaxLoc loop YOLO_V8 used before, against yolo::DecodeHead.
+//
+// Usage: ./DecoderBenchmark [iterations]   (default 200)
+// Synthetic 80-class heads at 640 (8400 anchors) and 1280 (33600 anchors) with mostly-background scores, as a
+// real frame has. Prints the median time per decode and the speedup; NMS and box scaling are not included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "head_decoder.h"
+
+
+static size_t LegacyDecode(float* output, int signalResultNum, int strideNum, int classNum, float threshold,
+    std::vector<float>& confidences, std::vector<int>& classIds)
+{
+    confidences.clear();
+    classIds.clear();
+    cv::Mat rawData = cv::Mat(signalResultNum, strideNum, CV_32F, output).t();
+    float* data = (float*)rawData.data;
+    for (int i = 0; i < strideNum; ++i)
+    {
+        cv::Mat scores(1, classNum, CV_32FC1, data + 4);
+        cv::Point class_id;
+        double maxClassScore;
+        cv::minMaxLoc(scores, 0, &maxClassScore, 0, &class_id);
+        if (maxClassScore > threshold)
+        {
+            confidences.push_back(maxClassScore);
+            classIds.push_back(class_id.x);
+        }
+        data += signalResultNum;
+    }
+    return confidences.size();
+}
+
+
+template<typename F>
+static double MedianMs(int iterations, F body)
+{
+    body();
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200;
+    const int classNum = 80;
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "head decode, " << classNum << " classes, median of " << iterations << " ("
+#if defined(YOLO_HEAD_DECODER_AVX512)
+              << "AVX-512"
+#elif defined(YOLO_HEAD_DECODER_AVX2)
+              << "AVX2"
+#elif defined(YOLO_HEAD_DECODER_NEON)
+              << "NEON"
+#else
+              << "scalar"
+#endif
+              << " decoder)\n";
+    for (int anchors : { 8400, 33600 })
+    {
+        const int rows = 4 + classNum;
+        std::vector<float> head((size_t)rows * anchors);
+        for (size_t i = 0; i < head.size(); i++)
+        {
+            head[i] = i < 4 * (size_t)anchors ? unit(rng) * 640.0f : (unit(rng) < 0.002f ? unit(rng) : unit(rng) * 0.05f);
+        }
+        for (float threshold : { 0.25f, 0.01f })
+        {
+            std::vector<float> confidences;
+            std::vector<int> classIds;
+            yolo::HeadCandidates candidates;
+            size_t kept = 0;
+            double legacy = MedianMs(iterations, [&] {
+                kept = LegacyDecode(head.data(), rows, anchors, classNum, threshold, confidences, classIds);
+            });
+            double shared = MedianMs(iterations, [&] {
+                yolo::DecodeHead(head.data(), anchors, 4, classNum, threshold, candidates);
+            });
+            std::cout << "  " << std::setw(5) << anchors << " anchors  threshold " << std::setw(5) << threshold
+                      << "  kept " << std::setw(5) << kept << "  transpose+minMaxLoc " << std::setw(8) << legacy
+                      << " ms  DecodeHead " << std::setw(8) << shared << " ms  speedup " << legacy / shared << "x\n";
+            if (kept != candidates.count)
+            {
+                std::cout << "  MISMATCH " << candidates.count << " candidates\n";
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
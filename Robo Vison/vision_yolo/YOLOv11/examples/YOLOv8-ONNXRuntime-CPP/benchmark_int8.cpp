@@ -0,0 +1,222 @@
+// FP32 against INT8 on the same CPU: speed and box mAP, to decide per model whether the quantized one ships.
+//
+// Usage: ./Int8Benchmark fp32.onnx int8.onnx images_dir [labels_dir [iterations [threads [imgsz]]]]
+//        (labels "-" for none, default 50 iterations, 1 intra-op thread, 640)
+// Labels are YOLO txt files (class cx cy w h, normalized) named after the images, e.g. from a COCO val2017 export.
+// Without labels the FP32 detections at confidence 0.25 are the ground truth, and the INT8 mAP measures agreement.
+// Both models run through YOLO_V8 with the validation settings (confidence 0.001, IoU 0.7, per-class NMS,
+// max_det 300) and the same letterbox, so only the weights and activations differ. Prints per model:
+//   infer        median InferStage on the first image, the session run quantization speeds up
+//   RunSession   median over the images, preprocess and post-processing included
+//   mAP50, mAP50-95 (../YOLOv8-CPP-Common/detection_metrics.h, the numbers ultralytics val reports)
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "inference.h"
+#include "detection_metrics.h"
+
+
+template<typename F>
+static double MedianUs(int iterations, F body)
+{
+    body();
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+
+static std::vector<yolo::EvalBox> ReadLabels(const std::filesystem::path& path, cv::Size size)
+{
+    std::vector<yolo::EvalBox> labels;
+    std::ifstream file(path);
+    yolo::EvalBox b;
+    float cx, cy, w, h;
+    while (file >> b.class_id >> cx >> cy >> w >> h)
+    {
+        b.x1 = (cx - w / 2) * size.width;
+        b.y1 = (cy - h / 2) * size.height;
+        b.x2 = (cx + w / 2) * size.width;
+        b.y2 = (cy + h / 2) * size.height;
+        labels.push_back(b);
+        file.ignore(1 << 16, '\n');//segment points after the box, if any
+    }
+    return labels;
+}
+
+
+static std::vector<yolo::EvalBox> ToEvalBoxes(const std::vector<DL_RESULT>& results)
+{
+    std::vector<yolo::EvalBox> boxes;
+    for (const DL_RESULT& r : results)
+    {
+        yolo::EvalBox b;
+        b.x1 = (float)r.box.x;
+        b.y1 = (float)r.box.y;
+        b.x2 = (float)(r.box.x + r.box.width);
+        b.y2 = (float)(r.box.y + r.box.height);
+        b.class_id = r.classId;
+        b.score = r.confidence;
+        boxes.push_back(b);
+    }
+    return boxes;
+}
+
+
+struct ModelRun
+{
+    std::string path;
+    double inferUs = 0.0;
+    double runUs = 0.0;
+    std::vector<std::vector<yolo::EvalBox>> detections;//per image, DL_RESULT is too large to keep for a val set
+    std::vector<cv::Size> sizes;
+};
+
+
+// Images are read one at a time, a whole validation set doesn't fit in memory decoded
+static bool Run(ModelRun& run, const std::vector<std::filesystem::path>& paths, int iterations, int threads,
+    int imgsz)
+{
+    YOLO_V8 detector;
+    DL_INIT_PARAM params;
+    params.modelPath = run.path;
+    params.modelType = YOLO_DETECT_V8;
+    params.imgSize = { imgsz, imgsz };
+    params.rectConfidenceThreshold = 0.001;
+    params.iouThreshold = 0.7;
+    params.agnosticNms = false;
+    params.maxDet = 300;
+    params.intraOpNumThreads = threads;
+    params.cudaEnable = false;
+    if (detector.CreateSession(params) != RET_OK)
+    {
+        return false;
+    }
+    DL_STAGE_BUFFER buffer;
+    if (detector.PreProcessStage(cv::imread(paths.front().string()), buffer) != RET_OK)
+    {
+        return false;
+    }
+    run.inferUs = MedianUs(iterations, [&] { detector.InferStage(buffer); });
+
+    std::vector<double> samples;
+    std::vector<DL_RESULT> results;
+    run.detections.resize(paths.size());
+    run.sizes.resize(paths.size());
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        cv::Mat image = cv::imread(paths[i].string());
+        if (image.empty())
+        {
+            continue;
+        }
+        run.sizes[i] = image.size();
+        results.clear();
+        auto start = std::chrono::steady_clock::now();
+        detector.RunSession(image, results);
+        samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        run.detections[i] = ToEvalBoxes(results);
+    }
+    if (samples.empty())
+    {
+        return false;
+    }
+    std::sort(samples.begin(), samples.end());
+    run.runUs = samples[samples.size() / 2];
+    return true;
+}
+
+
+int main(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        std::cerr << "usage: " << argv[0]
+                  << " fp32.onnx int8.onnx images_dir [labels_dir [iterations [threads [imgsz]]]]\n";
+        return 1;
+    }
+    std::filesystem::path imageDir = argv[3];
+    std::string labelDir = argc > 4 ? argv[4] : "-";
+    int iterations = argc > 5 ? std::atoi(argv[5]) : 50;
+    int threads = argc > 6 ? std::atoi(argv[6]) : 1;
+    int imgsz = argc > 7 ? std::atoi(argv[7]) : 640;
+
+    std::vector<std::filesystem::path> paths;
+    for (const auto& entry : std::filesystem::directory_iterator(imageDir))
+    {
+        std::string ext = entry.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if (ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp")
+        {
+            paths.push_back(entry.path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    if (paths.empty())
+    {
+        std::cerr << "no images in " << imageDir << std::endl;
+        return 1;
+    }
+
+    ModelRun runs[2];
+    runs[0].path = argv[1];
+    runs[1].path = argv[2];
+    for (ModelRun& run : runs)
+    {
+        if (!Run(run, paths, iterations, threads, imgsz))
+        {
+            return 1;
+        }
+    }
+
+    const bool labeled = labelDir != "-";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << paths.size() << " images, " << threads << " thread(s), mAP against "
+              << (labeled ? "labels in " + labelDir : std::string("the FP32 detections at confidence 0.25")) << "\n";
+    std::cout << "  model                              infer ms  RunSession ms   mAP50  mAP50-95\n";
+    yolo::DetectionSummary summaries[2];
+    for (int m = 0; m < 2; m++)
+    {
+        yolo::DetectionMetrics metrics;
+        for (size_t i = 0; i < paths.size(); i++)
+        {
+            std::vector<yolo::EvalBox> truth;
+            if (labeled)
+            {
+                truth = ReadLabels(std::filesystem::path(labelDir) / (paths[i].stem().string() + ".txt"),
+                    runs[0].sizes[i]);
+            }
+            else
+            {
+                std::copy_if(runs[0].detections[i].begin(), runs[0].detections[i].end(), std::back_inserter(truth),
+                    [](const yolo::EvalBox& b) { return b.score >= 0.25f; });
+            }
+            metrics.AddImage(runs[m].detections[i], truth);
+        }
+        summaries[m] = metrics.Compute();
+        std::string name = std::filesystem::path(runs[m].path).filename().string();
+        std::cout << "  " << std::left << std::setw(32) << name.substr(0, 32) << std::right << std::setw(11)
+                  << runs[m].inferUs / 1000.0 << std::setw(15) << runs[m].runUs / 1000.0 << std::setprecision(3)
+                  << std::setw(8) << summaries[m].map50 << std::setw(10) << summaries[m].map50_95
+                  << std::setprecision(2) << "\n";
+    }
+    std::cout << "  INT8: x" << runs[0].inferUs / runs[1].inferUs << " infer, x" << runs[0].runUs / runs[1].runUs
+              << " RunSession, mAP50-95 " << std::showpos << std::setprecision(3)
+              << summaries[1].map50_95 - summaries[0].map50_95 << std::noshowpos << "\n";
+    return 0;
+}
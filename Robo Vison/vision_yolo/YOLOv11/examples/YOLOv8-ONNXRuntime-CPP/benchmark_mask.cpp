@@ -0,0 +1,179 @@
+// Segmentation mask benchmark at 640x640: the full-prototype decode (ultralytics process_mask_native ported
+// as is: coefficients x all 160x160 prototype pixels, sigmoid everywhere, bilinear upsample of the whole mask,
+// crop to the box, threshold into a 640x640 bitmap per detection) against yolo::MaskDecoder (product over the
+// box footprint only, upsample of the box only, run-length output).
+//
+// Usage: ./MaskBenchmark [iterations]   (default 100)
+// 32 smooth random prototypes, boxes 30 to 300 px, 1 to 100 detections. Prints the median time per image and
+// the bytes of the masks in either form.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "mask_decoder.h"
+
+
+template<typename F>
+static double MedianUs(int iterations, F body)
+{
+    body();
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+
+// process_mask_native: (coefficients @ protos).sigmoid(), F.interpolate to the image, crop_mask, > threshold
+static void NaiveDecode(const std::vector<float>& coefficients, const std::vector<float>& boxes, size_t count,
+    const std::vector<float>& protos, int channels, int protoSize, int imageSize, float threshold,
+    std::vector<float>& full, std::vector<float>& upsampled, std::vector<std::vector<uint8_t>>& masks)
+{
+    const size_t plane = (size_t)protoSize * protoSize;
+    const float ratio = (float)protoSize / imageSize;
+    masks.resize(count);
+    for (size_t n = 0; n < count; n++)
+    {
+        full.assign(plane, 0.0f);
+        for (int c = 0; c < channels; c++)
+        {
+            const float coefficient = coefficients[n * channels + c];
+            const float* row = protos.data() + c * plane;
+            for (size_t i = 0; i < plane; i++)
+            {
+                full[i] += coefficient * row[i];
+            }
+        }
+        for (float& v : full)
+        {
+            v = 1.0f / (1.0f + std::exp(-v));
+        }
+        upsampled.resize((size_t)imageSize * imageSize);
+        for (int y = 0; y < imageSize; y++)
+        {
+            float sy = std::max(0.0f, (y + 0.5f) * ratio - 0.5f);
+            int y0 = (int)sy, y1 = y0 < protoSize - 1 ? y0 + 1 : y0;
+            float ly = sy - y0;
+            for (int x = 0; x < imageSize; x++)
+            {
+                float sx = std::max(0.0f, (x + 0.5f) * ratio - 0.5f);
+                int x0 = (int)sx, x1 = x0 < protoSize - 1 ? x0 + 1 : x0;
+                float lx = sx - x0;
+                upsampled[(size_t)y * imageSize + x] =
+                    (1 - ly) * ((1 - lx) * full[y0 * protoSize + x0] + lx * full[y0 * protoSize + x1]) +
+                    ly * ((1 - lx) * full[y1 * protoSize + x0] + lx * full[y1 * protoSize + x1]);
+            }
+        }
+        masks[n].resize((size_t)imageSize * imageSize);
+        const float* b = &boxes[4 * n];
+        for (int y = 0; y < imageSize; y++)
+        {
+            for (int x = 0; x < imageSize; x++)
+            {
+                bool inside = x >= b[0] && x < b[2] && y >= b[1] && y < b[3];
+                masks[n][(size_t)y * imageSize + x] = inside && upsampled[(size_t)y * imageSize + x] > threshold;
+            }
+        }
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 100;
+    const int channels = 32, protoSize = 160, imageSize = 640;
+    const float threshold = 0.5f;
+    std::mt19937 rng(38);
+
+    std::vector<float> protos((size_t)channels * protoSize * protoSize);
+    std::uniform_real_distribution<float> u(0.0f, 1.0f);
+    for (int c = 0; c < channels; c++)
+    {
+        float fx = 0.02f + 0.2f * u(rng), fy = 0.02f + 0.2f * u(rng), phase = 6.28f * u(rng);
+        for (int y = 0; y < protoSize; y++)
+        {
+            for (int x = 0; x < protoSize; x++)
+            {
+                protos[((size_t)c * protoSize + y) * protoSize + x] = std::sin(fx * x + fy * y + phase);
+            }
+        }
+    }
+
+    yolo::MaskGeometry geometry;
+    geometry.proto_width = geometry.proto_height = protoSize;
+    geometry.input_width = geometry.input_height = imageSize;
+    geometry.image_width = geometry.image_height = imageSize;
+
+    std::cout << "Masks, " << channels << "x" << protoSize << "x" << protoSize << " prototypes, " << imageSize << "x"
+              << imageSize << " image, median of " << iterations << " in us (" <<
+#if defined(YOLO_MASK_DECODER_AVX2)
+        "AVX2"
+#elif defined(YOLO_MASK_DECODER_NEON)
+        "NEON"
+#else
+        "scalar"
+#endif
+              << " product)\n";
+    std::cout << std::fixed << std::setprecision(1);
+    for (size_t count : { 1, 10, 30, 100 })
+    {
+        std::vector<float> coefficients(count * channels);
+        std::normal_distribution<float> coefficient(0.0f, 1.0f);
+        for (float& c : coefficients)
+        {
+            c = coefficient(rng);
+        }
+        std::vector<float> boxes;
+        std::uniform_real_distribution<float> position(0.0f, imageSize - 30.0f);
+        std::uniform_real_distribution<float> size(30.0f, 300.0f);
+        for (size_t n = 0; n < count; n++)
+        {
+            float x = position(rng), y = position(rng);
+            boxes.insert(boxes.end(), { x, y, std::min(x + size(rng), (float)imageSize),
+                std::min(y + size(rng), (float)imageSize) });
+        }
+
+        std::vector<float> full, upsampled;
+        std::vector<std::vector<uint8_t>> bitmaps;
+        double naiveUs = MedianUs(iterations, [&] {
+            NaiveDecode(coefficients, boxes, count, protos, channels, protoSize, imageSize, threshold, full, upsampled,
+                bitmaps);
+        });
+
+        yolo::MaskDecoder decoder;
+        std::vector<yolo::MaskRle> masks(count);
+        double decoderUs = MedianUs(iterations, [&] {
+            for (size_t n = 0; n < count; n++)
+            {
+                const float* b = &boxes[4 * n];
+                decoder.Decode(&coefficients[n * channels], 1, protos.data(), channels, geometry, b[0], b[1], b[2],
+                    b[3], threshold, masks[n]);
+            }
+        });
+
+        // Same pixels either way
+        size_t naiveArea = 0, decoderArea = 0, rleBytes = 0;
+        for (size_t n = 0; n < count; n++)
+        {
+            naiveArea += std::count(bitmaps[n].begin(), bitmaps[n].end(), 1);
+            decoderArea += masks[n].Area();
+            rleBytes += sizeof(yolo::MaskRle) + masks[n].counts.size() * sizeof(uint32_t);
+        }
+        std::cout << "  " << std::setw(3) << count << " detections  full " << std::setw(9) << naiveUs << "  decoder "
+                  << std::setw(8) << decoderUs << "  x" << std::setprecision(0) << naiveUs / decoderUs
+                  << std::setprecision(1) << "  bitmap " << count * imageSize * imageSize / 1024 << " KiB, rle "
+                  << rleBytes / 1024.0 << " KiB  (" << naiveArea << " / " << decoderArea << " px)\n";
+    }
+    return 0;
+}
@@ -0,0 +1,117 @@
+// NMS benchmark: cv::dnn::NMSBoxes (class-agnostic, and class-aware through the x7680 class offset the
+// LibTorch example used) against yolo::NonMaxSuppression at 100, 1k and 10k candidates.
+//
+// Usage: ./NmsBenchmark [iterations]   (default 200)
+// Candidates are clustered around objects like a real head's output, 80 classes, IoU 0.45, max_det 300.
+// Prints the median time per call and the number of boxes kept.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "nms.h"
+
+
+template<typename F>
+static double MedianUs(int iterations, F body)
+{
+    body();
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200;
+    const float iouThreshold = 0.45f;
+    const int maxDet = 300;
+    std::mt19937 rng(100);
+
+    std::cout << "NMS, 80 classes, IoU " << iouThreshold << ", max_det " << maxDet << ", median of " << iterations
+              << " in us (" <<
+#if defined(YOLO_NMS_AVX2)
+        "AVX2"
+#elif defined(YOLO_NMS_NEON)
+        "NEON"
+#else
+        "scalar"
+#endif
+              << " IoU)\n";
+    std::cout << std::fixed << std::setprecision(1);
+    for (int count : { 100, 1000, 10000 })
+    {
+        std::vector<cv::Rect> boxes;
+        std::vector<float> scores;
+        std::vector<int> classIds;
+        int objects = std::max(1, count / 20);
+        std::uniform_int_distribution<int> position(0, 1800);
+        std::uniform_int_distribution<int> size(16, 300);
+        std::uniform_int_distribution<int> jitter(-10, 10);
+        std::uniform_real_distribution<float> score(0.25f, 1.0f);
+        std::vector<cv::Rect> centers;
+        std::vector<int> centerClasses;
+        for (int o = 0; o < objects; o++)
+        {
+            centers.push_back(cv::Rect(position(rng), position(rng), size(rng), size(rng)));
+            centerClasses.push_back(rng() % 80);
+        }
+        for (int i = 0; i < count; i++)
+        {
+            int o = rng() % objects;
+            const cv::Rect& c = centers[o];
+            boxes.push_back(cv::Rect(c.x + jitter(rng), c.y + jitter(rng), c.width + jitter(rng), c.height + jitter(rng)));
+            scores.push_back(score(rng));
+            classIds.push_back(rng() % 8 == 0 ? (int)(rng() % 80) : centerClasses[o]);
+        }
+        std::vector<cv::Rect> offsetBoxes = boxes;
+        for (int i = 0; i < count; i++)
+        {
+            offsetBoxes[i].x += classIds[i] * 7680;
+            offsetBoxes[i].y += classIds[i] * 7680;
+        }
+
+        std::vector<int> keep;
+        size_t kept[5] = {};
+        double us[5];
+        us[0] = MedianUs(iterations, [&] { cv::dnn::NMSBoxes(boxes, scores, 0.0f, iouThreshold, keep); });
+        kept[0] = keep.size();
+        us[1] = MedianUs(iterations, [&] { cv::dnn::NMSBoxes(offsetBoxes, scores, 0.0f, iouThreshold, keep); });
+        kept[1] = keep.size();
+
+        yolo::NonMaxSuppression nms;
+        yolo::NmsOptions options;
+        options.iou_threshold = iouThreshold;
+        options.max_det = 0;//uncapped, comparable with NMSBoxes
+        options.agnostic = true;
+        us[2] = MedianUs(iterations, [&] { nms.RunRects(boxes, scores, classIds, options, keep); });
+        kept[2] = keep.size();
+        options.agnostic = false;
+        us[3] = MedianUs(iterations, [&] { nms.RunRects(boxes, scores, classIds, options, keep); });
+        kept[3] = keep.size();
+        options.max_det = maxDet;
+        us[4] = MedianUs(iterations, [&] { nms.RunRects(boxes, scores, classIds, options, keep); });
+        kept[4] = keep.size();
+
+        const char* names[5] = { "NMSBoxes agnostic", "NMSBoxes x7680 offset", "yolo agnostic", "yolo class-aware",
+            "yolo class-aware max_det" };
+        std::cout << "  " << count << " candidates\n";
+        for (int m = 0; m < 5; m++)
+        {
+            std::cout << "    " << std::left << std::setw(26) << names[m] << std::right << std::setw(10) << us[m]
+                      << " us  kept " << kept[m] << "\n";
+        }
+    }
+    return 0;
+}
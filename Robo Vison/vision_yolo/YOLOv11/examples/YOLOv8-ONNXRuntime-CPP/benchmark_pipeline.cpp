@@ -0,0 +1,127 @@
+// Pipelined against sequential video inference with YOLO_V8 on CPU.
+//
+// Usage: ./PipelineBenchmark video.mp4 [model.onnx [frames [intra_op_threads]]]   (default yolov8n.onnx 300 1)
+// Each mode decodes the same frames, runs detection and draws the boxes. Prints frames/s and the per-frame
+// latency from decoded frame to drawn result (p50 / p99).
+//   sequential   read -> RunSession -> draw in one loop (what main.cpp does)
+//   pipeline     capture / preprocess / inference / postprocess+draw on separate threads, blocking backpressure
+//   drop-oldest  the same, dropping the oldest waiting frame when preprocessing falls behind (live-camera mode)
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "inference.h"
+#include "pipeline.h"
+
+
+struct PipelineFrame
+{
+    cv::Mat image;
+    DL_STAGE_BUFFER buffer;
+    std::vector<DL_RESULT> results;
+};
+
+
+static void Draw(cv::Mat& image, const std::vector<DL_RESULT>& results)
+{
+    for (const DL_RESULT& result : results)
+    {
+        cv::rectangle(image, result.box, cv::Scalar(0, 255, 0), 2);
+    }
+}
+
+
+static void PrintRow(const char* mode, const yolo::PipelineStats& stats)
+{
+    std::cout << "  " << std::left << std::setw(13) << mode << std::right << std::setw(8) << stats.Fps() << " frames/s  "
+              << "latency p50 " << std::setw(8) << stats.LatencyPercentile(0.5) << " ms  p99 " << std::setw(8)
+              << stats.LatencyPercentile(0.99) << " ms  delivered " << stats.delivered << "  dropped " << stats.dropped
+              << "\n";
+}
+
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " video.mp4 [model.onnx [frames [intra_op_threads]]]" << std::endl;
+        return 1;
+    }
+    std::string videoPath = argv[1];
+    std::string modelPath = argc > 2 ? argv[2] : "yolov8n.onnx";
+    size_t maxFrames = argc > 3 ? std::atoi(argv[3]) : 300;
+    int intraOpThreads = argc > 4 ? std::atoi(argv[4]) : 1;
+
+    YOLO_V8 detector;
+    DL_INIT_PARAM params;
+    params.modelPath = modelPath;
+    params.modelType = YOLO_DETECT_V8;
+    params.imgSize = { 640, 640 };
+    params.rectConfidenceThreshold = 0.25;
+    params.iouThreshold = 0.5;
+    params.cudaEnable = false;
+    params.intraOpNumThreads = intraOpThreads;
+    if (detector.CreateSession(params) != RET_OK)
+    {
+        return 1;
+    }
+
+    // Sequential loop
+    yolo::PipelineStats sequential;
+    {
+        cv::VideoCapture capture(videoPath);
+        if (!capture.isOpened())
+        {
+            std::cerr << "cannot open " << videoPath << std::endl;
+            return 1;
+        }
+        cv::Mat frame;
+        std::vector<DL_RESULT> results;
+        auto start = std::chrono::steady_clock::now();
+        while (sequential.delivered < maxFrames && capture.read(frame))
+        {
+            auto decoded = std::chrono::steady_clock::now();
+            results.clear();
+            detector.RunSession(frame, results);
+            Draw(frame, results);
+            sequential.latency_ms.push_back(
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - decoded).count());
+            sequential.captured++;
+            sequential.delivered++;
+        }
+        sequential.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    auto runPipeline = [&](yolo::Backpressure backpressure) {
+        cv::VideoCapture capture(videoPath);
+        size_t captured = 0;
+        yolo::PipelineOptions options;
+        options.backpressure = backpressure;
+        yolo::Pipeline<PipelineFrame> pipeline(
+            options,
+            [&](PipelineFrame& f) { return captured++ < maxFrames && capture.read(f.image); },
+            [&](PipelineFrame& f) { detector.PreProcessStage(f.image, f.buffer); },
+            [&](PipelineFrame& f) { detector.InferStage(f.buffer); },
+            [&](PipelineFrame& f) {
+                f.results.clear();
+                detector.PostProcessStage(f.buffer, f.results);
+                Draw(f.image, f.results);
+            },
+            [](PipelineFrame&) {});
+        return pipeline.Run();
+    };
+    yolo::PipelineStats pipelined = runPipeline(yolo::Backpressure::kBlock);
+    yolo::PipelineStats dropOldest = runPipeline(yolo::Backpressure::kDropOldest);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << videoPath << ", " << modelPath << ", up to " << maxFrames << " frames, " << intraOpThreads
+              << " intra-op thread(s)\n";
+    PrintRow("sequential", sequential);
+    PrintRow("pipeline", pipelined);
+    PrintRow("drop-oldest", dropOldest);
+    std::cout << "  speedup " << pipelined.Fps() / sequential.Fps() << "x\n";
+    return 0;
+}
@@ -0,0 +1,163 @@
+// Pose benchmark and result dump for the accuracy comparison with ultralytics (compare_pose.py).
+//
+// Usage: ./PoseBenchmark yolov8n-pose.onnx image.jpg [iterations [results.csv]]   (default 200, pose_cpp.csv)
+// Runs one frame through the stage API and times, on that output:
+//   post-process   YOLO_V8::PostProcessStage: head decode, NMS, keypoints of the kept boxes into DL_RESULT
+//   naive          the direct port of the Python postprocess: transpose, every candidate's keypoints into its
+//                  own std::vector before cv::dnn::NMSBoxes
+// and the whole RunSession. The detections are written as CSV, one row per person:
+//   class,confidence,x,y,width,height,x0,y0,v0,x1,y1,v1,...
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "inference.h"
+
+
+template<typename F>
+static double MedianUs(int iterations, F body)
+{
+    body();
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+
+struct NaivePose
+{
+    cv::Rect box;
+    float confidence;
+    std::vector<cv::Point2f> keyPoints;
+    std::vector<float> visibility;
+};
+
+
+static size_t NaiveDecode(const std::vector<float>& output, int keyPointsNum, float scale, float confThreshold,
+    float iouThreshold, std::vector<NaivePose>& results)
+{
+    const int rows = 5 + 3 * keyPointsNum;
+    const int anchors = (int)(output.size() / rows);
+    cv::Mat transposed = cv::Mat(rows, anchors, CV_32F, const_cast<float*>(output.data())).t();
+    std::vector<NaivePose> candidates;
+    std::vector<cv::Rect> boxes;
+    std::vector<float> confidences;
+    for (int a = 0; a < anchors; a++)
+    {
+        const float* row = transposed.ptr<float>(a);
+        if (row[4] <= confThreshold)
+        {
+            continue;
+        }
+        NaivePose pose;
+        pose.confidence = row[4];
+        pose.box = cv::Rect(int((row[0] - 0.5 * row[2]) * scale), int((row[1] - 0.5 * row[3]) * scale),
+            int(row[2] * scale), int(row[3] * scale));
+        for (int k = 0; k < keyPointsNum; k++)
+        {
+            pose.keyPoints.push_back(cv::Point2f(row[5 + 3 * k] * scale, row[6 + 3 * k] * scale));
+            pose.visibility.push_back(row[7 + 3 * k]);
+        }
+        boxes.push_back(pose.box);
+        confidences.push_back(pose.confidence);
+        candidates.push_back(pose);
+    }
+    std::vector<int> keep;
+    cv::dnn::NMSBoxes(boxes, confidences, confThreshold, iouThreshold, keep);
+    results.clear();
+    for (int i : keep)
+    {
+        results.push_back(candidates[i]);
+    }
+    return results.size();
+}
+
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "usage: " << argv[0] << " model.onnx image.jpg [iterations [results.csv]]" << std::endl;
+        return 1;
+    }
+    std::string modelPath = argv[1];
+    cv::Mat image = cv::imread(argv[2]);
+    int iterations = argc > 3 ? std::atoi(argv[3]) : 200;
+    std::string csvPath = argc > 4 ? argv[4] : "pose_cpp.csv";
+    if (image.empty())
+    {
+        std::cerr << "cannot read " << argv[2] << std::endl;
+        return 1;
+    }
+
+    YOLO_V8 detector;
+    detector.classes = { "person" };
+    DL_INIT_PARAM params;
+    params.modelPath = modelPath;
+    params.modelType = YOLO_POSE;
+    params.keyPointsNum = 17;
+    params.imgSize = { 640, 640 };
+    params.rectConfidenceThreshold = 0.25;
+    params.iouThreshold = 0.7;
+    params.agnosticNms = false;
+    params.cudaEnable = false;
+    if (detector.CreateSession(params) != RET_OK)
+    {
+        return 1;
+    }
+
+    DL_STAGE_BUFFER buffer;
+    std::vector<DL_RESULT> results;
+    std::vector<NaivePose> naiveResults;
+    results.reserve(300);
+    if (detector.PreProcessStage(image, buffer) != RET_OK || detector.InferStage(buffer) != RET_OK)
+    {
+        return 1;
+    }
+    double postUs = MedianUs(iterations, [&] {
+        results.clear();
+        detector.PostProcessStage(buffer, results);
+    });
+    double naiveUs = MedianUs(iterations, [&] {
+        NaiveDecode(buffer.output, params.keyPointsNum, buffer.resizeScales, params.rectConfidenceThreshold,
+            params.iouThreshold, naiveResults);
+    });
+    std::vector<DL_RESULT> runResults;
+    double runUs = MedianUs(iterations, [&] {
+        runResults.clear();
+        detector.RunSession(image, runResults);
+    });
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << modelPath << ", " << image.cols << "x" << image.rows << ", median of " << iterations << "\n";
+    std::cout << "  post-process  " << std::setw(10) << postUs << " us  " << results.size() << " person(s)\n";
+    std::cout << "  naive         " << std::setw(10) << naiveUs << " us  " << naiveResults.size() << " person(s)\n";
+    std::cout << "  RunSession    " << std::setw(10) << runUs / 1000.0 << " ms\n";
+
+    std::ofstream csv(csvPath);
+    csv << std::setprecision(6);
+    for (const DL_RESULT& r : results)
+    {
+        csv << r.classId << "," << r.confidence << "," << r.box.x << "," << r.box.y << "," << r.box.width << ","
+            << r.box.height;
+        for (int k = 0; k < r.keyPointsNum; k++)
+        {
+            csv << "," << r.keyPoints[k].x << "," << r.keyPoints[k].y << "," << r.keyPoints[k].visibility;
+        }
+        csv << "\n";
+    }
+    std::cout << "  results written to " << csvPath << ", compare with: python compare_pose.py --model " << modelPath
+              << " --img " << argv[2] << " --csv " << csvPath << "\n";
+    return 0;
+}
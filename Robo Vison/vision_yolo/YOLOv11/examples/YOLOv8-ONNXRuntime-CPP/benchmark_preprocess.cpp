@@ -0,0 +1,172 @@
+// Preprocessing benchmark: the original PreProcess + BlobFromImage path against the fused letterbox kernel.
+//
+// Usage: ./PreprocessBenchmark [frame_width frame_height [iterations]]   (default 1920 1080 200)
+// Prints per-frame latency (median / mean) and the largest difference to the original output.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "letterbox_kernel.h"
+
+
+// The path YOLO_V8::RunSession used before the fused kernel: clone, cvtColor, resize, zeros + copyTo,
+// then a per-pixel cv::Mat::at walk into a freshly allocated blob.
+static float* OriginalPreProcess(const cv::Mat& iImg, int size)
+{
+    cv::Mat oImg = iImg.clone();
+    cv::cvtColor(oImg, oImg, cv::COLOR_BGR2RGB);
+    float resizeScales;
+    if (iImg.cols >= iImg.rows)
+    {
+        resizeScales = iImg.cols / (float)size;
+        cv::resize(oImg, oImg, cv::Size(size, int(iImg.rows / resizeScales)));
+    }
+    else
+    {
+        resizeScales = iImg.rows / (float)size;
+        cv::resize(oImg, oImg, cv::Size(int(iImg.cols / resizeScales), size));
+    }
+    cv::Mat tempImg = cv::Mat::zeros(size, size, CV_8UC3);
+    oImg.copyTo(tempImg(cv::Rect(0, 0, oImg.cols, oImg.rows)));
+    oImg = tempImg;
+
+    float* blob = new float[oImg.total() * 3];
+    for (int c = 0; c < 3; c++)
+    {
+        for (int h = 0; h < oImg.rows; h++)
+        {
+            for (int w = 0; w < oImg.cols; w++)
+            {
+                blob[c * oImg.cols * oImg.rows + h * oImg.cols + w] = oImg.at<cv::Vec3b>(h, w)[c] / 255.0f;
+            }
+        }
+    }
+    return blob;
+}
+
+
+struct Timing
+{
+    double median;
+    double mean;
+};
+
+
+static Timing Measure(int iterations, const std::function<void()>& body)
+{
+    body();//warm-up: page in buffers, build sampling tables
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (int i = 0; i < iterations; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double s : samples)
+    {
+        sum += s;
+    }
+    return { samples[samples.size() / 2], sum / samples.size() };
+}
+
+
+int main(int argc, char** argv)
+{
+    int frameWidth = argc > 2 ? std::atoi(argv[1]) : 1920;
+    int frameHeight = argc > 2 ? std::atoi(argv[2]) : 1080;
+    int iterations = argc > 3 ? std::atoi(argv[3]) : 200;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+
+    cv::Mat frame(frameHeight, frameWidth, CV_8UC3);
+    cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(256));
+
+    std::cout << "frame " << frameWidth << "x" << frameHeight << ", " << iterations << " iterations, "
+#if defined(YOLO_LETTERBOX_AVX2)
+              << "AVX2"
+#elif defined(YOLO_LETTERBOX_NEON)
+              << "NEON"
+#else
+              << "scalar"
+#endif
+              << " kernel" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+
+    for (int size : { 640, 1280 })
+    {
+        const size_t count = 3 * size_t(size) * size;
+        std::vector<float> reference(count);
+        {
+            float* blob = OriginalPreProcess(frame, size);
+            std::copy(blob, blob + count, reference.begin());
+            delete[] blob;
+        }
+
+        yolo::LetterboxKernel kernel;
+        std::vector<float> output(count);
+        std::vector<uint16_t> outputHalf(count);
+
+        struct Case
+        {
+            std::string name;
+            yolo::ResizeFilter filter;
+            int threads;
+            bool half;
+        };
+        std::vector<Case> cases = {
+            { "fused bilinear", yolo::ResizeFilter::kBilinear, 1, false },
+            { "fused area", yolo::ResizeFilter::kArea, 1, false },
+            { "fused bilinear fp16", yolo::ResizeFilter::kBilinear, 1, true },
+        };
+        if (threads > 1)
+        {
+            cases.push_back({ "fused bilinear x" + std::to_string(threads), yolo::ResizeFilter::kBilinear, threads, false });
+        }
+
+        Timing original = Measure(iterations, [&] { delete[] OriginalPreProcess(frame, size); });
+        std::cout << "\n" << size << "x" << size << "\n";
+        std::cout << "  " << std::left << std::setw(24) << "original" << std::right
+                  << "median " << std::setw(8) << original.median << " ms  mean " << std::setw(8) << original.mean << " ms\n";
+
+        for (const Case& c : cases)
+        {
+            yolo::LetterboxParams params;
+            params.dst_width = params.dst_height = size;
+            params.filter = c.filter;
+            params.threads = c.threads;
+            Timing t = Measure(iterations, [&] {
+                if (c.half)
+                {
+                    kernel.Run(frame.data, frame.cols, frame.rows, frame.step, 3, outputHalf.data(), params);
+                }
+                else
+                {
+                    kernel.Run(frame.data, frame.cols, frame.rows, frame.step, 3, output.data(), params);
+                }
+            });
+
+            // The original path rounds the resized image to u8, so bilinear differs by up to ~0.5/255 from that
+            // alone; area is a different filter and is expected to differ more
+            cv::Mat values(1, (int)count, CV_32F, output.data());
+            if (c.half)
+            {
+                cv::Mat(1, (int)count, CV_16F, outputHalf.data()).convertTo(values, CV_32F);
+            }
+            double maxDiff = cv::norm(values, cv::Mat(1, (int)count, CV_32F, reference.data()), cv::NORM_INF);
+            std::cout << "  " << std::left << std::setw(24) << c.name << std::right
+                      << "median " << std::setw(8) << t.median << " ms  mean " << std::setw(8) << t.mean << " ms  "
+                      << std::setprecision(1) << original.median / t.median << "x  " << std::setprecision(4)
+                      << "max diff " << maxDiff * 255 << "/255" << std::setprecision(3) << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,184 @@
+// Rotated NMS benchmark at 100, 1k, 5k and 20k candidates (a 1024x1024 -obb head has 21504 anchors). Three
+// approaches are compared:
+//   probiou matrix  the ultralytics nms_rotated port: sort, probiou of every pair (batch_probiou, upper triangle),
+//                   keep the boxes no better box overlaps
+//   greedy          every candidate against every kept box of its class through the exact probiou
+//   rotated nms     yolo::RotatedNonMaxSuppression (../YOLOv8-CPP-Common/rotated_nms.h)
+//
+// Usage: ./RotatedNmsBenchmark [iterations]   (default 100, the matrix runs fewer at large counts)
+// Candidates are clustered around rotated objects as in a real head's output, 15 classes (DOTA), IoU 0.7 and
+// max_det 300 as in ultralytics' predict defaults. Prints the median time per call and the number of boxes kept.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+#include "rotated_nms.h"
+
+
+template<typename F>
+static double MedianUs(int iterations, F body)
+{
+    body();
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+
+// nms_rotated: classes kept apart by offsetting the centers by class * 7680 as the Python postprocess does
+static size_t MatrixNms(const std::vector<yolo::RotatedBox>& boxes, const std::vector<float>& scores,
+    const std::vector<int>& classIds, float iouThreshold, int maxDet, std::vector<int>& keep)
+{
+    std::vector<int> order(scores.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return scores[a] > scores[b]; });
+    std::vector<yolo::RotatedBox> sorted;
+    for (int i : order)
+    {
+        yolo::RotatedBox b = boxes[i];
+        b.cx += classIds[i] * 7680.0f;
+        b.cy += classIds[i] * 7680.0f;
+        sorted.push_back(b);
+    }
+    std::vector<float> ious(sorted.size() * sorted.size(), 0.0f);
+    for (size_t i = 0; i < sorted.size(); i++)
+    {
+        for (size_t j = i + 1; j < sorted.size(); j++)
+        {
+            ious[i * sorted.size() + j] = yolo::ProbIou(sorted[i], sorted[j]);
+        }
+    }
+    keep.clear();
+    for (size_t j = 0; j < sorted.size() && keep.size() < (size_t)maxDet; j++)
+    {
+        bool suppressed = false;
+        for (size_t i = 0; i < j && !suppressed; i++)
+        {
+            suppressed = ious[i * sorted.size() + j] >= iouThreshold;
+        }
+        if (!suppressed)
+        {
+            keep.push_back(order[j]);
+        }
+    }
+    return keep.size();
+}
+
+
+static size_t GreedyNms(const std::vector<yolo::RotatedBox>& boxes, const std::vector<float>& scores,
+    const std::vector<int>& classIds, float iouThreshold, int maxDet, std::vector<int>& keep)
+{
+    std::vector<int> order(scores.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return scores[a] > scores[b]; });
+    keep.clear();
+    for (int i : order)
+    {
+        if (keep.size() == (size_t)maxDet)
+        {
+            break;
+        }
+        bool suppressed = false;
+        for (size_t k = 0; k < keep.size() && !suppressed; k++)
+        {
+            suppressed = classIds[keep[k]] == classIds[i] && yolo::ProbIou(boxes[keep[k]], boxes[i]) > iouThreshold;
+        }
+        if (!suppressed)
+        {
+            keep.push_back(i);
+        }
+    }
+    return keep.size();
+}
+
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 100;
+    const float iouThreshold = 0.7f;
+    const int maxDet = 300;
+    const int classNum = 15;
+    std::mt19937 rng(39);
+
+    std::cout << "Rotated NMS, " << classNum << " classes, IoU " << iouThreshold << ", max_det " << maxDet
+              << ", median in us (" <<
+#if defined(YOLO_ROTATED_NMS_AVX2)
+        "AVX2"
+#elif defined(YOLO_ROTATED_NMS_NEON)
+        "NEON"
+#else
+        "scalar"
+#endif
+              << " pre-test)\n";
+    std::cout << std::fixed << std::setprecision(1);
+    for (int count : { 100, 1000, 5000, 20000 })
+    {
+        std::vector<yolo::RotatedBox> boxes;
+        std::vector<float> scores;
+        std::vector<int> classIds;
+        int objects = std::max(1, count / 20);
+        std::uniform_real_distribution<float> position(0.0f, 1024.0f);
+        std::uniform_real_distribution<float> size(8.0f, 120.0f);
+        std::uniform_real_distribution<float> angle(0.0f, 3.1416f);
+        std::uniform_real_distribution<float> jitter(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> score(0.25f, 1.0f);
+        std::vector<yolo::RotatedBox> centers;
+        for (int o = 0; o < objects; o++)
+        {
+            centers.push_back({ position(rng), position(rng), size(rng), size(rng), angle(rng) });
+        }
+        for (int i = 0; i < count; i++)
+        {
+            int o = (int)(rng() % objects);
+            yolo::RotatedBox b = centers[o];
+            b.cx += 6.0f * jitter(rng);
+            b.cy += 6.0f * jitter(rng);
+            b.width *= 1.0f + 0.1f * jitter(rng);
+            b.height *= 1.0f + 0.1f * jitter(rng);
+            b.angle += 0.1f * jitter(rng);
+            boxes.push_back(yolo::RegularizeRotatedBox(b));
+            scores.push_back(score(rng));
+            classIds.push_back(rng() % 4 == 0 ? (int)(rng() % classNum) : o % classNum);
+        }
+
+        std::vector<int> matrixKeep, greedyKeep, keep;
+        const int matrixIterations = count >= 5000 ? 1 : iterations;
+        double matrixUs = count > 5000 ? 0.0 : MedianUs(matrixIterations, [&] {
+            MatrixNms(boxes, scores, classIds, iouThreshold, maxDet, matrixKeep);
+        });
+        double greedyUs = MedianUs(std::max(1, iterations / 10), [&] {
+            GreedyNms(boxes, scores, classIds, iouThreshold, maxDet, greedyKeep);
+        });
+        yolo::RotatedNonMaxSuppression nms;
+        yolo::NmsOptions options;
+        options.iou_threshold = iouThreshold;
+        options.max_det = maxDet;
+        double nmsUs = MedianUs(iterations, [&] {
+            nms.Run(boxes.data(), scores.data(), classIds.data(), boxes.size(), options, keep);
+        });
+
+        std::cout << "  " << std::setw(5) << count << " candidates  probiou matrix ";
+        if (count > 5000)
+        {
+            std::cout << std::setw(11) << "skipped" << "      ";
+        }
+        else
+        {
+            std::cout << std::setw(11) << matrixUs << " (" << std::setw(3) << matrixKeep.size() << ")";
+        }
+        std::cout << "  greedy " << std::setw(9) << greedyUs << " (" << std::setw(3) << greedyKeep.size() << ")"
+                  << "  rotated nms " << std::setw(7) << nmsUs << " (" << std::setw(3) << keep.size() << ")\n";
+    }
+    return 0;
+}
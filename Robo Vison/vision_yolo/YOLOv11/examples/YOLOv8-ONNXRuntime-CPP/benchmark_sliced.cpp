@@ -0,0 +1,243 @@
+// Full-frame RunSession against sliced RunSessionSliced (../YOLOv8-CPP-Common/slicing.h) on high-resolution images:
+// frames/s, and against ground truth the recall of small objects (under 32x32 pixels in the frame, the COCO
+// definition), of all objects, and the precision, at IoU 0.5. Slicing pays off when the small-object recall rises
+// by more than the fps and precision fall.
+//
+// Usage: ./SliceBenchmark model.onnx images_dir [labels_dir [slice [overlap [full_frame [threads [conf]]]]]]
+//        (labels "-" for none, default 640 slices, overlap 0.2, full frame on, 1 intra-op thread, confidence 0.25)
+// Labels are YOLO txt files (class cx cy w h, normalized) named after the images, e.g. VisDrone or a 4K COCO
+// subset. Without labels only the speed and the number of detections are printed. Export the model with
+// dynamic=True so all tiles of a frame go through one session run; fixed-batch models run them in chunks.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "inference.h"
+#include "detection_metrics.h"
+
+
+static std::vector<yolo::EvalBox> ReadLabels(const std::filesystem::path& path, cv::Size size)
+{
+    std::vector<yolo::EvalBox> labels;
+    std::ifstream file(path);
+    yolo::EvalBox b;
+    float cx, cy, w, h;
+    while (file >> b.class_id >> cx >> cy >> w >> h)
+    {
+        b.x1 = (cx - w / 2) * size.width;
+        b.y1 = (cy - h / 2) * size.height;
+        b.x2 = (cx + w / 2) * size.width;
+        b.y2 = (cy + h / 2) * size.height;
+        labels.push_back(b);
+        file.ignore(1 << 16, '\n');//segment points after the box, if any
+    }
+    return labels;
+}
+
+
+static bool Small(const yolo::EvalBox& box)
+{
+    return (box.x2 - box.x1) * (box.y2 - box.y1) < 32.0f * 32.0f;
+}
+
+
+struct ModeStats
+{
+    double seconds = 0.0;
+    size_t images = 0;
+    size_t predictionCount = 0;
+    size_t truePositives = 0;
+    size_t groundTruth = 0;
+    size_t smallGroundTruth = 0;
+    size_t recalled = 0;
+    size_t smallRecalled = 0;
+
+    // Predictions in score order take the unmatched ground-truth box of their class with the highest IoU >= 0.5
+    void Add(const std::vector<DL_RESULT>& results, const std::vector<yolo::EvalBox>& labels)
+    {
+        std::vector<yolo::EvalBox> predictions;
+        for (const DL_RESULT& result : results)
+        {
+            yolo::EvalBox box;
+            box.x1 = (float)result.box.x;
+            box.y1 = (float)result.box.y;
+            box.x2 = (float)(result.box.x + result.box.width);
+            box.y2 = (float)(result.box.y + result.box.height);
+            box.class_id = result.classId;
+            box.score = result.confidence;
+            predictions.push_back(box);
+        }
+        std::stable_sort(predictions.begin(), predictions.end(),
+            [](const yolo::EvalBox& a, const yolo::EvalBox& b) { return a.score > b.score; });
+        std::vector<bool> matched(labels.size(), false);
+        for (const yolo::EvalBox& prediction : predictions)
+        {
+            int best = -1;
+            float bestIou = 0.5f;
+            for (size_t g = 0; g < labels.size(); g++)
+            {
+                float iou = yolo::DetectionMetrics::Iou(prediction, labels[g]);
+                if (!matched[g] && labels[g].class_id == prediction.class_id && iou >= bestIou)
+                {
+                    best = (int)g;
+                    bestIou = iou;
+                }
+            }
+            if (best >= 0)
+            {
+                matched[best] = true;
+                truePositives++;
+            }
+        }
+        for (size_t g = 0; g < labels.size(); g++)
+        {
+            groundTruth++;
+            recalled += matched[g];
+            if (Small(labels[g]))
+            {
+                smallGroundTruth++;
+                smallRecalled += matched[g];
+            }
+        }
+        predictionCount += predictions.size();
+        images++;
+    }
+};
+
+
+static double Ratio(size_t a, size_t b)
+{
+    return b > 0 ? 100.0 * a / b : 0.0;
+}
+
+
+static void PrintRow(const char* mode, const ModeStats& stats, bool labelled)
+{
+    std::cout << "  " << std::left << std::setw(11) << mode << std::right << std::setw(8)
+              << (stats.seconds > 0.0 ? stats.images / stats.seconds : 0.0) << " frames/s " << std::setw(8)
+              << (stats.images > 0 ? (double)stats.predictionCount / stats.images : 0.0) << " boxes/frame";
+    if (labelled)
+    {
+        std::cout << "  recall small " << std::setw(6) << Ratio(stats.smallRecalled, stats.smallGroundTruth)
+                  << " %  all " << std::setw(6) << Ratio(stats.recalled, stats.groundTruth) << " %  precision "
+                  << std::setw(6) << Ratio(stats.truePositives, stats.predictionCount) << " %";
+    }
+    std::cout << "\n";
+}
+
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "usage: " << argv[0]
+                  << " model.onnx images_dir [labels_dir [slice [overlap [full_frame [threads [conf]]]]]]" << std::endl;
+        return 1;
+    }
+    std::string modelPath = argv[1];
+    std::filesystem::path imagesDir = argv[2];
+    std::string labelsDir = argc > 3 ? argv[3] : "-";
+    yolo::SliceOptions options;
+    options.slice_width = options.slice_height = argc > 4 ? std::atoi(argv[4]) : 640;
+    options.overlap_width_ratio = options.overlap_height_ratio = argc > 5 ? (float)std::atof(argv[5]) : 0.2f;
+    options.full_frame = argc > 6 ? std::atoi(argv[6]) != 0 : true;
+    int threads = argc > 7 ? std::atoi(argv[7]) : 1;
+    float confidence = argc > 8 ? (float)std::atof(argv[8]) : 0.25f;
+    bool labelled = labelsDir != "-";
+
+    std::vector<std::filesystem::path> images;
+    for (const auto& entry : std::filesystem::directory_iterator(imagesDir))
+    {
+        std::string extension = entry.path().extension().string();
+        if (extension == ".jpg" || extension == ".jpeg" || extension == ".png")
+        {
+            images.push_back(entry.path());
+        }
+    }
+    std::sort(images.begin(), images.end());
+    if (images.empty())
+    {
+        std::cerr << "no images in " << imagesDir << std::endl;
+        return 1;
+    }
+
+    YOLO_V8 detector;
+    DL_INIT_PARAM params;
+    params.modelPath = modelPath;
+    params.modelType = YOLO_DETECT_V8;
+    params.imgSize = { 640, 640 };
+    params.rectConfidenceThreshold = confidence;
+    params.iouThreshold = 0.5;
+    params.cudaEnable = false;
+    params.intraOpNumThreads = threads;
+    char* ret = detector.CreateSession(params);
+    if (ret != RET_OK)
+    {
+        std::cerr << ret << std::endl;
+        return 1;
+    }
+
+    ModeStats full, sliced;
+    size_t tiles = 0;
+    bool warmedUp = false;
+    std::vector<DL_RESULT> results;
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        cv::Mat image = cv::imread(images[i].string());
+        if (image.empty())
+        {
+            continue;
+        }
+        std::vector<yolo::EvalBox> labels;
+        if (labelled)
+        {
+            labels = ReadLabels(std::filesystem::path(labelsDir) / images[i].filename().replace_extension(".txt"),
+                image.size());
+        }
+        tiles += yolo::ComputeSlices(image.cols, image.rows, options).size();
+        if (!warmedUp)
+        {
+            // Warm-up: the batch buffers of the sliced path are sized on the first call
+            warmedUp = true;
+            detector.RunSession(image, results);
+            results.clear();
+            detector.RunSessionSliced(image, results, options);
+        }
+
+        results.clear();
+        auto start = std::chrono::steady_clock::now();
+        detector.RunSession(image, results);
+        full.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        full.Add(results, labels);
+
+        results.clear();
+        start = std::chrono::steady_clock::now();
+        ret = detector.RunSessionSliced(image, results, options);
+        sliced.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (ret != RET_OK)
+        {
+            std::cerr << ret << std::endl;
+            return 1;
+        }
+        sliced.Add(results, labels);
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << modelPath << ", " << full.images << " images, " << options.slice_width << "x" << options.slice_height
+              << " slices, overlap " << options.overlap_width_ratio << ", "
+              << (full.images > 0 ? (double)tiles / full.images : 0.0) << " tiles/frame"
+              << (options.full_frame ? " + full frame" : "") << ", " << threads << " intra-op thread(s)\n";
+    if (labelled)
+    {
+        std::cout << "  " << full.groundTruth << " objects, " << full.smallGroundTruth << " small (< 32x32 px)\n";
+    }
+    PrintRow("full frame", full, labelled);
+    PrintRow("sliced", sliced, labelled);
+    return 0;
+}
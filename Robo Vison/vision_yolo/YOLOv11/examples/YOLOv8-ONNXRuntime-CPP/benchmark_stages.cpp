@@ -0,0 +1,102 @@
+// Wall-clock latency of RunSession per stage (letterbox into the input, session run, decode + NMS) and in total,
+// as p50/p90/p99/max and fps over a number of frames after warm-up, for each intra-op thread count. The same
+// harness (../YOLOv8-CPP-Common/stage_benchmark.h) backs benchmark_stages in the OpenVINO, OpenCV DNN and LibTorch
+// examples, so their reports compare directly.
+//
+// Usage: ./StageBenchmark [model.onnx [image|- [iterations [warmup [threads [report.json|report.csv [cuda]]]]]]]
+//        (default yolov8n.onnx, a random 1280x720 frame, 200 iterations, 10 warm-up, threads 1,2,4 and the
+//        hardware concurrency, no report file, CPU)
+// threads is a comma-separated list, 0 for ORT's default. The report is JSON for a .json path and CSV otherwise.
+// With YOLO_TRACE=trace.json in the environment the stage zones of every frame (one in YOLO_TRACE_SAMPLE) are also
+// written there as a Chrome trace (../YOLOv8-CPP-Common/trace.h).
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ort_detector.h"
+#include "stage_benchmark.h"
+#include "trace.h"
+
+
+int main(int argc, char** argv)
+{
+    std::string modelPath = argc > 1 ? argv[1] : "yolov8n.onnx";
+    std::string imagePath = argc > 2 ? argv[2] : "-";
+    yolo::BenchmarkOptions options;
+    options.iterations = argc > 3 ? std::atoi(argv[3]) : 200;
+    options.warmup = argc > 4 ? std::atoi(argv[4]) : 10;
+    std::string cores = std::to_string(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<int> threads = yolo::ParseThreadList(argc > 5 ? argv[5] : "1,2,4," + cores);
+    std::string reportPath = argc > 6 ? argv[6] : "";
+    bool cuda = argc > 7 && std::atoi(argv[7]) != 0;
+    std::string tracePath = yolo::trace::EnableFromEnvironment();
+
+    cv::Mat frame;
+    if (imagePath == "-")
+    {
+        frame.create(720, 1280, CV_8UC3);
+        cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(256));
+    }
+    else
+    {
+        frame = cv::imread(imagePath);
+        if (frame.empty())
+        {
+            std::cerr << "cannot read " << imagePath << std::endl;
+            return 1;
+        }
+    }
+    yolo::ImageView view;
+    view.data = frame.data;
+    view.width = frame.cols;
+    view.height = frame.rows;
+    view.stride = frame.step;
+
+    std::vector<yolo::BenchmarkResult> results;
+    for (int threadCount : threads)
+    {
+        DL_INIT_PARAM params;
+        params.modelPath = modelPath;
+        params.modelType = YOLO_DETECT_V8;
+        params.imgSize = { 640, 640 };
+        params.rectConfidenceThreshold = 0.25;
+        params.iouThreshold = 0.5;
+        params.cudaEnable = cuda;
+        params.intraOpNumThreads = threadCount;
+
+        std::unique_ptr<ORT_DETECTOR> detector = ORT_DETECTOR::Create(params);
+        yolo::BenchmarkResult result;
+        bool ok = detector && yolo::BenchmarkDetector(*detector, view, options, threadCount, result);
+        if (!ok)
+        {
+            std::cerr << "cannot run " << modelPath << " with " << threadCount << " threads" << std::endl;
+            return 1;
+        }
+        results.push_back(result);
+    }
+
+    std::cout << modelPath << ", " << frame.cols << "x" << frame.rows << ", " << options.warmup << " warm-up\n";
+    yolo::PrintResults(std::cout, results);
+    if (!reportPath.empty())
+    {
+        yolo::BenchmarkInfo info;
+        info.model = modelPath;
+        info.frame_width = frame.cols;
+        info.frame_height = frame.rows;
+        info.warmup = options.warmup;
+        if (!yolo::WriteResults(reportPath, info, results))
+        {
+            std::cerr << "cannot write " << reportPath << std::endl;
+            return 1;
+        }
+    }
+    if (!tracePath.empty() && !yolo::trace::WriteChromeTrace(tracePath))
+    {
+        std::cerr << "cannot write " << tracePath << std::endl;
+        return 1;
+    }
+    return 0;
+}
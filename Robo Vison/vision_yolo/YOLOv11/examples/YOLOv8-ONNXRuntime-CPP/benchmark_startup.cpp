@@ -0,0 +1,116 @@
+// Time to first inference of a freshly started process, without and with the optimized model cache:
+//   no cache     CreateSession optimizes the graph at ORT_ENABLE_ALL, as on every start before
+//   cold cache   empty cache directory, the start that optimizes and writes the cache entry
+//   warm cache   the entry exists, the session maps it and skips optimization
+//
+// Usage: ./StartupBenchmark [model.onnx [cache_dir [runs [cuda]]]]   (default yolov8n.onnx model_cache 5, CPU)
+// Each measurement is a new process (this program started again with --child), so nothing is shared with the runs
+// before it but the OS page cache. The child times from main to the end of its first RunSession: ORT's Env,
+// CreateSession (which includes the warm-up run) and one frame. Entries go to cache_dir/startup_benchmark, which
+// is deleted before each cold run. For a disk-cold start drop the page cache first
+// (sync; echo 3 | sudo tee /proc/sys/vm/drop_caches).
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "inference.h"
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+
+static int Child(const std::string& modelPath, const std::string& cacheDir, bool cuda)
+{
+    auto start = std::chrono::steady_clock::now();
+    YOLO_V8 detector;
+    DL_INIT_PARAM params;
+    params.modelPath = modelPath;
+    params.modelType = YOLO_DETECT_V8;
+    params.imgSize = { 640, 640 };
+    params.cudaEnable = cuda;
+    params.cacheDir = cacheDir;
+    if (detector.CreateSession(params) != RET_OK)
+    {
+        return 1;
+    }
+    cv::Mat frame(720, 1280, CV_8UC3, cv::Scalar(114, 114, 114));
+    std::vector<DL_RESULT> results;
+    detector.RunSession(frame, results);
+    std::cout << "\nstartup_ms " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+        .count() << std::endl;
+    return 0;
+}
+
+
+// Median time to first inference over `runs` child processes, negative if a child failed
+static double Measure(const std::string& self, const std::string& modelPath, const std::string& cacheDir, bool cuda,
+    int runs, bool cold)
+{
+    std::vector<double> samples;
+    for (int r = 0; r < runs; r++)
+    {
+        if (cold)
+        {
+            std::filesystem::remove_all(cacheDir);
+        }
+        std::string command = "\"" + self + "\" --child \"" + modelPath + "\" \"" + (cacheDir.empty() ? "-" : cacheDir)
+            + "\" " + (cuda ? "1" : "0");
+        FILE* pipe = popen(command.c_str(), "r");
+        if (!pipe)
+        {
+            return -1.0;
+        }
+        char line[512];
+        double ms = -1.0;
+        while (std::fgets(line, sizeof(line), pipe))
+        {
+            std::sscanf(line, "startup_ms %lf", &ms);
+        }
+        if (pclose(pipe) != 0 || ms < 0.0)
+        {
+            return -1.0;
+        }
+        samples.push_back(ms);
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && std::string(argv[1]) == "--child")
+    {
+        return argc < 5 ? 1 : Child(argv[2], std::string(argv[3]) == "-" ? "" : argv[3], std::atoi(argv[4]) != 0);
+    }
+    std::string modelPath = argc > 1 ? argv[1] : "yolov8n.onnx";
+    std::filesystem::path cacheRoot = argc > 2 ? argv[2] : "model_cache";
+    int runs = argc > 3 ? std::atoi(argv[3]) : 5;
+    bool cuda = argc > 4 && std::atoi(argv[4]) != 0;
+    std::string cacheDir = (cacheRoot / "startup_benchmark").string();
+
+    double noCache = Measure(argv[0], modelPath, "", cuda, runs, false);
+    double cold = Measure(argv[0], modelPath, cacheDir, cuda, runs, true);
+    double warm = Measure(argv[0], modelPath, cacheDir, cuda, runs, false);
+    if (noCache < 0.0 || cold < 0.0 || warm < 0.0)
+    {
+        std::cerr << "a child process failed, run it alone: " << argv[0] << " --child " << modelPath << " "
+                  << cacheDir << " " << (cuda ? 1 : 0) << std::endl;
+        return 1;
+    }
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << modelPath << " on " << (cuda ? "CUDA" : "CPU") << ", median of " << runs
+              << " processes, time to first inference\n";
+    std::cout << "  no cache     " << std::setw(8) << noCache << " ms\n";
+    std::cout << "  cold cache   " << std::setw(8) << cold << " ms   (optimizes and writes the entry)\n";
+    std::cout << "  warm cache   " << std::setw(8) << warm << " ms   x" << noCache / warm << " faster\n";
+    return 0;
+}
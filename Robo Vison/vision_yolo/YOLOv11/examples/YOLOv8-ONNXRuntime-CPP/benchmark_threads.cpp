@@ -0,0 +1,119 @@
+// Throughput against worker threads for concurrent RunSession:
+//   shared        N workers calling RunSession on one YOLO_V8 (one session, one copy of the weights)
+//   per-thread    N YOLO_V8 instances, one per worker (one session each, what concurrency needed before)
+//
+// Usage: ./ThreadScalingBenchmark [model.onnx [seconds [max_threads]]]   (default yolov8n.onnx 3, all cores)
+// Every worker loops over a random 1280x720 frame for the given time with one intra-op thread, so N workers use N
+// cores either way. Prints frames/s, the speedup over one worker, and the resident memory the detectors and their
+// run contexts added (Linux, from /proc/self/status).
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "inference.h"
+
+
+static double ResidentMiB()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmRSS:") == 0)
+        {
+            return std::atof(line.c_str() + 6) / 1024.0;
+        }
+    }
+    return 0.0;
+}
+
+
+// Frames per second of `workers` threads, worker t running on detectors[t % detectors.size()]
+static double Throughput(std::vector<std::unique_ptr<YOLO_V8>>& detectors, int workers, const cv::Mat& frame,
+    double seconds)
+{
+    std::atomic<bool> stop{ false };
+    std::atomic<long> frames{ 0 };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < workers; t++)
+    {
+        threads.emplace_back([&, t] {
+            YOLO_V8& detector = *detectors[t % detectors.size()];
+            std::vector<DL_RESULT> results;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                results.clear();
+                detector.RunSession(frame, results);
+                frames++;
+            }
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    return frames / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+int main(int argc, char** argv)
+{
+    std::string modelPath = argc > 1 ? argv[1] : "yolov8n.onnx";
+    double seconds = argc > 2 ? std::atof(argv[2]) : 3.0;
+    int maxThreads = argc > 3 ? std::atoi(argv[3]) : (int)std::max(1u, std::thread::hardware_concurrency());
+
+    DL_INIT_PARAM params;
+    params.modelPath = modelPath;
+    params.modelType = YOLO_DETECT_V8;
+    params.imgSize = { 640, 640 };
+    params.rectConfidenceThreshold = 0.25;
+    params.iouThreshold = 0.5;
+    params.cudaEnable = false;
+    params.intraOpNumThreads = 1;
+    cv::Mat frame(720, 1280, CV_8UC3);
+    cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(256));
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << modelPath << ", " << seconds << " s per run, 1 intra-op thread per session\n";
+    std::cout << "  workers   shared fps  speedup    MiB   per-thread fps  speedup    MiB\n";
+    double sharedBase = 0.0, perThreadBase = 0.0;
+    for (int workers = 1; workers <= maxThreads; workers *= 2)
+    {
+        double fps[2], mib[2];
+        for (int mode = 0; mode < 2; mode++)
+        {
+            double before = ResidentMiB();
+            std::vector<std::unique_ptr<YOLO_V8>> detectors;
+            for (int d = 0; d < (mode == 0 ? 1 : workers); d++)
+            {
+                detectors.emplace_back(new YOLO_V8());
+                if (detectors.back()->CreateSession(params) != RET_OK)
+                {
+                    return 1;
+                }
+            }
+            fps[mode] = Throughput(detectors, workers, frame, seconds);
+            mib[mode] = ResidentMiB() - before;
+        }
+        if (workers == 1)
+        {
+            sharedBase = fps[0];
+            perThreadBase = fps[1];
+        }
+        std::cout << "  " << std::setw(7) << workers << std::setw(13) << fps[0] << std::setw(8) << fps[0] / sharedBase
+                  << "x" << std::setw(7) << mib[0] << std::setw(17) << fps[1] << std::setw(8)
+                  << fps[1] / perThreadBase << "x" << std::setw(7) << mib[1] << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,221 @@
+// INT8 calibration data from representative images, for quantize_int8.py.
+//
+// Usage: ./Calibrate model.onnx images_dir [output_dir [max_images [imgsz [modelType]]]]
+//        (default calibration, 300 images spread evenly over the sorted directory, 640, 1 = YOLO_DETECT_V8)
+// Every image goes through YOLO_V8::PreProcessStage, the letterbox the deployed model sees, so the calibrator
+// measures activations on the same input distribution. The FP32 model then runs on each tensor (InferStage).
+// Written to output_dir:
+//   calib_00000.npy ...   the preprocessed input tensors, 1 x 3 x imgsz x imgsz float32
+//   calibration.json      input shape, files, and the observed ranges of the input (per channel) and the head
+//                         output (per row: boxes, class scores, and keypoints / angle rows)
+// ORT can only fetch graph outputs, so the intermediate activation ranges are collected by the
+// onnxruntime.quantization calibrator in quantize_int8.py, which replays these tensors. The head ranges here
+// show why its decode tail stays FP32: boxes span the input size and scores 0..1 in the same tensor, one INT8
+// scale for both rounds most scores to 0.
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+#include "inference.h"
+
+
+struct Range
+{
+    float min = std::numeric_limits<float>::max();
+    float max = std::numeric_limits<float>::lowest();
+
+    void Add(const float* data, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            min = std::min(min, data[i]);
+            max = std::max(max, data[i]);
+        }
+    }
+};
+
+
+// NumPy .npy v1.0: magic, header length, a dict padded so the data starts on a 64-byte boundary
+static bool WriteNpy(const std::string& path, const float* data, const std::vector<int64_t>& shape)
+{
+    std::string header = "{'descr': '<f4', 'fortran_order': False, 'shape': (";
+    size_t count = 1;
+    for (int64_t d : shape)
+    {
+        header += std::to_string(d) + ", ";
+        count *= (size_t)d;
+    }
+    header += "), }";
+    header.append(63 - (10 + header.size()) % 64, ' ');
+    header += '\n';
+    std::ofstream file(path, std::ios::binary);
+    const uint16_t headerSize = (uint16_t)header.size();
+    file.write("\x93NUMPY\x01\x00", 8);
+    file.put((char)(headerSize & 0xff));
+    file.put((char)(headerSize >> 8));
+    file.write(header.data(), header.size());
+    file.write(reinterpret_cast<const char*>(data), count * sizeof(float));
+    return (bool)file;
+}
+
+
+static void WriteRanges(std::ofstream& json, const std::vector<Range>& ranges)
+{
+    json << "{\"min\": [";
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        json << (i ? ", " : "") << ranges[i].min;
+    }
+    json << "], \"max\": [";
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        json << (i ? ", " : "") << ranges[i].max;
+    }
+    json << "]}";
+}
+
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "usage: " << argv[0] << " model.onnx images_dir [output_dir [max_images [imgsz [modelType]]]]\n";
+        return 1;
+    }
+    std::string modelPath = argv[1];
+    std::filesystem::path imageDir = argv[2];
+    std::filesystem::path outputDir = argc > 3 ? argv[3] : "calibration";
+    size_t maxImages = argc > 4 ? (size_t)std::atoi(argv[4]) : 300;
+    int imgsz = argc > 5 ? std::atoi(argv[5]) : 640;
+    MODEL_TYPE modelType = argc > 6 ? (MODEL_TYPE)std::atoi(argv[6]) : YOLO_DETECT_V8;
+
+    std::vector<std::filesystem::path> images;
+    for (const auto& entry : std::filesystem::directory_iterator(imageDir))
+    {
+        std::string ext = entry.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        if (ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp")
+        {
+            images.push_back(entry.path());
+        }
+    }
+    std::sort(images.begin(), images.end());
+    if (images.empty() || maxImages == 0)
+    {
+        std::cerr << "no images in " << imageDir << std::endl;
+        return 1;
+    }
+    const size_t count = std::min(maxImages, images.size());
+    if ((modelType >= YOLO_DETECT_V8_HALF && modelType <= YOLO_CLS_HALF) || modelType == YOLO_SEG_HALF ||
+        modelType == YOLO_OBB_HALF)
+    {
+        std::cerr << "calibrate the FP32 model, the INT8 one is quantized from it\n";
+        return 1;
+    }
+
+    YOLO_V8 detector;
+    DL_INIT_PARAM params;
+    params.modelPath = modelPath;
+    params.modelType = modelType;
+    params.imgSize = { imgsz, imgsz };
+    params.cudaEnable = false;
+    if (detector.CreateSession(params) != RET_OK)
+    {
+        return 1;
+    }
+    std::filesystem::create_directories(outputDir);
+
+    const std::vector<int64_t> inputShape = { 1, 3, imgsz, imgsz };
+    const size_t plane = (size_t)imgsz * imgsz;
+    std::vector<Range> inputRanges(3), outputRanges;
+    std::vector<std::string> files;
+    DL_STAGE_BUFFER buffer;
+    for (size_t i = 0; i < count; i++)
+    {
+        const std::filesystem::path& path = images[i * images.size() / count];
+        cv::Mat image = cv::imread(path.string());
+        if (image.empty())
+        {
+            std::cerr << "skipping unreadable " << path << std::endl;
+            continue;
+        }
+        if (detector.PreProcessStage(image, buffer) != RET_OK || detector.InferStage(buffer) != RET_OK)
+        {
+            return 1;
+        }
+        char name[32];
+        std::snprintf(name, sizeof(name), "calib_%05zu.npy", files.size());
+        if (!WriteNpy((outputDir / name).string(), buffer.blob.data(), inputShape))
+        {
+            std::cerr << "cannot write " << outputDir / name << std::endl;
+            return 1;
+        }
+        files.push_back(name);
+        for (size_t c = 0; c < 3; c++)
+        {
+            inputRanges[c].Add(buffer.blob.data() + c * plane, plane);
+        }
+        // Detection, pose, segmentation and OBB heads are 1 x rows x anchors, classification heads 1 x classes
+        const size_t anchors = (size_t)(imgsz / 8) * (imgsz / 8) + (imgsz / 16) * (imgsz / 16) +
+            (imgsz / 32) * (imgsz / 32);
+        const size_t rows = buffer.output.size() % anchors == 0 ? buffer.output.size() / anchors : 1;
+        const size_t columns = buffer.output.size() / rows;
+        outputRanges.resize(rows);
+        for (size_t r = 0; r < rows; r++)
+        {
+            outputRanges[r].Add(buffer.output.data() + r * columns, columns);
+        }
+        std::cout << "\r" << files.size() << " / " << count << std::flush;
+    }
+    std::cout << std::endl;
+    if (files.empty())
+    {
+        return 1;
+    }
+
+    std::ofstream json(outputDir / "calibration.json");
+    json << "{\n  \"model\": \"" << std::filesystem::path(modelPath).generic_string() << "\",\n";
+    json << "  \"input_shape\": [1, 3, " << imgsz << ", " << imgsz << "],\n  \"files\": [";
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        json << (i ? ", " : "") << "\"" << files[i] << "\"";
+    }
+    json << "],\n  \"input\": ";
+    WriteRanges(json, inputRanges);
+    json << ",\n  \"output\": ";
+    WriteRanges(json, outputRanges);
+    json << "\n}\n";
+
+    Range input, boxes, scores;
+    for (const Range& range : inputRanges)
+    {
+        input.min = std::min(input.min, range.min);
+        input.max = std::max(input.max, range.max);
+    }
+    for (size_t r = 0; r < outputRanges.size(); r++)
+    {
+        Range& range = r < 4 && outputRanges.size() > 4 ? boxes : scores;
+        range.min = std::min(range.min, outputRanges[r].min);
+        range.max = std::max(range.max, outputRanges[r].max);
+    }
+    std::cout << files.size() << " tensors and calibration.json written to " << outputDir << "\n";
+    std::cout << "  input   [" << input.min << ", " << input.max << "]\n";
+    if (outputRanges.size() > 4)
+    {
+        std::cout << "  boxes   [" << boxes.min << ", " << boxes.max << "]\n  others  [" << scores.min << ", "
+                  << scores.max << "]   one INT8 scale over both steps "
+                  << (boxes.max - std::min(0.0f, boxes.min)) / 255
+                  << ", keep the decode tail FP32 (quantize_int8.py does)\n";
+    }
+    std::cout << "  next: python quantize_int8.py --model " << modelPath << " --calibration " << outputDir.string()
+              << "\n";
+    return 0;
+}
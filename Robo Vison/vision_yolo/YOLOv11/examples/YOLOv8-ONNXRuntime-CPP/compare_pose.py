@@ -0,0 +1,104 @@
+# Ultralytics YOLO 🚀, AGPL-3.0 license
+
+import argparse
+import csv
+import sys
+
+import numpy as np
+
+from ultralytics import YOLO
+
+
+def load_cpp_results(path):
+    """
+    Reads the detections PoseBenchmark writes, one row per person.
+
+    Args:
+        path (str): CSV with class,confidence,x,y,width,height followed by x,y,visibility per keypoint.
+
+    Returns:
+        (list[dict]): Boxes as x1, y1, x2, y2 and keypoints as a (K, 3) array.
+    """
+    results = []
+    with open(path, newline="") as f:
+        for row in csv.reader(f):
+            values = [float(v) for v in row]
+            x, y, w, h = values[2:6]
+            results.append(
+                {
+                    "confidence": values[1],
+                    "box": np.array([x, y, x + w, y + h]),
+                    "keypoints": np.array(values[6:]).reshape(-1, 3),
+                }
+            )
+    return results
+
+
+def box_iou(a, b):
+    """Returns the IoU of two x1, y1, x2, y2 boxes."""
+    w = max(0.0, min(a[2], b[2]) - max(a[0], b[0]))
+    h = max(0.0, min(a[3], b[3]) - max(a[1], b[1]))
+    inter = w * h
+    union = (a[2] - a[0]) * (a[3] - a[1]) + (b[2] - b[0]) * (b[3] - b[1]) - inter
+    return inter / union if union > 0 else 0.0
+
+
+def main(model_path, image_path, csv_path, conf, iou, max_kpt_error):
+    """
+    Runs the ultralytics predictor on the image and compares its poses with the C++ ones.
+
+    Each Python detection is matched to the unmatched C++ detection with the highest box IoU (at least 0.5). Keypoint
+    error is measured in pixels over keypoints both sides consider visible (visibility > 0.5). The C++ example pads
+    the letterbox at the bottom/right with black while ultralytics centres it with grey, so small differences are
+    expected, and detections close to the confidence threshold may appear on one side only.
+
+    Returns:
+        (bool): True when every Python detection at least 0.1 above conf is matched and the mean keypoint error is
+            within max_kpt_error.
+    """
+    result = YOLO(model_path, task="pose").predict(image_path, imgsz=640, conf=conf, iou=iou, verbose=False)[0]
+    py_boxes = result.boxes.xyxy.cpu().numpy()
+    py_conf = result.boxes.conf.cpu().numpy()
+    py_keypoints = result.keypoints.data.cpu().numpy()  # (N, K, 3), visibility in the last column
+    cpp = load_cpp_results(csv_path)
+
+    used = set()
+    box_ious, kpt_errors, vis_errors = [], [], []
+    unmatched, weak_unmatched = 0, 0
+    for box, confidence, keypoints in zip(py_boxes, py_conf, py_keypoints):
+        candidates = [(box_iou(box, c["box"]), j) for j, c in enumerate(cpp) if j not in used]
+        best_iou, best = max(candidates, default=(0.0, -1))
+        if best_iou < 0.5:
+            if confidence >= conf + 0.1:
+                unmatched += 1
+            else:
+                weak_unmatched += 1
+            continue
+        used.add(best)
+        box_ious.append(best_iou)
+        other = cpp[best]["keypoints"]
+        visible = (keypoints[:, 2] > 0.5) & (other[:, 2] > 0.5)
+        kpt_errors.extend(np.linalg.norm(keypoints[visible, :2] - other[visible, :2], axis=1))
+        vis_errors.extend(np.abs(keypoints[:, 2] - other[:, 2]))
+
+    mean_kpt = float(np.mean(kpt_errors)) if kpt_errors else 0.0
+    print(f"ultralytics {len(py_boxes)} person(s), C++ {len(cpp)}, unmatched {unmatched} (+{weak_unmatched} near conf)")
+    if box_ious:
+        print(f"  box IoU          mean {np.mean(box_ious):.3f}  min {np.min(box_ious):.3f}")
+        print(f"  keypoint error   mean {mean_kpt:.2f} px  max {np.max(kpt_errors) if kpt_errors else 0.0:.2f} px")
+        print(f"  visibility diff  mean {np.mean(vis_errors):.3f}")
+    ok = unmatched == 0 and mean_kpt <= max_kpt_error
+    print("OK" if ok else "FAIL")
+    return ok
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--model", default="yolov8n-pose.onnx", help="ONNX pose model used by PoseBenchmark.")
+    parser.add_argument("--img", required=True, help="Image given to PoseBenchmark.")
+    parser.add_argument("--csv", default="pose_cpp.csv", help="Results written by PoseBenchmark.")
+    parser.add_argument("--conf", type=float, default=0.25, help="Confidence threshold, as in PoseBenchmark.")
+    parser.add_argument("--iou", type=float, default=0.7, help="NMS IoU threshold, as in PoseBenchmark.")
+    parser.add_argument("--max-kpt-error", type=float, default=4.0, help="Allowed mean keypoint error in pixels.")
+    args = parser.parse_args()
+    sys.exit(0 if main(args.model, args.img, args.csv, args.conf, args.iou, args.max_kpt_error) else 1)
@@ -1,7 +1,7 @@
 #include "inference.h"
 #include <regex>
+#include <thread>
 
-#define benchmark
 #define min(a,b)            (((a) < (b)) ? (a) : (b))
 YOLO_V8::YOLO_V8() {
 
@@ -9,6 +9,7 @@ YOLO_V8::YOLO_V8() {
 
 
 YOLO_V8::~YOLO_V8() {
+    contexts.clear();//bindings before the session they belong to
     delete session;
 }
 
@@ -21,29 +22,94 @@ namespace Ort
 #endif
 
 
+// The *_HALF model types take and return FP16 tensors
+static bool HalfModel(MODEL_TYPE modelType)
+{
+    return (modelType >= YOLO_DETECT_V8_HALF && modelType <= YOLO_CLS_HALF) || modelType == YOLO_SEG_HALF ||
+        modelType == YOLO_OBB_HALF;
+}
+
+
+static bool SegModel(MODEL_TYPE modelType)
+{
+    return modelType == YOLO_SEG || modelType == YOLO_SEG_HALF;
+}
+
+
+// FP32 view of an output tensor, FP16 outputs are converted
+static cv::Mat OutputToFloat(float* output, size_t count)
+{
+    return cv::Mat(1, (int)count, CV_32F, output);
+}
+
+
+#ifdef USE_CUDA
+static cv::Mat OutputToFloat(half* output, size_t count)
+{
+    cv::Mat rawData;
+    cv::Mat(1, (int)count, CV_16F, output).convertTo(rawData, CV_32F);
+    return rawData;
+}
+
+
+// The letterbox kernel writes FP16 as raw IEEE half bits
+static uint16_t* KernelBlob(half* blob)
+{
+    return reinterpret_cast<uint16_t*>(blob);
+}
+#endif
+
+
+static float* KernelBlob(float* blob)
+{
+    return blob;
+}
+
+
+#ifdef YOLO_PRINT_TIMES
+// Opt-in (cmake -DYOLO_PRINT_TIMES=ON) line per RunSession; oTimes gives the same numbers without the console
+static void PrintBenchmark(bool cudaEnable, const yolo::StageTimes& times)
+{
+    std::cout << (cudaEnable ? "[YOLO_V8(CUDA)]: " : "[YOLO_V8(CPU)]: ") << times.preprocess_ms << "ms pre-process, "
+        << times.inference_ms << "ms inference, " << times.postprocess_ms << "ms post-process." << std::endl;
+}
+#endif // YOLO_PRINT_TIMES
+
+
 template<typename T>
-char* BlobFromImage(cv::Mat& iImg, T& iBlob) {
-    int channels = iImg.channels();
-    int imgHeight = iImg.rows;
-    int imgWidth = iImg.cols;
+char* YOLO_V8::LetterboxToBlob(const cv::Mat& iImg, T* blob, yolo::LetterboxKernel& kernel, float& scale) const
+{
+    YOLO_TRACE_ZONE("BlobFromImage");
+    if (iImg.depth() != CV_8U || (iImg.channels() != 1 && iImg.channels() != 3 && iImg.channels() != 4))
+    {
+        return "[YOLO_V8]:Input image must be 8-bit gray, BGR or BGRA.";
+    }
+    yolo::LetterboxParams params;
+    params.dst_height = imgSize.at(0);
+    params.dst_width = imgSize.at(1);
+    params.threads = preProcessThreads;
 
-    for (int c = 0; c < channels; c++)
+    const uint8_t* data = iImg.data;
+    int width = iImg.cols;
+    int height = iImg.rows;
+    if (modelType == YOLO_CLS || modelType == YOLO_CLS_HALF)//CenterCrop
     {
-        for (int h = 0; h < imgHeight; h++)
-        {
-            for (int w = 0; w < imgWidth; w++)
-            {
-                iBlob[c * imgWidth * imgHeight + h * imgWidth + w] = typename std::remove_pointer<T>::type(
-                    (iImg.at<cv::Vec3b>(h, w)[c]) / 255.0f);
-            }
-        }
+        int m = min(height, width);
+        data += (height - m) / 2 * iImg.step + (width - m) / 2 * iImg.elemSize();
+        width = height = m;
+        params.keep_ratio = false;
     }
+    yolo::LetterboxInfo info = kernel.Run(data, width, height, iImg.step, iImg.channels(), blob, params);
+    scale = info.scale_x;
     return RET_OK;
 }
 
 
-char* YOLO_V8::PreProcess(cv::Mat& iImg, std::vector<int> iImgSize, cv::Mat& oImg)
+// Letterboxed cv::Mat for callers that need the image itself; RunSession uses LetterboxToBlob
+char* YOLO_V8::PreProcess(cv::Mat& iImg, std::vector<int> iImgSize, cv::Mat& oImg) const
 {
+    YOLO_TRACE_ZONE("PreProcess");
+    float resizeScales;
     if (iImg.channels() == 3)
     {
         oImg = iImg.clone();
@@ -59,7 +125,11 @@ char* YOLO_V8::PreProcess(cv::Mat& iImg, std::vector<int> iImgSize, cv::Mat& oIm
     case YOLO_DETECT_V8:
     case YOLO_POSE:
     case YOLO_DETECT_V8_HALF:
-    case YOLO_POSE_V8_HALF://LetterBox
+    case YOLO_POSE_V8_HALF:
+    case YOLO_SEG:
+    case YOLO_SEG_HALF:
+    case YOLO_OBB:
+    case YOLO_OBB_HALF://LetterBox
     {
         if (iImg.cols >= iImg.rows)
         {
@@ -92,6 +162,11 @@ char* YOLO_V8::PreProcess(cv::Mat& iImg, std::vector<int> iImgSize, cv::Mat& oIm
 
 
 char* YOLO_V8::CreateSession(DL_INIT_PARAM& iParams) {
+    return CreateSession(iParams, nullptr);
+}
+
+
+char* YOLO_V8::CreateSession(DL_INIT_PARAM& iParams, std::shared_ptr<DL_SHARED_RUNTIME> sharedRuntime) {
     char* Ret = RET_OK;
     std::regex pattern("[\u4e00-\u9fa5]");
     bool result = std::regex_search(iParams.modelPath, pattern);
@@ -101,36 +176,80 @@ char* YOLO_V8::CreateSession(DL_INIT_PARAM& iParams) {
         std::cout << Ret << std::endl;
         return Ret;
     }
+    if ((iParams.modelType == YOLO_POSE || iParams.modelType == YOLO_POSE_V8_HALF) &&
+        (iParams.keyPointsNum < 1 || iParams.keyPointsNum > DL_MAX_KEYPOINTS))
+    {
+        Ret = "[YOLO_V8]:keyPointsNum must be between 1 and DL_MAX_KEYPOINTS.";
+        std::cout << Ret << std::endl;
+        return Ret;
+    }
     try
     {
         rectConfidenceThreshold = iParams.rectConfidenceThreshold;
         iouThreshold = iParams.iouThreshold;
+        nmsOptions.iou_threshold = iouThreshold;
+        nmsOptions.score_threshold = rectConfidenceThreshold;
+        nmsOptions.agnostic = iParams.agnosticNms;
+        nmsOptions.max_det = iParams.maxDet;
+        keyPointsNum = iParams.keyPointsNum;
+        maskThreshold = iParams.maskThreshold;
         imgSize = iParams.imgSize;
         modelType = iParams.modelType;
-        env = Ort::Env(ORT_LOGGING_LEVEL_WARNING, "Yolo");
+        preProcessThreads = iParams.preProcessThreads;
+        ioBinding = iParams.ioBinding;
+        cudaEnable = iParams.cudaEnable;
+        runtime = sharedRuntime;
+        if (!runtime)
+        {
+            env = Ort::Env(ORT_LOGGING_LEVEL_WARNING, "Yolo");
+        }
         Ort::SessionOptions sessionOption;
         if (iParams.cudaEnable)
         {
-            cudaEnable = iParams.cudaEnable;
             OrtCUDAProviderOptions cudaOption;
             cudaOption.device_id = 0;
             sessionOption.AppendExecutionProvider_CUDA(cudaOption);
         }
         sessionOption.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
-        sessionOption.SetIntraOpNumThreads(iParams.intraOpNumThreads);
+        if (runtime)
+        {
+            sessionOption.DisablePerSessionThreads();//the Env's global thread pools run it
+        }
+        else
+        {
+            sessionOption.SetIntraOpNumThreads(iParams.intraOpNumThreads);
+        }
         sessionOption.SetLogSeverityLevel(iParams.logSeverityLevel);
 
-#ifdef _WIN32
-        int ModelPathSize = MultiByteToWideChar(CP_UTF8, 0, iParams.modelPath.c_str(), static_cast<int>(iParams.modelPath.length()), nullptr, 0);
-        wchar_t* wide_cstr = new wchar_t[ModelPathSize + 1];
-        MultiByteToWideChar(CP_UTF8, 0, iParams.modelPath.c_str(), static_cast<int>(iParams.modelPath.length()), wide_cstr, ModelPathSize);
-        wide_cstr[ModelPathSize] = L'\0';
-        const wchar_t* modelPath = wide_cstr;
-#else
-        const char* modelPath = iParams.modelPath.c_str();
-#endif // _WIN32
-
-        session = new Ort::Session(env, modelPath, sessionOption);
+        // UTF-8 to the platform's path encoding, wide on Windows as ORTCHAR_T
+        const std::filesystem::path modelPath = std::filesystem::u8path(iParams.modelPath);
+        if (iParams.cacheDir.empty())
+        {
+            NewSession(modelPath, nullptr, 0, sessionOption);
+        }
+        else
+        {
+            CachedSession(modelPath, iParams.cacheDir, sessionOption);
+        }
+        Ret = CheckTensorTypes();
+        if (Ret != RET_OK)
+        {
+            std::cout << Ret << std::endl;
+            return Ret;
+        }
+        std::vector<int64_t> inputShape = session->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+        modelBatch = inputShape.empty() ? 1 : inputShape[0];//-1 for dynamic-batch models
+        // One image per core at most, the caller takes one; fixed-batch models never need more than their batch
+        int batchThreads = (int)std::thread::hardware_concurrency();
+        if (batchThreads < 1)
+        {
+            batchThreads = 1;//unknown core count
+        }
+        if (modelBatch > 0)
+        {
+            batchThreads = (int)min((int64_t)batchThreads, modelBatch);
+        }
+        batchWorkers.reset(new yolo::WorkerPool(batchThreads - 1));
         Ort::AllocatorWithDefaultOptions allocator;
         size_t inputNodesNum = session->GetInputCount();
         for (size_t i = 0; i < inputNodesNum; i++)
@@ -149,8 +268,12 @@ char* YOLO_V8::CreateSession(DL_INIT_PARAM& iParams) {
             outputNodeNames.push_back(temp_buf);
         }
         options = Ort::RunOptions{ nullptr };
-        WarmUpSession();
-        return RET_OK;
+        Ret = WarmUpSession();
+        if (Ret != RET_OK)
+        {
+            std::cout << Ret << std::endl;
+        }
+        return Ret;
     }
     catch (const std::exception& e)
     {
@@ -167,112 +290,534 @@ char* YOLO_V8::CreateSession(DL_INIT_PARAM& iParams) {
 }
 
 
-char* YOLO_V8::RunSession(cv::Mat& iImg, std::vector<DL_RESULT>& oResult) {
-#ifdef benchmark
-    clock_t starttime_1 = clock();
-#endif // benchmark
+void YOLO_V8::NewSession(const std::filesystem::path& modelPath, const void* modelData, size_t modelSize,
+    const Ort::SessionOptions& sessionOption)
+{
+    const Ort::Env& sessionEnv = runtime ? runtime->env : env;
+    if (!modelPath.empty())
+    {
+        session = runtime
+            ? new Ort::Session(sessionEnv, modelPath.c_str(), sessionOption, runtime->prepackedWeights)
+            : new Ort::Session(sessionEnv, modelPath.c_str(), sessionOption);
+    }
+    else
+    {
+        session = runtime
+            ? new Ort::Session(sessionEnv, modelData, modelSize, sessionOption, runtime->prepackedWeights)
+            : new Ort::Session(sessionEnv, modelData, modelSize, sessionOption);
+    }
+}
+
 
-    char* Ret = RET_OK;
-    cv::Mat processedImg;
-    PreProcess(iImg, imgSize, processedImg);
-    if (modelType < 4)
+void YOLO_V8::CachedSession(const std::filesystem::path& modelPath, const std::string& cacheDir,
+    Ort::SessionOptions& sessionOption)
+{
+    // The optimized graph depends on the ORT version and, at ORT_ENABLE_ALL, on the execution provider and the CPU's
+    // instruction set (NCHWc layouts and kernels picked for AVX-512 or AVX2), so all three go into the entry's hash
+    const std::string tag = std::string(OrtGetApiBase()->GetVersionString()) + (cudaEnable ? "|cuda|" : "|cpu|") +
+        yolo::CpuTag();
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::u8path(cacheDir), error);
+    const std::filesystem::path cachePath = yolo::CachedModelPath(modelPath, std::filesystem::u8path(cacheDir), tag,
+        ".ort");
+    if (cachePath.empty())
+    {
+        NewSession(modelPath, nullptr, 0, sessionOption);
+        return;
+    }
+    if (cachedModel.Open(cachePath))
+    {
+        // Optimized on an earlier start: no graph optimization, and the ORT format graph and initializers are used
+        // in place from the mapping instead of being parsed and copied
+        Ort::SessionOptions cachedOption = sessionOption.Clone();
+        cachedOption.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_DISABLE_ALL);
+        cachedOption.AddConfigEntry("session.use_ort_model_bytes_directly", "1");
+        cachedOption.AddConfigEntry("session.use_ort_model_bytes_for_initializers", "1");
+        try
+        {
+            NewSession(std::filesystem::path(), cachedModel.data(), cachedModel.size(), cachedOption);
+            return;
+        }
+        catch (const Ort::Exception& e)
+        {
+            std::cout << "[YOLO_V8]:Model cache " << cachePath.string() << " unusable, rebuilding: " << e.what()
+                      << std::endl;
+            cachedModel.Close();
+            std::filesystem::remove(cachePath, error);
+        }
+    }
+    // Saved under a pending name while ORT writes it, renamed once the session exists
+    const std::filesystem::path pendingPath = yolo::PendingCachePath(cachePath);
+    sessionOption.SetOptimizedModelFilePath(pendingPath.c_str());
+    sessionOption.AddConfigEntry("session.save_model_format", "ORT");
+    NewSession(modelPath, nullptr, 0, sessionOption);
+    if (!yolo::CommitCacheFile(pendingPath, cachePath))
     {
-        float* blob = new float[processedImg.total() * 3];
-        BlobFromImage(processedImg, blob);
+        std::cout << "[YOLO_V8]:Could not write the model cache " << cachePath.string() << std::endl;
+    }
+}
+
+
+char* YOLO_V8::CheckTensorTypes() const
+{
+    // INT8 models from onnxruntime.quantization (QDQ or QOperator) keep FP32 inputs and outputs and run as the FP32
+    // types. Models with quantized inputs would need the scale and zero point the tensors here don't carry.
+    const ONNXTensorElementDataType expected = HalfModel(modelType) ? ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16
+        : ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+    std::vector<ONNXTensorElementDataType> types = {
+        session->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetElementType() };
+    for (size_t i = 0; i < session->GetOutputCount() && i < 2; i++)
+    {
+        types.push_back(session->GetOutputTypeInfo(i).GetTensorTypeAndShapeInfo().GetElementType());
+    }
+    for (ONNXTensorElementDataType type : types)
+    {
+        if (type == ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8 || type == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8)
+        {
+            return "[YOLO_V8]:Model inputs or outputs are quantized, quantize with FP32 inputs and outputs.";
+        }
+        if (type != expected)
+        {
+            return HalfModel(modelType) ? "[YOLO_V8]:Model is not FP16, use a FP32 model type."
+                : "[YOLO_V8]:Model is not FP32 (or INT8 with FP32 inputs), use a *_HALF model type.";
+        }
+    }
+    return RET_OK;
+}
+
+
+std::unique_ptr<YOLO_V8::RunContext> YOLO_V8::AcquireContext() const
+{
+    {
+        std::lock_guard<std::mutex> lock(contextMutex);
+        if (!contexts.empty())
+        {
+            std::unique_ptr<RunContext> context = std::move(contexts.back());
+            contexts.pop_back();
+            return context;
+        }
+    }
+    return std::unique_ptr<RunContext>(new RunContext());
+}
+
+
+void YOLO_V8::ReleaseContext(std::unique_ptr<RunContext> context) const
+{
+    std::lock_guard<std::mutex> lock(contextMutex);
+    contexts.push_back(std::move(context));
+}
+
+
+char* YOLO_V8::RunSession(const cv::Mat& iImg, std::vector<DL_RESULT>& oResult, yolo::StageTimes* oTimes) const {
+    YOLO_TRACE_FRAME("RunSession");
+    yolo::StageClock stageClock;
+    yolo::StageTimes times;
+
+    std::unique_ptr<RunContext> context = AcquireContext();
+    char* Ret = PreProcessStage(iImg, context->buffer);
+    if (Ret != RET_OK)
+    {
+        ReleaseContext(std::move(context));
+        return Ret;
+    }
+    if (ioBinding)
+    {
+        Ret = BoundProcess(stageClock, times, *context, oResult);
+    }
+    else if (!HalfModel(modelType))
+    {
+        float* blob = context->buffer.blob.data();
         std::vector<int64_t> inputNodeDims = { 1, 3, imgSize.at(0), imgSize.at(1) };
-        TensorProcess(starttime_1, iImg, blob, inputNodeDims, oResult);
+        Ret = TensorProcess(stageClock, times, iImg, blob, inputNodeDims, context->buffer.resizeScales, oResult);
     }
     else
     {
 #ifdef USE_CUDA
-        half* blob = new half[processedImg.total() * 3];
-        BlobFromImage(processedImg, blob);
+        half* blob = reinterpret_cast<half*>(context->buffer.blobHalf.data());
         std::vector<int64_t> inputNodeDims = { 1,3,imgSize.at(0),imgSize.at(1) };
-        TensorProcess(starttime_1, iImg, blob, inputNodeDims, oResult);
+        Ret = TensorProcess(stageClock, times, iImg, blob, inputNodeDims, context->buffer.resizeScales, oResult);
+#else
+        Ret = "[YOLO_V8]:FP16 models need USE_CUDA.";
 #endif
     }
+    ReleaseContext(std::move(context));
+    if (Ret == RET_OK && oTimes)
+    {
+        *oTimes = times;
+    }
+#ifdef YOLO_PRINT_TIMES
+    if (Ret == RET_OK)
+    {
+        PrintBenchmark(cudaEnable, times);
+    }
+#endif // YOLO_PRINT_TIMES
+    return Ret;
+}
 
+
+char* YOLO_V8::RunSessionBatch(std::vector<cv::Mat>& iImgs, std::vector<std::vector<DL_RESULT>>& oResults)
+{
+    YOLO_TRACE_FRAME("RunSessionBatch");
+    std::lock_guard<std::mutex> lock(batchMutex);
+    oResults.assign(iImgs.size(), std::vector<DL_RESULT>());
+    // Dynamic-batch models take all images in one run, fixed-batch models run in chunks of their batch size
+    size_t batchSize = modelBatch > 0 ? (size_t)modelBatch : iImgs.size();
+    char* Ret = RET_OK;
+    for (size_t first = 0; first < iImgs.size() && Ret == RET_OK; first += batchSize)
+    {
+        size_t count = min(batchSize, iImgs.size() - first);
+        if (!HalfModel(modelType))
+        {
+            batchBlob.resize(batchSize * 3 * imgSize.at(0) * imgSize.at(1));
+            Ret = BatchProcess(iImgs, first, count, batchSize, batchBlob.data(), oResults);
+        }
+        else
+        {
+#ifdef USE_CUDA
+            batchBlobHalf.resize(batchSize * 3 * imgSize.at(0) * imgSize.at(1));
+            Ret = BatchProcess(iImgs, first, count, batchSize, reinterpret_cast<half*>(batchBlobHalf.data()), oResults);
+#else
+            Ret = "[YOLO_V8]:FP16 models need USE_CUDA.";
+#endif
+        }
+    }
     return Ret;
 }
 
 
+char* YOLO_V8::RunSessionSliced(const cv::Mat& iImg, std::vector<DL_RESULT>& oResult,
+    const yolo::SliceOptions& options)
+{
+    YOLO_TRACE_FRAME("RunSessionSliced");
+    if (modelType != YOLO_DETECT_V8 && modelType != YOLO_DETECT_V8_HALF)
+    {
+        return "[YOLO_V8]:Sliced inference supports detection models only.";
+    }
+    std::vector<yolo::SliceRect> slices = yolo::ComputeSlices(iImg.cols, iImg.rows, options);
+    if (options.full_frame && slices.size() > 1)
+    {
+        yolo::SliceRect frame;
+        frame.width = iImg.cols;
+        frame.height = iImg.rows;
+        slices.push_back(frame);
+    }
+    std::vector<cv::Mat> tiles;
+    tiles.reserve(slices.size());
+    for (const yolo::SliceRect& slice : slices)
+    {
+        tiles.push_back(iImg(cv::Rect(slice.x, slice.y, slice.width, slice.height)));//view, the letterbox reads it in place
+    }
+    std::vector<std::vector<DL_RESULT>> tileResults;
+    char* Ret = RunSessionBatch(tiles, tileResults);
+    if (Ret != RET_OK)
+    {
+        return Ret;
+    }
+
+    thread_local std::vector<yolo::SliceBox> boxes;
+    thread_local std::vector<yolo::SliceBox> merged;
+    thread_local yolo::SliceMerger merger;
+    boxes.clear();
+    for (size_t i = 0; i < tileResults.size(); i++)
+    {
+        for (const DL_RESULT& result : tileResults[i])
+        {
+            yolo::SliceBox box;
+            box.x1 = float(result.box.x + slices[i].x);
+            box.y1 = float(result.box.y + slices[i].y);
+            box.x2 = box.x1 + result.box.width;
+            box.y2 = box.y1 + result.box.height;
+            box.score = result.confidence;
+            box.class_id = result.classId;
+            boxes.push_back(box);
+        }
+    }
+    merger.Merge(boxes, options, merged);
+    for (const yolo::SliceBox& box : merged)
+    {
+        DL_RESULT result;
+        result.classId = box.class_id;
+        result.confidence = box.score;
+        result.box = cv::Rect(int(box.x1), int(box.y1), int(box.x2 - box.x1), int(box.y2 - box.y1));
+        oResult.push_back(result);
+    }
+    return RET_OK;
+}
+
+
 template<typename N>
-char* YOLO_V8::TensorProcess(clock_t& starttime_1, cv::Mat& iImg, N& blob, std::vector<int64_t>& inputNodeDims,
-    std::vector<DL_RESULT>& oResult) {
+char* YOLO_V8::BatchProcess(std::vector<cv::Mat>& iImgs, size_t first, size_t count, size_t batchSize, N* blob,
+    std::vector<std::vector<DL_RESULT>>& oResults)
+{
+    const size_t imageSize = 3 * imgSize.at(0) * imgSize.at(1);
+    if (batchLetterbox.size() < count)
+    {
+        batchLetterbox.resize(count);
+    }
+    std::vector<float> scales(count);
+    std::vector<char*> rets(count, RET_OK);
+
+    // Letterbox every image into its slot of the batch tensor on the persistent workers
+    batchWorkers->Run(count, [&](size_t i) {
+        rets[i] = LetterboxToBlob(iImgs[first + i], KernelBlob(blob + i * imageSize), batchLetterbox[i], scales[i]);
+    });
+    for (char* ret : rets)
+    {
+        if (ret != RET_OK)
+        {
+            return ret;
+        }
+    }
+    // Fixed-batch models: unused slots of the last chunk are zero images
+    std::fill(blob + count * imageSize, blob + batchSize * imageSize, N());
+
+    std::vector<int64_t> inputNodeDims = { (int64_t)batchSize, 3, imgSize.at(0), imgSize.at(1) };
+    Ort::Value inputTensor = Ort::Value::CreateTensor<N>(
+        Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU), blob, batchSize * imageSize,
+        inputNodeDims.data(), inputNodeDims.size());
+    std::vector<Ort::Value> outputTensor;
+    {
+        YOLO_TRACE_ZONE("session->Run");
+        outputTensor = session->Run(options, inputNodeNames.data(), &inputTensor, 1, outputNodeNames.data(),
+            outputNodeNames.size());
+    }
+
+    auto tensor_info = outputTensor.front().GetTensorTypeAndShapeInfo();
+    std::vector<int64_t> outputNodeDims = tensor_info.GetShape();
+    cv::Mat rawData = OutputToFloat(outputTensor.front().GetTensorMutableData<N>(), tensor_info.GetElementCount());
+    const size_t outputSize = tensor_info.GetElementCount() / outputNodeDims[0];
+    cv::Mat protoData;
+    size_t protoSize = 0;
+    if (SegModel(modelType))
+    {
+        size_t elements = outputTensor[1].GetTensorTypeAndShapeInfo().GetElementCount();
+        protoData = OutputToFloat(outputTensor[1].GetTensorMutableData<N>(), elements);
+        protoSize = elements / batchSize;
+    }
+
+    // Decode every image in parallel, each with its own letterbox scale; the workers keep their decode scratch
+    float* output = (float*)rawData.data;
+    const float* protos = (const float*)protoData.data;
+    batchWorkers->Run(count, [&](size_t i) {
+        rets[i] = DecodeOutput(output + i * outputSize, outputNodeDims, scales[i], oResults[first + i],
+            protos ? protos + i * protoSize : nullptr, iImgs[first + i].size());
+    });
+    for (char* ret : rets)
+    {
+        if (ret != RET_OK)
+        {
+            return ret;
+        }
+    }
+    return RET_OK;
+}
+
+
+template<typename N>
+char* YOLO_V8::TensorProcess(yolo::StageClock& stageClock, yolo::StageTimes& times, const cv::Mat& iImg, N& blob,
+    std::vector<int64_t>& inputNodeDims, float scale, std::vector<DL_RESULT>& oResult) const {
     Ort::Value inputTensor = Ort::Value::CreateTensor<typename std::remove_pointer<N>::type>(
         Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU), blob, 3 * imgSize.at(0) * imgSize.at(1),
         inputNodeDims.data(), inputNodeDims.size());
-#ifdef benchmark
-    clock_t starttime_2 = clock();
-#endif // benchmark
-    auto outputTensor = session->Run(options, inputNodeNames.data(), &inputTensor, 1, outputNodeNames.data(),
-        outputNodeNames.size());
-#ifdef benchmark
-    clock_t starttime_3 = clock();
-#endif // benchmark
+    times.preprocess_ms = stageClock.Lap();
+    std::vector<Ort::Value> outputTensor;
+    {
+        YOLO_TRACE_ZONE("session->Run");
+        outputTensor = session->Run(options, inputNodeNames.data(), &inputTensor, 1, outputNodeNames.data(),
+            outputNodeNames.size());
+    }
+    times.inference_ms = stageClock.Lap();
 
     Ort::TypeInfo typeInfo = outputTensor.front().GetTypeInfo();
     auto tensor_info = typeInfo.GetTensorTypeAndShapeInfo();
     std::vector<int64_t> outputNodeDims = tensor_info.GetShape();
     auto output = outputTensor.front().GetTensorMutableData<typename std::remove_pointer<N>::type>();
-    delete[] blob;
+    cv::Mat rawData = OutputToFloat(output, tensor_info.GetElementCount());
+    cv::Mat protoData;
+    if (SegModel(modelType))
+    {
+        protoData = OutputToFloat(outputTensor[1].GetTensorMutableData<typename std::remove_pointer<N>::type>(),
+            outputTensor[1].GetTensorTypeAndShapeInfo().GetElementCount());
+    }
+    char* Ret = DecodeOutput((float*)rawData.data, outputNodeDims, scale, oResult,
+        (const float*)protoData.data, iImg.size());
+    times.postprocess_ms = stageClock.Lap();
+    return Ret;
+
+}
+
+
+char* YOLO_V8::BindContext(RunContext& context) const
+{
+    const int64_t inputNodeDims[4] = { 1, 3, imgSize.at(0), imgSize.at(1) };
+    const size_t inputCount = 3 * imgSize.at(0) * imgSize.at(1);
+    DL_STAGE_BUFFER& buffer = context.buffer;
+    Ort::MemoryInfo memoryInfo = Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU);
+    Ort::Value inputTensor{ nullptr };
+    Ort::Value outputTensor{ nullptr };
+    Ort::Value protoTensor{ nullptr };
+    // Sized once here, the letterbox and ORT write into the same memory on every run
+    buffer.output.assign(outputCount, 0.0f);
+    buffer.proto.assign(protoCount, 0.0f);
+    if (!HalfModel(modelType))
+    {
+        buffer.blob.resize(inputCount);
+        inputTensor = Ort::Value::CreateTensor(memoryInfo, buffer.blob.data(), inputCount * sizeof(float),
+            inputNodeDims, 4, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT);
+        outputTensor = Ort::Value::CreateTensor(memoryInfo, buffer.output.data(), outputCount * sizeof(float),
+            outputNodeDims.data(), outputNodeDims.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT);
+        if (protoCount > 0)
+        {
+            protoTensor = Ort::Value::CreateTensor(memoryInfo, buffer.proto.data(), protoCount * sizeof(float),
+                protoNodeDims.data(), protoNodeDims.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT);
+        }
+    }
+    else
+    {
+        buffer.blobHalf.resize(inputCount);
+        buffer.outputHalf.assign(outputCount, 0);
+        inputTensor = Ort::Value::CreateTensor(memoryInfo, buffer.blobHalf.data(), inputCount * sizeof(uint16_t),
+            inputNodeDims, 4, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16);
+        outputTensor = Ort::Value::CreateTensor(memoryInfo, buffer.outputHalf.data(), outputCount * sizeof(uint16_t),
+            outputNodeDims.data(), outputNodeDims.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16);
+        if (protoCount > 0)
+        {
+            buffer.protoHalf.assign(protoCount, 0);
+            protoTensor = Ort::Value::CreateTensor(memoryInfo, buffer.protoHalf.data(), protoCount * sizeof(uint16_t),
+                protoNodeDims.data(), protoNodeDims.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16);
+        }
+    }
+    delete context.binding;
+    context.binding = new Ort::IoBinding(*session);
+    context.binding->BindInput(inputNodeNames[0], inputTensor);
+    context.binding->BindOutput(outputNodeNames[0], outputTensor);
+    if (protoCount > 0)
+    {
+        context.binding->BindOutput(outputNodeNames[1], protoTensor);
+    }
+    return RET_OK;
+}
+
+
+// RunSession through the context's bound tensors: the letterbox already wrote the input, ORT writes straight into
+// the context's output, no tensor or output allocation per frame
+char* YOLO_V8::BoundProcess(yolo::StageClock& stageClock, yolo::StageTimes& times, RunContext& context,
+    std::vector<DL_RESULT>& oResult) const
+{
+    if (context.binding == nullptr)
+    {
+        BindContext(context);
+    }
+    times.preprocess_ms = stageClock.Lap();
+    {
+        YOLO_TRACE_ZONE("session->Run");
+        session->Run(options, *context.binding);
+    }
+    times.inference_ms = stageClock.Lap();
+    char* Ret = PostProcessStage(context.buffer, oResult);
+    times.postprocess_ms = stageClock.Lap();
+    return Ret;
+}
+
+
+char* YOLO_V8::DecodeOutput(float* output, const std::vector<int64_t>& outputNodeDims, float scale,
+    std::vector<DL_RESULT>& oResult, const float* protos, cv::Size imageSize) const
+{
     switch (modelType)
     {
     case YOLO_DETECT_V8:
     case YOLO_DETECT_V8_HALF:
+    case YOLO_POSE:
+    case YOLO_POSE_V8_HALF:
+    case YOLO_SEG:
+    case YOLO_SEG_HALF:
+    case YOLO_OBB:
+    case YOLO_OBB_HALF:
     {
-        int signalResultNum = outputNodeDims[1];//84
+        int signalResultNum = outputNodeDims[1];//84, 56 for pose, 116 for seg, 20 for obb (DOTA)
         int strideNum = outputNodeDims[2];//8400
-        std::vector<int> class_ids;
-        std::vector<float> confidences;
-        std::vector<cv::Rect> boxes;
-        cv::Mat rawData;
-        if (modelType == YOLO_DETECT_V8)
+        bool pose = modelType == YOLO_POSE || modelType == YOLO_POSE_V8_HALF;
+        bool seg = SegModel(modelType);
+        bool obb = modelType == YOLO_OBB || modelType == YOLO_OBB_HALF;
+        if (seg && (protos == nullptr || protoNodeDims.size() != 4))
         {
-            // FP32
-            rawData = cv::Mat(signalResultNum, strideNum, CV_32F, output);
+            return "[YOLO_V8]:Segmentation models need the mask prototype output.";
         }
-        else
+        // Pose rows: box, class scores, then x, y, visibility of every keypoint
+        // Seg rows: box, class scores, then one coefficient per prototype
+        // Obb rows: box, class scores, then the angle in radians
+        int maskNum = seg ? (int)protoNodeDims[1] : 0;//32
+        int classNum = pose ? signalResultNum - 4 - 3 * keyPointsNum
+            : (classes.empty() ? signalResultNum - 4 - maskNum - (obb ? 1 : 0) : (int)classes.size());
+        if (classNum < 1)
         {
-            // FP16
-            rawData = cv::Mat(signalResultNum, strideNum, CV_16F, output);
-            rawData.convertTo(rawData, CV_32F);
+            return "[YOLO_V8]:Output shape does not match the model type.";
         }
+        // Scratch kept per thread and reused, steady-state decoding does not reallocate it
+        thread_local yolo::HeadCandidates candidates;
+        thread_local std::vector<int> class_ids;
+        thread_local std::vector<float> confidences;
+        thread_local std::vector<cv::Rect> boxes;
+        thread_local std::vector<int> nmsResult;
+        thread_local yolo::NonMaxSuppression nms;
+        thread_local yolo::MaskDecoder maskDecoder;
+        thread_local std::vector<yolo::RotatedBox> rotatedBoxes;
+        thread_local yolo::RotatedNonMaxSuppression rotatedNms;
+        class_ids.clear();
+        confidences.clear();
+        boxes.clear();
         // Note:
         // ultralytics add transpose operator to the output of yolov8 model.which make yolov8/v5/v7 has same shape
         // https://github.com/ultralytics/assets/releases/download/v8.3.0/yolov8n.pt
-        rawData = rawData.t();
-
-        float* data = (float*)rawData.data;
-
-        for (int i = 0; i < strideNum; ++i)
+        // The head is decoded in that channel-major layout, only anchors above the threshold are read further
+        yolo::DecodeHead(output, strideNum, 4, classNum, rectConfidenceThreshold, candidates);
+        for (size_t i = 0; i < candidates.count; ++i)
         {
-            float* classesScores = data + 4;
-            cv::Mat scores(1, this->classes.size(), CV_32FC1, classesScores);
-            cv::Point class_id;
-            double maxClassScore;
-            cv::minMaxLoc(scores, 0, &maxClassScore, 0, &class_id);
-            if (maxClassScore > rectConfidenceThreshold)
-            {
-                confidences.push_back(maxClassScore);
-                class_ids.push_back(class_id.x);
-                float x = data[0];
-                float y = data[1];
-                float w = data[2];
-                float h = data[3];
+            confidences.push_back(candidates.score[i]);
+            class_ids.push_back(candidates.class_id[i]);
+            float x = candidates.box[4 * i];
+            float y = candidates.box[4 * i + 1];
+            float w = candidates.box[4 * i + 2];
+            float h = candidates.box[4 * i + 3];
 
-                int left = int((x - 0.5 * w) * resizeScales);
-                int top = int((y - 0.5 * h) * resizeScales);
+            int left = int((x - 0.5 * w) * scale);
+            int top = int((y - 0.5 * h) * scale);
 
-                int width = int(w * resizeScales);
-                int height = int(h * resizeScales);
+            int width = int(w * scale);
+            int height = int(h * scale);
 
-                boxes.push_back(cv::Rect(left, top, width, height));
+            boxes.push_back(cv::Rect(left, top, width, height));
+        }
+        if (obb)
+        {
+            // Rotated boxes in frame coordinates, suppressed by probiou
+            const float* angle = output + (size_t)(signalResultNum - 1) * strideNum;
+            rotatedBoxes.clear();
+            for (size_t i = 0; i < candidates.count; ++i)
+            {
+                const float* box = &candidates.box[4 * i];
+                rotatedBoxes.push_back(yolo::RegularizeRotatedBox(
+                    { box[0] * scale, box[1] * scale, box[2] * scale, box[3] * scale, angle[candidates.anchor[i]] }));
             }
-            data += signalResultNum;
+            rotatedNms.Run(rotatedBoxes.data(), confidences.data(), class_ids.data(), candidates.count, nmsOptions,
+                nmsResult);
+        }
+        else
+        {
+            nms.RunRects(boxes, confidences, class_ids, nmsOptions, nmsResult);
+        }
+        yolo::MaskGeometry geometry;
+        if (seg)
+        {
+            geometry.proto_height = (int)protoNodeDims[2];
+            geometry.proto_width = (int)protoNodeDims[3];
+            geometry.input_height = imgSize.at(0);
+            geometry.input_width = imgSize.at(1);
+            geometry.scale = scale;
+            // Without the frame size masks are clipped to the letterboxed input
+            geometry.image_width = imageSize.empty() ? int(imgSize.at(1) * scale) : imageSize.width;
+            geometry.image_height = imageSize.empty() ? int(imgSize.at(0) * scale) : imageSize.height;
         }
-        std::vector<int> nmsResult;
-        cv::dnn::NMSBoxes(boxes, confidences, rectConfidenceThreshold, iouThreshold, nmsResult);
         for (int i = 0; i < nmsResult.size(); ++i)
         {
             int idx = nmsResult[i];
@@ -280,45 +825,48 @@ char* YOLO_V8::TensorProcess(clock_t& starttime_1, cv::Mat& iImg, N& blob, std::
             result.classId = class_ids[idx];
             result.confidence = confidences[idx];
             result.box = boxes[idx];
-            oResult.push_back(result);
-        }
-
-#ifdef benchmark
-        clock_t starttime_4 = clock();
-        double pre_process_time = (double)(starttime_2 - starttime_1) / CLOCKS_PER_SEC * 1000;
-        double process_time = (double)(starttime_3 - starttime_2) / CLOCKS_PER_SEC * 1000;
-        double post_process_time = (double)(starttime_4 - starttime_3) / CLOCKS_PER_SEC * 1000;
-        if (cudaEnable)
-        {
-            std::cout << "[YOLO_V8(CUDA)]: " << pre_process_time << "ms pre-process, " << process_time << "ms inference, " << post_process_time << "ms post-process." << std::endl;
-        }
-        else
-        {
-            std::cout << "[YOLO_V8(CPU)]: " << pre_process_time << "ms pre-process, " << process_time << "ms inference, " << post_process_time << "ms post-process." << std::endl;
+            if (obb)
+            {
+                const yolo::RotatedBox& rotated = rotatedBoxes[idx];
+                result.rotatedBox = cv::RotatedRect(cv::Point2f(rotated.cx, rotated.cy),
+                    cv::Size2f(rotated.width, rotated.height), rotated.angle * 180.0f / (float)CV_PI);
+                result.box = result.rotatedBox.boundingRect();
+            }
+            if (pose)
+            {
+                // Keypoints of kept boxes only, read from the anchor's column and mapped back like the box
+                const float* keyPoint = output + (size_t)(4 + classNum) * strideNum + candidates.anchor[idx];
+                result.keyPointsNum = keyPointsNum;
+                for (int k = 0; k < keyPointsNum; k++)
+                {
+                    result.keyPoints[k].x = keyPoint[(size_t)(3 * k) * strideNum] * scale;
+                    result.keyPoints[k].y = keyPoint[(size_t)(3 * k + 1) * strideNum] * scale;
+                    result.keyPoints[k].visibility = keyPoint[(size_t)(3 * k + 2) * strideNum];
+                }
+            }
+            if (seg)
+            {
+                // Masks of kept boxes only: the product, upsample and threshold stay inside the box
+                const float* box = &candidates.box[4 * idx];
+                const float* coefficients = output + (size_t)(signalResultNum - maskNum) * strideNum +
+                    candidates.anchor[idx];
+                maskDecoder.Decode(coefficients, strideNum, protos, maskNum, geometry, (box[0] - 0.5f * box[2]) * scale,
+                    (box[1] - 0.5f * box[3]) * scale, (box[0] + 0.5f * box[2]) * scale,
+                    (box[1] + 0.5f * box[3]) * scale, maskThreshold, result.mask);
+            }
+            oResult.push_back(std::move(result));
         }
-#endif // benchmark
-
         break;
     }
     case YOLO_CLS:
     case YOLO_CLS_HALF:
     {
-        cv::Mat rawData;
-        if (modelType == YOLO_CLS) {
-            // FP32
-            rawData = cv::Mat(1, this->classes.size(), CV_32F, output);
-        } else {
-            // FP16
-            rawData = cv::Mat(1, this->classes.size(), CV_16F, output);
-            rawData.convertTo(rawData, CV_32F);
-        }
-        float *data = (float *) rawData.data;
-
+        int classNum = classes.empty() ? (int)outputNodeDims[1] : (int)classes.size();
         DL_RESULT result;
-        for (int i = 0; i < this->classes.size(); i++)
+        for (int i = 0; i < classNum; i++)
         {
             result.classId = i;
-            result.confidence = data[i];
+            result.confidence = output[i];
             oResult.push_back(result);
         }
         break;
@@ -327,49 +875,199 @@ char* YOLO_V8::TensorProcess(clock_t& starttime_1, cv::Mat& iImg, N& blob, std::
         std::cout << "[YOLO_V8]: " << "Not support model type." << std::endl;
     }
     return RET_OK;
+}
+
 
+char* YOLO_V8::PreProcessStage(const cv::Mat& iImg, DL_STAGE_BUFFER& buffer) const
+{
+    YOLO_TRACE_ZONE("PreProcess");
+    const size_t inputCount = 3 * imgSize.at(0) * imgSize.at(1);
+    buffer.imageSize = iImg.size();
+    if (!HalfModel(modelType))
+    {
+        buffer.blob.resize(inputCount);
+        return LetterboxToBlob(iImg, buffer.blob.data(), buffer.letterbox, buffer.resizeScales);
+    }
+    buffer.blobHalf.resize(inputCount);
+    return LetterboxToBlob(iImg, buffer.blobHalf.data(), buffer.letterbox, buffer.resizeScales);
 }
 
 
-char* YOLO_V8::WarmUpSession() {
-    clock_t starttime_1 = clock();
-    cv::Mat iImg = cv::Mat(cv::Size(imgSize.at(0), imgSize.at(1)), CV_8UC3);
-    cv::Mat processedImg;
-    PreProcess(iImg, imgSize, processedImg);
-    if (modelType < 4)
-    {
-        float* blob = new float[iImg.total() * 3];
-        BlobFromImage(processedImg, blob);
-        std::vector<int64_t> YOLO_input_node_dims = { 1, 3, imgSize.at(0), imgSize.at(1) };
-        Ort::Value input_tensor = Ort::Value::CreateTensor<float>(
-            Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU), blob, 3 * imgSize.at(0) * imgSize.at(1),
-            YOLO_input_node_dims.data(), YOLO_input_node_dims.size());
-        auto output_tensors = session->Run(options, inputNodeNames.data(), &input_tensor, 1, outputNodeNames.data(),
-            outputNodeNames.size());
-        delete[] blob;
-        clock_t starttime_4 = clock();
-        double post_process_time = (double)(starttime_4 - starttime_1) / CLOCKS_PER_SEC * 1000;
-        if (cudaEnable)
+char* YOLO_V8::InferStage(DL_STAGE_BUFFER& buffer) const
+{
+    // Tensors wrap the caller's buffers, ORT writes the output in place
+    const int64_t inputNodeDims[4] = { 1, 3, imgSize.at(0), imgSize.at(1) };
+    const size_t inputCount = 3 * imgSize.at(0) * imgSize.at(1);
+    Ort::MemoryInfo memoryInfo = Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU);
+    Ort::Value input{ nullptr };
+    Ort::Value output[2] = { Ort::Value{ nullptr }, Ort::Value{ nullptr } };
+    const size_t outputNum = protoCount > 0 ? 2 : 1;//head, prototypes of segmentation models
+    if (!HalfModel(modelType))
+    {
+        buffer.output.resize(outputCount);
+        buffer.proto.resize(protoCount);
+        input = Ort::Value::CreateTensor(memoryInfo, buffer.blob.data(), inputCount * sizeof(float), inputNodeDims, 4,
+            ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT);
+        output[0] = Ort::Value::CreateTensor(memoryInfo, buffer.output.data(), outputCount * sizeof(float),
+            outputNodeDims.data(), outputNodeDims.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT);
+        if (protoCount > 0)
         {
-            std::cout << "[YOLO_V8(CUDA)]: " << "Cuda warm-up cost " << post_process_time << " ms. " << std::endl;
+            output[1] = Ort::Value::CreateTensor(memoryInfo, buffer.proto.data(), protoCount * sizeof(float),
+                protoNodeDims.data(), protoNodeDims.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT);
         }
     }
     else
     {
-#ifdef USE_CUDA
-        half* blob = new half[iImg.total() * 3];
-        BlobFromImage(processedImg, blob);
-        std::vector<int64_t> YOLO_input_node_dims = { 1,3,imgSize.at(0),imgSize.at(1) };
-        Ort::Value input_tensor = Ort::Value::CreateTensor<half>(Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU), blob, 3 * imgSize.at(0) * imgSize.at(1), YOLO_input_node_dims.data(), YOLO_input_node_dims.size());
-        auto output_tensors = session->Run(options, inputNodeNames.data(), &input_tensor, 1, outputNodeNames.data(), outputNodeNames.size());
-        delete[] blob;
-        clock_t starttime_4 = clock();
-        double post_process_time = (double)(starttime_4 - starttime_1) / CLOCKS_PER_SEC * 1000;
-        if (cudaEnable)
-        {
-            std::cout << "[YOLO_V8(CUDA)]: " << "Cuda warm-up cost " << post_process_time << " ms. " << std::endl;
+        buffer.outputHalf.resize(outputCount);
+        buffer.protoHalf.resize(protoCount);
+        input = Ort::Value::CreateTensor(memoryInfo, buffer.blobHalf.data(), inputCount * sizeof(uint16_t),
+            inputNodeDims, 4, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16);
+        output[0] = Ort::Value::CreateTensor(memoryInfo, buffer.outputHalf.data(), outputCount * sizeof(uint16_t),
+            outputNodeDims.data(), outputNodeDims.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16);
+        if (protoCount > 0)
+        {
+            output[1] = Ort::Value::CreateTensor(memoryInfo, buffer.protoHalf.data(), protoCount * sizeof(uint16_t),
+                protoNodeDims.data(), protoNodeDims.size(), ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16);
         }
-#endif
+    }
+    YOLO_TRACE_ZONE("session->Run");
+    session->Run(options, inputNodeNames.data(), &input, 1, outputNodeNames.data(), output, outputNum);
+    return RET_OK;
+}
+
+
+char* YOLO_V8::PostProcessStage(DL_STAGE_BUFFER& buffer, std::vector<DL_RESULT>& oResult) const
+{
+    if (HalfModel(modelType))
+    {
+        buffer.output.resize(outputCount);
+        cv::Mat output(1, (int)outputCount, CV_32F, buffer.output.data());
+        cv::Mat(1, (int)outputCount, CV_16F, buffer.outputHalf.data()).convertTo(output, CV_32F);
+        if (protoCount > 0)
+        {
+            buffer.proto.resize(protoCount);
+            cv::Mat protos(1, (int)protoCount, CV_32F, buffer.proto.data());
+            cv::Mat(1, (int)protoCount, CV_16F, buffer.protoHalf.data()).convertTo(protos, CV_32F);
+        }
+    }
+    return DecodeOutput(buffer.output.data(), outputNodeDims, buffer.resizeScales, oResult,
+        protoCount > 0 ? buffer.proto.data() : nullptr, buffer.imageSize);
+}
+
+
+char* YOLO_V8::ReadOutputShapes(std::vector<Ort::Value>& outputs)
+{
+    outputNodeDims = outputs.front().GetTensorTypeAndShapeInfo().GetShape();
+    outputCount = outputs.front().GetTensorTypeAndShapeInfo().GetElementCount();
+    protoNodeDims.clear();
+    protoCount = 0;
+    if (SegModel(modelType))
+    {
+        if (outputs.size() < 2 || outputs[1].GetTensorTypeAndShapeInfo().GetShape().size() != 4)
+        {
+            return "[YOLO_V8]:Segmentation model has no mask prototype output.";
+        }
+        protoNodeDims = outputs[1].GetTensorTypeAndShapeInfo().GetShape();
+        protoCount = outputs[1].GetTensorTypeAndShapeInfo().GetElementCount();
     }
     return RET_OK;
 }
+
+
+char* YOLO_V8::WarmUpSession() {
+    yolo::StageClock warmUpClock;
+    cv::Mat iImg = cv::Mat(cv::Size(imgSize.at(1), imgSize.at(0)), CV_8UC3);
+    std::unique_ptr<RunContext> context = AcquireContext();
+    DL_STAGE_BUFFER& buffer = context->buffer;
+    PreProcessStage(iImg, buffer);
+    const int64_t inputNodeDims[4] = { 1, 3, imgSize.at(0), imgSize.at(1) };
+    const size_t inputCount = 3 * imgSize.at(0) * imgSize.at(1);
+    Ort::MemoryInfo memoryInfo = Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU);
+    Ort::Value input_tensor = !HalfModel(modelType)
+        ? Ort::Value::CreateTensor(memoryInfo, buffer.blob.data(), inputCount * sizeof(float), inputNodeDims, 4,
+            ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT)
+        : Ort::Value::CreateTensor(memoryInfo, buffer.blobHalf.data(), inputCount * sizeof(uint16_t), inputNodeDims, 4,
+            ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16);
+    auto output_tensors = session->Run(options, inputNodeNames.data(), &input_tensor, 1, outputNodeNames.data(),
+        outputNodeNames.size());
+    char* Ret = ReadOutputShapes(output_tensors);
+    if (Ret != RET_OK)
+    {
+        return Ret;
+    }
+    if (ioBinding)
+    {
+        BindContext(*context);
+        session->Run(options, *context->binding);
+    }
+    ReleaseContext(std::move(context));//the first RunSession reuses it
+    double warmUpTime = warmUpClock.Lap();
+    if (cudaEnable)
+    {
+        std::cout << "[YOLO_V8(CUDA)]: " << "Cuda warm-up cost " << warmUpTime << " ms. " << std::endl;
+    }
+    return RET_OK;
+}
+
+
+YOLO_SESSION_POOL::YOLO_SESSION_POOL(int intraOpNumThreads, int interOpNumThreads)
+    : runtime(std::make_shared<DL_SHARED_RUNTIME>())
+{
+    Ort::ThreadingOptions threadingOptions;
+    threadingOptions.SetGlobalIntraOpNumThreads(intraOpNumThreads);
+    threadingOptions.SetGlobalInterOpNumThreads(interOpNumThreads);
+    runtime->env = Ort::Env(threadingOptions, ORT_LOGGING_LEVEL_WARNING, "YoloPool");
+}
+
+
+char* YOLO_SESSION_POOL::Lease(DL_INIT_PARAM& iParams, std::shared_ptr<YOLO_V8>& oDetector, bool exclusive)
+{
+    // Everything CreateSession reads except intraOpNumThreads, which the global thread pool replaces
+    std::string key = iParams.modelPath + "|" + std::to_string(iParams.modelType) + "|" +
+        std::to_string(iParams.imgSize.at(0)) + "x" + std::to_string(iParams.imgSize.at(1)) + "|" +
+        std::to_string(iParams.rectConfidenceThreshold) + "|" + std::to_string(iParams.iouThreshold) + "|" +
+        std::to_string(iParams.keyPointsNum) + "|" + std::to_string(iParams.cudaEnable) + "|" +
+        std::to_string(iParams.logSeverityLevel) + "|" + std::to_string(iParams.preProcessThreads) + "|" +
+        std::to_string(iParams.ioBinding) + "|" + std::to_string(iParams.agnosticNms) + "|" +
+        std::to_string(iParams.maxDet) + "|" + std::to_string(iParams.maskThreshold) + "|" + iParams.cacheDir;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (exclusive)
+    {
+        key += "#" + std::to_string(exclusiveCount++);
+    }
+    oDetector = detectors[key].lock();
+    if (oDetector)
+    {
+        return RET_OK;
+    }
+    std::shared_ptr<YOLO_V8> detector = std::make_shared<YOLO_V8>();
+    char* Ret = detector->CreateSession(iParams, runtime);
+    if (Ret != RET_OK)
+    {
+        detectors.erase(key);
+        return Ret;
+    }
+    detectors[key] = detector;
+    oDetector = detector;
+    return RET_OK;
+}
+
+
+size_t YOLO_SESSION_POOL::SessionCount()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = 0;
+    for (auto it = detectors.begin(); it != detectors.end();)
+    {
+        if (it->second.expired())
+        {
+            it = detectors.erase(it);
+        }
+        else
+        {
+            count++;
+            ++it;
+        }
+    }
+    return count;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #define    RET_OK nullptr
+#define    DL_MAX_KEYPOINTS 32
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -11,8 +12,22 @@
 #include <string>
 #include <vector>
 #include <cstdio>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <opencv2/opencv.hpp>
 #include "onnxruntime_cxx_api.h"
+#include "letterbox_kernel.h"
+#include "head_decoder.h"
+#include "nms.h"
+#include "mask_decoder.h"
+#include "rotated_nms.h"
+#include "slicing.h"
+#include "model_cache.h"
+#include "stage_times.h"
+#include "trace.h"
+#include "worker_pool.h"
 
 #ifdef USE_CUDA
 #include <cuda_fp16.h>
@@ -21,7 +36,7 @@
 
 enum MODEL_TYPE
 {
-    //FLOAT32 MODEL
+    //FLOAT32 MODEL (also INT8 QDQ/QOperator models, their inputs and outputs stay FP32)
     YOLO_DETECT_V8 = 1,
     YOLO_POSE = 2,
     YOLO_CLS = 3,
@@ -29,7 +44,15 @@ enum MODEL_TYPE
     //FLOAT16 MODEL
     YOLO_DETECT_V8_HALF = 4,
     YOLO_POSE_V8_HALF = 5,
-    YOLO_CLS_HALF = 6
+    YOLO_CLS_HALF = 6,
+
+    //SEGMENTATION MODEL (second output: mask prototypes)
+    YOLO_SEG = 7,
+    YOLO_SEG_HALF = 8,
+
+    //ORIENTED BOX MODEL (angle row after the class scores)
+    YOLO_OBB = 9,
+    YOLO_OBB_HALF = 10
 };
 
 
@@ -40,22 +63,63 @@ typedef struct _DL_INIT_PARAM
     std::vector<int> imgSize = { 640, 640 };
     float rectConfidenceThreshold = 0.6;
     float iouThreshold = 0.5;
-    int	keyPointsNum = 2;//Note:kpt number for pose
+    int	keyPointsNum = 17;//Note:kpt number for pose (x, y, visibility each), at most DL_MAX_KEYPOINTS
     bool cudaEnable = false;
     int logSeverityLevel = 3;
     int intraOpNumThreads = 1;
+    int preProcessThreads = 1;//Note:rows of the fused letterbox kernel split across threads
+    bool ioBinding = true;//Note:bind persistent input/output tensors once, false creates them on every run
+    bool agnosticNms = true;//Note:suppress across classes, false keeps each class apart (ultralytics default)
+    int maxDet = 300;//Note:at most this many detections per image, <= 0 for no limit
+    float maskThreshold = 0.5;//Note:mask probability threshold for segmentation models
+    std::string cacheDir;//Note:keeps the optimized model here, later starts map it instead of optimizing, empty for none
 } DL_INIT_PARAM;
 
 
+typedef struct _DL_KEYPOINT
+{
+    float x;
+    float y;
+    float visibility;//Note:keypoint confidence from the model, 0..1
+} DL_KEYPOINT;
+
+
 typedef struct _DL_RESULT
 {
     int classId;
     float confidence;
-    cv::Rect box;
-    std::vector<cv::Point2f> keyPoints;
+    cv::Rect box;//Note:for OBB models the bounding rectangle of rotatedBox
+    cv::RotatedRect rotatedBox;//Note:OBB models only, angle in degrees
+    int keyPointsNum = 0;
+    DL_KEYPOINT keyPoints[DL_MAX_KEYPOINTS];//Note:first keyPointsNum are valid, stored inline so results allocate nothing
+    yolo::MaskRle mask;//Note:segmentation models only, runs over mask.x/y/width/height (box clipped to the image)
 } DL_RESULT;
 
 
+// Per-frame buffers of the stage API, owned by the caller so stages of different frames can overlap
+typedef struct _DL_STAGE_BUFFER
+{
+    std::vector<float> blob;
+    std::vector<uint16_t> blobHalf;
+    std::vector<float> output;
+    std::vector<uint16_t> outputHalf;
+    std::vector<float> proto;//mask prototypes of segmentation models
+    std::vector<uint16_t> protoHalf;
+    yolo::LetterboxKernel letterbox;
+    float resizeScales = 1.0f;
+    cv::Size imageSize;
+} DL_STAGE_BUFFER;
+
+
+// ORT state shared by the sessions of a YOLO_SESSION_POOL: one Env whose global thread pools replace the per-session
+// ones, and the container the CPU kernels prepack weights into, filled once per distinct weight
+typedef struct _DL_SHARED_RUNTIME
+{
+    Ort::Env env{ nullptr };
+    Ort::PrepackedWeightsContainer prepackedWeights;
+} DL_SHARED_RUNTIME;
+
+
 class YOLO_V8
 {
 public:
@@ -66,23 +130,61 @@ public:
 public:
     char* CreateSession(DL_INIT_PARAM& iParams);
 
-    char* RunSession(cv::Mat& iImg, std::vector<DL_RESULT>& oResult);
+    // Session on a shared runtime (YOLO_SESSION_POOL): the runtime's Env and prepacked weights, no threads of its
+    // own (intraOpNumThreads is ignored). Keeps the runtime alive as long as the session.
+    char* CreateSession(DL_INIT_PARAM& iParams, std::shared_ptr<DL_SHARED_RUNTIME> sharedRuntime);
+
+    // Re-entrant: any number of threads may call RunSession on one instance, sharing the session and its weights.
+    // Each call takes its own context (letterbox, input, outputs and their IoBinding) from a pool.
+    // oTimes, if given, gets the wall-clock time of each stage of this call.
+    char* RunSession(const cv::Mat& iImg, std::vector<DL_RESULT>& oResult, yolo::StageTimes* oTimes = nullptr) const;
+
+    // Several frames in one run for dynamic-batch models (fixed-batch models run in chunks of their batch size).
+    // Each frame keeps its own letterbox scale. Frames are letterboxed and decoded in parallel on worker threads
+    // started once by CreateSession, so their decode scratch is reused across calls. oResults[i] belongs to iImgs[i].
+    // Batch calls on one instance run one at a time, alongside any RunSession calls.
+    char* RunSessionBatch(std::vector<cv::Mat>& iImgs, std::vector<std::vector<DL_RESULT>>& oResults);
+
+    // Sliced (SAHI) inference of detection models on large frames (YOLOv8-CPP-Common/slicing.h): the overlapping
+    // tiles, plus the whole frame with options.full_frame, go through RunSessionBatch as views of iImg, so they are
+    // letterboxed in parallel and take one session run on dynamic-batch models. Boxes are moved to frame
+    // coordinates and merged across tiles.
+    char* RunSessionSliced(const cv::Mat& iImg, std::vector<DL_RESULT>& oResult, const yolo::SliceOptions& options);
 
     char* WarmUpSession();
 
+    // RunSession split into stages for pipelined execution (YOLOv8-CPP-Common/pipeline.h). Any stage may run
+    // concurrently with any other on different buffers, InferStage is one session run per call.
+    char* PreProcessStage(const cv::Mat& iImg, DL_STAGE_BUFFER& buffer) const;
+
+    char* InferStage(DL_STAGE_BUFFER& buffer) const;
+
+    char* PostProcessStage(DL_STAGE_BUFFER& buffer, std::vector<DL_RESULT>& oResult) const;
+
     template<typename N>
-    char* TensorProcess(clock_t& starttime_1, cv::Mat& iImg, N& blob, std::vector<int64_t>& inputNodeDims,
-        std::vector<DL_RESULT>& oResult);
+    char* TensorProcess(yolo::StageClock& stageClock, yolo::StageTimes& times, const cv::Mat& iImg, N& blob,
+        std::vector<int64_t>& inputNodeDims, float scale, std::vector<DL_RESULT>& oResult) const;
 
-    char* PreProcess(cv::Mat& iImg, std::vector<int> iImgSize, cv::Mat& oImg);
+    char* PreProcess(cv::Mat& iImg, std::vector<int> iImgSize, cv::Mat& oImg) const;
+
+    // Fused letterbox/center-crop + BGR2RGB + normalize + HWC2CHW straight into the input blob
+    template<typename T>
+    char* LetterboxToBlob(const cv::Mat& iImg, T* blob, yolo::LetterboxKernel& kernel, float& scale) const;
+
+    // Decodes one image's FP32 output; outputNodeDims is the full output shape (batch first). Segmentation models
+    // also need the image's mask prototypes and the frame size the masks are clipped to.
+    char* DecodeOutput(float* output, const std::vector<int64_t>& outputNodeDims, float scale,
+        std::vector<DL_RESULT>& oResult, const float* protos = nullptr, cv::Size imageSize = cv::Size()) const;
 
     std::vector<std::string> classes{};
 
 private:
     Ort::Env env;
-    Ort::Session* session;
+    std::shared_ptr<DL_SHARED_RUNTIME> runtime;//set for pooled sessions, outlives session
+    yolo::MappedFile cachedModel;//optimized model the session uses in place, outlives session
+    Ort::Session* session = nullptr;
     bool cudaEnable;
-    Ort::RunOptions options;
+    Ort::RunOptions options;//default options, only read by Run so concurrent calls share them
     std::vector<const char*> inputNodeNames;
     std::vector<const char*> outputNodeNames;
 
@@ -90,5 +192,91 @@ private:
     std::vector<int> imgSize;
     float rectConfidenceThreshold;
     float iouThreshold;
-    float resizeScales;//letterbox scale
+    int keyPointsNum;
+    float maskThreshold;
+    yolo::NmsOptions nmsOptions;
+    int preProcessThreads;
+
+    // Per-call state of RunSession. The buffer holds the letterbox scratch, the input blob and the outputs,
+    // the binding (ioBinding only) points ORT at them, so a context runs with no allocation once bound.
+    struct RunContext
+    {
+        DL_STAGE_BUFFER buffer;
+        Ort::IoBinding* binding = nullptr;
+
+        ~RunContext() { delete binding; }
+    };
+
+    // Idle contexts; a call takes one or creates it, and gives it back when done. A context lost to an exception
+    // is freed, the pool only ever holds as many as calls have run at once.
+    std::unique_ptr<RunContext> AcquireContext() const;
+
+    void ReleaseContext(std::unique_ptr<RunContext> context) const;
+
+    mutable std::mutex contextMutex;
+    mutable std::vector<std::unique_ptr<RunContext>> contexts;
+
+    template<typename N>
+    char* BatchProcess(std::vector<cv::Mat>& iImgs, size_t first, size_t count, size_t batchSize, N* blob,
+        std::vector<std::vector<DL_RESULT>>& oResults);
+
+    // Tensors over a context's buffers, bound on the context's first run once the warm-up fixed the output shape
+    char* BindContext(RunContext& context) const;
+
+    char* BoundProcess(yolo::StageClock& stageClock, yolo::StageTimes& times, RunContext& context,
+        std::vector<DL_RESULT>& oResult) const;
+
+    // Input and output element types against modelType, before the warm-up run
+    char* CheckTensorTypes() const;
+
+    // Session on the shared runtime or this instance's Env, from a file or (modelPath empty) from modelData
+    void NewSession(const std::filesystem::path& modelPath, const void* modelData, size_t modelSize,
+        const Ort::SessionOptions& sessionOption);
+
+    // Session from the optimized model cached in cacheDir, saving it there on a miss
+    void CachedSession(const std::filesystem::path& modelPath, const std::string& cacheDir,
+        Ort::SessionOptions& sessionOption);
+
+    // Output shapes from the warm-up run, the second output holds the prototypes of segmentation models
+    char* ReadOutputShapes(std::vector<Ort::Value>& outputs);
+
+    bool ioBinding;
+    std::vector<int64_t> outputNodeDims;//output shape of a single-image run, from the warm-up run
+    size_t outputCount = 0;
+    std::vector<int64_t> protoNodeDims;//1 x 32 x 160 x 160 for segmentation models, empty otherwise
+    size_t protoCount = 0;
+
+    int64_t modelBatch;//input batch dimension, -1 for dynamic batch
+    std::mutex batchMutex;//guards the batch buffers below
+    std::vector<yolo::LetterboxKernel> batchLetterbox;//one per batch slot, frames may differ in size
+    std::unique_ptr<yolo::WorkerPool> batchWorkers;//letterbox and decode the images of a batch, started by CreateSession
+    std::vector<float> batchBlob;
+    std::vector<uint16_t> batchBlobHalf;
+};
+
+
+// Detectors for several cameras on one set of ORT resources. The pool creates one Env with global intra/inter-op
+// thread pools that every session uses instead of its own, and shares one PrepackedWeightsContainer, so sessions of
+// the same model keep one copy of the prepacked weights. Cameras asking for the same parameters lease the same
+// YOLO_V8, whose RunSession is re-entrant, so they also share the session and every other weight.
+// ORT has a single Env per process: create the pool before any YOLO_V8 outside it, or its thread pools are ignored.
+class YOLO_SESSION_POOL
+{
+public:
+    // intraOpNumThreads threads run every session's operators, 0 for one per core
+    explicit YOLO_SESSION_POOL(int intraOpNumThreads = 0, int interOpNumThreads = 1);
+
+    // Detector for a camera thread, created on first use. The lease keeps the session and the runtime alive,
+    // the session is released with the last lease. exclusive gives the camera a session of its own, still on the
+    // shared threads and prepacked weights.
+    char* Lease(DL_INIT_PARAM& iParams, std::shared_ptr<YOLO_V8>& oDetector, bool exclusive = false);
+
+    // Sessions currently leased
+    size_t SessionCount();
+
+private:
+    std::shared_ptr<DL_SHARED_RUNTIME> runtime;
+    std::mutex mutex;
+    std::map<std::string, std::weak_ptr<YOLO_V8>> detectors;//by DL_INIT_PARAM, exclusive ones numbered
+    size_t exclusiveCount = 0;
 };
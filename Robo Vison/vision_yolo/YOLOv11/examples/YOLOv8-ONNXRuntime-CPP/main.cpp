@@ -22,7 +22,41 @@ void Detector(YOLO_V8*& p) {
                 cv::RNG rng(cv::getTickCount());
                 cv::Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
 
-                cv::rectangle(img, re.box, color, 3);
+                // Segmentation models: blend the mask into the frame, one run of set pixels at a time
+                yolo::ForEachMaskSpan(re.mask, [&](int y, int x0, int x1) {
+                    for (int x = x0; x < x1; x++)
+                    {
+                        cv::Vec3b& pixel = img.at<cv::Vec3b>(y, x);
+                        for (int c = 0; c < 3; c++)
+                        {
+                            pixel[c] = cv::saturate_cast<uchar>(0.5 * pixel[c] + 0.5 * color[c]);
+                        }
+                    }
+                });
+
+                if (re.rotatedBox.size.width > 0)
+                {
+                    // OBB models: the rotated box
+                    cv::Point2f corners[4];
+                    re.rotatedBox.points(corners);
+                    for (int k = 0; k < 4; k++)
+                    {
+                        cv::line(img, corners[k], corners[(k + 1) % 4], color, 3);
+                    }
+                }
+                else
+                {
+                    cv::rectangle(img, re.box, color, 3);
+                }
+
+                // Pose models: keypoints the model considers visible
+                for (int k = 0; k < re.keyPointsNum; k++)
+                {
+                    if (re.keyPoints[k].visibility > 0.5f)
+                    {
+                        cv::circle(img, cv::Point2f(re.keyPoints[k].x, re.keyPoints[k].y), 4, color, cv::FILLED);
+                    }
+                }
 
                 float confidence = floor(100 * re.confidence) / 100;
                 std::cout << std::fixed << std::setprecision(2);
@@ -175,6 +209,56 @@ void DetectTest()
 }
 
 
+void PoseTest()
+{
+    YOLO_V8* yoloDetector = new YOLO_V8;
+    yoloDetector->classes = { "person" };
+    DL_INIT_PARAM params;
+    params.rectConfidenceThreshold = 0.25;
+    params.iouThreshold = 0.7;
+    params.modelPath = "yolov8n-pose.onnx";
+    params.imgSize = { 640, 640 };
+    params.modelType = YOLO_POSE;
+    params.keyPointsNum = 17;
+    yoloDetector->CreateSession(params);
+    Detector(yoloDetector);
+}
+
+
+void SegTest()
+{
+    YOLO_V8* yoloDetector = new YOLO_V8;
+    ReadCocoYaml(yoloDetector);
+    DL_INIT_PARAM params;
+    params.rectConfidenceThreshold = 0.25;
+    params.iouThreshold = 0.7;
+    params.modelPath = "yolov8n-seg.onnx";
+    params.imgSize = { 640, 640 };
+    params.modelType = YOLO_SEG;
+    params.maskThreshold = 0.5;
+    yoloDetector->CreateSession(params);
+    Detector(yoloDetector);
+}
+
+
+void ObbTest()
+{
+    YOLO_V8* yoloDetector = new YOLO_V8;
+    yoloDetector->classes = { "plane", "ship", "storage tank", "baseball diamond", "tennis court",
+        "basketball court", "ground track field", "harbor", "bridge", "large vehicle", "small vehicle", "helicopter",
+        "roundabout", "soccer ball field", "swimming pool" };//DOTAv1
+    DL_INIT_PARAM params;
+    params.rectConfidenceThreshold = 0.25;
+    params.iouThreshold = 0.7;
+    params.agnosticNms = false;
+    params.modelPath = "yolov8n-obb.onnx";
+    params.imgSize = { 1024, 1024 };
+    params.modelType = YOLO_OBB;
+    yoloDetector->CreateSession(params);
+    Detector(yoloDetector);
+}
+
+
 void ClsTest()
 {
     YOLO_V8* yoloDetector = new YOLO_V8;
@@ -189,5 +273,8 @@ void ClsTest()
 int main()
 {
     //DetectTest();
+    //PoseTest();
+    //SegTest();
+    //ObbTest();
     ClsTest();
 }
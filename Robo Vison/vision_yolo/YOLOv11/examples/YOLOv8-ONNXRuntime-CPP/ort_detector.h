@@ -0,0 +1,65 @@
+#pragma once
+
+// yolo::IDetector (YOLOv8-CPP-Common/detector.h) over YOLO_V8, for the backend probe and applications that swap
+// engines. Box models only: keypoints, masks and rotated boxes stay in DL_RESULT.
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "detector.h"
+#include "inference.h"
+
+
+class ORT_DETECTOR : public yolo::IDetector
+{
+public:
+    // nullptr when the session can't be created, e.g. no CUDA device for cudaEnable
+    static std::unique_ptr<ORT_DETECTOR> Create(DL_INIT_PARAM& iParams)
+    {
+        std::unique_ptr<ORT_DETECTOR> detector(new ORT_DETECTOR(iParams.cudaEnable));
+        if (detector->yolo.CreateSession(iParams) != RET_OK)
+        {
+            return nullptr;
+        }
+        return detector;
+    }
+
+    const char* Name() const override { return name.c_str(); }
+
+    bool Detect(const yolo::ImageView& frame, yolo::DetectionResults& results,
+        yolo::StageTimes* times = nullptr) override
+    {
+        results.clear();
+        // The frame as a Mat header, RunSession only reads it
+        const cv::Mat image(frame.height, frame.width, CV_8UC3, const_cast<uint8_t*>(frame.data), frame.stride);
+        detections.clear();//RunSession appends
+        if (yolo.RunSession(image, detections, times) != RET_OK)
+        {
+            return false;
+        }
+        for (const DL_RESULT& detection : detections)
+        {
+            yolo::DetectedObject object;
+            object.x = (float)detection.box.x;
+            object.y = (float)detection.box.y;
+            object.width = (float)detection.box.width;
+            object.height = (float)detection.box.height;
+            object.score = detection.confidence;
+            object.class_id = detection.classId;
+            if (!results.push_back(object))
+            {
+                break;
+            }
+        }
+        return true;
+    }
+
+    YOLO_V8& Yolo() { return yolo; }
+
+private:
+    explicit ORT_DETECTOR(bool cudaEnable) : name(cudaEnable ? "onnxruntime-cuda" : "onnxruntime-cpu") {}
+
+    YOLO_V8 yolo;
+    std::string name;
+    std::vector<DL_RESULT> detections;//reused, keeps its capacity from frame to frame
+};
@@ -0,0 +1,126 @@
+# Ultralytics YOLO 🚀, AGPL-3.0 license
+
+import argparse
+import json
+from pathlib import Path
+
+import numpy as np
+import onnx
+from onnxruntime.quantization import (
+    CalibrationDataReader,
+    CalibrationMethod,
+    QuantFormat,
+    QuantType,
+    quantize_static,
+)
+from onnxruntime.quantization.shape_inference import quant_pre_process
+
+
+class TensorReader(CalibrationDataReader):
+    """Feeds the tensors Calibrate wrote, in order, to the onnxruntime calibrator."""
+
+    def __init__(self, calibration_dir, input_name):
+        """
+        Args:
+            calibration_dir (Path): Directory with calibration.json and the calib_*.npy tensors.
+            input_name (str): Name of the model input.
+        """
+        info = json.loads((calibration_dir / "calibration.json").read_text())
+        self.files = [calibration_dir / f for f in info["files"]]
+        self.input_name = input_name
+        self.index = 0
+
+    def get_next(self):
+        """Returns the next input feed, None once every tensor has been read."""
+        if self.index == len(self.files):
+            return None
+        tensor = np.load(self.files[self.index])
+        self.index += 1
+        return {self.input_name: tensor}
+
+    def rewind(self):
+        """Restarts from the first tensor."""
+        self.index = 0
+
+
+def decode_tail(model):
+    """
+    Finds the nodes between the last convolutions and the graph outputs.
+
+    That tail decodes the head (DFL, anchors and strides, sigmoid, keypoints, angle) and concatenates boxes in
+    pixels with scores in 0..1. Quantized, the concatenated tensor gets one scale for both and most scores round to
+    0, so these nodes stay FP32. They are a few element-wise ops, their cost is small next to the convolutions.
+
+    Returns:
+        (list[str]): Node names, walking back from every output until a Conv.
+    """
+    producers = {output: node for node in model.graph.node for output in node.output}
+    tail, stack = set(), [o.name for o in model.graph.output]
+    while stack:
+        node = producers.get(stack.pop())
+        if node is None or node.op_type == "Conv" or node.name in tail:
+            continue
+        tail.add(node.name)
+        stack.extend(node.input)
+    return sorted(tail)
+
+
+def main(model_path, calibration_dir, output_path, quant_format, method, per_channel, reduce_range, keep_tail):
+    """
+    Quantizes an FP32 YOLO model to INT8 (activations uint8, weights int8) with the calibration tensors from
+    Calibrate, keeping FP32 inputs and outputs so YOLO_V8 runs the result with the FP32 model types.
+
+    reduce_range quantizes weights to 7 bits: on AVX2 CPUs without VNNI the u8s8 kernels can saturate in
+    VPMADDUBSW, which costs accuracy on some models; AVX512-VNNI and ARM CPUs don't need it.
+    """
+    model_path, calibration_dir = Path(model_path), Path(calibration_dir)
+    output_path = Path(output_path) if output_path else model_path.with_name(f"{model_path.stem}_int8.onnx")
+    prepared = output_path.with_name(f"{model_path.stem}_prepared.onnx")
+    quant_pre_process(str(model_path), str(prepared))
+
+    model = onnx.load(str(prepared))
+    exclude = [] if keep_tail else decode_tail(model)
+    reader = TensorReader(calibration_dir, model.graph.input[0].name)
+    quantize_static(
+        str(prepared),
+        str(output_path),
+        reader,
+        quant_format=QuantFormat.QDQ if quant_format == "qdq" else QuantFormat.QOperator,
+        per_channel=per_channel,
+        reduce_range=reduce_range,
+        activation_type=QuantType.QUInt8,
+        weight_type=QuantType.QInt8,
+        nodes_to_exclude=exclude,
+        calibrate_method={
+            "minmax": CalibrationMethod.MinMax,
+            "entropy": CalibrationMethod.Entropy,
+            "percentile": CalibrationMethod.Percentile,
+        }[method],
+    )
+    prepared.unlink()
+    print(f"{output_path} written from {len(reader.files)} calibration tensors ({quant_format}, {method}), "
+          f"{len(exclude)} decode nodes kept FP32")
+    print(f"compare with: ./Int8Benchmark {model_path} {output_path} <images_dir> [labels_dir]")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--model", type=str, default="yolov8n.onnx", help="FP32 ONNX model")
+    parser.add_argument("--calibration", type=str, default="calibration", help="Calibrate output directory")
+    parser.add_argument("--output", type=str, default="", help="INT8 model, default <model>_int8.onnx")
+    parser.add_argument("--format", choices=["qdq", "qoperator"], default="qdq", help="QDQ or QLinear* operators")
+    parser.add_argument("--method", choices=["minmax", "entropy", "percentile"], default="minmax")
+    parser.add_argument("--no-per-channel", action="store_true", help="one weight scale per tensor")
+    parser.add_argument("--reduce-range", action="store_true", help="7-bit weights for AVX2 CPUs without VNNI")
+    parser.add_argument("--keep-tail", action="store_true", help="quantize the head decode as well")
+    args = parser.parse_args()
+    main(
+        args.model,
+        args.calibration,
+        args.output,
+        args.format,
+        args.method,
+        not args.no_per_channel,
+        args.reduce_range,
+        args.keep_tail,
+    )
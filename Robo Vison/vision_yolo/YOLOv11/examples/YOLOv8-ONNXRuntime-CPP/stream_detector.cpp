@@ -0,0 +1,158 @@
+// Live detection on a camera, video file or RTSP stream with bounded latency: a capture thread keeps only the newest
+// frame (../YOLOv8-CPP-Common/stream_runner.h) and RunSession always works on it, frames that arrive meanwhile are
+// dropped. At the end it prints the capture-to-result latency (p50/p90/p99/max), fps and the drop rate.
+//
+// Usage: ./StreamDetector <model.onnx> <camera index|video file|rtsp://...> [policy [max_age_ms [fps [frames [show]]]]]
+//        (default oldest, no maximum age, the file's own frame rate for files and none for cameras and URLs,
+//        the whole stream, no window)
+// policy is oldest (drop the waiting frame for the new one), newest (drop the new one) or block (drop nothing).
+// A file is read at its frame rate to stand in for a camera; fps 0 reads it as fast as it decodes. With show the
+// results are drawn in a window, Esc stops. With YOLO_TRACE=trace.json the zones of the run are written there.
+
+#include <cctype>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "inference.h"
+#include "stream_runner.h"
+#include "trace.h"
+
+
+struct StreamFrame
+{
+    cv::Mat image;
+    std::vector<DL_RESULT> results;
+};
+
+
+static bool ParsePolicy(const std::string& name, yolo::DropPolicy& policy)
+{
+    if (name == "oldest")
+    {
+        policy = yolo::DropPolicy::kDropOldest;
+    }
+    else if (name == "newest")
+    {
+        policy = yolo::DropPolicy::kDropNewest;
+    }
+    else if (name == "block")
+    {
+        policy = yolo::DropPolicy::kBlock;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+
+static void Draw(cv::Mat& image, const std::vector<DL_RESULT>& results, const std::vector<std::string>& classes)
+{
+    for (const DL_RESULT& result : results)
+    {
+        cv::rectangle(image, result.box, cv::Scalar(0, 255, 0), 2);
+        const std::string label = result.classId < (int)classes.size() ? classes[result.classId] : std::to_string(result.classId);
+        cv::putText(image, label, cv::Point(result.box.x, result.box.y - 5), cv::FONT_HERSHEY_SIMPLEX, 0.6,
+            cv::Scalar(0, 255, 0), 2);
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "usage: " << argv[0]
+                  << " <model.onnx> <camera index|video file|rtsp://...> [oldest|newest|block [max_age_ms [fps [frames [show]]]]]"
+                  << std::endl;
+        return 1;
+    }
+    std::string modelPath = argv[1];
+    std::string source = argv[2];
+    yolo::StreamOptions options;
+    if (argc > 3 && !ParsePolicy(argv[3], options.policy))
+    {
+        std::cerr << "unknown policy " << argv[3] << std::endl;
+        return 1;
+    }
+    options.max_age_ms = argc > 4 ? std::atof(argv[4]) : 0.0;
+    double fps = argc > 5 ? std::atof(argv[5]) : -1.0;
+    options.max_frames = argc > 6 ? std::atoi(argv[6]) : 0;
+    bool show = argc > 7 && std::atoi(argv[7]) != 0;
+    std::string tracePath = yolo::trace::EnableFromEnvironment();
+
+    bool camera = !source.empty();
+    for (char c : source)
+    {
+        camera = camera && std::isdigit((unsigned char)c);
+    }
+    bool url = source.find("://") != std::string::npos;
+    cv::VideoCapture capture;
+    if (camera ? !capture.open(std::atoi(source.c_str())) : !capture.open(source))
+    {
+        std::cerr << "cannot open " << source << std::endl;
+        return 1;
+    }
+    // Cameras and streams deliver at their own rate; a file is paced to its frame rate unless told otherwise
+    options.source_fps = fps >= 0.0 ? fps : (camera || url ? 0.0 : capture.get(cv::CAP_PROP_FPS));
+
+    YOLO_V8 detector;
+    DL_INIT_PARAM params;
+    params.modelPath = modelPath;
+    params.modelType = YOLO_DETECT_V8;
+    params.imgSize = { 640, 640 };
+    params.rectConfidenceThreshold = 0.25;
+    params.iouThreshold = 0.5;
+    params.cudaEnable = false;
+    char* ret = detector.CreateSession(params);
+    if (ret != RET_OK)
+    {
+        std::cerr << ret << std::endl;
+        return 1;
+    }
+
+    yolo::StreamRunner<StreamFrame>* runner = nullptr;
+    yolo::StreamRunner<StreamFrame> stream(options,
+        [&capture](StreamFrame& frame) { return capture.read(frame.image); },
+        [&](StreamFrame& frame) {
+            frame.results.clear();
+            if (detector.RunSession(frame.image, frame.results) != RET_OK)
+            {
+                return false;
+            }
+            if (show)
+            {
+                Draw(frame.image, frame.results, detector.classes);
+                cv::imshow("Stream", frame.image);
+                if (cv::waitKey(1) == 27)
+                {
+                    runner->Stop();
+                }
+            }
+            return true;
+        });
+    runner = &stream;
+
+    yolo::StreamStats stats = stream.Run();
+    if (show)
+    {
+        cv::destroyAllWindows();
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << source << ", " << modelPath << ", source " << options.source_fps << " fps\n"
+              << "  captured " << stats.captured << "  processed " << stats.processed << "  dropped " << stats.dropped
+              << "  stale " << stats.stale << "  failed " << stats.failed << "  drop rate " << 100.0 * stats.DropRate()
+              << " %\n"
+              << "  " << stats.Fps() << " frames/s  capture-to-result latency p50 " << stats.latency.p50 << " ms  p90 "
+              << stats.latency.p90 << " ms  p99 " << stats.latency.p99 << " ms  max " << stats.latency.max << " ms\n";
+    if (!tracePath.empty() && !yolo::trace::WriteChromeTrace(tracePath))
+    {
+        std::cerr << "cannot write " << tracePath << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,174 @@
+// Test of the startup backend selection in ../YOLOv8-CPP-Common/backend_probe.h and the result buffer of
+// detector.h, with fake detectors whose Detect sleeps a fixed time: the fastest one is picked, unavailable and
+// failing ones are skipped, the decision is cached per key and reused without probing, and a cached backend that
+// no longer loads triggers a new probe.
+//
+// Usage: ./BackendProbeTest   (registered with ctest)
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "backend_probe.h"
+
+
+class FakeDetector : public yolo::IDetector
+{
+public:
+    FakeDetector(const char* name, int sleepMs, bool fails) : name(name), sleepMs(sleepMs), fails(fails) {}
+
+    const char* Name() const override { return name; }
+
+    bool Detect(const yolo::ImageView& frame, yolo::DetectionResults& results,
+        yolo::StageTimes* times = nullptr) override
+    {
+        results.clear();
+        std::this_thread::sleep_for(std::chrono::milliseconds(sleepMs));
+        if (times)
+        {
+            times->inference_ms = sleepMs;
+        }
+        if (fails)
+        {
+            return false;
+        }
+        yolo::DetectedObject object;
+        object.width = (float)frame.width;
+        object.height = (float)frame.height;
+        results.push_back(object);
+        return true;
+    }
+
+private:
+    const char* name;
+    int sleepMs;
+    bool fails;
+};
+
+
+struct Fake
+{
+    const char* name;
+    int sleepMs;
+    bool available = true;
+    bool fails = false;
+    int created = 0;
+};
+
+
+static std::vector<yolo::BackendCandidate> Candidates(std::vector<Fake>& fakes)
+{
+    std::vector<yolo::BackendCandidate> candidates;
+    for (Fake& fake : fakes)
+    {
+        yolo::BackendCandidate candidate;
+        candidate.name = fake.name;
+        candidate.create = [&fake]() -> std::unique_ptr<yolo::IDetector> {
+            fake.created++;
+            if (!fake.available)
+            {
+                return nullptr;
+            }
+            return std::unique_ptr<yolo::IDetector>(new FakeDetector(fake.name, fake.sleepMs, fake.fails));
+        };
+        candidates.push_back(candidate);
+    }
+    return candidates;
+}
+
+
+int main()
+{
+    int cases = 0;
+    int failures = 0;
+    auto expect = [&](const char* what, bool ok) {
+        cases++;
+        if (!ok)
+        {
+            failures++;
+            std::printf("FAIL %s\n", what);
+        }
+    };
+
+    {
+        yolo::DetectionResults results(2);
+        yolo::DetectedObject object;
+        expect("push within capacity", results.push_back(object) && results.push_back(object));
+        expect("push past capacity refused", !results.push_back(object) && results.size() == 2);
+        results.clear();
+        expect("clear keeps capacity", results.empty() && results.capacity() == 2);
+    }
+
+    std::vector<unsigned char> pixels(64 * 48 * 3);
+    yolo::ImageView frame;
+    frame.data = pixels.data();
+    frame.width = 64;
+    frame.height = 48;
+    frame.stride = 64 * 3;
+    yolo::ProbeOptions options;
+    options.warmup = 1;
+    options.iterations = 3;
+    options.cache_key = "model.onnx|640";
+    options.cache_path = "backend_probe_test.txt";
+    std::remove(options.cache_path.c_str());
+
+    std::vector<Fake> fakes = { { "slow", 12 }, { "fast", 2 }, { "missing", 0, false }, { "broken", 0, true, true } };
+    std::vector<yolo::BackendTiming> timings;
+    std::unique_ptr<yolo::IDetector> chosen =
+        yolo::SelectFastestBackend(Candidates(fakes), frame, options, &timings);
+    expect("fastest picked", chosen && std::string(chosen->Name()) == "fast");
+    expect("every candidate timed", timings.size() == 4);
+    expect("missing and broken unavailable", timings.size() == 4 && !timings[2].available && !timings[3].available);
+    expect("timings ordered", timings.size() == 4 && timings[0].available && timings[1].available &&
+        timings[1].median_ms < timings[0].median_ms);
+    yolo::DetectionResults results;
+    expect("chosen detector works", chosen && chosen->Detect(frame, results) && results.size() == 1 &&
+        results[0].width == 64.0f);
+
+    // Cached: only the winner is created, nothing is timed
+    for (Fake& fake : fakes)
+    {
+        fake.created = 0;
+    }
+    chosen = yolo::SelectFastestBackend(Candidates(fakes), frame, options, &timings);
+    expect("cached decision used", chosen && std::string(chosen->Name()) == "fast" && timings.empty());
+    expect("only the cached backend created", fakes[0].created == 0 && fakes[1].created == 1);
+
+    // Another key (other model) probes and keeps both decisions
+    fakes[0].sleepMs = 1;
+    fakes[1].sleepMs = 12;
+    yolo::ProbeOptions other = options;
+    other.cache_key = "other.onnx|640";
+    chosen = yolo::SelectFastestBackend(Candidates(fakes), frame, other, &timings);
+    expect("other key probed", chosen && std::string(chosen->Name()) == "slow" && timings.size() == 4);
+    chosen = yolo::SelectFastestBackend(Candidates(fakes), frame, options, &timings);
+    expect("first key kept", chosen && std::string(chosen->Name()) == "fast" && timings.empty());
+
+    // Another candidate set is another key
+    std::vector<Fake> fewer = { fakes[0], fakes[1], fakes[2] };
+    chosen = yolo::SelectFastestBackend(Candidates(fewer), frame, options, &timings);
+    expect("candidate set in the key", chosen && timings.size() == 3);
+
+    // The cached backend no longer loads: probe again and cache the new winner
+    fakes[0].sleepMs = 12;
+    fakes[1].sleepMs = 2;
+    fakes[1].available = false;
+    chosen = yolo::SelectFastestBackend(Candidates(fakes), frame, options, &timings);
+    expect("reprobed without the cached backend", chosen && std::string(chosen->Name()) == "slow" &&
+        timings.size() == 4);
+    fakes[1].available = true;
+    chosen = yolo::SelectFastestBackend(Candidates(fakes), frame, options, &timings);
+    expect("new decision cached", chosen && std::string(chosen->Name()) == "slow" && timings.empty());
+
+    // Nothing runs: no detector, no decision written
+    std::vector<Fake> none = { { "missing", 0, false }, { "broken", 0, true, true } };
+    chosen = yolo::SelectFastestBackend(Candidates(none), frame, options, &timings);
+    expect("no backend", !chosen && timings.size() == 2);
+    chosen = yolo::SelectFastestBackend(Candidates(none), frame, options, &timings);
+    expect("no decision cached", !chosen && timings.size() == 2);
+
+    std::remove(options.cache_path.c_str());
+    std::printf("%d cases, %d failures\n", cases, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,133 @@
+// Stress test of concurrent YOLO_V8::RunSession calls on a single instance.
+//
+// Usage: ./ConcurrencyTest [model.onnx [image [threads [iterations]]]]   (default yolov8n.onnx, random frame, 8, 20)
+// Frames are the image at several sizes and aspect ratios, plus its mirror. Each frame has its own letterbox scale,
+// so a scale or buffer taken from another thread's frame moves or changes the boxes. The reference results come
+// from one RunSession per frame on a single thread. Then `threads` workers share the detector, each starting at its
+// own frame, and every result must match the reference: same count, class and box, confidence within 1e-5. Runs
+// with ioBinding on and off. Without an image a random frame is used, which gives few detections and a weaker check.
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "inference.h"
+
+
+static bool Same(const std::vector<DL_RESULT>& a, const std::vector<DL_RESULT>& b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (a[i].classId != b[i].classId || a[i].box != b[i].box ||
+            std::fabs(a[i].confidence - b[i].confidence) > 1e-5f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+int main(int argc, char** argv)
+{
+    std::string modelPath = argc > 1 ? argv[1] : "yolov8n.onnx";
+    cv::Mat image;
+    if (argc > 2)
+    {
+        image = cv::imread(argv[2]);
+    }
+    if (image.empty())
+    {
+        std::cout << "no image, using a random frame (few detections, weaker check)\n";
+        image = cv::Mat(720, 1280, CV_8UC3);
+        cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(256));
+    }
+    int threads = argc > 3 ? std::atoi(argv[3]) : 8;
+    int iterations = argc > 4 ? std::atoi(argv[4]) : 20;
+
+    std::vector<cv::Mat> frames;
+    for (double scale : { 0.5, 1.0, 1.7 })
+    {
+        cv::Mat resized;
+        cv::resize(image, resized, cv::Size(), scale, scale);
+        frames.push_back(resized);
+        frames.push_back(resized(cv::Rect(0, 0, resized.cols * 2 / 3, resized.rows)).clone());//taller
+        frames.push_back(resized(cv::Rect(0, 0, resized.cols, resized.rows / 2)).clone());//wider
+    }
+    cv::Mat mirrored;
+    cv::flip(image, mirrored, 1);
+    frames.push_back(mirrored);
+
+    int failures = 0;
+    for (bool ioBinding : { true, false })
+    {
+        YOLO_V8 detector;
+        DL_INIT_PARAM params;
+        params.modelPath = modelPath;
+        params.modelType = YOLO_DETECT_V8;
+        params.imgSize = { 640, 640 };
+        params.rectConfidenceThreshold = 0.1;
+        params.iouThreshold = 0.5;
+        params.cudaEnable = false;
+        params.ioBinding = ioBinding;
+        if (detector.CreateSession(params) != RET_OK)
+        {
+            return 1;
+        }
+
+        std::vector<std::vector<DL_RESULT>> reference(frames.size());
+        size_t detections = 0;
+        for (size_t f = 0; f < frames.size(); f++)
+        {
+            detector.RunSession(frames[f], reference[f]);
+            detections += reference[f].size();
+        }
+
+        std::atomic<int> runs{ 0 };
+        std::atomic<int> mismatches{ 0 };
+        std::atomic<int> errors{ 0 };
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++)
+        {
+            workers.emplace_back([&, t] {
+                std::vector<DL_RESULT> results;
+                for (int i = 0; i < iterations; i++)
+                {
+                    for (size_t k = 0; k < frames.size(); k++)
+                    {
+                        size_t f = (t + k) % frames.size();
+                        results.clear();
+                        if (detector.RunSession(frames[f], results) != RET_OK)
+                        {
+                            errors++;
+                        }
+                        else if (!Same(results, reference[f]))
+                        {
+                            mismatches++;
+                        }
+                        runs++;
+                    }
+                }
+            });
+        }
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+
+        std::cout << (ioBinding ? "IoBinding " : "per-run   ") << threads << " threads, " << frames.size()
+                  << " frames (" << detections << " detections), " << runs << " runs, " << mismatches
+                  << " mismatches, " << errors << " errors\n";
+        failures += mismatches + errors;
+    }
+    std::cout << (failures ? "FAIL" : "OK") << "\n";
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,175 @@
+// Test of the box mAP in ../YOLOv8-CPP-Common/detection_metrics.h that Int8Benchmark reports. Expected values
+// are those ultralytics' ap_per_class/compute_ap give for the same matches: 101-point interpolation, np.interp
+// returning the sentinel 0 at recall 1 (so a perfect class scores 0.995), classes without ground truth ignored,
+// matching by IoU before confidence. The random part compares Compute() against a direct per-class
+// recomputation from predictions that are exact copies of, beside, or far from the ground truth.
+//
+// Usage: ./DetectionMetricsTest   (registered with ctest)
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "detection_metrics.h"
+
+
+static yolo::EvalBox Box(float x1, float y1, float x2, float y2, int classId, float score = 1.0f)
+{
+    yolo::EvalBox b;
+    b.x1 = x1;
+    b.y1 = y1;
+    b.x2 = x2;
+    b.y2 = y2;
+    b.class_id = classId;
+    b.score = score;
+    return b;
+}
+
+
+static bool Near(double a, double b)
+{
+    return std::fabs(a - b) < 1e-9;
+}
+
+
+int main()
+{
+    int cases = 0;
+    int failures = 0;
+    auto expect = [&](const char* what, bool ok) {
+        cases++;
+        if (!ok)
+        {
+            failures++;
+            std::printf("FAIL %s\n", what);
+        }
+    };
+
+    // compute_ap by hand
+    expect("ap of a perfect curve", Near(yolo::DetectionMetrics::AveragePrecision({ 1.0 }, { 1.0 }), 0.995));
+    expect("ap of no hits", Near(yolo::DetectionMetrics::AveragePrecision({ 0.0 }, { 0.0 }), 0.0));
+    // False positive ranked first: envelope 0.5 on [0, 1), 0 at 1
+    expect("ap after a false positive",
+        Near(yolo::DetectionMetrics::AveragePrecision({ 0.0, 1.0 }, { 0.0, 0.5 }), 0.4975));
+    // Half the objects found at precision 1: envelope 1 up to 0.5, then falls linearly to the sentinel 0 at 1
+    expect("ap of half recall", Near(yolo::DetectionMetrics::AveragePrecision({ 0.5 }, { 1.0 }), 0.75));
+
+    {
+        yolo::DetectionMetrics metrics;
+        metrics.AddImage({ Box(0, 0, 10, 10, 0, 0.9f), Box(20, 20, 40, 40, 1, 0.8f) },
+            { Box(0, 0, 10, 10, 0), Box(20, 20, 40, 40, 1) });
+        yolo::DetectionSummary s = metrics.Compute();
+        expect("perfect predictions", Near(s.map50, 0.995) && Near(s.map50_95, 0.995) && s.classes == 2 &&
+            s.ground_truth == 2 && s.predictions == 2 && s.images == 1);
+    }
+    {
+        yolo::DetectionMetrics metrics;
+        metrics.AddImage({}, { Box(0, 0, 10, 10, 0) });
+        metrics.AddImage({ Box(0, 0, 10, 10, 3, 0.9f) }, {});
+        yolo::DetectionSummary s = metrics.Compute();
+        expect("classes without predictions score 0, predictions without ground truth are not averaged",
+            Near(s.map50, 0.0) && s.classes == 1 && s.images == 2 && s.predictions == 1);
+    }
+    {
+        // Wrong class never matches
+        yolo::DetectionMetrics metrics;
+        metrics.AddImage({ Box(0, 0, 10, 10, 1, 0.9f) }, { Box(0, 0, 10, 10, 0) });
+        expect("class-aware matching", Near(metrics.Compute().map50, 0.0));
+    }
+    {
+        // A 10 px box shifted by 2 px: IoU 80 / 120, a hit at 0.50 to 0.65, a miss above
+        yolo::DetectionMetrics metrics;
+        metrics.AddImage({ Box(2, 0, 12, 10, 0, 0.9f) }, { Box(0, 0, 10, 10, 0) });
+        yolo::DetectionSummary s = metrics.Compute();
+        expect("iou 0.67 hits four of ten thresholds", Near(s.map50, 0.995) && Near(s.map50_95, 0.995 * 4 / 10));
+    }
+    {
+        // Matching by IoU, not confidence: the confident loose box loses the object to the tight one and is a
+        // false positive ranked first
+        yolo::DetectionMetrics metrics;
+        metrics.AddImage({ Box(3, 0, 13, 10, 0, 0.9f), Box(0, 0, 10, 10, 0, 0.5f) }, { Box(0, 0, 10, 10, 0) });
+        yolo::DetectionSummary s = metrics.Compute();
+        expect("tightest box takes the object", Near(s.map50, 0.4975));
+    }
+    {
+        // Duplicates: the second copy of an object is a false positive ranked below the hit
+        yolo::DetectionMetrics metrics;
+        metrics.AddImage({ Box(0, 0, 10, 10, 0, 0.9f), Box(0, 0, 10, 10, 0, 0.8f) }, { Box(0, 0, 10, 10, 0) });
+        expect("duplicate after the hit", Near(metrics.Compute().map50, 0.995));
+    }
+
+    // Random images against a direct recomputation (AP at 0.5 per class, one image per class and score order)
+    std::mt19937 rng(40);
+    std::uniform_real_distribution<float> size(10.0f, 100.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (int trial = 0; trial < 200; trial++)
+    {
+        const int classNum = 1 + (int)(rng() % 5);
+        yolo::DetectionMetrics metrics;
+        std::vector<std::vector<std::pair<float, bool>>> hits(classNum);
+        std::vector<size_t> objects(classNum, 0);
+        for (int image = 0; image < 4; image++)
+        {
+            std::vector<yolo::EvalBox> truth, predictions;
+            // Objects on a grid so no prediction overlaps a second object
+            for (int o = 0; o < 8; o++)
+            {
+                float x = 150.0f * (o % 4), y = 300.0f * (o / 4), w = size(rng), h = size(rng);
+                int c = (int)(rng() % classNum);
+                truth.push_back(Box(x, y, x + w, y + h, c));
+                objects[c]++;
+                float r = unit(rng);
+                if (r < 0.4f)
+                {
+                    predictions.push_back(Box(x, y, x + w, y + h, c, unit(rng)));//exact
+                    hits[c].push_back({ predictions.back().score, true });
+                }
+                else if (r < 0.6f)
+                {
+                    predictions.push_back(Box(x, y + h, x + w, y + 2 * h, c, unit(rng)));//below, IoU 0
+                    hits[c].push_back({ predictions.back().score, false });
+                }
+            }
+            for (int n = (int)(rng() % 3); n > 0; n--)
+            {
+                int c = (int)(rng() % classNum);
+                predictions.push_back(Box(700.0f, 700.0f, 720.0f, 720.0f, c, unit(rng)));//nowhere near
+                hits[c].push_back({ predictions.back().score, false });
+            }
+            metrics.AddImage(predictions, truth);
+        }
+        double map50 = 0.0;
+        int classes = 0;
+        for (int c = 0; c < classNum; c++)
+        {
+            if (objects[c] == 0)
+            {
+                continue;
+            }
+            classes++;
+            std::stable_sort(hits[c].begin(), hits[c].end(),
+                [](const std::pair<float, bool>& a, const std::pair<float, bool>& b) { return a.first > b.first; });
+            std::vector<double> recall, precision;
+            double tp = 0.0;
+            for (size_t i = 0; i < hits[c].size(); i++)
+            {
+                tp += hits[c][i].second;
+                recall.push_back(tp / objects[c]);
+                precision.push_back(tp / (i + 1));
+            }
+            map50 += hits[c].empty() ? 0.0 : yolo::DetectionMetrics::AveragePrecision(recall, precision);
+        }
+        yolo::DetectionSummary s = metrics.Compute();
+        cases++;
+        if (!Near(s.map50, map50 / classes) || !Near(s.map50, s.map50_95))
+        {
+            failures++;
+            std::printf("FAIL random trial %d: map50 %.6f, expected %.6f, map50-95 %.6f\n", trial, s.map50,
+                map50 / classes, s.map50_95);
+        }
+    }
+
+    std::printf("%d cases, %d failures\n", cases, failures);
+    return failures ? 1 : 0;
+}
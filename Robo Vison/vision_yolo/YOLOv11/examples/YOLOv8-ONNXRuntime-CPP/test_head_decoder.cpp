@@ -0,0 +1,178 @@
+// Bit-exact test of yolo::DecodeHead (../YOLOv8-CPP-Common/head_decoder.h) against the decode YOLO_V8 used
+// before it: transpose the head with cv::Mat::t(), cv::minMaxLoc over each anchor's class scores, box math in
+// double. Random heads over several anchor counts (vector tails included), class counts, score distributions
+// (uniform, mostly-background, heavily tied) and thresholds; every candidate's class, score and box must match.
+//
+// Usage: ./HeadDecoderTest   (registered with ctest)
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "head_decoder.h"
+
+
+struct Decoded
+{
+    std::vector<int> classIds;
+    std::vector<float> confidences;
+    std::vector<cv::Rect> boxes;
+};
+
+
+// YOLO_V8::TensorProcess detect branch before the shared decoder, minus NMS
+static Decoded LegacyDecode(float* output, int signalResultNum, int strideNum, int classNum, float threshold,
+    float scale)
+{
+    Decoded d;
+    cv::Mat rawData = cv::Mat(signalResultNum, strideNum, CV_32F, output).t();
+    float* data = (float*)rawData.data;
+    for (int i = 0; i < strideNum; ++i)
+    {
+        float* classesScores = data + 4;
+        cv::Mat scores(1, classNum, CV_32FC1, classesScores);
+        cv::Point class_id;
+        double maxClassScore;
+        cv::minMaxLoc(scores, 0, &maxClassScore, 0, &class_id);
+        if (maxClassScore > threshold)
+        {
+            d.confidences.push_back(maxClassScore);
+            d.classIds.push_back(class_id.x);
+            float x = data[0];
+            float y = data[1];
+            float w = data[2];
+            float h = data[3];
+            int left = int((x - 0.5 * w) * scale);
+            int top = int((y - 0.5 * h) * scale);
+            int width = int(w * scale);
+            int height = int(h * scale);
+            d.boxes.push_back(cv::Rect(left, top, width, height));
+        }
+        data += signalResultNum;
+    }
+    return d;
+}
+
+
+static Decoded SharedDecode(const float* output, int strideNum, int classNum, float threshold, float scale,
+    yolo::HeadCandidates& candidates)
+{
+    Decoded d;
+    yolo::DecodeHead(output, strideNum, 4, classNum, threshold, candidates);
+    for (size_t i = 0; i < candidates.count; ++i)
+    {
+        d.confidences.push_back(candidates.score[i]);
+        d.classIds.push_back(candidates.class_id[i]);
+        float x = candidates.box[4 * i];
+        float y = candidates.box[4 * i + 1];
+        float w = candidates.box[4 * i + 2];
+        float h = candidates.box[4 * i + 3];
+        int left = int((x - 0.5 * w) * scale);
+        int top = int((y - 0.5 * h) * scale);
+        int width = int(w * scale);
+        int height = int(h * scale);
+        d.boxes.push_back(cv::Rect(left, top, width, height));
+    }
+    return d;
+}
+
+
+static bool Same(const Decoded& a, const Decoded& b)
+{
+    if (a.classIds != b.classIds || a.confidences.size() != b.confidences.size() || a.boxes.size() != b.boxes.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < a.boxes.size(); i++)
+    {
+        const cv::Rect& p = a.boxes[i];
+        const cv::Rect& q = b.boxes[i];
+        if (p.x != q.x || p.y != q.y || p.width != q.width || p.height != q.height)
+        {
+            return false;
+        }
+    }
+    return a.confidences.empty()
+        || std::memcmp(a.confidences.data(), b.confidences.data(), a.confidences.size() * sizeof(float)) == 0;
+}
+
+
+int main()
+{
+    enum Distribution { kUniform, kBackground, kTied };
+    const int anchorCounts[] = { 8400, 2100, 33600, 1, 7, 8, 9, 31, 33, 65 };
+    const int classCounts[] = { 80, 1, 3, 17 };
+    const float thresholds[] = { 0.25f, 0.5f, 0.0f };
+    std::mt19937 rng(2024);
+    yolo::HeadCandidates candidates;//reused across cases like the backends do
+    int cases = 0;
+    int failures = 0;
+
+    for (int anchors : anchorCounts)
+    {
+        for (int classes : classCounts)
+        {
+            for (int extraRows : { 0, 32 })//e.g. mask coefficients after the class rows
+            {
+                for (Distribution distribution : { kUniform, kBackground, kTied })
+                {
+                    const int rows = 4 + classes + extraRows;
+                    std::vector<float> head((size_t)rows * anchors);
+                    std::uniform_real_distribution<float> box(0.0f, 640.0f);
+                    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+                    for (int r = 0; r < rows; r++)
+                    {
+                        for (int a = 0; a < anchors; a++)
+                        {
+                            float& v = head[(size_t)r * anchors + a];
+                            if (r < 4)
+                            {
+                                v = box(rng);
+                            }
+                            else if (distribution == kUniform)
+                            {
+                                v = unit(rng);
+                            }
+                            else if (distribution == kBackground)
+                            {
+                                v = unit(rng) < 0.01f ? unit(rng) : unit(rng) * 0.05f;
+                            }
+                            else
+                            {
+                                v = (float)(rng() % 5) / 4.0f;//0, 0.25, 0.5, 0.75, 1: ties everywhere
+                            }
+                        }
+                    }
+                    for (float threshold : thresholds)
+                    {
+                        const float scale = 1.6875f;
+                        // The legacy transpose reads only the first 4 + classes rows as the model's signal width
+                        Decoded expected = LegacyDecode(head.data(), rows, anchors, classes, threshold, scale);
+                        Decoded actual = SharedDecode(head.data(), anchors, classes, threshold, scale, candidates);
+                        cases++;
+                        if (!Same(expected, actual))
+                        {
+                            failures++;
+                            std::printf("FAIL anchors %d classes %d extra %d distribution %d threshold %.2f: "
+                                "%zu candidates, expected %zu\n", anchors, classes, extraRows, (int)distribution,
+                                threshold, actual.classIds.size(), expected.classIds.size());
+                        }
+                    }
+                }
+            }
+        }
+    }
+    std::printf("%d cases, %d failures (%s decoder)\n", cases, failures,
+#if defined(YOLO_HEAD_DECODER_AVX512)
+        "AVX-512"
+#elif defined(YOLO_HEAD_DECODER_AVX2)
+        "AVX2"
+#elif defined(YOLO_HEAD_DECODER_NEON)
+        "NEON"
+#else
+        "scalar"
+#endif
+    );
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,254 @@
+// Steady-state allocation test and latency comparison for the IoBinding path of YOLO_V8::RunSession.
+//
+// Usage: ./IoBindingTest [model.onnx [image [iterations]]]   (default yolov8n.onnx, random frame, 200)
+// Linux/macOS only: it replaces the global operator new with malloc-backed counting versions.
+//
+// Every operator new in the process is counted, including the ones inside onnxruntime. The test:
+//   1. measures what a bare Ort::Session::Run over an IoBinding of preallocated tensors allocates per run,
+//      which is onnxruntime's own per-run bookkeeping and the floor for any caller;
+//   2. runs YOLO_V8 with ioBinding = false (tensors created per run, output allocated by ORT) and = true,
+//      on a blank frame (no detections) and on the image, and reports allocations per RunSession;
+//   3. fails if the bound RunSession on the blank frame allocates more than the bare Run, i.e. if the
+//      letterbox, the binding or the decode scratch allocate anything of their own.
+// Frames with detections are reported but not checked: the result vector and the NMS scratch grow with the
+// number of boxes.
+// onnxruntime's CPU arena allocates with aligned malloc, not operator new; with the arena enabled it reuses
+// its blocks after the warm-up.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include "inference.h"
+
+
+static std::atomic<bool> counting{ false };
+static std::atomic<size_t> allocations{ 0 };
+
+
+static void* CountedAlloc(size_t size)
+{
+    if (counting.load(std::memory_order_relaxed))
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    void* p = std::malloc(size ? size : 1);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+
+static void* CountedAlignedAlloc(size_t size, std::align_val_t align)
+{
+    if (counting.load(std::memory_order_relaxed))
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    size_t alignment = static_cast<size_t>(align);
+    void* p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+
+void* operator new(size_t size) { return CountedAlloc(size); }
+void* operator new[](size_t size) { return CountedAlloc(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    try { return CountedAlloc(size); } catch (...) { return nullptr; }
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    try { return CountedAlloc(size); } catch (...) { return nullptr; }
+}
+void* operator new(size_t size, std::align_val_t align) { return CountedAlignedAlloc(size, align); }
+void* operator new[](size_t size, std::align_val_t align) { return CountedAlignedAlloc(size, align); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+
+// Average operator new calls per body() over iterations, after two untimed warm-up calls
+template<typename F>
+static double AllocationsPerRun(int iterations, F body)
+{
+    body();
+    body();
+    allocations = 0;
+    counting = true;
+    for (int i = 0; i < iterations; i++)
+    {
+        body();
+    }
+    counting = false;
+    return (double)allocations / iterations;
+}
+
+
+struct Latency
+{
+    double p50, p90, p99, max, mean;
+};
+
+
+template<typename F>
+static Latency Measure(int iterations, F body)
+{
+    body();
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (int i = 0; i < iterations; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double s : samples)
+    {
+        sum += s;
+    }
+    auto at = [&](double q) { return samples[(std::min)(samples.size() - 1, (size_t)(q * samples.size()))]; };
+    return { at(0.50), at(0.90), at(0.99), samples.back(), sum / samples.size() };
+}
+
+
+// onnxruntime alone: Run over an IoBinding of tensors allocated once, no pre- or post-processing
+static double BareOrtAllocations(const std::string& modelPath, const std::vector<int>& imgSize, int iterations)
+{
+    Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "IoBindingTest");
+    Ort::SessionOptions sessionOption;
+    sessionOption.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+    sessionOption.SetIntraOpNumThreads(1);
+    Ort::Session session(env, modelPath.c_str(), sessionOption);
+    Ort::AllocatorWithDefaultOptions allocator;
+    Ort::AllocatedStringPtr inputName = session.GetInputNameAllocated(0, allocator);
+    Ort::AllocatedStringPtr outputName = session.GetOutputNameAllocated(0, allocator);
+
+    Ort::MemoryInfo memoryInfo = Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU);
+    std::vector<int64_t> inputDims = { 1, 3, imgSize.at(0), imgSize.at(1) };
+    std::vector<float> input(3 * imgSize.at(0) * imgSize.at(1), 0.5f);
+    Ort::Value inputTensor = Ort::Value::CreateTensor<float>(memoryInfo, input.data(), input.size(), inputDims.data(),
+        inputDims.size());
+
+    // Output shape from one plain run, dynamic axes included
+    const char* inputNames[] = { inputName.get() };
+    const char* outputNames[] = { outputName.get() };
+    std::vector<int64_t> outputDims = session.Run(Ort::RunOptions{ nullptr }, inputNames, &inputTensor, 1, outputNames,
+        1).front().GetTensorTypeAndShapeInfo().GetShape();
+    size_t outputCount = 1;
+    for (int64_t dim : outputDims)
+    {
+        outputCount *= (size_t)dim;
+    }
+    std::vector<float> output(outputCount);
+    Ort::Value outputTensor = Ort::Value::CreateTensor<float>(memoryInfo, output.data(), output.size(),
+        outputDims.data(), outputDims.size());
+
+    Ort::IoBinding binding(session);
+    binding.BindInput(inputName.get(), inputTensor);
+    binding.BindOutput(outputName.get(), outputTensor);
+    Ort::RunOptions options{ nullptr };
+    return AllocationsPerRun(iterations, [&] { session.Run(options, binding); });
+}
+
+
+static void PrintLatency(const char* name, const Latency& l)
+{
+    std::cout << "  " << std::left << std::setw(12) << name << std::right << "p50 " << std::setw(8) << l.p50
+              << "  p90 " << std::setw(8) << l.p90 << "  p99 " << std::setw(8) << l.p99 << "  max " << std::setw(8)
+              << l.max << "  mean " << std::setw(8) << l.mean << " ms\n";
+}
+
+
+int main(int argc, char** argv)
+{
+    std::string modelPath = argc > 1 ? argv[1] : "yolov8n.onnx";
+    cv::Mat image;
+    if (argc > 2)
+    {
+        image = cv::imread(argv[2]);
+    }
+    if (image.empty())
+    {
+        image = cv::Mat(720, 1280, CV_8UC3);
+        cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(256));
+    }
+    int iterations = argc > 3 ? std::atoi(argv[3]) : 200;
+    const cv::Mat blank(720, 1280, CV_8UC3, cv::Scalar(114, 114, 114));
+
+    DL_INIT_PARAM params;
+    params.modelPath = modelPath;
+    params.modelType = YOLO_DETECT_V8;
+    params.imgSize = { 640, 640 };
+    params.rectConfidenceThreshold = 0.25;
+    params.iouThreshold = 0.5;
+    params.cudaEnable = false;
+
+    YOLO_V8 perRun;
+    YOLO_V8 bound;
+    params.ioBinding = false;
+    if (perRun.CreateSession(params) != RET_OK)
+    {
+        return 1;
+    }
+    params.ioBinding = true;
+    if (bound.CreateSession(params) != RET_OK)
+    {
+        return 1;
+    }
+
+    std::vector<DL_RESULT> results;
+    results.reserve(300);
+    auto run = [&](YOLO_V8& detector, const cv::Mat& frame) {
+        return [&detector, &frame, &results] {
+            results.clear();
+            detector.RunSession(const_cast<cv::Mat&>(frame), results);
+        };
+    };
+    double bareAllocs = BareOrtAllocations(modelPath, params.imgSize, iterations);
+    double perRunBlank = AllocationsPerRun(iterations, run(perRun, blank));
+    double boundBlank = AllocationsPerRun(iterations, run(bound, blank));
+    double perRunImage = AllocationsPerRun(iterations, run(perRun, image));
+    double boundImage = AllocationsPerRun(iterations, run(bound, image));
+    size_t detections = results.size();
+    Latency perRunLatency = Measure(iterations, run(perRun, image));
+    Latency boundLatency = Measure(iterations, run(bound, image));
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << modelPath << ", " << iterations << " iterations, " << detections << " detection(s) on the image\n\n";
+    std::cout << "operator new per run\n";
+    std::cout << "  bare Ort::Session::Run + IoBinding   " << std::setw(8) << bareAllocs << "\n";
+    std::cout << "  RunSession per-run tensors, blank    " << std::setw(8) << perRunBlank << "\n";
+    std::cout << "  RunSession IoBinding, blank          " << std::setw(8) << boundBlank << "\n";
+    std::cout << "  RunSession per-run tensors, image    " << std::setw(8) << perRunImage << "\n";
+    std::cout << "  RunSession IoBinding, image          " << std::setw(8) << boundImage << "\n\n";
+    std::cout << "RunSession latency\n";
+    PrintLatency("per-run", perRunLatency);
+    PrintLatency("IoBinding", boundLatency);
+
+    if (boundBlank > bareAllocs)
+    {
+        std::cout << "\nFAIL RunSession allocates " << boundBlank - bareAllocs << " times per run on top of onnxruntime\n";
+        return 1;
+    }
+    std::cout << "\nOK RunSession adds no allocations to onnxruntime's own\n";
+    return 0;
+}
@@ -0,0 +1,209 @@
+// Test of yolo::MaskDecoder (../YOLOv8-CPP-Common/mask_decoder.h) against the full-prototype reference: the
+// coefficients times every prototype pixel, sigmoid everywhere, bilinear upsample (align_corners=False) of the
+// whole mask to the letterboxed image, then crop to the box and threshold. Smooth random prototypes, boxes
+// inside, across and outside the image, several letterbox scales, proto sizes, channel counts and thresholds.
+// The decoded runs must cover exactly the clipped box and set the same pixels; a pixel may only differ when
+// its reference logit is within rounding of the threshold.
+//
+// Usage: ./MaskDecoderTest   (registered with ctest)
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "mask_decoder.h"
+
+
+struct Protos
+{
+    int channels, height, width;
+    std::vector<float> data;
+};
+
+
+static Protos Generate(std::mt19937& rng, int channels, int height, int width)
+{
+    // A few random waves per channel, so masks have blobs and edges like real prototypes
+    Protos p{ channels, height, width, std::vector<float>((size_t)channels * height * width) };
+    std::uniform_real_distribution<float> u(0.0f, 1.0f);
+    for (int c = 0; c < channels; c++)
+    {
+        float fx = 0.02f + 0.2f * u(rng), fy = 0.02f + 0.2f * u(rng), phase = 6.28f * u(rng);
+        float gx = 0.02f + 0.1f * u(rng), gy = 0.02f + 0.1f * u(rng);
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                p.data[((size_t)c * height + y) * width + x] =
+                    std::sin(fx * x + fy * y + phase) + 0.5f * std::cos(gx * x - gy * y);
+            }
+        }
+    }
+    return p;
+}
+
+
+// Bitmap of the clipped box, 1 = set, 2 = too close to the threshold to tell
+static std::vector<unsigned char> Reference(const Protos& p, const std::vector<float>& coefficients,
+    const yolo::MaskGeometry& g, const float* box, float threshold, int& x0, int& y0, int& x1, int& y1)
+{
+    std::vector<double> logits((size_t)p.height * p.width, 0.0);
+    for (int c = 0; c < p.channels; c++)
+    {
+        for (size_t i = 0; i < logits.size(); i++)
+        {
+            logits[i] += (double)coefficients[c] * p.data[(size_t)c * logits.size() + i];
+        }
+    }
+    double ratioX = (double)p.width / (g.input_width * (double)g.scale);
+    double ratioY = (double)p.height / (g.input_height * (double)g.scale);
+    auto tap = [](int d, double ratio, int size, int& i0, int& i1, double& l1) {
+        double s = std::max(0.0, (d + 0.5) * ratio - 0.5);
+        i0 = std::min((int)s, size - 1);
+        i1 = i0 < size - 1 ? i0 + 1 : i0;
+        l1 = s - i0;
+    };
+    x0 = std::max(0, (int)std::ceil(box[0]));
+    y0 = std::max(0, (int)std::ceil(box[1]));
+    x1 = std::min(g.image_width, (int)std::ceil(box[2]));
+    y1 = std::min(g.image_height, (int)std::ceil(box[3]));
+    std::vector<unsigned char> bitmap;
+    for (int y = y0; y < y1; y++)
+    {
+        int iy0, iy1;
+        double ly;
+        tap(y, ratioY, p.height, iy0, iy1, ly);
+        for (int x = x0; x < x1; x++)
+        {
+            int ix0, ix1;
+            double lx;
+            tap(x, ratioX, p.width, ix0, ix1, lx);
+            double v = (1 - ly) * ((1 - lx) * logits[iy0 * p.width + ix0] + lx * logits[iy0 * p.width + ix1]) +
+                ly * ((1 - lx) * logits[iy1 * p.width + ix0] + lx * logits[iy1 * p.width + ix1]);
+            double probability = 1.0 / (1.0 + std::exp(-v));
+            double logit = std::log((double)threshold / (1.0 - threshold));
+            bitmap.push_back(std::fabs(v - logit) < 1e-4 ? 2 : probability > threshold);
+        }
+    }
+    return bitmap;
+}
+
+
+int main()
+{
+    std::mt19937 rng(38);
+    yolo::MaskDecoder decoder;//reused across cases like the backends do
+    yolo::MaskRle mask;
+    int cases = 0;
+    int failures = 0;
+    size_t ambiguous = 0;
+    struct Shape { int channels, protoH, protoW, inputH, inputW; };
+    for (Shape s : { Shape{ 32, 160, 160, 640, 640 }, Shape{ 32, 60, 80, 240, 320 }, Shape{ 7, 40, 40, 160, 160 } })
+    {
+        Protos p = Generate(rng, s.channels, s.protoH, s.protoW);
+        for (int image : { 0, 1, 2 })
+        {
+            yolo::MaskGeometry g;
+            g.proto_width = s.protoW;
+            g.proto_height = s.protoH;
+            g.input_width = s.inputW;
+            g.input_height = s.inputH;
+            const int sizes[3][2] = { { s.inputW, s.inputH }, { 1920, 1080 }, { 375, 500 } };
+            g.image_width = sizes[image][0];
+            g.image_height = sizes[image][1];
+            g.scale = std::max((float)g.image_width / g.input_width, (float)g.image_height / g.input_height);
+            std::uniform_real_distribution<float> px(-0.1f * g.image_width, 1.1f * g.image_width);
+            std::uniform_real_distribution<float> py(-0.1f * g.image_height, 1.1f * g.image_height);
+            std::normal_distribution<float> coefficient(0.0f, 1.0f);
+            for (int k = 0; k < 25; k++)
+            {
+                float box[4] = { px(rng), py(rng), px(rng), py(rng) };
+                if (k % 5 != 4)//every fifth box is left inverted (empty)
+                {
+                    if (box[2] < box[0]) std::swap(box[0], box[2]);
+                    if (box[3] < box[1]) std::swap(box[1], box[3]);
+                }
+                std::vector<float> coefficients(s.channels);
+                for (float& c : coefficients)
+                {
+                    c = coefficient(rng);
+                }
+                // Coefficients as they sit in the head: one column of a channel-major output
+                const int stride = 11;
+                std::vector<float> column((size_t)s.channels * stride, 0.0f);
+                for (int c = 0; c < s.channels; c++)
+                {
+                    column[(size_t)c * stride] = coefficients[c];
+                }
+                for (float threshold : { 0.5f, 0.3f, 0.8f })
+                {
+                    cases++;
+                    int x0, y0, x1, y1;
+                    std::vector<unsigned char> expected = Reference(p, coefficients, g, box, threshold, x0, y0, x1, y1);
+                    size_t area = decoder.Decode(column.data(), stride, p.data.data(), s.channels, g, box[0], box[1],
+                        box[2], box[3], threshold, mask);
+
+                    bool ok = true;
+                    const int width = std::max(0, x1 - x0), height = std::max(0, y1 - y0);
+                    size_t total = 0;
+                    for (uint32_t count : mask.counts)
+                    {
+                        total += count;
+                    }
+                    if (width == 0 || height == 0)
+                    {
+                        ok = mask.width == 0 && mask.height == 0 && mask.counts.empty() && area == 0;
+                    }
+                    else if (mask.x != x0 || mask.y != y0 || mask.width != width || mask.height != height ||
+                        total != (size_t)width * height || area != mask.Area())
+                    {
+                        ok = false;
+                    }
+                    else
+                    {
+                        std::vector<unsigned char> actual((size_t)g.image_width * g.image_height, 0);
+                        yolo::PaintMask(mask, actual.data(), g.image_width, 1);
+                        for (int y = 0; y < g.image_height && ok; y++)
+                        {
+                            for (int x = 0; x < g.image_width; x++)
+                            {
+                                bool inside = x >= x0 && x < x1 && y >= y0 && y < y1;
+                                unsigned char want = inside ? expected[(size_t)(y - y0) * width + (x - x0)] : 0;
+                                unsigned char got = actual[(size_t)y * g.image_width + x];
+                                if (want == 2)
+                                {
+                                    ambiguous++;
+                                }
+                                else if (want != got)
+                                {
+                                    ok = false;
+                                    break;
+                                }
+                            }
+                        }
+                    }
+                    if (!ok)
+                    {
+                        failures++;
+                        std::printf("FAIL %d channels, proto %dx%d, image %dx%d, box %.1f %.1f %.1f %.1f, threshold "
+                            "%.2f: got %dx%d at %d,%d, %zu px\n", s.channels, s.protoW, s.protoH, g.image_width,
+                            g.image_height, box[0], box[1], box[2], box[3], threshold, mask.width, mask.height, mask.x,
+                            mask.y, area);
+                    }
+                }
+            }
+        }
+    }
+
+    std::printf("%d cases, %d failures, %zu pixels at the threshold (%s product)\n", cases, failures, ambiguous,
+#if defined(YOLO_MASK_DECODER_AVX2)
+        "AVX2"
+#elif defined(YOLO_MASK_DECODER_NEON)
+        "NEON"
+#else
+        "scalar"
+#endif
+    );
+    return failures ? 1 : 0;
+}
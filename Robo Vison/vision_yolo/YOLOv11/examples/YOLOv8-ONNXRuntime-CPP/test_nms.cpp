@@ -0,0 +1,194 @@
+// Test of yolo::NonMaxSuppression (../YOLOv8-CPP-Common/nms.h) against a brute-force reference: stable sort
+// by score, every kept box suppresses all later overlapping boxes (torchvision nms), classes kept apart by
+// comparing ids, then the first max_det. Clustered random candidates with integer corners (what the cv::Rect
+// backends pass) and tied scores; class-aware and agnostic, with and without the grid, several thresholds and
+// max_det values, plus RunRects and RunBatch. The kept indices must match exactly, order included.
+//
+// Usage: ./NmsTest   (registered with ctest)
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "nms.h"
+
+
+struct Candidates
+{
+    std::vector<float> boxes;//x1, y1, x2, y2
+    std::vector<float> scores;
+    std::vector<int> classIds;
+};
+
+
+struct Rect
+{
+    int x, y, width, height;
+};
+
+
+static Candidates Generate(std::mt19937& rng, size_t count, int classNum)
+{
+    Candidates c;
+    size_t objects = std::max<size_t>(1, count / 20);
+    std::uniform_int_distribution<int> position(0, 1800);
+    std::uniform_int_distribution<int> size(4, 300);
+    std::uniform_int_distribution<int> jitter(-12, 12);
+    std::vector<int> centers;
+    for (size_t o = 0; o < objects; o++)
+    {
+        centers.insert(centers.end(), { position(rng), position(rng), size(rng), size(rng), (int)(rng() % classNum) });
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        const int* o = &centers[5 * (rng() % objects)];
+        float x1 = (float)(o[0] + jitter(rng));
+        float y1 = (float)(o[1] + jitter(rng));
+        c.boxes.insert(c.boxes.end(), { x1, y1, x1 + o[2] + jitter(rng), y1 + o[3] + jitter(rng) });
+        c.scores.push_back((float)(rng() % 64) / 64.0f);//ties
+        c.classIds.push_back(rng() % 4 == 0 ? (int)(rng() % classNum) : o[4]);
+    }
+    return c;
+}
+
+
+static std::vector<int> Reference(const Candidates& c, const yolo::NmsOptions& options)
+{
+    std::vector<int> order;
+    for (size_t i = 0; i < c.scores.size(); i++)
+    {
+        if (c.scores[i] > options.score_threshold)
+        {
+            order.push_back((int)i);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return c.scores[a] > c.scores[b]; });
+    std::vector<char> suppressed(c.scores.size(), 0);
+    std::vector<int> keep;
+    for (size_t k = 0; k < order.size(); k++)
+    {
+        int i = order[k];
+        if (suppressed[i])
+        {
+            continue;
+        }
+        keep.push_back(i);
+        const float* a = &c.boxes[4 * i];
+        float areaA = (a[2] - a[0]) * (a[3] - a[1]);
+        for (size_t l = k + 1; l < order.size(); l++)
+        {
+            int j = order[l];
+            if (suppressed[j] || (!options.agnostic && c.classIds[i] != c.classIds[j]))
+            {
+                continue;
+            }
+            const float* b = &c.boxes[4 * j];
+            float w = std::max(0.0f, std::min(a[2], b[2]) - std::max(a[0], b[0]));
+            float h = std::max(0.0f, std::min(a[3], b[3]) - std::max(a[1], b[1]));
+            float inter = w * h;
+            if (inter / (areaA + (b[2] - b[0]) * (b[3] - b[1]) - inter) > options.iou_threshold)
+            {
+                suppressed[j] = 1;
+            }
+        }
+    }
+    if (options.max_det > 0 && keep.size() > (size_t)options.max_det)
+    {
+        keep.resize(options.max_det);
+    }
+    return keep;
+}
+
+
+int main()
+{
+    std::mt19937 rng(36);
+    yolo::NonMaxSuppression nms;//reused across cases like the backends do
+    std::vector<int> keep;
+    int cases = 0;
+    int failures = 0;
+    auto check = [&](const char* what, size_t count, const yolo::NmsOptions& options, const std::vector<int>& expected,
+        const std::vector<int>& actual) {
+        cases++;
+        if (expected != actual)
+        {
+            failures++;
+            std::printf("FAIL %s: %zu candidates, agnostic %d, grid from %zu, iou %.2f, max_det %d: kept %zu, "
+                "expected %zu\n", what, count, (int)options.agnostic, options.grid_min_candidates,
+                options.iou_threshold, options.max_det, actual.size(), expected.size());
+        }
+    };
+
+    for (size_t count : { 0, 1, 7, 100, 1000, 5000, 10000 })
+    {
+        Candidates c = Generate(rng, count, 10);
+        for (bool agnostic : { false, true })
+        {
+            for (size_t gridFrom : { (size_t)0, (size_t)-1 })
+            {
+                for (float iou : { 0.45f, 0.7f, 0.0f })
+                {
+                    for (int maxDet : { 300, 0, 5 })
+                    {
+                        for (float scoreThreshold : { -FLT_MAX, 0.3f })
+                        {
+                            yolo::NmsOptions options;
+                            options.agnostic = agnostic;
+                            options.grid_min_candidates = gridFrom;
+                            options.iou_threshold = iou;
+                            options.max_det = maxDet;
+                            options.score_threshold = scoreThreshold;
+                            nms.Run(c.boxes.data(), c.scores.data(), c.classIds.data(), count, options, keep);
+                            check("Run", count, options, Reference(c, options), keep);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // cv::Rect-like input and several images at once
+    std::vector<Candidates> images;
+    std::vector<yolo::NmsInput> inputs;
+    for (size_t count : { 2000, 0, 300 })
+    {
+        images.push_back(Generate(rng, count, 80));
+    }
+    for (const Candidates& c : images)
+    {
+        yolo::NmsInput input;
+        input.boxes = c.boxes.data();
+        input.scores = c.scores.data();
+        input.class_ids = c.classIds.data();
+        input.count = c.scores.size();
+        inputs.push_back(input);
+    }
+    yolo::NmsOptions options;
+    std::vector<std::vector<int>> batchKeep;
+    nms.RunBatch(inputs.data(), inputs.size(), options, batchKeep);
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        check("RunBatch", images[i].scores.size(), options, Reference(images[i], options), batchKeep[i]);
+
+        std::vector<Rect> rects;
+        for (size_t j = 0; j < images[i].scores.size(); j++)
+        {
+            const float* b = &images[i].boxes[4 * j];
+            rects.push_back({ (int)b[0], (int)b[1], (int)(b[2] - b[0]), (int)(b[3] - b[1]) });
+        }
+        nms.RunRects(rects, images[i].scores, images[i].classIds, options, keep);
+        check("RunRects", rects.size(), options, Reference(images[i], options), keep);
+    }
+
+    std::printf("%d cases, %d failures (%s IoU)\n", cases, failures,
+#if defined(YOLO_NMS_AVX2)
+        "AVX2"
+#elif defined(YOLO_NMS_NEON)
+        "NEON"
+#else
+        "scalar"
+#endif
+    );
+    return failures ? 1 : 0;
+}
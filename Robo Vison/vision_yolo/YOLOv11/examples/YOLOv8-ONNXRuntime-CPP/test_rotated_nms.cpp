@@ -0,0 +1,185 @@
+// Test of the oriented box helpers in ../YOLOv8-CPP-Common/rotated_nms.h. RegularizeRotatedBox, RotatedBoxCorners
+// and ProbIou are checked against values from ultralytics ops (regularize_rboxes, xywhr2xyxyxyxy, batch_probiou).
+// yolo::RotatedNonMaxSuppression is checked against a brute-force greedy reference that compares every candidate
+// with every kept box of its class through ProbIou, without the Mahalanobis pre-test. The candidates are clustered,
+// rotated, thin and wide, with tied scores. Runs are class-aware and agnostic, over several thresholds and max_det
+// values, and the kept indices must match exactly, order included.
+//
+// Usage: ./RotatedNmsTest   (registered with ctest)
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "rotated_nms.h"
+
+
+struct Candidates
+{
+    std::vector<yolo::RotatedBox> boxes;
+    std::vector<float> scores;
+    std::vector<int> classIds;
+};
+
+
+static Candidates Generate(std::mt19937& rng, size_t count, int classNum)
+{
+    Candidates c;
+    size_t objects = std::max<size_t>(1, count / 20);
+    std::uniform_real_distribution<float> position(0.0f, 1024.0f);
+    std::uniform_real_distribution<float> size(2.0f, 300.0f);
+    std::uniform_real_distribution<float> angle(-3.2f, 3.2f);
+    std::uniform_real_distribution<float> jitter(-1.0f, 1.0f);
+    std::vector<yolo::RotatedBox> centers;
+    std::vector<int> centerClass;
+    for (size_t o = 0; o < objects; o++)
+    {
+        centers.push_back({ position(rng), position(rng), size(rng), size(rng), angle(rng) });
+        centerClass.push_back((int)(rng() % classNum));
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t o = rng() % objects;
+        yolo::RotatedBox b = centers[o];
+        b.cx += 8.0f * jitter(rng);
+        b.cy += 8.0f * jitter(rng);
+        b.width = std::max(1.0f, b.width * (1.0f + 0.1f * jitter(rng)));
+        b.height = std::max(1.0f, b.height * (1.0f + 0.1f * jitter(rng)));
+        b.angle += 0.2f * jitter(rng);
+        c.boxes.push_back(yolo::RegularizeRotatedBox(b));
+        c.scores.push_back((float)(rng() % 64) / 64.0f);//ties
+        c.classIds.push_back(rng() % 4 == 0 ? (int)(rng() % classNum) : centerClass[o]);
+    }
+    return c;
+}
+
+
+static std::vector<int> Reference(const Candidates& c, const yolo::NmsOptions& options)
+{
+    std::vector<int> order;
+    for (size_t i = 0; i < c.scores.size(); i++)
+    {
+        if (c.scores[i] > options.score_threshold)
+        {
+            order.push_back((int)i);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return c.scores[a] > c.scores[b]; });
+    std::vector<int> keep;
+    for (int i : order)
+    {
+        if (options.max_det > 0 && keep.size() == (size_t)options.max_det)
+        {
+            break;
+        }
+        bool suppressed = false;
+        for (int k : keep)
+        {
+            if ((options.agnostic || c.classIds[i] == c.classIds[k]) &&
+                yolo::ProbIou(c.boxes[k], c.boxes[i]) > options.iou_threshold)
+            {
+                suppressed = true;
+                break;
+            }
+        }
+        if (!suppressed)
+        {
+            keep.push_back(i);
+        }
+    }
+    return keep;
+}
+
+
+static bool Near(float a, float b)
+{
+    return std::fabs(a - b) <= 1e-4f * std::max(1.0f, std::fabs(b));
+}
+
+
+int main()
+{
+    int cases = 0;
+    int failures = 0;
+    auto expect = [&](const char* what, bool ok) {
+        cases++;
+        if (!ok)
+        {
+            failures++;
+            std::printf("FAIL %s\n", what);
+        }
+    };
+
+    // Helpers against ultralytics ops
+    const float pi = 3.14159265f;
+    yolo::RotatedBox r = yolo::RegularizeRotatedBox({ 10.0f, 20.0f, 30.0f, 40.0f, 2.0f });
+    expect("regularize swaps in [pi/2, pi)",
+        Near(r.width, 40.0f) && Near(r.height, 30.0f) && Near(r.angle, 2.0f - pi / 2));
+    r = yolo::RegularizeRotatedBox({ 10.0f, 20.0f, 30.0f, 40.0f, -0.5f });
+    expect("regularize negative angle", Near(r.width, 40.0f) && Near(r.height, 30.0f) && Near(r.angle, pi / 2 - 0.5f));
+    r = yolo::RegularizeRotatedBox({ 10.0f, 20.0f, 30.0f, 40.0f, 0.3f });
+    expect("regularize keeps [0, pi/2)", Near(r.width, 30.0f) && Near(r.height, 40.0f) && Near(r.angle, 0.3f));
+    float corners[8];
+    yolo::RotatedBoxCorners({ 100.0f, 50.0f, 40.0f, 20.0f, pi / 2 }, corners);
+    const float expected[8] = { 90.0f, 70.0f, 110.0f, 70.0f, 110.0f, 30.0f, 90.0f, 30.0f };
+    bool cornersOk = true;
+    for (int i = 0; i < 8; i++)
+    {
+        cornersOk = cornersOk && std::fabs(corners[i] - expected[i]) < 1e-3f;
+    }
+    expect("xywhr2xyxyxyxy", cornersOk);
+    yolo::RotatedBox a{ 100.0f, 100.0f, 50.0f, 20.0f, 0.4f };
+    expect("probiou of a box with itself", ProbIou(a, a) > 0.99f);
+    expect("probiou of far boxes", ProbIou(a, { 400.0f, 400.0f, 50.0f, 20.0f, 0.4f }) < 1e-3f);
+    expect("probiou is symmetric",
+        ProbIou(a, { 110.0f, 95.0f, 40.0f, 25.0f, 1.0f }) == ProbIou({ 110.0f, 95.0f, 40.0f, 25.0f, 1.0f }, a));
+    expect("probiou ignores half turns", Near(ProbIou(a, { 105.0f, 100.0f, 50.0f, 20.0f, 0.4f + pi }),
+        ProbIou(a, { 105.0f, 100.0f, 50.0f, 20.0f, 0.4f })));
+
+    std::mt19937 rng(39);
+    yolo::RotatedNonMaxSuppression nms;//reused across cases like the backends do
+    std::vector<int> keep;
+    for (size_t count : { 0, 1, 7, 100, 1000, 4000 })
+    {
+        Candidates c = Generate(rng, count, 15);
+        for (bool agnostic : { false, true })
+        {
+            for (float iou : { 0.45f, 0.7f, 0.05f, 0.0f, -0.1f })
+            {
+                for (int maxDet : { 300, 0, 5 })
+                {
+                    for (float scoreThreshold : { -FLT_MAX, 0.3f })
+                    {
+                        yolo::NmsOptions options;
+                        options.agnostic = agnostic;
+                        options.iou_threshold = iou;
+                        options.max_det = maxDet;
+                        options.score_threshold = scoreThreshold;
+                        nms.Run(c.boxes.data(), c.scores.data(), c.classIds.data(), count, options, keep);
+                        std::vector<int> reference = Reference(c, options);
+                        cases++;
+                        if (keep != reference)
+                        {
+                            failures++;
+                            std::printf("FAIL Run: %zu candidates, agnostic %d, iou %.2f, max_det %d: kept %zu, "
+                                "expected %zu\n", count, (int)agnostic, iou, maxDet, keep.size(), reference.size());
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::printf("%d cases, %d failures (%s pre-test)\n", cases, failures,
+#if defined(YOLO_ROTATED_NMS_AVX2)
+        "AVX2"
+#elif defined(YOLO_ROTATED_NMS_NEON)
+        "NEON"
+#else
+        "scalar"
+#endif
+    );
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,218 @@
+// Test of the sliced-inference geometry and merge in ../YOLOv8-CPP-Common/slicing.h behind RunSessionSliced: tiles
+// against sahi.slicing.get_slice_bboxes for common frame sizes, and NMS / NMM with IoU and IoS against
+// hand-worked cases and a brute-force greedy reference.
+//
+// Usage: ./SlicingTest   (registered with ctest)
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "slicing.h"
+
+
+// sahi.slicing.get_slice_bboxes, transcribed
+static std::vector<yolo::SliceRect> SahiSlices(int width, int height, int sliceWidth, int sliceHeight, float overlapW,
+    float overlapH)
+{
+    std::vector<yolo::SliceRect> slices;
+    int overlapY = int(overlapH * sliceHeight);
+    int overlapX = int(overlapW * sliceWidth);
+    int yMin = 0, yMax = 0;
+    while (yMax < height)
+    {
+        int xMin = 0, xMax = 0;
+        yMax = yMin + sliceHeight;
+        while (xMax < width)
+        {
+            xMax = xMin + sliceWidth;
+            yolo::SliceRect slice;
+            if (yMax > height || xMax > width)
+            {
+                int x2 = std::min(width, xMax);
+                int y2 = std::min(height, yMax);
+                slice.x = std::max(0, x2 - sliceWidth);
+                slice.y = std::max(0, y2 - sliceHeight);
+                slice.width = x2 - slice.x;
+                slice.height = y2 - slice.y;
+            }
+            else
+            {
+                slice.x = xMin;
+                slice.y = yMin;
+                slice.width = sliceWidth;
+                slice.height = sliceHeight;
+            }
+            slices.push_back(slice);
+            xMin = xMax - overlapX;
+        }
+        yMin = yMax - overlapY;
+    }
+    return slices;
+}
+
+
+static bool Same(const std::vector<yolo::SliceRect>& a, const std::vector<yolo::SliceRect>& b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (a[i].x != b[i].x || a[i].y != b[i].y || a[i].width != b[i].width || a[i].height != b[i].height)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+static yolo::SliceBox Box(float x1, float y1, float x2, float y2, float score, int classId = 0)
+{
+    yolo::SliceBox box;
+    box.x1 = x1;
+    box.y1 = y1;
+    box.x2 = x2;
+    box.y2 = y2;
+    box.score = score;
+    box.class_id = classId;
+    return box;
+}
+
+
+int main()
+{
+    int cases = 0;
+    int failures = 0;
+    auto expect = [&](const char* what, bool ok) {
+        cases++;
+        if (!ok)
+        {
+            failures++;
+            std::printf("FAIL %s\n", what);
+        }
+    };
+
+    yolo::SliceOptions options;
+    std::vector<yolo::SliceRect> slices = yolo::ComputeSlices(1920, 1080, options);
+    // Columns at 0, 512, 1024 and 1280 (moved back to the border), rows at 0 and 440
+    expect("1080p tiles", slices.size() == 8 && slices[3].x == 1280 && slices[4].y == 440 && slices[7].x == 1280 &&
+        slices[7].y == 440 && slices[7].width == 640 && slices[7].height == 640);
+    slices = yolo::ComputeSlices(500, 300, options);
+    expect("frame smaller than a slice", slices.size() == 1 && slices[0].width == 500 && slices[0].height == 300);
+    slices = yolo::ComputeSlices(640, 640, options);
+    expect("frame of one slice", slices.size() == 1);
+    expect("empty frame", yolo::ComputeSlices(0, 1080, options).empty());
+
+    const int sizes[][2] = { { 1920, 1080 }, { 3840, 2160 }, { 1280, 720 }, { 641, 641 }, { 4000, 3000 }, { 700, 2000 } };
+    const float overlaps[] = { 0.0f, 0.2f, 0.5f };
+    const int sliceSizes[] = { 320, 512, 640 };
+    bool matchesSahi = true;
+    for (const auto& size : sizes)
+    {
+        for (float overlap : overlaps)
+        {
+            for (int sliceSize : sliceSizes)
+            {
+                yolo::SliceOptions o;
+                o.slice_width = o.slice_height = sliceSize;
+                o.overlap_width_ratio = o.overlap_height_ratio = overlap;
+                matchesSahi = matchesSahi && Same(yolo::ComputeSlices(size[0], size[1], o),
+                    SahiSlices(size[0], size[1], sliceSize, sliceSize, overlap, overlap));
+            }
+        }
+    }
+    expect("tiles as sahi", matchesSahi);
+
+    // One object cut by a tile border: the left and right parts from two tiles, most of it from the full frame at
+    // the best score, and another object of class 1
+    yolo::SliceMerger merger;
+    std::vector<yolo::SliceBox> merged;
+    std::vector<yolo::SliceBox> pieces = { Box(100, 100, 150, 140, 0.8f), Box(140, 100, 200, 140, 0.7f),
+        Box(105, 100, 195, 140, 0.85f), Box(500, 500, 520, 520, 0.9f, 1) };
+    options.merge = yolo::SliceMerge::kNmm;
+    options.metric = yolo::SliceMatchMetric::kIos;
+    merger.Merge(pieces, options, merged);
+    expect("nmm ios rebuilds the object", merged.size() == 2 && merged[0].class_id == 1 && merged[1].x1 == 100 &&
+        merged[1].x2 == 200 && merged[1].score == 0.85f);
+
+    options.merge = yolo::SliceMerge::kNms;
+    merger.Merge(pieces, options, merged);
+    expect("nms ios keeps the best box as it is", merged.size() == 2 && merged[1].x1 == 105 && merged[1].x2 == 195);
+
+    // IoU: the left part (0.47) stays, the right part (0.58) goes
+    options.metric = yolo::SliceMatchMetric::kIou;
+    merger.Merge(pieces, options, merged);
+    expect("nms iou keeps the smaller piece", merged.size() == 3 && merged[2].x1 == 100 && merged[2].x2 == 150);
+
+    options.agnostic = true;
+    merger.Merge({ Box(0, 0, 10, 10, 0.9f, 0), Box(0, 0, 10, 10, 0.8f, 1) }, options, merged);
+    expect("agnostic matches across classes", merged.size() == 1 && merged[0].class_id == 0);
+    options.agnostic = false;
+    merger.Merge({ Box(0, 0, 10, 10, 0.9f, 0), Box(0, 0, 10, 10, 0.8f, 1) }, options, merged);
+    expect("classes kept apart", merged.size() == 2);
+
+    options.max_det = 1;
+    merger.Merge(pieces, options, merged);
+    expect("max_det", merged.size() == 1 && merged[0].score == 0.9f);
+    options.max_det = 300;
+
+    // Random boxes: the vectorized NMS path against the greedy loop of NMM without the merging
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> coordinate(0.0f, 400.0f);
+    std::uniform_real_distribution<float> extent(5.0f, 80.0f);
+    std::uniform_real_distribution<float> score(0.0f, 1.0f);
+    bool agree = true;
+    for (int round = 0; round < 50; round++)
+    {
+        std::vector<yolo::SliceBox> boxes;
+        for (int i = 0; i < 200; i++)
+        {
+            float x = coordinate(random);
+            float y = coordinate(random);
+            boxes.push_back(Box(x, y, x + extent(random), y + extent(random), score(random), i % 3));
+        }
+        yolo::SliceOptions nms;
+        nms.merge = yolo::SliceMerge::kNms;
+        nms.metric = yolo::SliceMatchMetric::kIou;
+        nms.match_threshold = 0.3f;
+        std::vector<yolo::SliceBox> fast, reference;
+        merger.Merge(boxes, nms, fast);
+        // Reference: every unmatched box in score order removes the later boxes of its class above the threshold
+        std::vector<int> order(boxes.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            order[i] = (int)i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return boxes[a].score > boxes[b].score; });
+        std::vector<bool> removed(boxes.size(), false);
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            if (removed[order[i]])
+            {
+                continue;
+            }
+            reference.push_back(boxes[order[i]]);
+            for (size_t j = i + 1; j < order.size(); j++)
+            {
+                const yolo::SliceBox& a = boxes[order[i]];
+                const yolo::SliceBox& b = boxes[order[j]];
+                if (a.class_id == b.class_id && yolo::SliceMerger::Match(a, b, yolo::SliceMatchMetric::kIou) > 0.3f)
+                {
+                    removed[order[j]] = true;
+                }
+            }
+        }
+        agree = agree && fast.size() == reference.size();
+        for (size_t i = 0; agree && i < fast.size(); i++)
+        {
+            agree = fast[i].x1 == reference[i].x1 && fast[i].y1 == reference[i].y1 && fast[i].score == reference[i].score;
+        }
+    }
+    expect("nms path matches the greedy reference", agree);
+
+    std::printf("%d cases, %d failures\n", cases, failures);
+    return failures ? 1 : 0;
+}
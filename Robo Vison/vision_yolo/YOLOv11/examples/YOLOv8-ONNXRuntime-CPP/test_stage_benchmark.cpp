@@ -0,0 +1,141 @@
+// Test of the benchmark statistics and reports in ../YOLOv8-CPP-Common/stage_benchmark.h that every
+// benchmark_stages tool uses: nearest-rank percentiles against hand-computed values, the timed loop against a fake
+// detector with known stage times (failures excluded, fps over the timed calls), and the JSON and CSV layouts.
+//
+// Usage: ./StageBenchmarkTest   (registered with ctest)
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "stage_benchmark.h"
+
+
+class FakeDetector : public yolo::IDetector
+{
+public:
+    const char* Name() const override { return "fake,\"cpu\""; }
+
+    bool Detect(const yolo::ImageView&, yolo::DetectionResults& results, yolo::StageTimes* times = nullptr) override
+    {
+        results.clear();
+        calls++;
+        // Every fourth timed call fails; the rest take 2 ms and report stages of 1, 2 and 3 ms
+        if (calls > warmup && (calls - warmup) % 4 == 0)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        if (times)
+        {
+            times->preprocess_ms = 1.0;
+            times->inference_ms = 2.0;
+            times->postprocess_ms = 3.0;
+        }
+        return true;
+    }
+
+    int warmup = 0;
+    int calls = 0;
+};
+
+
+static bool Near(double a, double b, double tolerance = 1e-9)
+{
+    return std::fabs(a - b) <= tolerance;
+}
+
+
+int main()
+{
+    int cases = 0;
+    int failures = 0;
+    auto expect = [&](const char* what, bool ok) {
+        cases++;
+        if (!ok)
+        {
+            failures++;
+            std::printf("FAIL %s\n", what);
+        }
+    };
+
+    // 1..100 shuffled: the nearest rank of p is p itself
+    std::vector<double> hundred;
+    for (int i = 100; i >= 1; i--)
+    {
+        hundred.push_back(i);
+    }
+    yolo::LatencyStats stats = yolo::Summarize(hundred);
+    expect("p50 of 1..100", Near(stats.p50, 50));
+    expect("p90 of 1..100", Near(stats.p90, 90));
+    expect("p99 of 1..100", Near(stats.p99, 99));
+    expect("max of 1..100", Near(stats.max, 100));
+    expect("mean of 1..100", Near(stats.mean, 50.5));
+
+    // Ten samples: p50 is the 5th, p90 the 9th, p99 rounds up to the 10th
+    stats = yolo::Summarize({ 10, 1, 9, 2, 8, 3, 7, 4, 6, 5 });
+    expect("p50 of 10", Near(stats.p50, 5));
+    expect("p90 of 10", Near(stats.p90, 9));
+    expect("p99 of 10", Near(stats.p99, 10));
+    stats = yolo::Summarize({ 4.5 });
+    expect("single sample", Near(stats.p50, 4.5) && Near(stats.p99, 4.5) && Near(stats.max, 4.5));
+    stats = yolo::Summarize({});
+    expect("no samples", Near(stats.p50, 0) && Near(stats.max, 0));
+
+    std::vector<int> threads = yolo::ParseThreadList("1,2,,8");
+    expect("thread list", threads == std::vector<int>({ 1, 2, 8 }));
+    expect("empty thread list is the default", yolo::ParseThreadList("") == std::vector<int>({ 0 }));
+
+    FakeDetector detector;
+    yolo::BenchmarkOptions options;
+    options.warmup = 3;
+    options.iterations = 20;
+    detector.warmup = options.warmup;
+    yolo::ImageView frame;
+    yolo::BenchmarkResult result;
+    bool ok = yolo::BenchmarkDetector(detector, frame, options, 4, result);
+    expect("benchmark ran", ok && detector.calls == 23);
+    expect("failures counted apart", result.iterations == 15 && result.failures == 5);
+    expect("stage times reported", Near(result.preprocess.p50, 1) && Near(result.inference.p99, 2) &&
+        Near(result.postprocess.max, 3));
+    expect("total is the wall time of the call", result.total.p50 >= 2.0 && result.total.p50 < 50.0);
+    // 15 successful calls of about 2 ms in the loop: well under 500 fps, far above 1
+    expect("fps over the timed loop", result.fps > 1.0 && result.fps < 500.0);
+    expect("name and threads", result.backend == "fake,\"cpu\"" && result.threads == 4);
+
+    yolo::BenchmarkInfo info;
+    info.model = "models/yolov8n.onnx";
+    info.frame_width = 1280;
+    info.frame_height = 720;
+    info.warmup = 3;
+    std::ostringstream json;
+    yolo::WriteJson(json, info, { result, result });
+    const std::string text = json.str();
+    expect("json escapes the name", text.find("\"backend\": \"fake,\\\"cpu\\\"\"") != std::string::npos);
+    expect("json has every stage", text.find("\"preprocess\": {\"p50_ms\": 1.0000") != std::string::npos &&
+        text.find("\"postprocess\": {\"p50_ms\": 3.0000") != std::string::npos &&
+        text.find("\"total\": {") != std::string::npos);
+    expect("json lists both results", text.find("},\n    {\"backend\"") != std::string::npos);
+    expect("json frame", text.find("\"frame\": [1280, 720]") != std::string::npos);
+
+    std::ostringstream csv;
+    yolo::WriteCsv(csv, info, { result });
+    std::istringstream lines(csv.str());
+    std::string header, row, extra;
+    std::getline(lines, header);
+    std::getline(lines, row);
+    expect("csv one row per result", !row.empty() && !std::getline(lines, extra));
+    size_t headerColumns = 1;
+    for (char c : header)
+    {
+        headerColumns += c == ',';
+    }
+    expect("csv header", headerColumns == 10 + 4 * 5 && header.find("inference_p99_ms") != std::string::npos);
+    expect("csv quotes the name", row.find(",\"fake,\"\"cpu\"\"\",4,15,5,") != std::string::npos);
+
+    std::printf("%d cases, %d failures\n", cases, failures);
+    return failures ? 1 : 0;
+}
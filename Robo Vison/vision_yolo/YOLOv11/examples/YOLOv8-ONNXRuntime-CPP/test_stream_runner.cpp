@@ -0,0 +1,220 @@
+// Test of the live-stream runner in ../YOLOv8-CPP-Common/stream_runner.h behind StreamDetector: the mailbox under
+// each drop policy, buffers swapped rather than copied, and whole streams from a paced fake camera into a slower
+// consumer (drops, newest frame first, bounded latency, stale frames, errors).
+//
+// Usage: ./StreamRunnerTest   (registered with ctest)
+
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "stream_runner.h"
+
+
+struct FakeFrame
+{
+    int sequence = -1;
+    std::vector<int> pixels;
+};
+
+
+// A camera at 500 fps (2 ms a frame) and a consumer taking 10 ms a frame
+static yolo::StreamStats RunCamera(yolo::DropPolicy policy, int frames, std::vector<int>& processed,
+    double maxAgeMs = 0.0)
+{
+    yolo::StreamOptions options;
+    options.policy = policy;
+    options.source_fps = 500.0;
+    options.max_age_ms = maxAgeMs;
+    int next = 0;
+    yolo::StreamRunner<FakeFrame> runner(options,
+        [&next, frames](FakeFrame& frame) {
+            if (next == frames)
+            {
+                return false;
+            }
+            frame.sequence = next++;
+            return true;
+        },
+        [&processed](FakeFrame& frame) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            processed.push_back(frame.sequence);
+            return true;
+        });
+    return runner.Run();
+}
+
+
+int main()
+{
+    int cases = 0;
+    int failures = 0;
+    auto expect = [&](const char* what, bool ok) {
+        cases++;
+        if (!ok)
+        {
+            failures++;
+            std::printf("FAIL %s\n", what);
+        }
+    };
+
+    // Mailbox on one thread
+    {
+        yolo::LatestMailbox<FakeFrame> mailbox(yolo::DropPolicy::kDropOldest);
+        FakeFrame frame;
+        frame.sequence = 1;
+        frame.pixels.assign(16, 1);
+        const int* buffer = frame.pixels.data();
+        expect("put into empty slot", mailbox.Put(frame));
+        expect("put hands back an empty buffer", frame.sequence == -1 && frame.pixels.empty());
+        frame.sequence = 2;
+        expect("put over a waiting frame drops it", !mailbox.Put(frame) && mailbox.dropped() == 1);
+        expect("the dropped frame's buffer comes back", frame.sequence == 1 && frame.pixels.data() == buffer);
+        FakeFrame taken;
+        expect("take the newest", mailbox.Take(taken) && taken.sequence == 2);
+        mailbox.Close();
+        expect("closed and empty", !mailbox.Take(taken));
+        expect("put after close drops", !mailbox.Put(frame) && mailbox.dropped() == 2);
+    }
+    {
+        yolo::LatestMailbox<FakeFrame> mailbox(yolo::DropPolicy::kDropNewest);
+        FakeFrame frame;
+        frame.sequence = 1;
+        mailbox.Put(frame);
+        frame.sequence = 2;
+        expect("drop newest keeps the waiting frame", !mailbox.Put(frame) && frame.sequence == 2);
+        mailbox.Close();
+        FakeFrame taken;
+        expect("closed mailbox still hands out the waiting frame", mailbox.Take(taken) && taken.sequence == 1);
+        expect("then ends", !mailbox.Take(taken));
+    }
+    {
+        // kBlock: the producer waits for every take, nothing is lost
+        yolo::LatestMailbox<FakeFrame> mailbox(yolo::DropPolicy::kBlock);
+        std::thread producer([&mailbox] {
+            for (int i = 0; i < 50; i++)
+            {
+                FakeFrame frame;
+                frame.sequence = i;
+                mailbox.Put(frame);
+            }
+            mailbox.Close();
+        });
+        FakeFrame taken;
+        bool inOrder = true;
+        int count = 0;
+        while (mailbox.Take(taken))
+        {
+            inOrder = inOrder && taken.sequence == count;
+            count++;
+        }
+        producer.join();
+        expect("block loses nothing", count == 50 && inOrder && mailbox.dropped() == 0);
+    }
+
+    // Drop oldest: about one frame in five is processed, always the newest, latency stays near one processing time
+    std::vector<int> processed;
+    yolo::StreamStats stats = RunCamera(yolo::DropPolicy::kDropOldest, 200, processed);
+    expect("every frame captured", stats.captured == 200);
+    expect("frames accounted for", stats.processed + stats.dropped + stats.stale == stats.captured &&
+        stats.processed == processed.size());
+    expect("slow consumer drops frames", stats.dropped > 100 && stats.DropRate() > 0.5);
+    bool increasing = true;
+    for (size_t i = 1; i < processed.size(); i++)
+    {
+        increasing = increasing && processed[i] > processed[i - 1];
+    }
+    expect("frames processed in capture order", increasing);
+    expect("the last frame is processed", !processed.empty() && processed.back() == 199);
+    // 10 ms of processing plus at most one capture interval of waiting; a queue would reach hundreds of ms
+    expect("latency bounded", stats.latency.p50 >= 10.0 && stats.latency.p90 < 40.0);
+    expect("fps near the consumer's", stats.Fps() > 30.0 && stats.Fps() <= 101.0);
+
+    // Drop newest: as many drops, but a waiting frame is never replaced
+    processed.clear();
+    stats = RunCamera(yolo::DropPolicy::kDropNewest, 200, processed);
+    expect("drop newest drops", stats.dropped > 100 && stats.processed + stats.dropped == stats.captured);
+    expect("drop newest starts with the first frame", !processed.empty() && processed.front() == 0);
+
+    // Block: a file processed in full, capture slowed to the consumer
+    processed.clear();
+    stats = RunCamera(yolo::DropPolicy::kBlock, 30, processed);
+    expect("block processes every frame", stats.processed == 30 && stats.dropped == 0 && stats.DropRate() == 0.0);
+    expect("block keeps order", processed.size() == 30 && processed.front() == 0 && processed.back() == 29);
+
+    // Block with a maximum age: frames that waited for the consumer longer than 5 ms are skipped
+    processed.clear();
+    stats = RunCamera(yolo::DropPolicy::kBlock, 30, processed, 5.0);
+    expect("stale frames dropped", stats.stale > 10 && stats.processed + stats.stale == 30 && stats.dropped == 0);
+
+    // Stop and max_frames end the capture
+    {
+        yolo::StreamOptions options;
+        options.max_frames = 25;
+        int next = 0;
+        yolo::StreamRunner<FakeFrame> runner(options,
+            [&next](FakeFrame& frame) {
+                frame.sequence = next++;
+                return true;
+            },
+            [](FakeFrame&) { return true; });
+        stats = runner.Run();
+        expect("max frames", stats.captured == 25 && next == 25);
+    }
+    {
+        yolo::StreamOptions options;
+        options.source_fps = 1000.0;
+        yolo::StreamRunner<FakeFrame>* self = nullptr;
+        yolo::StreamRunner<FakeFrame> runner(options,
+            [](FakeFrame& frame) {
+                frame.sequence = 0;
+                return true;
+            },
+            [&self](FakeFrame&) {
+                self->Stop();
+                return false;
+            });
+        self = &runner;
+        stats = runner.Run();
+        expect("stop from the consumer", stats.failed >= 1 && stats.processed == 0 && stats.captured < 10);
+    }
+
+    // Errors on either thread come out of Run
+    {
+        yolo::StreamOptions options;
+        yolo::StreamRunner<FakeFrame> runner(options,
+            [](FakeFrame&) -> bool { throw std::runtime_error("camera lost"); },
+            [](FakeFrame&) { return true; });
+        bool thrown = false;
+        try
+        {
+            runner.Run();
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        expect("source error rethrown", thrown);
+    }
+    {
+        yolo::StreamOptions options;
+        options.source_fps = 1000.0;
+        yolo::StreamRunner<FakeFrame> runner(options,
+            [](FakeFrame&) { return true; },
+            [](FakeFrame&) -> bool { throw std::runtime_error("model failed"); });
+        bool thrown = false;
+        try
+        {
+            runner.Run();
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        expect("process error rethrown after capture stops", thrown);
+    }
+
+    std::printf("%d cases, %d failures\n", cases, failures);
+    return failures ? 1 : 0;
+}
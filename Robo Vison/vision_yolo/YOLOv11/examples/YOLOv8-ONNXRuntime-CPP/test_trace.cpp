@@ -0,0 +1,216 @@
+// Test of the hot-path tracing in ../YOLOv8-CPP-Common/trace.h that the backends' stage zones record into:
+// nothing is recorded while disabled, nested zones and their threads, rings of exited threads reused by new ones,
+// frame sampling, the ring keeping the newest zones once full, snapshots taken while other threads record, and the
+// Chrome trace JSON.
+//
+// Usage: ./TraceTest   (registered with ctest)
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "trace.h"
+
+
+static size_t Count(const std::vector<yolo::trace::Event>& events, const char* name)
+{
+    size_t count = 0;
+    for (const yolo::trace::Event& event : events)
+    {
+        count += std::strcmp(event.name, name) == 0;
+    }
+    return count;
+}
+
+
+static void Frame()
+{
+    YOLO_TRACE_FRAME("Frame");
+    YOLO_TRACE_ZONE("Stage");
+}
+
+
+int main()
+{
+    int cases = 0;
+    int failures = 0;
+    auto expect = [&](const char* what, bool ok) {
+        cases++;
+        if (!ok)
+        {
+            failures++;
+            std::printf("FAIL %s\n", what);
+        }
+    };
+
+    {
+        YOLO_TRACE_ZONE("Off");
+    }
+    expect("disabled records nothing", yolo::trace::Collect().empty() && !yolo::trace::IsEnabled());
+
+    yolo::trace::Enable(true);
+    {
+        YOLO_TRACE_ZONE("Outer");
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        {
+            YOLO_TRACE_ZONE("Inner");
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    std::vector<yolo::trace::Event> events = yolo::trace::Collect();
+    expect("two zones", events.size() == 2);
+    if (events.size() == 2)
+    {
+        const yolo::trace::Event& outer = events[0];
+        const yolo::trace::Event& inner = events[1];
+        expect("ordered by start", std::strcmp(outer.name, "Outer") == 0 && std::strcmp(inner.name, "Inner") == 0);
+        expect("inner nested in outer", inner.start_ns >= outer.start_ns &&
+            inner.start_ns + inner.duration_ns <= outer.start_ns + outer.duration_ns);
+        expect("durations in ns", outer.duration_ns >= 3000000 && inner.duration_ns >= 1000000);
+        expect("same thread", outer.thread == inner.thread && outer.thread >= 1);
+    }
+
+    // Threads alive at once record into their own rings and get their own ids
+    yolo::trace::Clear();
+    expect("clear", yolo::trace::Collect().empty());
+    std::vector<std::thread> threads;
+    std::atomic<int> recorded(0);
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([t, &recorded] {
+            yolo::trace::SetThreadName("worker " + std::to_string(t));
+            for (int i = 0; i < 100; i++)
+            {
+                YOLO_TRACE_ZONE("Work");
+            }
+            recorded++;
+            while (recorded.load() < 4)
+            {
+                std::this_thread::yield();
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    threads.clear();
+    events = yolo::trace::Collect();
+    std::vector<uint32_t> ids;
+    for (const yolo::trace::Event& event : events)
+    {
+        if (std::find(ids.begin(), ids.end(), event.thread) == ids.end())
+        {
+            ids.push_back(event.thread);
+        }
+    }
+    expect("zones of exited threads kept", Count(events, "Work") == 400);
+    expect("one id per thread", ids.size() == 4);
+
+    // Threads started and joined in a loop take over the rings of exited ones instead of adding a ring each
+    const size_t rings = yolo::trace::RingCount();
+    for (int t = 0; t < 200; t++)
+    {
+        std::thread once([] { YOLO_TRACE_ZONE("Once"); });
+        once.join();
+    }
+    expect("sequential threads reuse a ring", yolo::trace::RingCount() == rings);
+    for (int round = 0; round < 50; round++)
+    {
+        for (int t = 0; t < 4; t++)
+        {
+            threads.emplace_back([] { YOLO_TRACE_ZONE("Batch"); });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        threads.clear();
+    }
+    expect("concurrent threads bounded by the most alive", yolo::trace::RingCount() == rings);
+    expect("zones of recycled rings kept", Count(yolo::trace::Collect(), "Once") == 200 &&
+        Count(yolo::trace::Collect(), "Batch") == 200);
+
+    // One outermost frame in 5 is recorded with its zones; nested frames follow the outer decision
+    yolo::trace::Clear();
+    yolo::trace::SetSampleEvery(5);
+    for (int i = 0; i < 20; i++)
+    {
+        YOLO_TRACE_FRAME("Outer frame");
+        Frame();
+    }
+    yolo::trace::SetSampleEvery(1);
+    events = yolo::trace::Collect();
+    expect("sampled frames", Count(events, "Outer frame") == 4);
+    expect("nested frames follow the outer one", Count(events, "Frame") == 4 && Count(events, "Stage") == 4);
+    {
+        YOLO_TRACE_ZONE("After frames");
+    }
+    expect("zones outside frames recorded", Count(yolo::trace::Collect(), "After frames") == 1);
+
+    // A full ring keeps the newest zones
+    yolo::trace::Clear();
+    yolo::trace::SetBufferCapacity(16);
+    std::thread small([] {
+        for (int i = 0; i < 40; i++)
+        {
+            YOLO_TRACE_ZONE(i < 24 ? "Old" : "New");
+        }
+    });
+    small.join();
+    events = yolo::trace::Collect();
+    expect("ring keeps the newest", Count(events, "New") == 16 && Count(events, "Old") == 0);
+
+    // Snapshots while a thread keeps overwriting its ring only return complete zones
+    yolo::trace::Clear();
+    std::atomic<bool> stop(false);
+    std::thread writer([&stop] {
+        while (!stop.load())
+        {
+            YOLO_TRACE_ZONE("Spin");
+        }
+    });
+    bool consistent = true;
+    for (int i = 0; i < 200; i++)
+    {
+        for (const yolo::trace::Event& event : yolo::trace::Collect())
+        {
+            consistent = consistent && event.name != nullptr && event.start_ns > 0;
+        }
+    }
+    stop.store(true);
+    writer.join();
+    expect("concurrent snapshots", consistent && Count(yolo::trace::Collect(), "Spin") <= 16);
+    yolo::trace::SetBufferCapacity(8192);
+
+    // Chrome trace: complete events in microseconds with ns decimals, thread names as metadata
+    yolo::trace::Clear();
+    yolo::trace::SetThreadName("main \"thread\"");
+    {
+        YOLO_TRACE_ZONE("Json");
+    }
+    std::ostringstream json;
+    yolo::trace::WriteChromeTrace(json);
+    const std::string text = json.str();
+    expect("json object", text.find("{\"displayTimeUnit\": \"ns\", \"traceEvents\": [") == 0 &&
+        text.find("\n]}\n") == text.size() - 4);
+    expect("json complete event", text.find("{\"name\": \"Json\", \"cat\": \"yolo\", \"ph\": \"X\", \"ts\": 0.000, ")
+        != std::string::npos);
+    expect("json escapes thread names", text.find("\"args\": {\"name\": \"main \\\"thread\\\"\"}") != std::string::npos);
+    expect("json drops cleared zones", text.find("\"Outer\"") == std::string::npos);
+
+    yolo::trace::Enable(false);
+    yolo::trace::Clear();
+    {
+        YOLO_TRACE_ZONE("Off again");
+    }
+    expect("disabled again", yolo::trace::Collect().empty());
+
+    std::printf("%d cases, %d failures\n", cases, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,132 @@
+// Test of the persistent workers in ../YOLOv8-CPP-Common/worker_pool.h behind RunSessionBatch: every index runs
+// once, the same threads serve every call (so their thread_local scratch survives), exceptions come back to the
+// caller, and concurrent callers are serialized.
+//
+// Usage: ./WorkerPoolTest   (registered with ctest)
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "worker_pool.h"
+
+
+int main()
+{
+    int cases = 0;
+    int failures = 0;
+    auto expect = [&](const char* what, bool ok) {
+        cases++;
+        if (!ok)
+        {
+            failures++;
+            std::printf("FAIL %s\n", what);
+        }
+    };
+
+    {
+        yolo::WorkerPool pool(3);
+        expect("workers", pool.workers() == 3);
+
+        std::vector<int> hits(1000, 0);
+        pool.Run(hits.size(), [&hits](size_t i) { hits[i]++; });
+        bool once = true;
+        for (int hit : hits)
+        {
+            once = once && hit == 1;
+        }
+        expect("every index once", once);
+
+        // Items slow enough that the workers take part: the caller and up to three workers, and no one else
+        std::mutex mutex;
+        std::set<std::thread::id> threads;
+        pool.Run(16, [&](size_t) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.insert(std::this_thread::get_id());
+        });
+        expect("caller takes part", threads.count(std::this_thread::get_id()) == 1);
+        expect("items spread over the workers", threads.size() >= 2 && threads.size() <= 4);
+
+        // 200 calls reuse the same four threads, each allocating its thread_local scratch once
+        std::atomic<int> allocations{0};
+        std::set<std::thread::id> seen;
+        for (int call = 0; call < 200; call++)
+        {
+            pool.Run(8, [&](size_t) {
+                thread_local std::vector<float> scratch;
+                if (scratch.empty())
+                {
+                    scratch.resize(4096);
+                    allocations++;
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                seen.insert(std::this_thread::get_id());
+            });
+        }
+        expect("no new threads across calls", seen.size() <= 4);
+        expect("scratch allocated once per thread", allocations.load() <= 4);
+
+        bool thrown = false;
+        std::atomic<int> ran{0};
+        try
+        {
+            pool.Run(32, [&ran](size_t i) {
+                ran++;
+                if (i == 5)
+                {
+                    throw std::runtime_error("decode failed");
+                }
+            });
+        }
+        catch (const std::runtime_error&)
+        {
+            thrown = true;
+        }
+        expect("item exception rethrown", thrown);
+        expect("the other items still ran", ran.load() == 32);
+        int after = 0;
+        pool.Run(10, [&after, &mutex](size_t) {
+            std::lock_guard<std::mutex> lock(mutex);
+            after++;
+        });
+        expect("usable after an exception", after == 10);
+
+        bool ranEmpty = false;
+        pool.Run(0, [&ranEmpty](size_t) { ranEmpty = true; });
+        expect("empty loop", !ranEmpty);
+
+        // Two callers on one pool: each call still sees all of its indices, none of the other's
+        std::atomic<bool> mixed{false};
+        auto caller = [&](int tag) {
+            for (int call = 0; call < 100; call++)
+            {
+                std::vector<int> mine(20, 0);
+                pool.Run(mine.size(), [&](size_t i) { mine[i] += tag; });
+                for (int value : mine)
+                {
+                    mixed = mixed || value != tag;
+                }
+            }
+        };
+        std::thread a(caller, 1);
+        std::thread b(caller, 2);
+        a.join();
+        b.join();
+        expect("concurrent callers serialized", !mixed);
+    }
+
+    {
+        yolo::WorkerPool inline_pool(0);
+        std::set<std::thread::id> threads;
+        inline_pool.Run(5, [&threads](size_t) { threads.insert(std::this_thread::get_id()); });
+        expect("no workers runs inline", threads.size() == 1 && threads.count(std::this_thread::get_id()) == 1);
+    }
+
+    std::printf("%d cases, %d failures\n", cases, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,76 @@
+// Frames per second on a video for both performance hints, with the blocking RunInference loop and with the
+// asynchronous StartInference / FinishInference ring.
+//
+// Usage: ./benchmark_async <model_path.{onnx, xml}> <video_path> [frames]   (default 300 frames)
+// The frames are decoded up front so the video decoder is not measured. Each run works on copies of them, because
+// the detections are drawn on the frames, and starts after a warm-up of one frame per request.
+
+#include "inference.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <opencv2/videoio.hpp>
+
+namespace {
+
+double MeasureFps(yolo::Inference &inference, const std::vector<cv::Mat> &frames, bool asynchronous) {
+	const auto start = std::chrono::steady_clock::now();
+	if (!asynchronous) {
+		for (const cv::Mat &frame : frames) {
+			cv::Mat image = frame.clone();
+			inference.RunInference(image);
+		}
+	} else {
+		cv::Mat done;
+		for (const cv::Mat &frame : frames) {
+			cv::Mat image = frame.clone(); // A new cv::Mat per frame, the ring holds it until it is finished
+			if (!inference.StartInference(image)) {
+				inference.FinishInference(done);
+				inference.StartInference(image);
+			}
+		}
+		while (inference.FinishInference(done)) {
+		}
+	}
+	return frames.size() / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	if (argc < 3) {
+		std::cerr << "usage: " << argv[0] << " <model_path> <video_path> [frames]" << std::endl;
+		return 1;
+	}
+	const std::string model_path = argv[1];
+	const size_t max_frames = argc > 3 ? std::atoi(argv[3]) : 300;
+
+	cv::VideoCapture capture(argv[2]);
+	std::vector<cv::Mat> frames;
+	cv::Mat frame;
+	while (frames.size() < max_frames && capture.read(frame)) {
+		frames.push_back(frame.clone());
+	}
+	if (frames.empty()) {
+		std::cerr << "ERROR: no frames in " << argv[2] << std::endl;
+		return 1;
+	}
+
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << frames.size() << " frames of " << argv[2] << "\n";
+	std::cout << "  hint         requests   RunInference fps   async fps\n";
+	for (ov::hint::PerformanceMode mode : {ov::hint::PerformanceMode::LATENCY, ov::hint::PerformanceMode::THROUGHPUT}) {
+		yolo::Inference inference(model_path, cv::Size(640, 640), 0.5, 0.5, mode);
+		const std::vector<cv::Mat> warm_up(frames.begin(), frames.begin() + std::min(frames.size(), inference.RequestCount()));
+		MeasureFps(inference, warm_up, true);
+		const double sync_fps = MeasureFps(inference, frames, false);
+		const double async_fps = MeasureFps(inference, frames, true);
+		std::cout << "  " << std::left << std::setw(13) << (mode == ov::hint::PerformanceMode::LATENCY ? "LATENCY" : "THROUGHPUT")
+		          << std::right << std::setw(8) << inference.RequestCount() << std::setw(19) << sync_fps << std::setw(12)
+		          << async_fps << "\n";
+	}
+	return 0;
+}
@@ -0,0 +1,71 @@
+// End-to-end RunInference latency on a video, with the frame resized on the CPU (cv::resize, then the u8 tensor)
+// against the model compiled for the video's resolution, whose graph letterboxes the frame memory it is given.
+//
+// Usage: ./benchmark_preprocess <model_path.{onnx, xml}> <video_path> [frames]   (default 300 frames)
+// The frames are decoded up front so the video decoder is not measured, and copied before each run because the
+// detections are drawn on them. Both models are compiled with the LATENCY hint. Prints the median and 90th
+// percentile of RunInference, preprocessing, inference and drawing included.
+
+#include "inference.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <opencv2/videoio.hpp>
+
+namespace {
+
+std::vector<double> MeasureLatency(yolo::Inference &inference, const std::vector<cv::Mat> &frames) {
+	std::vector<cv::Mat> images(frames.size());
+	for (size_t i = 0; i < frames.size(); ++i) {
+		frames[i].copyTo(images[i]);
+	}
+	cv::Mat warm_up = frames.front().clone();
+	inference.RunInference(warm_up);
+
+	std::vector<double> samples;
+	for (cv::Mat &image : images) {
+		const auto start = std::chrono::steady_clock::now();
+		inference.RunInference(image);
+		samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	std::sort(samples.begin(), samples.end());
+	return samples;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	if (argc < 3) {
+		std::cerr << "usage: " << argv[0] << " <model_path> <video_path> [frames]" << std::endl;
+		return 1;
+	}
+	const std::string model_path = argv[1];
+	const size_t max_frames = argc > 3 ? std::atoi(argv[3]) : 300;
+
+	cv::VideoCapture capture(argv[2]);
+	std::vector<cv::Mat> frames;
+	cv::Mat frame;
+	while (frames.size() < max_frames && capture.read(frame)) {
+		frames.push_back(frame.clone());
+	}
+	if (frames.empty()) {
+		std::cerr << "ERROR: no frames in " << argv[2] << std::endl;
+		return 1;
+	}
+	const cv::Size frame_size = frames.front().size();
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << frames.size() << " frames of " << frame_size.width << "x" << frame_size.height << "\n";
+	std::cout << "  preprocessing      median ms     p90 ms\n";
+	for (bool in_graph : {false, true}) {
+		yolo::Inference inference(model_path, cv::Size(640, 640), 0.5, 0.5, ov::hint::PerformanceMode::LATENCY,
+		                          in_graph ? frame_size : cv::Size());
+		const std::vector<double> samples = MeasureLatency(inference, frames);
+		std::cout << "  " << std::left << std::setw(17) << (in_graph ? "graph letterbox" : "cv::resize") << std::right
+		          << std::setw(11) << samples[samples.size() / 2] << std::setw(11) << samples[samples.size() * 9 / 10] << "\n";
+	}
+	return 0;
+}
@@ -0,0 +1,94 @@
+// Time to first inference of a freshly started process, without and with the compiled model cache (ov::cache_dir):
+//   no cache     read_model, the preprocessing graph and compile_model, as on every start before
+//   cold cache   empty cache directory, the start that compiles and exports the blob
+//   warm cache   the blob exists and is imported instead of compiled
+//
+// Usage: ./benchmark_startup <model_path.{onnx, xml}> [cache_dir [runs]]   (default model_cache, 5 runs)
+// Each measurement is a new process (this program started again with --child), so nothing is shared with the runs
+// before it but the OS page cache. The child times from main to the end of its first RunInference. Blobs go to
+// cache_dir/startup_benchmark, which is deleted before each cold run. For a disk-cold start drop the page cache
+// first (sync; echo 3 | sudo tee /proc/sys/vm/drop_caches).
+
+#include "inference.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+namespace {
+
+int Child(const std::string &model_path, const std::string &cache_dir) {
+	const auto start = std::chrono::steady_clock::now();
+	yolo::Inference inference(model_path, cv::Size(640, 640), 0.5, 0.5, ov::hint::PerformanceMode::LATENCY, cv::Size(),
+	                          cache_dir);
+	cv::Mat frame(720, 1280, CV_8UC3, cv::Scalar(114, 114, 114));
+	inference.RunInference(frame);
+	std::cout << "startup_ms " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+	          << std::endl;
+	return 0;
+}
+
+// Median time to first inference over `runs` child processes, negative if a child failed
+double Measure(const std::string &self, const std::string &model_path, const std::string &cache_dir, int runs, bool cold) {
+	std::vector<double> samples;
+	for (int r = 0; r < runs; ++r) {
+		if (cold) {
+			std::filesystem::remove_all(cache_dir);
+		}
+		const std::string command = "\"" + self + "\" --child \"" + model_path + "\" \"" + (cache_dir.empty() ? "-" : cache_dir) + "\"";
+		FILE *pipe = popen(command.c_str(), "r");
+		if (!pipe) {
+			return -1.0;
+		}
+		char line[512];
+		double ms = -1.0;
+		while (std::fgets(line, sizeof(line), pipe)) {
+			std::sscanf(line, "startup_ms %lf", &ms);
+		}
+		if (pclose(pipe) != 0 || ms < 0.0) {
+			return -1.0;
+		}
+		samples.push_back(ms);
+	}
+	std::sort(samples.begin(), samples.end());
+	return samples[samples.size() / 2];
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	if (argc > 1 && std::string(argv[1]) == "--child") {
+		return argc < 4 ? 1 : Child(argv[2], std::string(argv[3]) == "-" ? "" : argv[3]);
+	}
+	if (argc < 2) {
+		std::cerr << "usage: " << argv[0] << " <model_path> [cache_dir [runs]]" << std::endl;
+		return 1;
+	}
+	const std::string model_path = argv[1];
+	const std::filesystem::path cache_root = argc > 2 ? argv[2] : "model_cache";
+	const int runs = argc > 3 ? std::atoi(argv[3]) : 5;
+	const std::string cache_dir = (cache_root / "startup_benchmark").string();
+
+	const double no_cache = Measure(argv[0], model_path, "", runs, false);
+	const double cold = Measure(argv[0], model_path, cache_dir, runs, true);
+	const double warm = Measure(argv[0], model_path, cache_dir, runs, false);
+	if (no_cache < 0.0 || cold < 0.0 || warm < 0.0) {
+		std::cerr << "ERROR: a child process failed, run it alone: " << argv[0] << " --child " << model_path << " " << cache_dir << std::endl;
+		return 1;
+	}
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << model_path << ", median of " << runs << " processes, time to first inference\n";
+	std::cout << "  no cache     " << std::setw(8) << no_cache << " ms\n";
+	std::cout << "  cold cache   " << std::setw(8) << cold << " ms   (compiles and exports the blob)\n";
+	std::cout << "  warm cache   " << std::setw(8) << warm << " ms   x" << no_cache / warm << " faster\n";
+	return 0;
+}
@@ -1,29 +1,56 @@
 #include "inference.h"
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
-#include <opencv2/dnn.hpp>
 #include <random>
+#include <stdexcept>
 
 namespace yolo {
 
 // Constructor to initialize the model with default input shape
-Inference::Inference(const std::string &model_path, const float &model_confidence_threshold, const float &model_NMS_threshold) {
+Inference::Inference(const std::string &model_path, const float &model_confidence_threshold, const float &model_NMS_threshold,
+                     ov::hint::PerformanceMode performance_mode) {
 	model_input_shape_ = cv::Size(640, 640); // Set the default size for models with dynamic shapes to prevent errors.
 	model_confidence_threshold_ = model_confidence_threshold;
 	model_NMS_threshold_ = model_NMS_threshold;
-	InitializeModel(model_path);
+	InitializeModel(model_path, performance_mode, std::string(), 0);
 }
 
 // Constructor to initialize the model with specified input shape
-Inference::Inference(const std::string &model_path, const cv::Size model_input_shape, const float &model_confidence_threshold, const float &model_NMS_threshold) {
+Inference::Inference(const std::string &model_path, const cv::Size model_input_shape, const float &model_confidence_threshold, const float &model_NMS_threshold,
+                     ov::hint::PerformanceMode performance_mode, const cv::Size frame_size, const std::string &cache_dir,
+                     const int num_threads) {
 	model_input_shape_ = model_input_shape;
+	frame_size_ = frame_size;
 	model_confidence_threshold_ = model_confidence_threshold;
 	model_NMS_threshold_ = model_NMS_threshold;
-	InitializeModel(model_path);
+	InitializeModel(model_path, performance_mode, cache_dir, num_threads);
 }
 
-void Inference::InitializeModel(const std::string &model_path) {
+Inference::~Inference() {
+	// The callbacks refer to the slots, no request may complete after they are gone
+	for (; in_flight_ > 0; --in_flight_) {
+		slots_[(next_slot_ + slots_.size() - in_flight_) % slots_.size()]->request.wait();
+	}
+}
+
+void Inference::InitializeModel(const std::string &model_path, ov::hint::PerformanceMode performance_mode, const std::string &cache_dir,
+                                int num_threads) {
+	nms_options_.iou_threshold = model_NMS_threshold_;
+	nms_options_.score_threshold = model_confidence_threshold_;
+	nms_options_.agnostic = true;
+
 	ov::Core core; // OpenVINO core object
+	core.set_property(ov::enable_mmap(true)); // Map the IR weights instead of reading them
+	if (!cache_dir.empty()) {
+		// The compiled blob is saved under a hash of the model (after preprocessing), device and properties. Later
+		// starts import it and skip compilation; a changed model, setting or OpenVINO version compiles a new one.
+		core.set_property(ov::cache_dir(cache_dir));
+	}
+	if (num_threads > 0) {
+		core.set_property("CPU", ov::inference_num_threads(num_threads)); // AUTO passes it on when it picks the CPU
+	}
 	std::shared_ptr<ov::Model> model = core.read_model(model_path); // Read the model from file
 
 	// If the model has dynamic shapes, reshape it to the specified input shape
@@ -31,26 +58,54 @@ void Inference::InitializeModel(const std::string &model_path) {
 		model->reshape({1, 3, static_cast<long int>(model_input_shape_.height), static_cast<long int>(model_input_shape_.width)});
 	}
 
+	// Get input shape from the model (NCHW)
+	const ov::Shape input_shape = model->input().get_shape();
+	model_input_shape_ = cv::Size2f(input_shape[3], input_shape[2]);
+
 	// Preprocessing setup for the model
 	ov::preprocess::PrePostProcessor ppp = ov::preprocess::PrePostProcessor(model);
 	ppp.input().tensor().set_element_type(ov::element::u8).set_layout("NHWC").set_color_format(ov::preprocess::ColorFormat::BGR);
-	ppp.input().preprocess().convert_element_type(ov::element::f32).convert_color(ov::preprocess::ColorFormat::RGB).scale({255, 255, 255});
+	ov::preprocess::PreProcessSteps &steps = ppp.input().preprocess();
+	steps.convert_element_type(ov::element::f32).convert_color(ov::preprocess::ColorFormat::RGB);
+	if (!frame_size_.empty()) {
+		// Letterbox in the graph: the tensor is the whole frame, resized keeping its aspect ratio and padded with
+		// gray (114) to the model input, centered as ultralytics does
+		ppp.input().tensor().set_spatial_static_shape(frame_size_.height, frame_size_.width);
+		letterbox_scale_ = std::min(model_input_shape_.width / frame_size_.width, model_input_shape_.height / frame_size_.height);
+		const int resized_width = static_cast<int>(std::round(frame_size_.width * letterbox_scale_));
+		const int resized_height = static_cast<int>(std::round(frame_size_.height * letterbox_scale_));
+		const int pad_width = static_cast<int>(model_input_shape_.width) - resized_width;
+		const int pad_height = static_cast<int>(model_input_shape_.height) - resized_height;
+		letterbox_pad_ = cv::Point2f(pad_width / 2, pad_height / 2);
+		steps.resize(ov::preprocess::ResizeAlgorithm::RESIZE_LINEAR, resized_height, resized_width);
+		steps.pad({0, pad_height / 2, pad_width / 2, 0}, {0, pad_height - pad_height / 2, pad_width - pad_width / 2, 0}, 114.0f,
+		          ov::op::PadMode::CONSTANT);
+	}
+	steps.scale({255, 255, 255});
 	ppp.input().model().set_layout("NCHW");
 	ppp.output().tensor().set_element_type(ov::element::f32);
 	model = ppp.build(); // Build the preprocessed model
 
-	// Compile the model for inference
-	compiled_model_ = core.compile_model(model, "AUTO");
-	inference_request_ = compiled_model_.create_infer_request(); // Create inference request
+	// Compile the model for inference. LATENCY runs one request as fast as possible, THROUGHPUT splits the device
+	// into streams that each run a request, so several frames are in flight.
+	compiled_model_ = core.compile_model(model, "AUTO", ov::hint::performance_mode(performance_mode));
+	sync_slot_.request = compiled_model_.create_infer_request(); // Create inference request
 
-	short width, height;
+	// One asynchronous request per stream, plus what the device needs to keep them busy
+	const uint32_t request_count = compiled_model_.get_property(ov::optimal_number_of_infer_requests);
+	for (uint32_t i = 0; i < request_count; ++i) {
+		slots_.emplace_back(new InferSlot());
+		InferSlot *slot = slots_.back().get();
+		slot->request = compiled_model_.create_infer_request();
+		slot->request.set_callback([this, slot](std::exception_ptr error) {
+			std::lock_guard<std::mutex> lock(slot_mutex_);
+			slot->error = error;
+			slot->done = true;
+			slot_done_.notify_all();
+		});
+	}
 
-	// Get input shape from the model
-	const std::vector<ov::Output<ov::Node>> inputs = model->inputs();
-	const ov::Shape input_shape = inputs[0].get_shape();
-	height = input_shape[1];
-	width = input_shape[2];
-	model_input_shape_ = cv::Size2f(width, height);
+	short width, height;
 
 	// Get output shape from the model
 	const std::vector<ov::Output<ov::Node>> outputs = model->outputs();
@@ -62,65 +117,135 @@ void Inference::InitializeModel(const std::string &model_path) {
 
 // Method to run inference on an input frame
 void Inference::RunInference(cv::Mat &frame) {
-	Preprocessing(frame); // Preprocess the input frame
-	inference_request_.infer(); // Run inference
-	PostProcessing(frame); // Postprocess the inference results
+	YOLO_TRACE_FRAME("RunInference");
+	sync_slot_.frame = frame; // Shares the pixels, the detections are drawn on the caller's frame
+	Preprocessing(frame, sync_slot_); // Preprocess the input frame
+	{
+		YOLO_TRACE_ZONE("infer");
+		sync_slot_.request.infer(); // Run inference
+	}
+	PostProcessing(sync_slot_); // Postprocess the inference results
+	sync_slot_.frame.release();
+}
+
+void Inference::RunInference(const cv::Mat &frame, std::vector<Detection> &detections, StageTimes *times) {
+	YOLO_TRACE_FRAME("RunInference");
+	StageClock stage_clock;
+	StageTimes stage_times;
+	detections.clear();
+	Preprocessing(frame, sync_slot_);
+	stage_times.preprocess_ms = stage_clock.Lap();
+	{
+		YOLO_TRACE_ZONE("infer");
+		sync_slot_.request.infer();
+	}
+	stage_times.inference_ms = stage_clock.Lap();
+	PostProcessing(sync_slot_, &detections);
+	stage_times.postprocess_ms = stage_clock.Lap();
+	if (times) {
+		*times = stage_times;
+	}
+}
+
+// Method to start inference on the next free request
+bool Inference::StartInference(cv::Mat &frame) {
+	if (in_flight_ == slots_.size()) {
+		return false;
+	}
+	InferSlot &slot = *slots_[next_slot_];
+	slot.frame = frame;
+	Preprocessing(frame, slot);
+	{
+		std::lock_guard<std::mutex> lock(slot_mutex_);
+		slot.done = false;
+		slot.error = nullptr;
+	}
+	slot.request.start_async();
+	next_slot_ = (next_slot_ + 1) % slots_.size();
+	++in_flight_;
+	return true;
+}
+
+// Method to wait for the oldest request and postprocess its results
+bool Inference::FinishInference(cv::Mat &frame) {
+	if (in_flight_ == 0) {
+		return false;
+	}
+	InferSlot &slot = *slots_[(next_slot_ + slots_.size() - in_flight_) % slots_.size()];
+	{
+		YOLO_TRACE_ZONE("WaitInference");
+		std::unique_lock<std::mutex> lock(slot_mutex_);
+		slot_done_.wait(lock, [&slot] { return slot.done; });
+	}
+	--in_flight_;
+	if (slot.error) {
+		slot.frame.release();
+		std::rethrow_exception(slot.error);
+	}
+	PostProcessing(slot);
+	frame = slot.frame;
+	slot.frame.release();
+	return true;
 }
 
 // Method to preprocess the input frame
-void Inference::Preprocessing(const cv::Mat &frame) {
-	cv::Mat resized_frame;
-	cv::resize(frame, resized_frame, model_input_shape_, 0, 0, cv::INTER_AREA); // Resize the frame to match the model input shape
+void Inference::Preprocessing(const cv::Mat &frame, InferSlot &slot) {
+	YOLO_TRACE_ZONE("Preprocessing");
+	if (!frame_size_.empty()) {
+		// The graph letterboxes the frame, wrap its memory as the input tensor. slot.frame keeps it alive.
+		if (frame.size() != frame_size_ || frame.type() != CV_8UC3) {
+			throw std::invalid_argument("frame is not a BGR image of the frame_size the model was compiled for");
+		}
+		cv::Mat input = frame;
+		if (!input.isContinuous()) {
+			input = slot.input = frame.clone(); // A region of a larger image, rows are not back to back
+		}
+		slot.scale_factor = cv::Point2f(1.0f / letterbox_scale_, 1.0f / letterbox_scale_);
+		slot.offset = letterbox_pad_;
+		const ov::Tensor input_tensor = ov::Tensor(compiled_model_.input().get_element_type(), compiled_model_.input().get_shape(), input.data);
+		slot.request.set_input_tensor(input_tensor);
+		return;
+	}
+
+	cv::resize(frame, slot.input, model_input_shape_, 0, 0, cv::INTER_AREA); // Resize the frame to match the model input shape
 
 	// Calculate scaling factor
-	scale_factor_.x = static_cast<float>(frame.cols / model_input_shape_.width);
-	scale_factor_.y = static_cast<float>(frame.rows / model_input_shape_.height);
+	slot.scale_factor.x = static_cast<float>(frame.cols / model_input_shape_.width);
+	slot.scale_factor.y = static_cast<float>(frame.rows / model_input_shape_.height);
+	slot.offset = cv::Point2f();
 
-	float *input_data = (float *)resized_frame.data; // Get pointer to resized frame data
-	const ov::Tensor input_tensor = ov::Tensor(compiled_model_.input().get_element_type(), compiled_model_.input().get_shape(), input_data); // Create input tensor
-	inference_request_.set_input_tensor(input_tensor); // Set input tensor for inference
+	// The tensor wraps slot.input, which stays alive until the request is done
+	const ov::Tensor input_tensor = ov::Tensor(compiled_model_.input().get_element_type(), compiled_model_.input().get_shape(), slot.input.data); // Create input tensor
+	slot.request.set_input_tensor(input_tensor); // Set input tensor for inference
 }
 
 // Method to postprocess the inference results
-void Inference::PostProcessing(cv::Mat &frame) {
+void Inference::PostProcessing(InferSlot &slot, std::vector<Detection> *detections) {
+	YOLO_TRACE_ZONE("PostProcessing");
 	std::vector<int> class_list;
 	std::vector<float> confidence_list;
 	std::vector<cv::Rect> box_list;
 
 	// Get the output tensor from the inference request
-	const float *detections = inference_request_.get_output_tensor().data<const float>();
-	const cv::Mat detection_outputs(model_output_shape_, CV_32F, (float *)detections); // Create OpenCV matrix from output tensor
-
-	// Iterate over detections and collect class IDs, confidence scores, and bounding boxes
-	for (int i = 0; i < detection_outputs.cols; ++i) {
-		const cv::Mat classes_scores = detection_outputs.col(i).rowRange(4, detection_outputs.rows);
-
-		cv::Point class_id;
-		double score;
-		cv::minMaxLoc(classes_scores, nullptr, &score, nullptr, &class_id); // Find the class with the highest score
-
-		// Check if the detection meets the confidence threshold
-		if (score > model_confidence_threshold_) {
-			class_list.push_back(class_id.y);
-			confidence_list.push_back(score);
-
-			const float x = detection_outputs.at<float>(0, i);
-			const float y = detection_outputs.at<float>(1, i);
-			const float w = detection_outputs.at<float>(2, i);
-			const float h = detection_outputs.at<float>(3, i);
-
-			cv::Rect box;
-			box.x = static_cast<int>(x);
-			box.y = static_cast<int>(y);
-			box.width = static_cast<int>(w);
-			box.height = static_cast<int>(h);
-			box_list.push_back(box);
-		}
+	const float *output = slot.request.get_output_tensor().data<const float>();
+
+	// Decode the channel-major output directly: per-anchor best class with SIMD, boxes only for anchors above the threshold
+	DecodeHead(output, model_output_shape_.width, 4, model_output_shape_.height - 4, model_confidence_threshold_, candidates_);
+	for (size_t i = 0; i < candidates_.count; ++i) {
+		class_list.push_back(candidates_.class_id[i]);
+		confidence_list.push_back(candidates_.score[i]);
+
+		cv::Rect box;
+		box.x = static_cast<int>(candidates_.box[4 * i]);
+		box.y = static_cast<int>(candidates_.box[4 * i + 1]);
+		box.width = static_cast<int>(candidates_.box[4 * i + 2]);
+		box.height = static_cast<int>(candidates_.box[4 * i + 3]);
+		box_list.push_back(box);
 	}
 
 	// Apply Non-Maximum Suppression (NMS) to filter overlapping bounding boxes
 	std::vector<int> NMS_result;
-	cv::dnn::NMSBoxes(box_list, confidence_list, model_confidence_threshold_, model_NMS_threshold_, NMS_result);
+	nms_.RunRects(box_list, confidence_list, class_list, nms_options_, NMS_result);
 
 	// Collect final detections after NMS
 	for (int i = 0; i < NMS_result.size(); ++i) {
@@ -129,19 +254,23 @@ void Inference::PostProcessing(cv::Mat &frame) {
 
 		result.class_id = class_list[id];
 		result.confidence = confidence_list[id];
-		result.box = GetBoundingBox(box_list[id]);
+		result.box = GetBoundingBox(box_list[id], slot);
 
-		DrawDetectedObject(frame, result);
+		if (detections) {
+			detections->push_back(result);
+		} else {
+			DrawDetectedObject(slot.frame, result);
+		}
 	}
 }
 
 // Method to get the bounding box in the correct scale
-cv::Rect Inference::GetBoundingBox(const cv::Rect &src) const {
+cv::Rect Inference::GetBoundingBox(const cv::Rect &src, const InferSlot &slot) const {
 	cv::Rect box = src;
-	box.x = (box.x - box.width / 2) * scale_factor_.x;
-	box.y = (box.y - box.height / 2) * scale_factor_.y;
-	box.width *= scale_factor_.x;
-	box.height *= scale_factor_.y;
+	box.x = (box.x - box.width / 2 - slot.offset.x) * slot.scale_factor.x;
+	box.y = (box.y - box.height / 2 - slot.offset.y) * slot.scale_factor.y;
+	box.width *= slot.scale_factor.x;
+	box.height *= slot.scale_factor.y;
 	return box;
 }
 
@@ -1,11 +1,20 @@
 #ifndef YOLO_INFERENCE_H_
 #define YOLO_INFERENCE_H_
 
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <opencv2/imgproc.hpp>
 #include <openvino/openvino.hpp>
 
+#include "head_decoder.h"
+#include "nms.h"
+#include "stage_times.h"
+#include "trace.h"
+
 namespace yolo {
 
 struct Detection {
@@ -18,29 +27,75 @@ class Inference {
  public:
 	Inference() {}
 	// Constructor to initialize the model with default input shape
-	Inference(const std::string &model_path, const float &model_confidence_threshold, const float &model_NMS_threshold);
-	// Constructor to initialize the model with specified input shape
-	Inference(const std::string &model_path, const cv::Size model_input_shape, const float &model_confidence_threshold, const float &model_NMS_threshold);
+	Inference(const std::string &model_path, const float &model_confidence_threshold, const float &model_NMS_threshold,
+	          ov::hint::PerformanceMode performance_mode = ov::hint::PerformanceMode::LATENCY);
+	// Constructor to initialize the model with specified input shape. With a frame_size the compiled graph takes the
+	// frames at that resolution as they are: it letterboxes, converts and scales them itself, reading the cv::Mat memory
+	// with no copy. Without one, frames of any size are resized on the CPU first. With a cache_dir the compiled model is
+	// saved there and imported on later starts instead of compiled again. num_threads caps the CPU plugin's inference
+	// threads, 0 leaves it to OpenVINO.
+	Inference(const std::string &model_path, const cv::Size model_input_shape, const float &model_confidence_threshold, const float &model_NMS_threshold,
+	          ov::hint::PerformanceMode performance_mode = ov::hint::PerformanceMode::LATENCY, const cv::Size frame_size = cv::Size(),
+	          const std::string &cache_dir = std::string(), const int num_threads = 0);
+	// Waits for the frames still in flight
+	~Inference();
 
 	void RunInference(cv::Mat &frame);
+	// Replaces detections with the frame's detections, in frame pixels, without drawing on it. times, if given, gets
+	// the wall-clock time of the preprocessing, the inference request and the decode + NMS.
+	void RunInference(const cv::Mat &frame, std::vector<Detection> &detections, StageTimes *times = nullptr);
+
+	// Asynchronous inference over the compiled model's optimal number of requests, for the THROUGHPUT mode where
+	// the device runs several streams at once. Frames are started round-robin and finished in the order they were
+	// started. StartInference returns false when every request is busy: finish the oldest frame first. The frame is
+	// drawn on when it is finished, so keep it alive and unchanged until then (use a new cv::Mat per frame).
+	bool StartInference(cv::Mat &frame);
+	// Waits for the oldest started frame and draws its detections on it. Returns false when no frame is in flight.
+	bool FinishInference(cv::Mat &frame);
+	// Number of asynchronous requests, the frames that can be in flight
+	size_t RequestCount() const { return slots_.size(); }
 
  private:
-	void InitializeModel(const std::string &model_path);
-	void Preprocessing(const cv::Mat &frame);
-	void PostProcessing(cv::Mat &frame);
-	cv::Rect GetBoundingBox(const cv::Rect &src) const;
+	// An inference request with the frame it is running on
+	struct InferSlot {
+		ov::InferRequest request;
+		cv::Mat input;               // Resized (or non-continuous) frame the input tensor points at, alive until the request is done
+		cv::Point2f scale_factor;    // Scaling factor for the input frame
+		cv::Point2f offset;          // Letterbox padding, in model input pixels
+		cv::Mat frame;               // Frame to draw the detections on
+		bool done = false;           // Set by the request's callback
+		std::exception_ptr error;    // Set by the request's callback when inference failed
+	};
+
+	void InitializeModel(const std::string &model_path, ov::hint::PerformanceMode performance_mode, const std::string &cache_dir, int num_threads);
+	void Preprocessing(const cv::Mat &frame, InferSlot &slot);
+	// Draws the detections on slot.frame, or appends them to detections when given
+	void PostProcessing(InferSlot &slot, std::vector<Detection> *detections = nullptr);
+	cv::Rect GetBoundingBox(const cv::Rect &src, const InferSlot &slot) const;
 	void DrawDetectedObject(cv::Mat &frame, const Detection &detections) const;
 
-	cv::Point2f scale_factor_;			// Scaling factor for the input frame
 	cv::Size2f model_input_shape_;	// Input shape of the model
 	cv::Size model_output_shape_;		// Output shape of the model
+	cv::Size frame_size_;           // Frame resolution the graph letterboxes, empty when frames are resized on the CPU
+	float letterbox_scale_ = 1.0f;  // Frame to model input scale of the graph letterbox
+	cv::Point2f letterbox_pad_;     // Left and top padding of the graph letterbox
 
-	ov::InferRequest inference_request_;  // OpenVINO inference request
+	InferSlot sync_slot_;                // Request of RunInference
 	ov::CompiledModel compiled_model_;    // OpenVINO compiled model
 
+	std::vector<std::unique_ptr<InferSlot>> slots_;  // Asynchronous requests, used round-robin
+	size_t next_slot_ = 0;               // Slot the next frame starts on
+	size_t in_flight_ = 0;               // Frames started and not finished, the oldest is next_slot_ - in_flight_
+	std::mutex slot_mutex_;              // Guards done and error of the slots
+	std::condition_variable slot_done_;  // Signalled by the request callbacks
+
 	float model_confidence_threshold_;  // Confidence threshold for detections
 	float model_NMS_threshold_;         // Non-Maximum Suppression threshold
 
+	HeadCandidates candidates_;         // Decoder output, reused between frames
+	NonMaxSuppression nms_;             // NMS scratch, reused between frames
+	NmsOptions nms_options_;            // Class-agnostic, at most 300 detections
+
 	std::vector<std::string> classes_ {
 		"person", "bicycle", "car", "motorcycle", "airplane", "bus", "train", "truck", "boat", "traffic light", 
 		"fire hydrant", "stop sign", "parking meter", "bench", "bird", "cat", "dog", "horse", "sheep", "cow", 
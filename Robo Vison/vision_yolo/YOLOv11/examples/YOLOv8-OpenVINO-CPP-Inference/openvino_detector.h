@@ -0,0 +1,67 @@
+#ifndef YOLO_OPENVINO_DETECTOR_H_
+#define YOLO_OPENVINO_DETECTOR_H_
+
+// IDetector (detector.h) over Inference, for the backend probe and applications that swap engines
+
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "detector.h"
+#include "inference.h"
+
+namespace yolo {
+
+class OpenVinoDetector : public IDetector {
+ public:
+	// nullptr when the model doesn't read or compile. The other arguments are those of Inference's second constructor.
+	static std::unique_ptr<OpenVinoDetector> Create(const std::string &model_path, const cv::Size model_input_shape = cv::Size(640, 640),
+	                                                const float model_confidence_threshold = 0.5f, const float model_NMS_threshold = 0.5f,
+	                                                const std::string &cache_dir = std::string(), const int num_threads = 0) {
+		try {
+			std::unique_ptr<OpenVinoDetector> detector(new OpenVinoDetector());
+			detector->inference_.reset(new Inference(model_path, model_input_shape, model_confidence_threshold, model_NMS_threshold,
+			                                         ov::hint::PerformanceMode::LATENCY, cv::Size(), cache_dir, num_threads));
+			return detector;
+		} catch (const std::exception &) {
+			return nullptr;
+		}
+	}
+
+	const char *Name() const override { return "openvino-auto"; }
+
+	bool Detect(const ImageView &frame, DetectionResults &results, StageTimes *times = nullptr) override {
+		results.clear();
+		// The frame as a Mat header, RunInference only reads it
+		const cv::Mat image(frame.height, frame.width, CV_8UC3, const_cast<uint8_t *>(frame.data), frame.stride);
+		try {
+			inference_->RunInference(image, detections_, times);
+		} catch (const std::exception &) {
+			return false;
+		}
+		for (const Detection &detection : detections_) {
+			DetectedObject object;
+			object.x = static_cast<float>(detection.box.x);
+			object.y = static_cast<float>(detection.box.y);
+			object.width = static_cast<float>(detection.box.width);
+			object.height = static_cast<float>(detection.box.height);
+			object.score = detection.confidence;
+			object.class_id = detection.class_id;
+			if (!results.push_back(object)) {
+				break;
+			}
+		}
+		return true;
+	}
+
+ private:
+	OpenVinoDetector() {}
+
+	std::unique_ptr<Inference> inference_;
+	std::vector<Detection> detections_;  // Reused, keeps its capacity from frame to frame
+};
+
+} // namespace yolo
+
+#endif // YOLO_OPENVINO_DETECTOR_H_